@@ -6,14 +6,49 @@ CFLAGS="-Iinclude -I/opt/local/include -L/opt/local/lib -lsqlite3 -lxml2 -lzip -
 
 mkdir -p build
 
+cc ${CFLAGS} -c -o build/arrow.o src/arrow.c
+cc ${CFLAGS} -O2 -c -o build/bitmap.o src/bitmap.c
+cc ${CFLAGS} -c -o build/defparse.o src/defparse.c
+cc ${CFLAGS} -c -o build/defzip.o src/defzip.c
+cc ${CFLAGS} -O2 -c -o build/dindex.o src/dindex.c
+cc ${CFLAGS} -c -o build/dpatch.o src/dpatch.c
+cc ${CFLAGS} -c -o build/epoch.o src/epoch.c
+cc ${CFLAGS} -O2 -c -o build/escape.o src/escape.c
+cc ${CFLAGS} -c -o build/evloop.o src/evloop.c
+cc ${CFLAGS} -c -o build/facets.o src/facets.c
+cc ${CFLAGS} -c -o build/fst.o src/fst.c
+cc ${CFLAGS} -c -o build/fuzzy.o src/fuzzy.c
+cc ${CFLAGS} -O2 -c -o build/hist.o src/hist.c
+cc ${CFLAGS} -c -o build/json.o src/json.c
+cc ${CFLAGS} -c -o build/mapfile.o src/mapfile.c
+cc ${CFLAGS} -O2 -c -o build/metrics.o src/metrics.c
+cc ${CFLAGS} -c -o build/obuf.o src/obuf.c
+cc ${CFLAGS} -c -o build/pool.o src/pool.c
+cc ${CFLAGS} -c -o build/sarray.o src/sarray.c
+cc ${CFLAGS} -O2 -c -o build/segment.o src/segment.c
+cc ${CFLAGS} -c -o build/sqldict.o src/sqldict.c
 cc ${CFLAGS} -c -o build/sqlite.o src/sqlite.c
-cc ${CFLAGS} -c -o build/xlsx.o src/xlsx.c
-cc ${CFLAGS} -c -o build/xml.o src/xml.c
+cc ${CFLAGS} -c -o build/synth.o src/synth.c
+cc ${CFLAGS} -O2 -c -o build/trace.o src/trace.c
+cc ${CFLAGS} -c -o build/wildcard.o src/wildcard.c
+cc ${CFLAGS} -O2 -c -o build/xlsx.o src/xlsx.c
+cc ${CFLAGS} -O2 -c -o build/xml.o src/xml.c
+cc ${CFLAGS} -c -o build/zhd.o src/zhd.c
 
-cc ${CFLAGS} -D__XLSX_STANDALONE__ -o build/xlsx src/cmd.c build/{xml,xlsx}.o
-cc ${CFLAGS} -D__ZXML_STANDALONE__ -o build/zxml src/cmd.c build/xml.o
-cc ${CFLAGS} -D__XML_STANDALONE__ -o build/xml src/cmd.c build/xml.o
+cc ${CFLAGS} -D__XLSX_STANDALONE__ -o build/xlsx src/cmd.c build/{xml,trace,xlsx,escape,obuf}.o
+cc ${CFLAGS} -D__ZXML_STANDALONE__ -o build/zxml src/cmd.c build/{xml,trace}.o
+cc ${CFLAGS} -D__XML_STANDALONE__ -o build/xml src/cmd.c build/{xml,trace}.o
 
-cc ${CFLAGS} -o build/xldict src/xldict.c build/{xml,xlsx}.o
+cc ${CFLAGS} -o build/xldict src/xldict.c build/{xml,trace,xlsx,dindex,mapfile,bitmap,facets,fst,fuzzy,sarray,sqldict,sqlite,wildcard,defzip,obuf,pool}.o -lpthread
+cc ${CFLAGS} -O2 -o build/zhseg src/zhseg.c build/{xml,trace,xlsx,dindex,mapfile,segment,obuf}.o
+cc ${CFLAGS} -o build/zhdictd src/zhdictd.c build/{xml,trace,xlsx,dindex,mapfile,evloop,epoch,escape,json,obuf,pool}.o -lpthread
 
-cc ${CFLAGS} -o build/conv src/conv.c build/{xml,xlsx,sqlite}.o
+cc ${CFLAGS} -o build/conv src/conv.c build/{xml,trace,xlsx,sqlite,metrics,defparse,dindex,mapfile,defzip,obuf}.o
+cc ${CFLAGS} -o build/xlsx2sql src/xlsx2sql.c build/{xml,trace,xlsx,sqlite,metrics}.o
+cc ${CFLAGS} -o build/dictdiff src/dictdiff.c build/{xml,trace,xlsx,sqlite,sqldict,dpatch,dindex,mapfile,defzip,obuf}.o
+cc ${CFLAGS} -o build/xlsx2zhd src/xlsx2zhd.c build/{xml,trace,xlsx,dindex,mapfile,zhd,obuf}.o
+cc ${CFLAGS} -o build/xlsx2arrow src/xlsx2arrow.c build/{xml,trace,xlsx,arrow,mapfile,metrics,obuf}.o
+
+cc ${CFLAGS} -O2 -o build/bench_micro src/bench_micro.c build/{xml,trace,xlsx,metrics,obuf}.o
+cc ${CFLAGS} -O2 -o build/bench_query src/bench_query.c build/{xml,trace,xlsx,dindex,mapfile,metrics,hist,synth}.o
+cc ${CFLAGS} -O2 -o build/genxlsx src/genxlsx.c build/{metrics,obuf}.o
@@ -0,0 +1,52 @@
+/* ********************************************************** */
+/* -*- arrow.h -*- Apache Arrow IPC file writer           -*- */
+/* ********************************************************** */
+/* Tyler Besselman (C) October 2026                           */
+/* ********************************************************** */
+
+#ifndef __ARROW__
+#define __ARROW__ 1
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <xlsx.h>
+
+// Magic at the start and end of an Arrow IPC file (Feather v2 is the same format).
+#define ARROW_MAGIC "ARROW1"
+
+// Default number of rows in each record batch.
+#define ARROW_BATCH_ROWS 65536
+
+// Arrow array types we write. Each column gets the narrowest type that holds every value in it.
+enum arrow_type {
+    // Every value is an integer.
+    ARROW_INT64,
+
+    // Every value is a number.
+    ARROW_FLOAT64,
+
+    // Anything else (numbers in these columns are written as text).
+    ARROW_UTF8
+};
+
+// What was written.
+struct arrow_stats {
+    size_t rows;
+    size_t batches;
+
+    uint64_t bytes;
+};
+
+// Get the name of an Arrow type.
+extern const char *arrow_type_name(enum arrow_type type);
+
+// Pick the type for a column of a document (ignoring the first row, which names the columns).
+extern enum arrow_type arrow_infer(struct xlsx *doc, size_t col);
+
+// Write every row of a document after the first (which names the columns) to an Arrow IPC file at `path`,
+//   in record batches of at most `batch_rows` rows. Every column is nullable, and empty cells are nulls.
+// Buffers are 8 byte aligned in the file, so readers can map it and use the arrays in place. Returns non-zero on failure.
+extern int arrow_write(const char *path, struct xlsx *doc, size_t batch_rows, struct arrow_stats *stats);
+
+#endif /* !defined(__ARROW__) */
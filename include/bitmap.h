@@ -0,0 +1,65 @@
+/* ********************************************************** */
+/* -*- bitmap.h -*- Compressed bitmaps of 32 bit values   -*- */
+/* ********************************************************** */
+/* Tyler Besselman (C) October 2026                           */
+/* ********************************************************** */
+
+#ifndef __BITMAP__
+#define __BITMAP__ 1
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Values are split into containers by their high 16 bits (like roaring bitmaps).
+// Containers with at most this many values are sorted arrays of the low 16 bits, and anything bigger is a plain bitset.
+#define BITMAP_ARRAY_MAX 4096
+
+// Number of 64 bit words in a bitset container.
+#define BITMAP_WORDS (0x10000 / 64)
+
+// Values sharing the same high 16 bits. Exactly one of `array` or `bits` is set.
+struct bitmap_container {
+    uint16_t key;
+    uint32_t card;
+
+    uint16_t *array;
+    uint64_t *bits;
+};
+
+// A set of 32 bit values. Containers are sorted by key.
+struct bitmap {
+    struct bitmap_container *cs;
+    uint32_t n;
+    uint32_t cap;
+};
+
+// Initializer for an empty bitmap.
+#define BITMAP_INIT ((struct bitmap){ .cs = NULL, .n = 0, .cap = 0 })
+
+// Add a value to a bitmap (adding values in increasing order is fastest). Returns non-zero on failure.
+extern int bitmap_add(struct bitmap *bm, uint32_t v);
+
+// Check if a bitmap has a value.
+extern bool bitmap_contains(const struct bitmap *bm, uint32_t v);
+
+// Count the values in a bitmap.
+extern uint64_t bitmap_card(const struct bitmap *bm);
+
+// Fill in `out` (which must be empty) with the values in both `a` and `b`. Returns non-zero on failure.
+extern int bitmap_and(const struct bitmap *a, const struct bitmap *b, struct bitmap *out);
+
+// Fill in `out` (which must be empty) with the values in either `a` or `b`. Returns non-zero on failure.
+extern int bitmap_or(const struct bitmap *a, const struct bitmap *b, struct bitmap *out);
+
+// Fill in `out` (which must be empty) with a copy of `bm`. Returns non-zero on failure.
+extern int bitmap_copy(const struct bitmap *bm, struct bitmap *out);
+
+// Perform a block on each value in a bitmap in increasing order. If `blk` returns any non-zero value, stop early.
+// Returns the number of values visited.
+extern size_t bitmap_foreach(const struct bitmap *bm, int (^blk)(uint32_t v));
+
+// Free the memory held by a bitmap, leaving it empty.
+extern void bitmap_free(struct bitmap *bm);
+
+#endif /* !defined(__BITMAP__) */
@@ -0,0 +1,56 @@
+/* ********************************************************** */
+/* -*- defparse.h -*- Structured definition parsing       -*- */
+/* ********************************************************** */
+/* Tyler Besselman (C) October 2026                           */
+/* ********************************************************** */
+
+#ifndef __DEFPARSE__
+#define __DEFPARSE__ 1
+
+#include <stddef.h>
+#include <stdint.h>
+
+// A run of bytes inside the definition being parsed (not `\0` terminated).
+struct defparse_span {
+    const char *str;
+    uint32_t len;
+};
+
+// What a piece of a definition is.
+enum defparse_kind {
+    // A single numbered sense (or the whole definition if it isn't numbered), without its number.
+    DEFPARSE_SENSE,
+
+    // An example from a "如：「...」、「...」" list, without the quotes.
+    DEFPARSE_EXAMPLE,
+
+    // A 《source》, with the quote following it (if there is one).
+    DEFPARSE_CITATION,
+
+    // Any other 「quoted」 word (like in "見「...」條" or "同「...」").
+    DEFPARSE_XREF
+};
+
+// A piece of a definition. Every span points into the definition itself.
+struct defparse_item {
+    enum defparse_kind kind;
+
+    // Which sense this is (or belongs to), counting from 1.
+    uint32_t sense;
+
+    // Part of speech tag for the sense (like "名" from "[名]"). Empty if there isn't one.
+    struct defparse_span pos;
+
+    // The sense, example, quote, or word.
+    struct defparse_span text;
+
+    // The source of a citation (like "史記．卷一"). Empty for anything else.
+    struct defparse_span source;
+};
+
+// Split `len` bytes of a definition into senses, examples, citations, and cross-references in a single pass.
+// Each sense comes before anything inside it, and everything comes in the order it appears in the definition.
+// Nothing is allocated or copied. If `blk` returns any non-zero value, stop early. Returns the number of senses.
+extern size_t defparse(const char *def, size_t len, int (^blk)(const struct defparse_item *item));
+
+#endif /* !defined(__DEFPARSE__) */
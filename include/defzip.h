@@ -0,0 +1,109 @@
+/* ********************************************************** */
+/* -*- defzip.h -*- Static-model definition compression   -*- */
+/* ********************************************************** */
+/* Tyler Besselman (C) October 2026                           */
+/* ********************************************************** */
+
+#ifndef __DEFZIP__
+#define __DEFZIP__ 1
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <sqlite.h>
+#include <obuf.h>
+
+// Enable debug messages
+#define DEBUG_DEFZIP 1
+
+// Magic bytes and version at the start of a saved model. Bump the version if the layout changes.
+#define DEFZIP_MAGIC "ZHDZ"
+#define DEFZIP_VERSION 1
+
+// Longest phrase (in codepoints) in the shared dictionary, and the most phrases we keep.
+#define DEFZIP_PHRASE_LEN 3
+#define DEFZIP_MAX_PHRASES 8192
+
+// Fewest times a phrase has to show up in the training text to be considered.
+#define DEFZIP_MIN_COUNT 16
+
+// Longest code, and the number of bits decoded with a single table lookup.
+// Codes are limited so any symbol (plus an escaped codepoint) fits in one refill of the bit buffer.
+#define DEFZIP_MAX_CODE 24
+#define DEFZIP_TABLE_BITS 11
+
+// Symbol 0 is an escape, followed by a raw 21 bit codepoint (or `DEFZIP_RAW_BYTE | byte` for invalid UTF-8).
+#define DEFZIP_ESCAPE 0
+#define DEFZIP_ESCAPE_BITS 21
+#define DEFZIP_RAW_BYTE 0x110000
+
+// Where the model is kept in a database, and the SQL function which decompresses a value with it.
+// The function passes anything which isn't a blob through, so it works on uncompressed columns too.
+#define DEFZIP_SQL_TABLE "壓縮模型"
+#define DEFZIP_SQL_FIELD "模型"
+#define DEFZIP_SQL_FUNC  "defzip_decode"
+
+// Hash table slot mapping a phrase (up to `DEFZIP_PHRASE_LEN` packed codepoints) to its symbol. Slots are empty when `key` is 0.
+struct defzip_slot {
+    uint64_t key;
+    uint32_t sym;
+};
+
+// A static model: a shared dictionary of phrases (and single codepoints) with a canonical Huffman code for each.
+// Every string is coded on its own, so each one can be decoded without any of the others.
+struct defzip {
+    // Bytes of each symbol are `pool[offs[i]]` through `pool[offs[i] + lens[i] - 1]` (the escape has none).
+    char *pool;
+    uint32_t *offs;
+    uint8_t *lens;
+    uint32_t nsyms;
+
+    // Code length and (right aligned) code of each symbol.
+    uint8_t *code_lens;
+    uint32_t *codes;
+    uint32_t max_code;
+
+    // Canonical decoding: codes of length `l` start at `first_code[l]`, and there are `count[l]` of them,
+    //   for symbols `sorted[first_index[l]]` through `sorted[first_index[l] + count[l] - 1]`.
+    uint32_t first_code[DEFZIP_MAX_CODE + 1];
+    uint32_t first_index[DEFZIP_MAX_CODE + 1];
+    uint32_t count[DEFZIP_MAX_CODE + 1];
+    uint32_t *sorted;
+
+    // Codes up to `DEFZIP_TABLE_BITS` long are decoded here, indexed by the next bits of input.
+    // Entries are `(sym << 8) | length`, or 0 if the code is longer than the table.
+    uint32_t *table;
+
+    // Open addressing (linear probing) hash table over phrases used for encoding. `nslots` is a power of 2.
+    struct defzip_slot *slots;
+    uint32_t nslots;
+};
+
+// Train a model on `n` strings. Returns NULL on failure.
+extern struct defzip *defzip_train(const char *const *strs, size_t n);
+
+// Compress `len` bytes of a string, appending the result to `out`. Returns non-zero on failure.
+extern int defzip_encode(const struct defzip *dz, const char *str, size_t len, struct obuf *out);
+
+// Decompress `size` bytes of data from `defzip_encode`, returning a `\0` terminated string to be freed by the caller.
+// The length of the string is put in `len`. Returns NULL if the data is malformed (or on failure).
+extern char *defzip_decode(const struct defzip *dz, const uint8_t *data, size_t size, size_t *len);
+
+// Append a model to `out` in the format read by `defzip_load`. Returns non-zero on failure.
+extern int defzip_save(const struct defzip *dz, struct obuf *out);
+
+// Read a model saved by `defzip_save`. Returns NULL on failure.
+extern struct defzip *defzip_load(const uint8_t *data, size_t size);
+
+// Create the model table in a database and store a model in it. Returns non-zero on failure.
+extern int defzip_sqlite_store(sqlite3 *db, const struct defzip *dz);
+
+// Load the model from a database (if it has one) and register `DEFZIP_SQL_FUNC` with it, which then owns the model.
+// `found` is set if the database has a model. Returns non-zero on failure.
+extern int defzip_sqlite_attach(sqlite3 *db, bool *found);
+
+// Free a model.
+extern void defzip_free(struct defzip *dz);
+
+#endif /* !defined(__DEFZIP__) */
@@ -0,0 +1,175 @@
+/* ********************************************************** */
+/* -*- dindex.h -*- In-memory dictionary lookup index     -*- */
+/* ********************************************************** */
+/* Tyler Besselman (C) October 2026                           */
+/* ********************************************************** */
+
+#ifndef __DINDEX__
+#define __DINDEX__ 1
+
+#include <sys/types.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include <mapfile.h>
+#include <xlsx.h>
+
+// Enable debug messages
+#define DEBUG_DINDEX 1
+
+// Offset value used for missing strings in the pool.
+#define DINDEX_NONE UINT32_MAX
+
+// Magic bytes and version at the start of index files. Bump the version if the layout or hash changes.
+#define DINDEX_MAGIC "ZHDINDEX"
+#define DINDEX_VERSION 1
+
+// Stroke count used for characters we have no stroke count for (sorts after everything real).
+#define DINDEX_STROKES_UNKNOWN 64
+
+// Orderings for prefix completions.
+enum dindex_order {
+    // Codepoint order (the same as the order of `words`)
+    DINDEX_ORDER_LEX,
+
+    // Total stroke count, then codepoint order
+    DINDEX_ORDER_STROKES
+};
+
+// A single dictionary entry (one row of the source document).
+struct dindex_entry {
+    // Offset of the word in the string pool.
+    uint32_t word;
+
+    // Offset of the definition in the string pool (DINDEX_NONE if missing).
+    uint32_t def;
+
+    // Row number of this entry in the source document.
+    uint32_t row;
+};
+
+// A unique word. Some words have multiple entries (e.g. multiple pronunciations).
+struct dindex_word {
+    // Offset and length (in bytes) of the word in the string pool.
+    uint32_t str;
+    uint32_t len;
+
+    // Entries for this word are `rows[first]` through `rows[first + count - 1]`.
+    uint32_t first;
+    uint32_t count;
+
+    // Total stroke count of all characters in this word.
+    uint32_t strokes;
+};
+
+// Hash table slot. Slots are empty when `word` is 0; otherwise it is the word index + 1.
+struct dindex_slot {
+    uint32_t hash;
+    uint32_t word;
+};
+
+// A node in the prefix trie. Each edge is a single codepoint.
+// Since words are sorted, all words starting with the prefix for a node are contiguous.
+struct dindex_node {
+    // Codepoint on the edge leading to this node.
+    uint32_t cp;
+
+    // Children are `nodes[child]` through `nodes[child + nchild - 1]`, sorted by codepoint.
+    uint32_t child;
+    uint32_t nchild;
+
+    // Words with this prefix are `words[lo]` through `words[hi - 1]`.
+    uint32_t lo;
+    uint32_t hi;
+};
+
+// Everything here is a flat array, and strings are stored as offsets into a single pool.
+struct dindex {
+    // All strings, each terminated with a `\0`.
+    const char *pool;
+    size_t pool_size;
+
+    // Dictionary entries in document order.
+    const struct dindex_entry *entries;
+    uint32_t nentries;
+
+    // Unique words, sorted in codepoint order.
+    const struct dindex_word *words;
+    uint32_t nwords;
+
+    // Entry indicies grouped by word.
+    const uint32_t *rows;
+
+    // Open addressing (linear probing) hash table over words. `nslots` is a power of 2.
+    const struct dindex_slot *slots;
+    uint32_t nslots;
+
+    // Prefix trie over words. The root is `nodes[0]`.
+    const struct dindex_node *nodes;
+    uint32_t nnodes;
+
+    // If this index was loaded from a file, the mapping everything above points into.
+    void *map;
+    size_t map_size;
+};
+
+// Header at the start of an index file. Everything after this is a section at a given offset from the start of the file.
+// Since all references inside the index are offsets, the file can be mapped anywhere and used directly.
+struct dindex_header {
+    struct mapfile_header file;
+
+    // Element counts.
+    uint32_t nentries;
+    uint32_t nwords;
+    uint32_t nslots;
+    uint32_t nnodes;
+
+    // Offsets and sizes of each section.
+    struct mapfile_section pool, entries, words, rows, slots, nodes;
+};
+
+// Get a string from the pool of an index.
+#define dindex_str(idx, off) (&(idx)->pool[(off)])
+
+// Hash `len` bytes of a UTF-8 string.
+extern uint64_t dindex_hash(const char *str, size_t len);
+
+// Build an index over the words in column `names` with definitions from column `defs`.
+// Stroke counts of single characters are taken from column `strokes` (if it is not negative).
+// Row 0 is assumed to hold column headers. The index holds copies of all strings it needs.
+extern struct dindex *dindex_build(struct xlsx *doc, size_t names, size_t defs, off_t strokes);
+
+// Find a word, returning NULL if it isn't in the dictionary.
+extern const struct dindex_word *dindex_find(const struct dindex *idx, const char *word, size_t len);
+
+// Perform a block on each entry for an exact word. Returns the number of matching entries.
+// If `blk` returns any non-zero value, stop early.
+extern size_t dindex_lookup(const struct dindex *idx, const char *word, int (^blk)(const struct dindex_entry *entry));
+
+// Perform a block on up to `k` words starting with `prefix` in the given order.
+// If `blk` returns any non-zero value, stop early. Returns the total number of words with this prefix.
+extern size_t dindex_prefix(const struct dindex *idx, const char *prefix, enum dindex_order order, size_t k, int (^blk)(const struct dindex_word *word));
+
+// Write an index to a file at `path`. The file is written beside the destination and renamed into place.
+// Returns non-zero on failure.
+extern int dindex_save(const struct dindex *idx, const char *path);
+
+// Check if the file at `path` looks like an index file (it starts with `DINDEX_MAGIC`).
+extern bool dindex_is_file(const char *path);
+
+// Map an index file written by `dindex_save`. Every offset and index inside it is bounds checked, so this reads the
+//   whole file once. Returns NULL on failure.
+extern struct dindex *dindex_open(const char *path);
+
+// Build an index from a dictionary workbook, finding the word, definition, and stroke count columns by their headers.
+// Column headers are printed if `verbose` is set. Returns NULL on failure.
+extern struct dindex *dindex_load_xlsx(const char *path, bool verbose);
+
+// Open a prebuilt index file if that's what `path` is, otherwise build an index from the workbook at `path`.
+extern struct dindex *dindex_load(const char *path, bool verbose);
+
+// Free an index.
+extern void dindex_free(struct dindex *idx);
+
+#endif /* !defined(__DINDEX__) */
@@ -0,0 +1,97 @@
+/* ********************************************************** */
+/* -*- dpatch.h -*- Binary patches between dictionaries   -*- */
+/* ********************************************************** */
+/* Tyler Besselman (C) October 2026                           */
+/* ********************************************************** */
+
+#ifndef __DPATCH__
+#define __DPATCH__ 1
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <sqlite.h>
+#include <obuf.h>
+
+// Enable debug messages
+#define DEBUG_DPATCH 1
+
+// Magic bytes and version at the start of a patch. Bump the version if the encoding changes.
+#define DPATCH_MAGIC "ZHDPATCH"
+#define DPATCH_VERSION 1
+
+// Column entries are matched by between snapshots.
+#define DPATCH_KEY "字詞號"
+
+// Operations in a patch. Each one is a byte, followed by the change in key from the last operation.
+#define DPATCH_OP_DELETE 'D'    // Old row hash
+#define DPATCH_OP_INSERT 'I'    // Every value but the key
+#define DPATCH_OP_UPDATE 'U'    // Old row hash, then the number of changed columns and each (column, value)
+
+// Types of values in a snapshot (and tags for values in a patch).
+enum dpatch_type {
+    DPATCH_NULL,
+    DPATCH_INT,
+    DPATCH_STR
+};
+
+// A single value. Strings are `len` bytes at offset `ival` in the snapshot's pool.
+struct dpatch_value {
+    int64_t ival;
+    uint32_t len;
+    uint8_t type;
+};
+
+// Rows of a dictionary (a workbook, or a database from xlsx2sql) in order of key.
+// Column names are as xlsx2sql would name them, and columns with nothing in them are left out (like xlsx2sql does).
+struct dsnap {
+    char **cols;
+    size_t ncols;
+
+    // Index of the key column.
+    size_t key;
+
+    // Values of row `i` are `values[order[i].row * ncols]` through `values[order[i].row * ncols + ncols - 1]`.
+    struct dpatch_value *values;
+    size_t nrows;
+
+    struct dsnap_key {
+        int64_t key;
+        uint32_t row;
+    } *order;
+
+    struct obuf pool;
+};
+
+// Counts of what a patch does.
+struct dpatch_stats {
+    size_t inserts;
+    size_t deletes;
+    size_t updates;
+
+    // Number of columns changed across all updates.
+    size_t fields;
+};
+
+// Get a string value from a snapshot.
+#define dsnap_str(snap, v) (&(snap)->pool.data[(v)->ival])
+
+// Load a snapshot of a workbook or database. Returns NULL on failure.
+extern struct dsnap *dsnap_load(const char *path);
+
+// Free a snapshot.
+extern void dsnap_free(struct dsnap *snap);
+
+// Append a patch turning `old` into `new` to `out`, filling in `stats`. Both need the same columns. Returns non-zero on failure.
+extern int dpatch_diff(const struct dsnap *old, const struct dsnap *new, struct obuf *out, struct dpatch_stats *stats);
+
+// Apply a patch to a database (from xlsx2sql) in a single transaction, filling in `stats`.
+// Each row a patch changes is checked against what it was diffed from first, and nothing is changed if any of them differ.
+// Only rows the patch touches are read, so this takes time in proportion to the size of the patch. Returns non-zero on failure.
+// The result has the same entries (by `DPATCH_KEY`) as a fresh conversion of the new snapshot, but isn't identical to one:
+//   row ids (the `id` column from xlsx2sql) aren't part of a patch, so inserted rows get new ids rather than their sheet row,
+//   and rows keep their ids when rows before them are inserted or deleted.
+extern int dpatch_apply(sqlite3 *db, const uint8_t *patch, size_t size, struct dpatch_stats *stats);
+
+#endif /* !defined(__DPATCH__) */
@@ -0,0 +1,61 @@
+/* ********************************************************** */
+/* -*- epoch.h -*- Epoch based reclamation for readers    -*- */
+/* ********************************************************** */
+/* Tyler Besselman (C) October 2026                           */
+/* ********************************************************** */
+
+#ifndef __EPOCH__
+#define __EPOCH__ 1
+
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stddef.h>
+
+// Size of a cache line. Each reader's slot gets its own, so readers never write to a shared line.
+#define EPOCH_LINE 64
+
+// What a single reader is doing.
+struct epoch_reader {
+    // The epoch this reader entered in, or 0 if it isn't reading.
+    _Atomic uint64_t epoch;
+
+    char pad[EPOCH_LINE - sizeof(uint64_t)];
+};
+
+// A fixed set of readers of data which a writer replaces (by atomically swapping a pointer) while they keep going.
+// Readers never wait or take a lock. A writer swaps in new data, then calls `epoch_synchronize` before freeing the old data,
+//   which waits until every reader that might still see the old data has left.
+struct epoch {
+    // The current epoch (never 0).
+    _Atomic uint64_t now;
+
+    struct epoch_reader *readers;
+    size_t nreaders;
+};
+
+// Set up for `nreaders` readers, numbered from 0. Returns non-zero on failure.
+extern int epoch_init(struct epoch *e, size_t nreaders);
+
+// Start reading as reader `reader`. Shared pointers must be loaded after this, and anything loaded is safe to use until `epoch_exit`.
+// A reader can't enter again before exiting.
+static inline void epoch_enter(struct epoch *e, size_t reader)
+{
+    // Seeing the newest epoch means seeing whatever was swapped in before it started, hence acquire.
+    atomic_store_explicit(&e->readers[reader].epoch, atomic_load_explicit(&e->now, memory_order_acquire), memory_order_relaxed);
+
+    // Make sure any writer sees that we've entered before we load anything it might free.
+    atomic_thread_fence(memory_order_seq_cst);
+}
+
+// Stop reading. Nothing loaded since `epoch_enter` can be used after this.
+static inline void epoch_exit(struct epoch *e, size_t reader)
+{ atomic_store_explicit(&e->readers[reader].epoch, 0, memory_order_release); }
+
+// Wait until no reader can still be using anything unpublished before this call (i.e. every reader which entered before
+//   has exited). Readers which enter in the meantime aren't waited for. Only one thread should call this at a time.
+extern void epoch_synchronize(struct epoch *e);
+
+// Free the reader slots.
+extern void epoch_free(struct epoch *e);
+
+#endif /* !defined(__EPOCH__) */
@@ -0,0 +1,33 @@
+/* ********************************************************** */
+/* -*- escape.h -*- Escaping text fields for CSV/TSV/JSON -*- */
+/* ********************************************************** */
+/* Tyler Besselman (C) October 2026                           */
+/* ********************************************************** */
+
+#ifndef __ESCAPE__
+#define __ESCAPE__ 1
+
+#include <stddef.h>
+
+#include <obuf.h>
+
+// Ways a field of text can be written out.
+enum escape_format {
+    // RFC 4180: fields with `,`, `"`, or line breaks are quoted, and quotes are doubled.
+    ESCAPE_CSV,
+
+    // Tabs, line breaks, and backslashes are written as `\t`, `\n`, `\r`, and `\\` (fields are never quoted).
+    ESCAPE_TSV,
+
+    // A quoted JSON string.
+    ESCAPE_JSON
+};
+
+// Get the length of the longest prefix of `len` bytes at `str` which can be written as is in a format.
+// Text is checked 8 bytes at a time, so long runs of plain text (which is nearly everything) are cheap to skip over.
+extern size_t escape_span(enum escape_format fmt, const char *str, size_t len);
+
+// Append `len` bytes at `str` to a buffer as a single field in a format. Returns non-zero on failure.
+extern int escape_field(struct obuf *out, enum escape_format fmt, const char *str, size_t len);
+
+#endif /* !defined(__ESCAPE__) */
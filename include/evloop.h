@@ -0,0 +1,52 @@
+/* ********************************************************** */
+/* -*- evloop.h -*- Readiness based event loop            -*- */
+/* ********************************************************** */
+/* Tyler Besselman (C) October 2026                           */
+/* ********************************************************** */
+
+#ifndef __EVLOOP__
+#define __EVLOOP__ 1
+
+#include <stddef.h>
+
+// Use epoll where we have it, otherwise fall back to poll.
+#if defined(__linux__) && !defined(EVLOOP_USE_POLL)
+    #define EVLOOP_USE_EPOLL 1
+#endif
+
+// Events we can wait for (or which happened).
+#define EVLOOP_READ     0x1
+#define EVLOOP_WRITE    0x2
+
+// Reported along with READ when the other side hung up or the descriptor has an error.
+#define EVLOOP_HUP      0x4
+
+// A set of file descriptors to wait on. Each loop should only be used by one thread at a time.
+struct evloop;
+
+// A file descriptor which is ready. Only the data pointer it was registered with is given back.
+struct evloop_event {
+    unsigned int events;
+    void *data;
+};
+
+// Create an empty event loop. Returns NULL on failure.
+extern struct evloop *evloop_create(void);
+
+// Start waiting for `events` on `fd`. Returns non-zero on failure.
+extern int evloop_add(struct evloop *loop, int fd, unsigned int events, void *data);
+
+// Change the events we're waiting for on `fd`. Returns non-zero on failure.
+extern int evloop_mod(struct evloop *loop, int fd, unsigned int events, void *data);
+
+// Stop waiting on `fd`. This must be done before closing it. Returns non-zero on failure.
+extern int evloop_del(struct evloop *loop, int fd);
+
+// Wait up to `timeout` milliseconds (forever if negative) for up to `max` descriptors to become ready.
+// Returns the number of events stored in `events`, or -1 on failure.
+extern int evloop_wait(struct evloop *loop, struct evloop_event *events, int max, int timeout);
+
+// Free an event loop. This doesn't close any registered descriptors.
+extern void evloop_free(struct evloop *loop);
+
+#endif /* !defined(__EVLOOP__) */
@@ -0,0 +1,75 @@
+/* ********************************************************** */
+/* -*- facets.h -*- Bitmap indexes over character data    -*- */
+/* ********************************************************** */
+/* Tyler Besselman (C) October 2026                           */
+/* ********************************************************** */
+
+#ifndef __FACETS__
+#define __FACETS__ 1
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <bitmap.h>
+#include <xlsx.h>
+
+// Enable debug messages
+#define DEBUG_FACETS 1
+
+// Stroke counts at or above this aren't indexed.
+#define FACETS_MAX_STROKES 64
+
+// Longest pinyin initial or final we keep (in bytes, including the `\0`).
+#define FACETS_SOUND_LEN 16
+
+// Longest single value in a filter (in bytes). Every value we index is far shorter.
+#define FACETS_VALUE_MAX 64
+
+// A string valued attribute: a bitmap of characters for each distinct value (sorted by value).
+struct facets_attr {
+    char **keys;
+    struct bitmap *maps;
+
+    uint32_t n;
+    uint32_t cap;
+};
+
+// Bitmap indexes over every single character entry in a dictionary.
+// Bitmaps hold character ids, which are positions in `chars` (and `rows`).
+struct facets {
+    // Each character (as UTF-8), and the document row it came from.
+    char (*chars)[5];
+    uint32_t *rows;
+    uint32_t n;
+
+    // Every character.
+    struct bitmap all;
+
+    // Characters by radical, and by the initial and final of their pinyin (without tones, with 'ü' for 'v').
+    // Finals are spelled as sounded, so "xué" has the final "üe".
+    struct facets_attr radicals;
+    struct facets_attr initials;
+    struct facets_attr finals;
+
+    // Characters by total stroke count, and by strokes outside the radical.
+    struct bitmap strokes[FACETS_MAX_STROKES];
+    struct bitmap xstrokes[FACETS_MAX_STROKES];
+};
+
+// Build bitmap indexes over the single characters in a dictionary workbook (with column headers in row 0).
+// Only the word column (字詞名) is required. Returns NULL on failure.
+extern struct facets *facets_build(struct xlsx *doc);
+
+// Build bitmap indexes from the workbook at `path`. Returns NULL on failure.
+extern struct facets *facets_load(const char *path);
+
+// Fill in `out` (which must be empty) with every character matching a filter.
+// A filter is a list of space separated terms, all of which must match. Each term is `attr:value`, where `value` may be
+//   a comma separated list of values (any of which may match), and attributes are `rad`, `strokes`, `xstrokes`,
+//   `initial`, and `final`. Stroke counts may be ranges like `8-10`. Returns non-zero on failure.
+extern int facets_filter(const struct facets *fc, const char *filter, struct bitmap *out);
+
+// Free bitmap indexes.
+extern void facets_free(struct facets *fc);
+
+#endif /* !defined(__FACETS__) */
@@ -0,0 +1,30 @@
+/* ********************************************************** */
+/* -*- fnv.h -*- FNV-1a hashing                           -*- */
+/* ********************************************************** */
+/* Tyler Besselman (C) October 2026                           */
+/* ********************************************************** */
+
+#ifndef __FNV__
+#define __FNV__ 1
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Starting value for a 32 bit FNV-1a hash.
+#define FNV_INIT 2166136261U
+
+// Continue a 32 bit FNV-1a hash `h` over `len` bytes at `data` (start from `FNV_INIT`).
+static inline uint32_t fnv1a(uint32_t h, const void *data, size_t len)
+{
+    const uint8_t *bytes = data;
+
+    for (size_t i = 0; i < len; i++)
+    {
+        h ^= bytes[i];
+        h *= 16777619U;
+    }
+
+    return h;
+}
+
+#endif /* !defined(__FNV__) */
@@ -0,0 +1,128 @@
+/* ********************************************************** */
+/* -*- fst.h -*- Finite state transducer over words       -*- */
+/* ********************************************************** */
+/* Tyler Besselman (C) October 2026                           */
+/* ********************************************************** */
+
+#ifndef __FST__
+#define __FST__ 1
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <dindex.h>
+#include <mapfile.h>
+#include <obuf.h>
+
+// Enable debug messages
+#define DEBUG_FST 1
+
+// Magic bytes and version at the start of FST files. Bump the version if the node encoding changes.
+#define FST_MAGIC "ZHDFST01"
+#define FST_VERSION 3
+
+// Node flags (the first byte of each node).
+#define FST_FINAL   0x01    // A key ends here
+#define FST_FOUT    0x02    // The final output is not 0 (a varint follows)
+#define FST_ONE     0x04    // Exactly one transition, stored compactly
+#define FST_OUT     0x08    // (FST_ONE) The transition output is not 0 (a varint follows the input byte)
+#define FST_NEXT    0x10    // (FST_ONE) The target is the node right after this one (otherwise a varint distance follows)
+#define FST_TABLE   0x20    // Two or more transitions, stored as fixed width arrays
+
+// A minimal acyclic transducer mapping byte strings to 64 bit values.
+// Each transition has an output and a key's value is the sum of outputs along its path (plus the final output of the node it ends at).
+// Nodes are stored parents first, and every transition points forward by a distance from the end of its node,
+//   so a chain of single transitions is only 2 bytes per key byte. Everything is used directly from the bytes (or a mapping of them).
+struct fst {
+    const uint8_t *data;
+    size_t size;
+
+    // Offset of the root node, and the number of keys.
+    uint64_t root;
+    uint64_t nkeys;
+
+    // From `fst_build`, where each word maps to its ordinal (its place in the index's sorted words), the rest of the word table:
+    //   entries for word `w` are `rows[first[w]]` through `rows[first[w + 1] - 1]` of the index, which has `nentries` entries.
+    // These are NULL for FSTs made with a builder directly.
+    const uint32_t *first;
+    const uint16_t *strokes;
+    uint32_t nentries;
+
+    // Hash of the index's words and how many entries each has, so we can tell which index this goes with.
+    uint64_t words_hash;
+
+    // Built in memory (freed with the FST).
+    uint8_t *buf;
+    void *words_buf;
+
+    // If this was loaded from a file, the mapping everything above points into.
+    void *map;
+    size_t map_size;
+};
+
+// Header at the start of an FST file.
+struct fst_header {
+    struct mapfile_header file;
+
+    uint64_t root;
+    uint64_t nkeys;
+    uint64_t nentries;
+    uint64_t words_hash;
+
+    // The word table sections are empty if the FST doesn't have one.
+    struct mapfile_section data, first, strokes;
+};
+
+// Builds an FST from keys given in sorted order. Nodes are frozen (and shared with any identical node) as soon as
+//   no later key can reach them, so building takes time linear in the total key length.
+struct fst_builder;
+
+// Make a new builder. Returns NULL on failure.
+extern struct fst_builder *fst_builder_new(void);
+
+// Add a key. Keys must be added in strictly increasing (byte) order. Returns non-zero on failure.
+extern int fst_builder_add(struct fst_builder *b, const char *key, size_t len, uint64_t value);
+
+// Finish building and free the builder. Returns NULL on failure.
+extern struct fst *fst_builder_finish(struct fst_builder *b);
+
+// Free a builder without finishing it.
+extern void fst_builder_free(struct fst_builder *b);
+
+// Build an FST over the words of an index, mapping each word to its ordinal, with a word table alongside.
+// Together with the index's entries, this does everything the index's own word, hash, and trie tables do. Returns NULL on failure.
+extern struct fst *fst_build(const struct dindex *idx);
+
+// Check that an FST from `fst_build` was built from `idx` (or an identical index), so it can be used with it.
+extern bool fst_fits(const struct fst *fst, const struct dindex *idx);
+
+// Perform a block on each entry for an exact word, like `dindex_lookup` (using the FST in place of the index's word table).
+extern size_t fst_lookup(const struct fst *fst, const struct dindex *idx, const char *word, int (^blk)(const struct dindex_entry *entry));
+
+// Perform a block on up to `k` words starting with `prefix` in the given order, with each word's stroke count, like `dindex_prefix`.
+// If `blk` returns any non-zero value, stop early. Returns the total number of words with this prefix.
+extern size_t fst_complete(const struct fst *fst, const struct dindex *idx, const char *prefix, enum dindex_order order, size_t k, int (^blk)(const char *word, size_t len, uint32_t strokes));
+
+// Get the value of a key. Returns false if it isn't in the FST.
+extern bool fst_get(const struct fst *fst, const char *key, size_t len, uint64_t *value);
+
+// Perform a block on each key in `[lo, hi)` in order, with its value (either bound may be NULL to leave it open).
+// The key is only valid during the call (it is `\0` terminated). If `blk` returns any non-zero value, stop early.
+// Returns the number of keys passed to `blk`.
+extern size_t fst_range(const struct fst *fst, const char *lo, const char *hi, int (^blk)(const char *key, size_t len, uint64_t value));
+
+// Perform a block on up to `k` keys starting with `prefix` in order. Otherwise the same as `fst_range`.
+extern size_t fst_prefix(const struct fst *fst, const char *prefix, size_t k, int (^blk)(const char *key, size_t len, uint64_t value));
+
+// Write an FST to a file at `path` (written beside it and renamed into place). Returns non-zero on failure.
+extern int fst_save(const struct fst *fst, const char *path);
+
+// Map an FST file written by `fst_save`. Only the header is checked (word table entries are checked as they're used).
+// Returns NULL on failure.
+extern struct fst *fst_open(const char *path);
+
+// Free an FST.
+extern void fst_free(struct fst *fst);
+
+#endif /* !defined(__FST__) */
@@ -0,0 +1,57 @@
+/* ********************************************************** */
+/* -*- fuzzy.h -*- Approximate word lookup                -*- */
+/* ********************************************************** */
+/* Tyler Besselman (C) October 2026                           */
+/* ********************************************************** */
+
+#ifndef __FUZZY__
+#define __FUZZY__ 1
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <dindex.h>
+
+// Enable debug messages
+#define DEBUG_FUZZY 1
+
+// Longest query (in codepoints) we look for approximate matches for.
+#define FUZZY_MAX_LEN 64
+
+// Largest edit distance we search for.
+#define FUZZY_MAX_DIST 4
+
+// An inverted index from codepoints to the words containing them, used to find words close to a query.
+// Any word within `d` edits of a query must contain all but `d` of the distinct codepoints in the query
+//   and have a length within `d` of it, so only words passing both filters are compared in full.
+struct fuzzy {
+    const struct dindex *idx;
+
+    // Distinct codepoints in the dictionary (sorted), and where each one's word list starts in `postings`.
+    // Words with `cps[i]` are `postings[offsets[i]]` through `postings[offsets[i + 1] - 1]`, in ascending order.
+    uint32_t *cps;
+    uint32_t *offsets;
+    uint32_t ncps;
+
+    uint32_t *postings;
+
+    // Length of each word in codepoints (capped at 255).
+    uint8_t *lens;
+};
+
+// Build an approximate lookup index over the words in `idx` (which must outlive it). Returns NULL on failure.
+extern struct fuzzy *fuzzy_build(const struct dindex *idx);
+
+// Get the default maximum edit distance for a query of `len` codepoints.
+static inline size_t fuzzy_default_dist(size_t len)
+{ return (len <= 2 ? 1 : (len <= 6 ? 2 : 3)); }
+
+// Perform a block on up to `k` words within `max_dist` edits (over codepoints) of `word`, nearest first.
+// Words at the same distance come in codepoint order. Words sharing no codepoints with the query are never matched.
+// If `blk` returns any non-zero value, stop early. Returns the number of words passed to `blk`.
+extern size_t fuzzy_lookup(const struct fuzzy *fz, const char *word, size_t max_dist, size_t k, int (^blk)(const struct dindex_word *word, size_t dist));
+
+// Free an approximate lookup index.
+extern void fuzzy_free(struct fuzzy *fz);
+
+#endif /* !defined(__FUZZY__) */
@@ -0,0 +1,72 @@
+/* ********************************************************** */
+/* -*- hist.h -*- Log-linear latency histograms           -*- */
+/* ********************************************************** */
+/* Tyler Besselman (C) October 2026                           */
+/* ********************************************************** */
+
+#ifndef __HIST__
+#define __HIST__ 1
+
+#include <stdint.h>
+#include <stdio.h>
+
+// Each power of 2 is split into this many (as a power of 2) linear sub-buckets.
+// 5 bits gives 32 sub-buckets, so any recorded value is within ~3% of what we report.
+#define HIST_SUB_BITS   5
+#define HIST_SUB_COUNT  (1 << HIST_SUB_BITS)
+
+// Values below `HIST_SUB_COUNT` are exact, and each power of 2 above that gets `HIST_SUB_COUNT` buckets.
+#define HIST_BUCKETS    ((64 - HIST_SUB_BITS + 1) << HIST_SUB_BITS)
+
+// A fixed-size histogram of 64-bit values (e.g. latencies in nanoseconds) in the style of HdrHistogram.
+struct hist {
+    uint64_t counts[HIST_BUCKETS];
+
+    uint64_t count;
+    uint64_t sum;
+    uint64_t min;
+    uint64_t max;
+};
+
+// Get the bucket a value is counted in.
+static inline size_t hist_bucket(uint64_t value)
+{
+    if (value < HIST_SUB_COUNT) { return value; }
+
+    unsigned int msb = 63 - __builtin_clzll(value);
+    unsigned int shift = msb - HIST_SUB_BITS;
+
+    // The top `HIST_SUB_BITS + 1` bits of the value pick the sub-bucket.
+    return ((size_t)shift << HIST_SUB_BITS) + (value >> shift);
+}
+
+// Record a single value.
+static inline void hist_record(struct hist *h, uint64_t value)
+{
+    h->counts[hist_bucket(value)]++;
+    h->count++;
+    h->sum += value;
+
+    if (value < h->min) { h->min = value; }
+    if (value > h->max) { h->max = value; }
+}
+
+// Reset a histogram to empty.
+extern void hist_init(struct hist *h);
+
+// Add every value recorded in `src` to `dst`.
+extern void hist_merge(struct hist *dst, const struct hist *src);
+
+// Get the highest value in a bucket.
+extern uint64_t hist_bucket_max(size_t bucket);
+
+// Get the value at percentile `p` (0 to 100). Returns 0 for empty histograms.
+extern uint64_t hist_percentile(const struct hist *h, double p);
+
+// Get the average of all recorded values.
+extern double hist_mean(const struct hist *h);
+
+// Print a duration given in nanoseconds with a readable unit, right aligned in `width` columns.
+extern void hist_print_ns(FILE *out, uint64_t ns, int width);
+
+#endif /* !defined(__HIST__) */
@@ -0,0 +1,51 @@
+/* ********************************************************** */
+/* -*- json.h -*- Minimal JSON reading and writing        -*- */
+/* ********************************************************** */
+/* Tyler Besselman (C) October 2026                           */
+/* ********************************************************** */
+
+#ifndef __JSON__
+#define __JSON__ 1
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include <obuf.h>
+
+// Types of values we can read from an object.
+enum json_type {
+    JSON_NULL,
+    JSON_BOOL,
+    JSON_NUMBER,
+    JSON_STRING
+};
+
+// A single member value in an object.
+struct json_value {
+    enum json_type type;
+
+    // The value exactly as it appeared in the input (including quotes for strings).
+    const char *raw;
+    size_t raw_len;
+
+    // Decoded, `\0` terminated string (only for JSON_STRING).
+    const char *str;
+    size_t len;
+
+    // Value of a number or boolean.
+    double num;
+    bool b;
+};
+
+// Parse a flat JSON object (members may not be objects or arrays) held in `len` bytes at `json`.
+// `blk` is called for each member with its (decoded) key. Decoded strings live in `scratch` until the next call.
+// Returns non-zero if the object is malformed or `blk` returns non-zero.
+extern int json_object(const char *json, size_t len, struct obuf *scratch, int (^blk)(const char *key, const struct json_value *val));
+
+// Append `len` bytes of UTF-8 at `str` to a buffer as a quoted JSON string. Returns non-zero on failure.
+extern int json_string_n(struct obuf *out, const char *str, size_t len);
+
+// Append a `\0` terminated string to a buffer as a quoted JSON string. Returns non-zero on failure.
+extern int json_string(struct obuf *out, const char *str);
+
+#endif /* !defined(__JSON__) */
@@ -0,0 +1,66 @@
+/* ********************************************************** */
+/* -*- mapfile.h -*- Helpers for mmap'd data files        -*- */
+/* ********************************************************** */
+/* Tyler Besselman (C) October 2026                           */
+/* ********************************************************** */
+
+#ifndef __MAPFILE__
+#define __MAPFILE__ 1
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+// Sections in data files are aligned to this many bytes.
+#define MAPFILE_ALIGN 64
+
+// Byte order marker as written by the host that built a file (so we can detect a mismatch).
+#define MAPFILE_BYTE_ORDER 0x01020304
+
+// Every data file starts with this. Format specific header fields (and section tables) follow it.
+struct mapfile_header {
+    char magic[8];
+    uint32_t version;
+    uint32_t byte_order;
+
+    // Total size of the file in bytes.
+    uint64_t size;
+};
+
+// Where a section is, relative to the start of the file.
+struct mapfile_section {
+    uint64_t offset;
+    uint64_t size;
+};
+
+// Fill in the common header fields. The size is filled in by `mapfile_section` calls.
+extern void mapfile_header_init(struct mapfile_header *header, const char *magic, uint32_t version, size_t header_size);
+
+// Place a section of `size` bytes at the next aligned offset, growing the file size in the header.
+extern void mapfile_section(struct mapfile_header *header, struct mapfile_section *section, size_t size);
+
+// Same as above, but with a larger alignment (a power of 2 which is a multiple of `MAPFILE_ALIGN`, like a page).
+extern void mapfile_section_align(struct mapfile_header *header, struct mapfile_section *section, size_t size, size_t align);
+
+// Write a section (after padding up to its offset).
+extern int mapfile_write(FILE *fp, const struct mapfile_section *section, const void *data);
+
+// Write a data file with `blk`. It is written beside `path` and renamed into place, so readers never see a partial file.
+// Returns non-zero on failure (including if `blk` returns non-zero).
+extern int mapfile_save(const char *path, int (^blk)(FILE *fp));
+
+// Check if the file at `path` starts with `magic`.
+extern bool mapfile_is(const char *path, const char *magic);
+
+// Map a whole data file, checking the magic, version, byte order, and size in its header.
+// `what` names the kind of file in error messages (e.g. "index"). Returns NULL on failure, otherwise the size of the mapping is in `*size`.
+extern void *mapfile_open(const char *path, const char *what, const char *magic, uint32_t version, size_t header_size, size_t *size);
+
+// Check a section lies inside the file, is aligned, and has the expected size.
+extern bool mapfile_section_ok(const struct mapfile_header *header, const struct mapfile_section *section, uint64_t size);
+
+// Unmap a data file.
+extern void mapfile_close(void *map, size_t size);
+
+#endif /* !defined(__MAPFILE__) */
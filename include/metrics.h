@@ -0,0 +1,97 @@
+/* ********************************************************** */
+/* -*- metrics.h -*- Progress and metrics reporting       -*- */
+/* ********************************************************** */
+/* Tyler Besselman (C) October 2026                           */
+/* ********************************************************** */
+
+#ifndef __METRICS__
+#define __METRICS__ 1
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+// Environment variable enabling per-row diagnostics (any non-empty value other than "0")
+#define METRICS_ENV_VERBOSE "ZHDICT_VERBOSE"
+
+// Environment variable naming a file the final JSON summary is written to (default is stderr)
+#define METRICS_ENV_SUMMARY "ZHDICT_METRICS"
+
+// Minimum time between progress lines on a terminal and when redirected (in milliseconds)
+#define METRICS_INTERVAL_TTY    250
+#define METRICS_INTERVAL_FILE   5000
+
+// Only look at the clock once every this many steps (must be a power of 2)
+#define METRICS_POLL_MASK       0xFF
+
+// Counters and timing info for a single long-running task (e.g. a conversion)
+struct metrics {
+    // Name of this task (used in progress lines and the summary)
+    const char *name;
+
+    // Expected number of items (0 if unknown)
+    size_t total;
+
+    // Items processed so far, and how many bytes of content they held
+    size_t done;
+    size_t bytes;
+
+    // Items we intentionally skipped and items we rejected as malformed
+    size_t skipped;
+    size_t malformed;
+
+    // Timestamps (in nanoseconds) of task start and the last progress line
+    uint64_t start;
+    uint64_t last;
+
+    // Minimum time between progress lines (in nanoseconds)
+    uint64_t interval;
+
+    // Whether we can redraw the progress line in place
+    bool tty;
+
+    // Whether per-item diagnostics should be printed
+    bool verbose;
+};
+
+// Print a per-item diagnostic only if this task is verbose.
+#define metrics_debug(m, ...)                           \
+    do {                                                \
+        if ((m)->verbose) {                             \
+            fprintf(stderr, __VA_ARGS__);               \
+        }                                               \
+    } while (0)
+
+// Get a monotonic timestamp in nanoseconds.
+extern uint64_t metrics_now(void);
+
+// Start tracking a task expected to process `total` items (0 if unknown).
+extern void metrics_init(struct metrics *m, const char *name, size_t total);
+
+// Print a progress line now if enough time has passed since the last one.
+extern void metrics_poll(struct metrics *m);
+
+// Print the final progress line and JSON summary. `status` is 0 if the task succeeded.
+extern void metrics_finish(struct metrics *m, int status);
+
+// Record a processed item holding `bytes` bytes of content.
+// This only checks the clock once every `METRICS_POLL_MASK + 1` calls.
+static inline void metrics_step(struct metrics *m, size_t bytes)
+{
+    m->done++;
+    m->bytes += bytes;
+
+    if (!(m->done & METRICS_POLL_MASK)) {
+        metrics_poll(m);
+    }
+}
+
+// Record an item we skipped intentionally.
+static inline void metrics_skip(struct metrics *m)
+{ m->skipped++; }
+
+// Record an item we rejected as malformed.
+static inline void metrics_malformed(struct metrics *m)
+{ m->malformed++; }
+
+#endif /* !defined(__METRICS__) */
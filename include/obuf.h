@@ -0,0 +1,41 @@
+/* ********************************************************** */
+/* -*- obuf.h -*- Growable output buffers                 -*- */
+/* ********************************************************** */
+/* Tyler Besselman (C) October 2026                           */
+/* ********************************************************** */
+
+#ifndef __OBUF__
+#define __OBUF__ 1
+
+#include <stdarg.h>
+#include <stdio.h>
+
+// A growable buffer used to format output before writing it out in one go.
+struct obuf {
+    char *data;
+    size_t len;
+    size_t cap;
+};
+
+// Initializer for an empty buffer.
+#define OBUF_INIT ((struct obuf){ .data = NULL, .len = 0, .cap = 0 })
+
+// Make sure a buffer has room for `n` more bytes. Returns non-zero on failure.
+extern int obuf_reserve(struct obuf *buf, size_t n);
+
+// Append `n` bytes to a buffer. Returns non-zero on failure.
+extern int obuf_append(struct obuf *buf, const void *data, size_t n);
+
+// Append a `\0` terminated string to a buffer. Returns non-zero on failure.
+extern int obuf_puts(struct obuf *buf, const char *str);
+
+// Append formatted output to a buffer. Returns non-zero on failure.
+extern int obuf_printf(struct obuf *buf, const char *fmt, ...) __attribute__((format(printf, 2, 3)));
+
+// Write out the contents of a buffer and empty it. Returns non-zero on failure.
+extern int obuf_flush(struct obuf *buf, FILE *out);
+
+// Free the memory held by a buffer.
+extern void obuf_free(struct obuf *buf);
+
+#endif /* !defined(__OBUF__) */
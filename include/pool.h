@@ -0,0 +1,32 @@
+/* ********************************************************** */
+/* -*- pool.h -*- Simple thread pool for parallel loops   -*- */
+/* ********************************************************** */
+/* Tyler Besselman (C) October 2026                           */
+/* ********************************************************** */
+
+#ifndef __POOL__
+#define __POOL__ 1
+
+#include <stddef.h>
+
+// A fixed set of worker threads used to run loop iterations in parallel.
+struct pool;
+
+// Get the number of online CPUs (at least 1).
+extern size_t pool_ncpus(void);
+
+// Create a pool using `threads` threads in total (including the calling thread). 0 means one per CPU.
+// Returns NULL on failure.
+extern struct pool *pool_create(size_t threads);
+
+// Get the number of threads (including the caller) used by a pool.
+extern size_t pool_threads(struct pool *pool);
+
+// Run `blk` for each `i` in [0, count) across all threads in the pool, returning once every call has finished.
+// Iterations may run in any order. The calling thread also runs iterations.
+extern void pool_apply(struct pool *pool, size_t count, void (^blk)(size_t i));
+
+// Stop all threads and free a pool.
+extern void pool_destroy(struct pool *pool);
+
+#endif /* !defined(__POOL__) */
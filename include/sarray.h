@@ -0,0 +1,100 @@
+/* ********************************************************** */
+/* -*- sarray.h -*- Suffix array over definition text     -*- */
+/* ********************************************************** */
+/* Tyler Besselman (C) October 2026                           */
+/* ********************************************************** */
+
+#ifndef __SARRAY__
+#define __SARRAY__ 1
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <dindex.h>
+#include <mapfile.h>
+
+// Enable debug messages
+#define DEBUG_SARRAY 1
+
+// Magic bytes and version at the start of suffix array files.
+#define SARRAY_MAGIC "ZHSARRAY"
+#define SARRAY_VERSION 1
+
+// Symbols in the text below the ranks of real codepoints.
+#define SARRAY_SENTINEL     0
+#define SARRAY_SEPARATOR    1
+#define SARRAY_FIRST_RANK   2
+
+// A suffix array over the definitions of every entry in an index, one symbol per codepoint.
+// Codepoints are replaced by their rank in the (sorted) set of codepoints that appear, and each definition is
+//   followed by a separator, so no match can run from one definition into the next.
+struct sarray {
+    // The index whose entries this covers.
+    const struct dindex *idx;
+
+    // Codepoint for each rank (starting from `SARRAY_FIRST_RANK`).
+    const uint32_t *cps;
+    uint32_t ncps;
+
+    // The text (ranks), ending with `SARRAY_SENTINEL`.
+    const int32_t *text;
+    uint32_t n;
+
+    // Suffix array, and the longest common prefix of each suffix with the one before it (`lcp[0]` is 0).
+    const int32_t *sa;
+    const uint32_t *lcp;
+
+    // The definition of entry `i` starts at `text[starts[i]]` (entries with no definition take no space).
+    const uint32_t *starts;
+    uint32_t nentries;
+
+    // Pool size of the index this was built from (to catch pairing with the wrong index).
+    uint64_t pool_size;
+
+    // If this was loaded from a file, the mapping everything above points into.
+    void *map;
+    size_t map_size;
+};
+
+// Header at the start of a suffix array file. Sections are at the given offsets from the start of the file.
+struct sarray_header {
+    struct mapfile_header file;
+
+    uint64_t pool_size;
+
+    uint32_t n;
+    uint32_t ncps;
+    uint32_t nentries;
+
+    // Keeps the section table 8 byte aligned (always 0).
+    uint32_t reserved;
+
+    struct mapfile_section cps, text, sa, lcp, starts;
+};
+
+// Build a suffix array over every definition in `idx` using `threads` threads (0 means one per CPU).
+// Returns NULL on failure.
+extern struct sarray *sarray_build(const struct dindex *idx, size_t threads);
+
+// Count occurrences of `phrase` across all definitions.
+extern size_t sarray_count(const struct sarray *sa, const char *phrase);
+
+// Perform a block on each entry whose definition contains `phrase` (in entry order), with how many times it does.
+// If `blk` returns any non-zero value, stop early. Returns the total number of occurrences.
+extern size_t sarray_search(const struct sarray *sa, const char *phrase, int (^blk)(const struct dindex_entry *entry, size_t count));
+
+// Get the entry the text at `pos` belongs to.
+extern uint32_t sarray_entry(const struct sarray *sa, uint32_t pos);
+
+// Write a suffix array to a file at `path` (written beside it and renamed into place). Returns non-zero on failure.
+extern int sarray_save(const struct sarray *sa, const char *path);
+
+// Map a suffix array file written by `sarray_save`, checking it was built from `idx`.
+// Every suffix and entry start is bounds checked, so this reads the suffix array once. Returns NULL on failure.
+extern struct sarray *sarray_open(const char *path, const struct dindex *idx);
+
+// Free a suffix array.
+extern void sarray_free(struct sarray *sa);
+
+#endif /* !defined(__SARRAY__) */
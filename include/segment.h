@@ -0,0 +1,91 @@
+/* ********************************************************** */
+/* -*- segment.h -*- Dictionary driven text segmentation  -*- */
+/* ********************************************************** */
+/* Tyler Besselman (C) October 2026                           */
+/* ********************************************************** */
+
+#ifndef __SEGMENT__
+#define __SEGMENT__ 1
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <dindex.h>
+
+// Enable debug messages (these go to stderr, since segmented text is usually written to stdout)
+#define DEBUG_SEGMENT 1
+
+// How to choose between overlapping words.
+enum segment_mode {
+    // Take the longest word at each position, left to right.
+    SEGMENT_FORWARD,
+
+    // Take the longest word ending at each position, right to left.
+    SEGMENT_BACKWARD,
+
+    // Consider every word at every position, taking the split with the fewest tokens (ties go to longer words first).
+    SEGMENT_DAG
+};
+
+// A state in a double-array trie over the bytes of each word.
+// The transition from state `s` on byte `c` is to `t = (cells[s].base & ~SEGMENT_WORD) + c` if `cells[t].check == s`.
+// Cells are kept to 8 bytes (with the word flag in the base) since matching is bound by how many fit in cache.
+struct segment_cell {
+    uint32_t base;
+    uint32_t check;
+};
+
+// Set in the base of states where a word ends.
+#define SEGMENT_WORD 0x80000000
+
+// Check value of cells not in use.
+#define SEGMENT_FREE UINT32_MAX
+
+// A compiled segmenter. For backward matching, the trie is built over each word with its bytes reversed.
+struct segmenter {
+    const struct dindex *idx;
+    enum segment_mode mode;
+
+    // The root is `cells[0]`. There are always at least 256 cells past the largest base, so transitions never need a bounds check.
+    struct segment_cell *cells;
+    uint32_t ncells;
+};
+
+// Scratch space used while segmenting (reused between calls to avoid reallocating).
+struct segment_buf {
+    // Tokens are `[tokens[2 * i], tokens[2 * i + 1])` as byte offsets into the text.
+    uint32_t *tokens;
+
+    // Per-byte working space.
+    uint32_t *cost;
+    uint32_t *next;
+
+    size_t cap;
+};
+
+// Initializer for an empty buffer.
+#define SEGMENT_BUF_INIT ((struct segment_buf){ .tokens = NULL, .cost = NULL, .next = NULL, .cap = 0 })
+
+// Take the transition from state `s` on byte `c`. Returns 0 (the root, which is never a target) if there isn't one.
+static inline uint32_t segment_next(const struct segment_cell *cells, uint32_t s, uint8_t c)
+{
+    uint32_t t = (cells[s].base & ~SEGMENT_WORD) + c;
+    return (cells[t].check == s ? t : 0);
+}
+
+// Compile a segmenter over every word in `idx`. Returns NULL on failure.
+extern struct segmenter *segment_create(const struct dindex *idx, enum segment_mode mode);
+
+// Split `len` bytes of UTF-8 text into tokens in a single pass. Whitespace separates tokens and is never part of one.
+// Text the dictionary doesn't cover becomes single characters, except runs of ASCII letters and digits, which are kept whole.
+// Returns non-zero on failure, otherwise the number of tokens in `buf` is in `*ntokens`.
+extern int segment_text(const struct segmenter *seg, const char *text, size_t len, struct segment_buf *buf, size_t *ntokens);
+
+// Free the memory held by a scratch buffer.
+extern void segment_buf_free(struct segment_buf *buf);
+
+// Free a segmenter.
+extern void segment_free(struct segmenter *seg);
+
+#endif /* !defined(__SEGMENT__) */
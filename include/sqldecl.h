@@ -33,10 +33,43 @@
 #define SQL_TABLE_DICT_NAME             "辭典"
 #define SQL_TABLE_DICT_FIELD_ID         "編號"
 #define SQL_TABLE_DICT_FIELD_WORD       "字詞"
-#define SQL_TABLE_DICT_FIELD_CHARS      "詞"
+#define SQL_TABLE_DICT_FIELD_CHARS      "字數"
 #define SQL_TABLE_DICT_FIELD_CHAR_INFO  "詞"
 #define SQL_TABLE_DICT_FIELD_DEF        "釋義資料"
 
+// Name strings for sense table (one row per numbered sense of a definition)
+#define SQL_TABLE_SENSE_NAME            "義項"
+#define SQL_TABLE_SENSE_FIELD_ID        "編號"
+#define SQL_TABLE_SENSE_FIELD_ENTRY     "辭典"
+#define SQL_TABLE_SENSE_FIELD_ORDER     "序號"
+#define SQL_TABLE_SENSE_FIELD_POS       "詞性"
+#define SQL_TABLE_SENSE_FIELD_TEXT      "釋義"
+
+// Name strings for example table
+#define SQL_TABLE_EXAMPLE_NAME          "例句"
+#define SQL_TABLE_EXAMPLE_FIELD_ID      "編號"
+#define SQL_TABLE_EXAMPLE_FIELD_SENSE   "義項"
+#define SQL_TABLE_EXAMPLE_FIELD_TEXT    "例句"
+
+// Name strings for citation table
+#define SQL_TABLE_CITE_NAME             "引文"
+#define SQL_TABLE_CITE_FIELD_ID         "編號"
+#define SQL_TABLE_CITE_FIELD_SENSE      "義項"
+#define SQL_TABLE_CITE_FIELD_SOURCE     "出處"
+#define SQL_TABLE_CITE_FIELD_TEXT       "引文"
+
+// Name strings for cross-reference table (one row per direction of each edge between entries)
+#define SQL_TABLE_XREF_NAME             "參見"
+#define SQL_TABLE_XREF_FIELD_ENTRY      "辭典"
+#define SQL_TABLE_XREF_FIELD_DIR        "方向"
+#define SQL_TABLE_XREF_FIELD_OTHER      "對象"
+#define SQL_TABLE_XREF_FIELD_SENSE      "義項"
+#define SQL_TABLE_XREF_FIELD_PHRASE     "用語"
+
+// Values for the direction field of the cross-reference table
+#define SQL_XREF_FORWARD                0 // The entry's definition refers to the other entry
+#define SQL_XREF_REVERSE                1 // The other entry's definition refers to the entry
+
 // SQL creation statement for radical table
 #define SQL_STMT_CREATE_RAD                                                             \
     "create table " SQL_TABLE_RAD_NAME "("                                              \
@@ -47,10 +80,10 @@
 
 // SQL creation statement for character table
 #define SQL_STMT_CREATE_CHAR                                                            \
-    "create table" SQL_TABLE_CHAR_NAME "("                                              \
+    "create table " SQL_TABLE_CHAR_NAME "("                                             \
         SQL_TABLE_CHAR_FIELD_ID         " integer primary key, "                        \
         SQL_TABLE_CHAR_FIELD_CHAR       " text not null, "                              \
-        "foreign key(" SQL_TABLE_CHAR_FIELD_RAD ") "                                    \
+        SQL_TABLE_CHAR_FIELD_RAD        " integer "                                     \
             "references "   SQL_TABLE_RAD_NAME "(" SQL_TABLE_RAD_FIELD_ID "), "         \
         SQL_TABLE_CHAR_FIELD_STROKES    " integer, "                                    \
         SQL_TABLE_CHAR_FIELD_XSTROKES   " integer, "                                    \
@@ -61,20 +94,76 @@
     ") strict;"
 
 // SQL creation statement for dictionary table
+// Definitions are text, or blobs when compressed (see defzip.h).
 #define SQL_STMT_CREATE_DICT                                                            \
     "create table " SQL_TABLE_DICT_NAME "("                                             \
         SQL_TABLE_DICT_FIELD_ID         " integer primary key, "                        \
         SQL_TABLE_DICT_FIELD_WORD       " text not null, "                              \
         SQL_TABLE_DICT_FIELD_CHARS      " integer, "                                    \
         SQL_TABLE_DICT_FIELD_CHAR_INFO  " blob,"                                        \
-        SQL_TABLE_DICT_FIELD_DEF        " text not null"                                \
+        SQL_TABLE_DICT_FIELD_DEF        " any not null"                                 \
+    ") strict;"
+
+// SQL creation statement for sense table
+// Sense text is compressed along with definitions.
+#define SQL_STMT_CREATE_SENSE                                                           \
+    "create table " SQL_TABLE_SENSE_NAME "("                                            \
+        SQL_TABLE_SENSE_FIELD_ID        " integer primary key, "                        \
+        SQL_TABLE_SENSE_FIELD_ENTRY     " integer not null "                            \
+            "references "   SQL_TABLE_DICT_NAME "(" SQL_TABLE_DICT_FIELD_ID "), "       \
+        SQL_TABLE_SENSE_FIELD_ORDER     " integer not null, "                           \
+        SQL_TABLE_SENSE_FIELD_POS       " text, "                                       \
+        SQL_TABLE_SENSE_FIELD_TEXT      " any not null"                                 \
     ") strict;"
 
+// SQL creation statement for example table
+#define SQL_STMT_CREATE_EXAMPLE                                                         \
+    "create table " SQL_TABLE_EXAMPLE_NAME "("                                          \
+        SQL_TABLE_EXAMPLE_FIELD_ID      " integer primary key, "                        \
+        SQL_TABLE_EXAMPLE_FIELD_SENSE   " integer not null "                            \
+            "references "   SQL_TABLE_SENSE_NAME "(" SQL_TABLE_SENSE_FIELD_ID "), "     \
+        SQL_TABLE_EXAMPLE_FIELD_TEXT    " text not null"                                \
+    ") strict;"
+
+// SQL creation statement for citation table
+#define SQL_STMT_CREATE_CITE                                                            \
+    "create table " SQL_TABLE_CITE_NAME "("                                             \
+        SQL_TABLE_CITE_FIELD_ID         " integer primary key, "                        \
+        SQL_TABLE_CITE_FIELD_SENSE      " integer not null "                            \
+            "references "   SQL_TABLE_SENSE_NAME "(" SQL_TABLE_SENSE_FIELD_ID "), "     \
+        SQL_TABLE_CITE_FIELD_SOURCE     " text not null, "                              \
+        SQL_TABLE_CITE_FIELD_TEXT       " text"                                         \
+    ") strict;"
+
+// SQL creation statement for cross-reference table
+// Edges are keyed by entry first, so following (or reversing) a reference is a primary key lookup.
+#define SQL_STMT_CREATE_XREF                                                            \
+    "create table " SQL_TABLE_XREF_NAME "("                                             \
+        SQL_TABLE_XREF_FIELD_ENTRY      " integer not null "                            \
+            "references "   SQL_TABLE_DICT_NAME "(" SQL_TABLE_DICT_FIELD_ID "), "       \
+        SQL_TABLE_XREF_FIELD_DIR        " integer not null, "                           \
+        SQL_TABLE_XREF_FIELD_OTHER      " integer not null "                            \
+            "references "   SQL_TABLE_DICT_NAME "(" SQL_TABLE_DICT_FIELD_ID "), "       \
+        SQL_TABLE_XREF_FIELD_SENSE      " integer not null "                            \
+            "references "   SQL_TABLE_SENSE_NAME "(" SQL_TABLE_SENSE_FIELD_ID "), "     \
+        SQL_TABLE_XREF_FIELD_PHRASE     " text not null, "                              \
+        "primary key ("                                                                 \
+            SQL_TABLE_XREF_FIELD_ENTRY  ", "                                            \
+            SQL_TABLE_XREF_FIELD_DIR    ", "                                            \
+            SQL_TABLE_XREF_FIELD_OTHER  ", "                                            \
+            SQL_TABLE_XREF_FIELD_SENSE                                                  \
+        ")"                                                                             \
+    ") strict, without rowid;"
+
 // SQL creation statement for table indicies
 #define SQL_STMT_CREATE_INDEX                                                           \
     "create index irad      on " SQL_TABLE_RAD_NAME  "(" SQL_TABLE_RAD_FIELD_CHAR  ");" \
     "create index ichars    on " SQL_TABLE_CHAR_NAME "(" SQL_TABLE_CHAR_FIELD_CHAR ");" \
-    "create index ientries  on " SQL_TABLE_DICT_NAME "(" SQL_TABLE_DICT_FIELD_WORD ");"
+    "create index ientries  on " SQL_TABLE_DICT_NAME "(" SQL_TABLE_DICT_FIELD_WORD ");" \
+    "create index isenses   on " SQL_TABLE_SENSE_NAME   "(" SQL_TABLE_SENSE_FIELD_ENTRY   ");" \
+    "create index iexamples on " SQL_TABLE_EXAMPLE_NAME "(" SQL_TABLE_EXAMPLE_FIELD_SENSE ");" \
+    "create index icites    on " SQL_TABLE_CITE_NAME    "(" SQL_TABLE_CITE_FIELD_SENSE    ");" \
+    "create index isources  on " SQL_TABLE_CITE_NAME    "(" SQL_TABLE_CITE_FIELD_SOURCE   ");"
 
 // Parameter count for radical insertion statement
 #define SQL_INS_RAD_CNT         2
@@ -118,7 +207,6 @@
         SQL_TABLE_CHAR_FIELD_XPRON      ", "                                \
         SQL_TABLE_CHAR_FIELD_PRON_ORD                                       \
     ") values("                                                             \
-        "?" _SQLSTR(SQL_INS_CHAR_ID)        ", "                            \
         "?" _SQLSTR(SQL_INS_CHAR_CHAR)      ", "                            \
         "?" _SQLSTR(SQL_INS_CHAR_RAD)       ", "                            \
         "?" _SQLSTR(SQL_INS_CHAR_STROKES)   ", "                            \
@@ -155,6 +243,93 @@
         "?" _SQLSTR(SQL_INS_DICT_DEF)                                       \
     ") returning " SQL_TABLE_DICT_FIELD_ID ";"
 
+// Parameter count for sense insertion statement
+#define SQL_INS_SENSE_CNT       4
+
+// Individual parameter numbers for sense insertion statement
+#define SQL_INS_SENSE_ENTRY     1
+#define SQL_INS_SENSE_ORDER     2
+#define SQL_INS_SENSE_POS       3
+#define SQL_INS_SENSE_TEXT      4
+
+// SQL statement for inserting into sense table
+#define SQL_STMT_INSERT_SENSE                                               \
+    "insert into " SQL_TABLE_SENSE_NAME " ("                                \
+        SQL_TABLE_SENSE_FIELD_ENTRY     ", "                                \
+        SQL_TABLE_SENSE_FIELD_ORDER     ", "                                \
+        SQL_TABLE_SENSE_FIELD_POS       ", "                                \
+        SQL_TABLE_SENSE_FIELD_TEXT                                          \
+    ") values("                                                             \
+        "?" _SQLSTR(SQL_INS_SENSE_ENTRY)    ", "                            \
+        "?" _SQLSTR(SQL_INS_SENSE_ORDER)    ", "                            \
+        "?" _SQLSTR(SQL_INS_SENSE_POS)      ", "                            \
+        "?" _SQLSTR(SQL_INS_SENSE_TEXT)                                     \
+    ") returning " SQL_TABLE_SENSE_FIELD_ID ";"
+
+// Parameter count for example insertion statement
+#define SQL_INS_EXAMPLE_CNT     2
+
+// Individual parameter numbers for example insertion statement
+#define SQL_INS_EXAMPLE_SENSE   1
+#define SQL_INS_EXAMPLE_TEXT    2
+
+// SQL statement for inserting into example table
+#define SQL_STMT_INSERT_EXAMPLE                                             \
+    "insert into " SQL_TABLE_EXAMPLE_NAME " ("                              \
+        SQL_TABLE_EXAMPLE_FIELD_SENSE   ", "                                \
+        SQL_TABLE_EXAMPLE_FIELD_TEXT                                        \
+    ") values("                                                             \
+        "?" _SQLSTR(SQL_INS_EXAMPLE_SENSE)  ", "                            \
+        "?" _SQLSTR(SQL_INS_EXAMPLE_TEXT)                                   \
+    ") returning " SQL_TABLE_EXAMPLE_FIELD_ID ";"
+
+// Parameter count for citation insertion statement
+#define SQL_INS_CITE_CNT        3
+
+// Individual parameter numbers for citation insertion statement
+#define SQL_INS_CITE_SENSE      1
+#define SQL_INS_CITE_SOURCE     2
+#define SQL_INS_CITE_TEXT       3
+
+// SQL statement for inserting into citation table
+#define SQL_STMT_INSERT_CITE                                                \
+    "insert into " SQL_TABLE_CITE_NAME " ("                                 \
+        SQL_TABLE_CITE_FIELD_SENSE      ", "                                \
+        SQL_TABLE_CITE_FIELD_SOURCE     ", "                                \
+        SQL_TABLE_CITE_FIELD_TEXT                                           \
+    ") values("                                                             \
+        "?" _SQLSTR(SQL_INS_CITE_SENSE)     ", "                            \
+        "?" _SQLSTR(SQL_INS_CITE_SOURCE)    ", "                            \
+        "?" _SQLSTR(SQL_INS_CITE_TEXT)                                      \
+    ") returning " SQL_TABLE_CITE_FIELD_ID ";"
+
+// Parameter count for cross-reference insertion statement
+#define SQL_INS_XREF_CNT        5
+
+// Individual parameter numbers for cross-reference insertion statement
+#define SQL_INS_XREF_ENTRY      1
+#define SQL_INS_XREF_DIR        2
+#define SQL_INS_XREF_OTHER      3
+#define SQL_INS_XREF_SENSE      4
+#define SQL_INS_XREF_PHRASE     5
+
+// SQL statement for inserting into cross-reference table
+// The same word can be referenced more than once in a sense, so repeated edges are ignored.
+#define SQL_STMT_INSERT_XREF                                                \
+    "insert or ignore into " SQL_TABLE_XREF_NAME " ("                       \
+        SQL_TABLE_XREF_FIELD_ENTRY      ", "                                \
+        SQL_TABLE_XREF_FIELD_DIR        ", "                                \
+        SQL_TABLE_XREF_FIELD_OTHER      ", "                                \
+        SQL_TABLE_XREF_FIELD_SENSE      ", "                                \
+        SQL_TABLE_XREF_FIELD_PHRASE                                         \
+    ") values("                                                             \
+        "?" _SQLSTR(SQL_INS_XREF_ENTRY)     ", "                            \
+        "?" _SQLSTR(SQL_INS_XREF_DIR)       ", "                            \
+        "?" _SQLSTR(SQL_INS_XREF_OTHER)     ", "                            \
+        "?" _SQLSTR(SQL_INS_XREF_SENSE)     ", "                            \
+        "?" _SQLSTR(SQL_INS_XREF_PHRASE)                                    \
+    ");"
+
 // Parameter count for radical update statement
 #define SQL_UPD_RAD_CND         2
 
@@ -166,10 +341,10 @@
 #define SQL_STMT_UPDATE_RAD                                                 \
     "update " SQL_TABLE_RAD_NAME " set "                                    \
         SQL_TABLE_RAD_FIELD_STROKES " = ?" _SQLSTR(SQL_UPD_RAD_STROKES)     \
-    "where " SQL_TABLE_RAD_FIELD_ID " = ?" _SQLSTR(SQL_UPD_RAD_ID) ";"
+    " where " SQL_TABLE_RAD_FIELD_ID " = ?" _SQLSTR(SQL_UPD_RAD_ID) ";"
 
 // Parameter count for character update statement
-#define SQL_UPD_CHAR_CND        4
+#define SQL_UPD_CHAR_CND        8
 
 // Individual parameter numbers for character update
 #define SQL_UPD_CHAR_ID         1
@@ -0,0 +1,81 @@
+/* ********************************************************** */
+/* -*- sqldict.h -*- Dictionary queries against sqlite    -*- */
+/* ********************************************************** */
+/* Tyler Besselman (C) October 2026                           */
+/* ********************************************************** */
+
+#ifndef __SQLDICT__
+#define __SQLDICT__ 1
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <dindex.h>
+#include <sqlite.h>
+
+// Enable debug messages
+#define DEBUG_SQLDICT 1
+
+// Every sqlite database starts with these 16 bytes (including the `\0`).
+#define SQLDICT_MAGIC "SQLite format 3"
+
+// Largest page cache (in KiB) used for a dictionary database.
+#define SQLDICT_CACHE_KIB 8192
+
+// A dictionary in a database written by `xlsx2sql` or `conv`, opened read only.
+// The table and columns are found when the database is opened, and every query we make is prepared once up front.
+struct sqldict {
+    sqlite3 *db;
+
+    // Exact lookups (by word).
+    sqlite3_stmt *exact;
+
+    // Prefix completions in each order, and the total number of words with a prefix.
+    sqlite3_stmt *prefix[2];
+    sqlite3_stmt *count;
+
+    // Lookups by pronunciation (NULL if the table has no pronunciation columns).
+    sqlite3_stmt *pron;
+
+    // Whether row ids are rows of the source document (tables from `xlsx2sql` have an `id` column for this).
+    // Otherwise they are whatever the table is keyed by, which for `conv` is 編號 (each entry's 字詞號).
+    bool sheet_rows;
+};
+
+// A single row passed to query callbacks. Strings are only valid during the callback.
+struct sqldict_entry {
+    // The row id in the table. This is the row number in the source document (with row 0 being the header) only if
+    //   `sheet_rows` is set; `conv` keys its table by 編號 (the entry's 字詞號) instead.
+    int64_t row;
+
+    const char *word;
+
+    // Definition and pronunciations (NULL if missing).
+    const char *def;
+    const char *zhuyin;
+    const char *pinyin;
+};
+
+// Check if the file at `path` is a sqlite database.
+extern bool sqldict_is_file(const char *path);
+
+// Open a dictionary database read only. Returns NULL on failure.
+extern struct sqldict *sqldict_open(const char *path);
+
+// Perform a block on each entry for an exact word. Returns the number of matching entries.
+// If `blk` returns any non-zero value, stop early.
+extern size_t sqldict_lookup(struct sqldict *sd, const char *word, int (^blk)(const struct sqldict_entry *entry));
+
+// Perform a block on up to `k` words starting with `prefix` in the given order, with their stroke count (-1 if unknown).
+// If `blk` returns any non-zero value, stop early. Returns the total number of words with this prefix.
+extern size_t sqldict_prefix(struct sqldict *sd, const char *prefix, enum dindex_order order, size_t k, int (^blk)(const char *word, int64_t strokes));
+
+// Perform a block on up to `k` entries pronounced `pron` (in either zhuyin or pinyin). Returns the number of entries found.
+// If `blk` returns any non-zero value, stop early.
+extern size_t sqldict_pron(struct sqldict *sd, const char *pron, size_t k, int (^blk)(const struct sqldict_entry *entry));
+
+// Close a dictionary database.
+extern void sqldict_close(struct sqldict *sd);
+
+#endif /* !defined(__SQLDICT__) */
@@ -7,6 +7,7 @@
 #ifndef __SQLITE__
 #define __SQLITE__ 1
 
+#include <stdint.h>
 #include <sqlite3.h>
 #include <stdio.h>
 
@@ -33,9 +34,18 @@ extern sqlite3_stmt *sqlite_prepare(sqlite3 *db, const char *query);
 // Bind a string
 extern int sqlite_bind_str(sqlite3_stmt *statement, int loc, const char *str);
 
+// Bind `len` bytes of a string (which needn't be `\0` terminated)
+extern int sqlite_bind_strn(sqlite3_stmt *statement, int loc, const char *str, size_t len);
+
+// Bind `len` bytes of binary data
+extern int sqlite_bind_blob(sqlite3_stmt *statement, int loc, const void *data, size_t len);
+
 // Bind a number
 extern int sqlite_bind_int(sqlite3_stmt *statement, int loc, int val);
 
+// Bind a 64 bit number
+extern int sqlite_bind_int64(sqlite3_stmt *statement, int loc, int64_t val);
+
 // Bind a null value
 extern int sqlite_bind_null(sqlite3_stmt *statement, int loc);
 
@@ -0,0 +1,42 @@
+/* ********************************************************** */
+/* -*- synth.h -*- Synthetic dictionary generator         -*- */
+/* ********************************************************** */
+/* Tyler Besselman (C) October 2026                           */
+/* ********************************************************** */
+
+#ifndef __SYNTH__
+#define __SYNTH__ 1
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <xlsx.h>
+
+// Columns in a synthetic dictionary (row 0 holds the same headers as the real one).
+#define SYNTH_COL_WORD      0
+#define SYNTH_COL_DEF       1
+#define SYNTH_COL_STROKES   2
+#define SYNTH_COLS          3
+
+// Small, fast PRNG (splitmix64). Good enough for generating test data, not for anything else.
+static inline uint64_t synth_rand(uint64_t *state)
+{
+    uint64_t z = ((*state) += 0x9E3779B97F4A7C15ULL);
+
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+
+    return z ^ (z >> 31);
+}
+
+// Get a random number in [0, n).
+static inline uint64_t synth_below(uint64_t *state, uint64_t n)
+{ return (uint64_t)(((__uint128_t)synth_rand(state) * n) >> 64); }
+
+// Generate a dictionary-like document with `rows` entries (plus a header row) in memory.
+// Words are mostly 1-4 common characters with a few long idioms and repeated words, like the real thing.
+// Everything is a literal string (or integer stroke count), so it's freed normally with `xlsx_doc_free`.
+// The same seed always gives the same document. Returns NULL on failure.
+extern struct xlsx *synth_dict(size_t rows, uint64_t seed);
+
+#endif /* !defined(__SYNTH__) */
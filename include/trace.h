@@ -0,0 +1,71 @@
+/* ********************************************************** */
+/* -*- trace.h -*- Timeline tracing of scoped spans       -*- */
+/* ********************************************************** */
+/* Tyler Besselman (C) October 2026                           */
+/* ********************************************************** */
+
+#ifndef __TRACE__
+#define __TRACE__ 1
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <time.h>
+
+// Environment variable naming a file to write every span to at exit, as Chrome trace JSON (which Perfetto also opens).
+// Tracing is off unless this is set, and spans cost a single branch when it's off.
+#define TRACE_ENV "ZHDICT_TRACE"
+
+// Number of spans kept for each thread (the oldest are overwritten after this). Must be a power of 2.
+#define TRACE_RING 65536
+
+// Longest detail (e.g. a path or query) kept with a span, including the terminator.
+#define TRACE_DETAIL 64
+
+// Whether spans are being recorded. This is set once at startup.
+extern bool trace_on;
+
+// A span being timed. `name` is NULL if tracing is off.
+struct trace_span {
+    const char *name;
+    const char *detail;
+    uint64_t start;
+};
+
+// Get a monotonic timestamp in nanoseconds.
+static inline uint64_t trace_now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+// Record a finished span (only called when tracing is on).
+extern void _trace_record(const struct trace_span *span, uint64_t end);
+
+// Start a span. `name` should be a literal, and `detail` (which may be NULL) must stay valid until the span ends.
+static inline struct trace_span trace_begin(const char *name, const char *detail)
+{
+    if (__builtin_expect(!trace_on, 1)) {
+        return (struct trace_span){ .name = NULL };
+    }
+
+    return (struct trace_span){ .name = name, .detail = detail, .start = trace_now() };
+}
+
+// End a span started with `trace_begin`.
+static inline void trace_end(struct trace_span *span)
+{
+    if (__builtin_expect(span->name != NULL, 0)) {
+        _trace_record(span, trace_now());
+    }
+}
+
+#define _TRACE_CAT(a, b) a ## b
+#define _TRACE_VAR(line) _TRACE_CAT(_trace_span_, line)
+
+// Time the rest of the enclosing scope as a span. Don't jump into the scope past this (it ends the span on the way out).
+#define TRACE_SPAN(name, detail) \
+    struct trace_span _TRACE_VAR(__LINE__) __attribute__((cleanup(trace_end))) = trace_begin(name, detail)
+
+#endif /* !defined(__TRACE__) */
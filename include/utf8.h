@@ -0,0 +1,116 @@
+/* ********************************************************** */
+/* -*- utf8.h -*- UTF-8 decoding helpers                  -*- */
+/* ********************************************************** */
+/* Tyler Besselman (C) October 2026                           */
+/* ********************************************************** */
+
+#ifndef __UTF8__
+#define __UTF8__ 1
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Codepoint returned for invalid UTF-8 sequences.
+#define UTF8_INVALID 0xFFFD
+
+// A table indexed by the first byte of a UTF-8 codepoint
+//   determining the length of the encoded char.
+static const uint8_t UTF8_TRAILING_COUNT[0x100] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2,
+    3, 3, 3, 3, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5
+};
+
+// Decode the codepoint at `*s`, advancing `*s` past it.
+// Invalid or truncated sequences decode as `UTF8_INVALID` and only consume a single byte.
+static inline uint32_t utf8_next(const char **s)
+{
+    const uint8_t *p = (const uint8_t *)(*s);
+    size_t bytes = UTF8_TRAILING_COUNT[p[0]];
+
+    // ASCII is by far the most common case outside of CJK text.
+    if (p[0] < 0x80)
+    {
+        (*s)++;
+        return p[0];
+    }
+
+    // Stray continuation bytes and anything longer than 4 bytes is invalid.
+    if (!bytes || bytes > 3 || (p[0] & 0xC0) == 0x80)
+    {
+        (*s)++;
+        return UTF8_INVALID;
+    }
+
+    uint32_t cp = p[0] & (0x3F >> bytes);
+
+    for (size_t i = 1; i <= bytes; i++)
+    {
+        // This also catches the terminating `\0` in truncated sequences.
+        if ((p[i] & 0xC0) != 0x80)
+        {
+            (*s)++;
+            return UTF8_INVALID;
+        }
+
+        cp = (cp << 6) | (p[i] & 0x3F);
+    }
+
+    (*s) += bytes + 1;
+    return cp;
+}
+
+// Encode a codepoint into `buf` (which must have room for 4 bytes), returning the number of bytes written.
+static inline size_t utf8_encode(uint32_t cp, char *buf)
+{
+    uint8_t *p = (uint8_t *)buf;
+
+    if (cp < 0x80) {
+        p[0] = cp;
+        return 1;
+    } else if (cp < 0x800) {
+        p[0] = 0xC0 | (cp >> 6);
+        p[1] = 0x80 | (cp & 0x3F);
+        return 2;
+    } else if (cp < 0x10000) {
+        p[0] = 0xE0 | (cp >> 12);
+        p[1] = 0x80 | ((cp >> 6) & 0x3F);
+        p[2] = 0x80 | (cp & 0x3F);
+        return 3;
+    } else {
+        p[0] = 0xF0 | (cp >> 18);
+        p[1] = 0x80 | ((cp >> 12) & 0x3F);
+        p[2] = 0x80 | ((cp >> 6) & 0x3F);
+        p[3] = 0x80 | (cp & 0x3F);
+        return 4;
+    }
+}
+
+// Count the codepoints in a `\0` terminated string.
+static inline size_t utf8_count(const char *s)
+{
+    size_t n = 0;
+
+    while (*s)
+    {
+        utf8_next(&s);
+        n++;
+    }
+
+    return n;
+}
+
+#endif /* !defined(__UTF8__) */
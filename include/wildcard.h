@@ -0,0 +1,58 @@
+/* ********************************************************** */
+/* -*- wildcard.h -*- Positional wildcard word search     -*- */
+/* ********************************************************** */
+/* Tyler Besselman (C) October 2026                           */
+/* ********************************************************** */
+
+#ifndef __WILDCARD__
+#define __WILDCARD__ 1
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <dindex.h>
+
+// Enable debug messages
+#define DEBUG_WILDCARD 1
+
+// Longest word (in codepoints) which is indexed. Longer words never match a pattern.
+#define WILDCARD_MAX_LEN 32
+
+// Codepoints standing for any single character in a pattern ('?' and the fullwidth '？').
+#define WILDCARD_ANY      '?'
+#define WILDCARD_ANY_WIDE 0xFF1F
+
+// Pack a (codepoint, word length, position) triple into a single key.
+// Codepoints fit in 21 bits, lengths in 6 (up to `WILDCARD_MAX_LEN`), and positions in 5.
+#define WILDCARD_KEY(cp, len, pos) (((uint32_t)(cp) << 11) | ((uint32_t)(len) << 5) | (uint32_t)(pos))
+
+// An inverted index from (codepoint, word length, position) to the words with that codepoint at that position.
+// The key with codepoint 0 (which no word has) at position 0 holds every word of a given length.
+struct wildcard {
+    const struct dindex *idx;
+
+    // Distinct keys (sorted), and where each one's word list starts in `postings`.
+    // Words for `keys[i]` are `postings[offsets[i]]` through `postings[offsets[i + 1] - 1]`, in ascending order.
+    uint32_t *keys;
+    uint32_t *offsets;
+    uint32_t nkeys;
+
+    uint32_t *postings;
+};
+
+// Check if a query is a wildcard pattern (it has a '?' or '？' somewhere).
+extern bool wildcard_is_pattern(const char *query);
+
+// Build a positional index over the words in `idx` (which must outlive it). Returns NULL on failure.
+extern struct wildcard *wildcard_build(const struct dindex *idx);
+
+// Perform a block on up to `k` words matching a pattern (like "一?不?") in codepoint order.
+// Words match if they have exactly as many codepoints as the pattern, and the same codepoint wherever it has no wildcard.
+// If `blk` returns any non-zero value, stop early. Returns the total number of matching words.
+extern size_t wildcard_match(const struct wildcard *wc, const char *pattern, size_t k, int (^blk)(const struct dindex_word *word));
+
+// Free a positional index.
+extern void wildcard_free(struct wildcard *wc);
+
+#endif /* !defined(__WILDCARD__) */
@@ -68,6 +68,12 @@ struct xlsx {
 // Get value of `XLSX_TYPE_STR` entries.
 #define xlsx_str(doc, val) ((doc)->strtab.base[(val)->sref])
 
+// Given we know entry->type is STR or LSTR get the string value of entry
+#define XLSX_STRVAL(doc, entry) (((entry)->type == XLSX_TYPE_STR) ? xlsx_str(doc, (entry)) : (entry)->str)
+
+// Check if an xlsx value holds any type of string.
+#define XLSX_ISSTR(entry) ((entry)->type == XLSX_TYPE_STR || (entry)->type == XLSX_TYPE_LSTR)
+
 // Get # of rows/cols in a document.
 #define xlsx_rows(doc) ((doc)->rows)
 #define xlsx_cols(doc) ((doc)->cols)
@@ -75,6 +81,12 @@ struct xlsx {
 // Read in excel document at a given path.
 extern struct xlsx *xlsx_doc_at(const char *path);
 
+// Read the rows of an excel document at a given path one at a time as they're parsed, without ever holding the whole sheet.
+// `blk` is called on each row like `xlsx_foreach_row`. The `doc` it's passed has the string table and column count (set by the first row),
+//   but only holds the current row, and both are only valid during the call.
+// Returns non-zero on failure. If `blk` returns any value other than 0, the function will stop and return this value.
+extern int xlsx_stream_at(const char *path, int (^blk)(const struct xlsx *doc, struct xlsx_value *row, size_t n));
+
 // Get the i'th row in an excel document
 extern struct xlsx_value *xlsx_row(struct xlsx *doc, size_t i);
 
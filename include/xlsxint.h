@@ -0,0 +1,20 @@
+/* ********************************************************** */
+/* -*- xlsxint.h -*- XLSX reader internals                -*- */
+/* ********************************************************** */
+/* Tyler Besselman (C) October 2026                           */
+/* ********************************************************** */
+
+#ifndef __XLSXINT__
+#define __XLSXINT__ 1
+
+#include <stddef.h>
+
+#include <xlsx.h>
+
+// Only the reader itself and the benchmarks should need these.
+
+// Fill in a cell from its type attribute (which may be NULL) and the text of its value.
+// `row` and `col` are just for messages. Returns non-zero (leaving the cell empty) if the value is malformed.
+extern int _xlsx_value(struct xlsx_value *slot, const char *type, const char *value, size_t row, size_t col);
+
+#endif /* !defined(__XLSXINT__) */
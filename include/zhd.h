@@ -0,0 +1,149 @@
+/* ********************************************************** */
+/* -*- zhd.h -*- Compact read-only dictionary files       -*- */
+/* ********************************************************** */
+/* Tyler Besselman (C) October 2026                           */
+/* ********************************************************** */
+
+#ifndef __ZHD__
+#define __ZHD__ 1
+
+#include <sys/types.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <mapfile.h>
+
+// Magic bytes and version at the start of zhd files. Bump the version if the layout or hash changes.
+#define ZHD_MAGIC "ZHDICT01"
+#define ZHD_VERSION 1
+
+// Sections are page aligned, so each one starts on its own page when mapped.
+#define ZHD_ALIGN 4096
+
+// Offset value used for missing strings in the pool.
+#define ZHD_NONE UINT32_MAX
+
+// Words are front coded in blocks of this many. The first word in each block is stored whole.
+#define ZHD_BLOCK 16
+
+// Longest word (in bytes, including the `\0`) which can be stored.
+#define ZHD_MAX_WORD 1024
+
+// A single dictionary entry. Strings are offsets into the pool (`ZHD_NONE` if missing).
+struct zhd_entry {
+    uint32_t def;
+    uint32_t zhuyin;
+    uint32_t pinyin;
+
+    // Row number of this entry in the source document.
+    uint32_t row;
+};
+
+// A unique word. Entries for word `w` are `entries[words[w].first]` through `entries[words[w].first + words[w].count - 1]`.
+struct zhd_word {
+    uint32_t first;
+    uint32_t count;
+};
+
+// Hash table slot. Slots are empty when `word` is 0; otherwise it is the word index + 1.
+struct zhd_slot {
+    uint32_t hash;
+    uint32_t word;
+};
+
+// Fixed width record for a single character word, sorted by codepoint.
+struct zhd_char {
+    uint32_t cp;
+
+    // Codepoint of the radical (0 if unknown), and stroke counts (0 if unknown).
+    uint32_t radical;
+    uint8_t strokes;
+    uint8_t xstrokes;
+    uint16_t reserved;
+
+    // Index of the word for this character.
+    uint32_t word;
+};
+
+// Header at the start of a zhd file. Everything after this is a section at a given (page aligned) offset from the start of the file.
+// Every reference inside the file is an offset or an index, so it is used exactly as mapped.
+struct zhd_header {
+    struct mapfile_header file;
+
+    // Element counts.
+    uint32_t nwords;
+    uint32_t nentries;
+    uint32_t nslots;
+    uint32_t nchars;
+    uint32_t nblocks;
+    uint32_t reserved;
+
+    // Offsets and sizes of each section.
+    // `keys` holds front coded words, and `blocks` the offset in `keys` where each block of `ZHD_BLOCK` words starts.
+    struct mapfile_section pool, keys, blocks, words, entries, slots, chars;
+};
+
+// An open zhd file. Everything points into the mapping.
+struct zhd {
+    const char *pool;
+    size_t pool_size;
+
+    const uint8_t *keys;
+    size_t keys_size;
+
+    const uint32_t *blocks;
+    uint32_t nblocks;
+
+    const struct zhd_word *words;
+    uint32_t nwords;
+
+    const struct zhd_entry *entries;
+    uint32_t nentries;
+
+    // Open addressing (linear probing) hash table over words. `nslots` is a power of 2.
+    const struct zhd_slot *slots;
+    uint32_t nslots;
+
+    const struct zhd_char *chars;
+    uint32_t nchars;
+
+    void *map;
+    size_t map_size;
+};
+
+// Get a string from the pool of a zhd file. Offsets past the end of the pool (like `ZHD_NONE`) give an empty string.
+// Since the pool is checked to end with a `\0`, this is always safe to read even if the rest of the file is corrupt.
+#define zhd_str(zd, off) ((off) < (zd)->pool_size ? &(zd)->pool[(off)] : "")
+
+// Hash `len` bytes of a word (as stored in the hash table).
+extern uint32_t zhd_hash(const char *str, size_t len);
+
+// Check if the file at `path` looks like a zhd file (it starts with `ZHD_MAGIC`).
+extern bool zhd_is_file(const char *path);
+
+// Map a zhd file. Only the header (and the last byte of the string pool, which must end a string) is checked,
+//   so opening doesn't touch the rest of the file. Returns NULL on failure.
+extern struct zhd *zhd_open(const char *path);
+
+// Decode word `w` into `buf` (which must have room for `ZHD_MAX_WORD` bytes). Returns its length, or -1 if the file is corrupt.
+extern ssize_t zhd_word(const struct zhd *zd, uint32_t w, char *buf);
+
+// Find a word, returning its index (or -1 if it isn't in the dictionary).
+extern int64_t zhd_find(const struct zhd *zd, const char *word, size_t len);
+
+// Perform a block on each entry for an exact word. Returns the number of matching entries.
+// If `blk` returns any non-zero value, stop early.
+extern size_t zhd_lookup(const struct zhd *zd, const char *word, int (^blk)(const struct zhd_entry *entry));
+
+// Perform a block on up to `k` words starting with `prefix`, in codepoint order. The word is only valid during the call.
+// If `blk` returns any non-zero value, stop early. Returns the number of words passed to `blk`.
+extern size_t zhd_prefix(const struct zhd *zd, const char *prefix, size_t k, int (^blk)(const char *word, uint32_t w));
+
+// Find the record for a single character, returning NULL if there isn't one.
+extern const struct zhd_char *zhd_char(const struct zhd *zd, uint32_t cp);
+
+// Close a zhd file.
+extern void zhd_close(struct zhd *zd);
+
+#endif /* !defined(__ZHD__) */
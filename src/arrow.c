@@ -0,0 +1,630 @@
+/* ********************************************************** */
+/* -*- arrow.c -*- Apache Arrow IPC file writer           -*- */
+/* ********************************************************** */
+/* Tyler Besselman (C) October 2026                           */
+/* ********************************************************** */
+
+#include <strings.h>
+#include <stdbool.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+
+#include <arrow.h>
+#include <mapfile.h>
+#include <obuf.h>
+
+// Enable debug messages
+#define DEBUG_ARROW 0
+
+// Metadata version written (V5).
+#define ARROW_VERSION 4
+
+// Message header types (the `MessageHeader` union in Message.fbs).
+#define ARROW_HEADER_SCHEMA 1
+#define ARROW_HEADER_BATCH  3
+
+// Types from the `Type` union in Schema.fbs.
+#define ARROW_FB_INT   2
+#define ARROW_FB_FLOAT 3
+#define ARROW_FB_UTF8  5
+
+// `Precision.DOUBLE` for floating point fields.
+#define ARROW_DOUBLE 2
+
+// Every buffer in a body starts on this boundary.
+#define ARROW_ALIGN 8
+
+// Metadata is FlatBuffers, which we write by hand (there's only a handful of tables) front to back:
+//   a table comes first and whatever it refers to is appended after it, then the offset to it is patched in.
+// Offsets all point forward, and every scalar is aligned to its size (the buffer starts 8 byte aligned in the file).
+
+// Field of a table being written. Absent fields have no size. References are offsets patched in later.
+struct _fb_field {
+    uint8_t size;
+    bool ref;
+
+    uint64_t value;
+};
+
+#define _FB_NONE            ((struct _fb_field){ .size = 0 })
+#define _FB_SCALAR(n, v)    ((struct _fb_field){ .size = (n), .value = (uint64_t)(v) })
+#define _FB_REF             ((struct _fb_field){ .size = 4, .ref = true })
+
+// Put a little endian value of `size` bytes at `at`.
+static void _fb_put(struct obuf *b, size_t at, uint64_t value, size_t size)
+{
+    for (size_t i = 0; i < size; i++) {
+        b->data[at + i] = (char)(value >> (8 * i));
+    }
+}
+
+// Point the offset at `at` to `target`.
+static void _fb_patch(struct obuf *b, size_t at, size_t target)
+{ _fb_put(b, at, target - at, 4); }
+
+// Append `n` zero bytes. Returns where they start, or SIZE_MAX on failure.
+static size_t _fb_zero(struct obuf *b, size_t n)
+{
+    if (!n) { return b->len; }
+    if (obuf_reserve(b, n)) { return SIZE_MAX; }
+
+    memset(&b->data[b->len], 0, n);
+    b->len += n;
+
+    return b->len - n;
+}
+
+// Pad with zeroes until the position `extra` bytes on is aligned to `align`.
+static int _fb_align(struct obuf *b, size_t align, size_t extra)
+{
+    size_t pad = (align - ((b->len + extra) & (align - 1))) & (align - 1);
+    return (_fb_zero(b, pad) == SIZE_MAX);
+}
+
+// Write a table (and its vtable) with `n` fields, by id, which the offset at `at` points to.
+// The position of each field is put in `pos`, so references can be patched in. Returns non-zero on failure.
+static int _fb_table(struct obuf *b, size_t at, size_t n, const struct _fb_field *fields, size_t *pos)
+{
+    uint16_t offsets[n + 1];
+    uint16_t size = 4;
+
+    // Fields are laid out biggest first, so only the first 8 byte field can need padding.
+    for (uint8_t width = 8; width; width /= 2)
+    {
+        for (size_t i = 0; i < n; i++)
+        {
+            if (fields[i].size != width) { continue; }
+
+            size = (size + width - 1) & ~(width - 1);
+            offsets[i] = size;
+            size += width;
+        }
+    }
+
+    size_t vtsize = 4 + (2 * n);
+
+    // The table itself starts 8 byte aligned, right after its vtable.
+    if (_fb_align(b, 8, vtsize)) { return 1; }
+
+    size_t vtable = _fb_zero(b, vtsize + size);
+    if (vtable == SIZE_MAX) { return 1; }
+
+    size_t table = vtable + vtsize;
+
+    _fb_put(b, vtable, vtsize, 2);
+    _fb_put(b, vtable + 2, size, 2);
+    _fb_put(b, table, vtsize, 4);
+
+    for (size_t i = 0; i < n; i++)
+    {
+        if (!fields[i].size) { continue; }
+
+        _fb_put(b, vtable + 4 + (2 * i), offsets[i], 2);
+        pos[i] = table + offsets[i];
+
+        if (!fields[i].ref) {
+            _fb_put(b, pos[i], fields[i].value, fields[i].size);
+        }
+    }
+
+    _fb_patch(b, at, table);
+    return 0;
+}
+
+// Write a vector of `n` zeroed elements of `width` bytes which the offset at `at` points to.
+// Returns where the elements start (0 on failure, since that's never an element).
+static size_t _fb_vector(struct obuf *b, size_t at, size_t n, size_t width, size_t align)
+{
+    if (_fb_align(b, (align > 4 ? align : 4), 4)) { return 0; }
+
+    size_t start = _fb_zero(b, 4 + (n * width));
+    if (start == SIZE_MAX) { return 0; }
+
+    _fb_put(b, start, n, 4);
+    _fb_patch(b, at, start);
+
+    return start + 4;
+}
+
+// Write a string which the offset at `at` points to.
+static int _fb_string(struct obuf *b, size_t at, const char *str)
+{
+    size_t len = strlen(str);
+
+    if (_fb_align(b, 4, 0)) { return 1; }
+
+    size_t start = _fb_zero(b, 4);
+    if (start == SIZE_MAX) { return 1; }
+
+    _fb_put(b, start, len, 4);
+    _fb_patch(b, at, start);
+
+    // Strings keep a `\0` terminator.
+    return (obuf_append(b, str, len) || _fb_zero(b, 1) == SIZE_MAX);
+}
+
+// A column being written.
+struct _arrow_col {
+    const char *name;
+    enum arrow_type type;
+};
+
+// Where a buffer is in a record batch body.
+struct _arrow_buf {
+    uint64_t offset;
+    uint64_t len;
+};
+
+// A node (array) in a record batch.
+struct _arrow_node {
+    uint64_t len;
+    uint64_t nulls;
+};
+
+// A message in the file (a `Block` in the footer).
+struct _arrow_block {
+    uint64_t offset;
+    uint32_t meta_len;
+    uint64_t body_len;
+};
+
+const char *arrow_type_name(enum arrow_type type)
+{
+    switch (type)
+    {
+        case ARROW_INT64:   return "int64";
+        case ARROW_FLOAT64: return "float64";
+        case ARROW_UTF8:    return "utf8";
+    }
+
+    return "?";
+}
+
+enum arrow_type arrow_infer(struct xlsx *doc, size_t col)
+{
+    __block enum arrow_type type = ARROW_INT64;
+
+    xlsx_iter_col(doc, col, ^(struct xlsx_value *entry, size_t n) {
+        if (!n) { return 0; }
+
+        switch (entry->type)
+        {
+            case XLSX_TYPE_NULL:  break;
+            case XLSX_TYPE_INT:   break;
+            case XLSX_TYPE_FLOAT: type = ARROW_FLOAT64; break;
+
+            default:
+                type = ARROW_UTF8;
+                return 1;
+        }
+
+        return 0;
+    });
+
+    return type;
+}
+
+// Write the type of a field (the table for the `Type` union member) which the offset at `at` points to.
+static int _arrow_fb_type(struct obuf *b, size_t at, enum arrow_type type)
+{
+    size_t pos[2];
+
+    switch (type)
+    {
+        case ARROW_INT64:
+            return _fb_table(b, at, 2, (struct _fb_field[]){ _FB_SCALAR(4, 64), _FB_SCALAR(1, true) }, pos);
+
+        case ARROW_FLOAT64:
+            return _fb_table(b, at, 1, (struct _fb_field[]){ _FB_SCALAR(2, ARROW_DOUBLE) }, pos);
+
+        case ARROW_UTF8:
+            return _fb_table(b, at, 0, NULL, pos);
+    }
+
+    return 1;
+}
+
+// Write the schema which the offset at `at` points to.
+static int _arrow_fb_schema(struct obuf *b, size_t at, const struct _arrow_col *cols, size_t ncols)
+{
+    // Arrays are written in the machine's own byte order.
+    bool big = (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__);
+    size_t pos[2];
+
+    if (_fb_table(b, at, 2, (struct _fb_field[]){ _FB_SCALAR(2, big), _FB_REF }, pos)) {
+        return 1;
+    }
+
+    size_t fields = _fb_vector(b, pos[1], ncols, 4, 4);
+    if (!fields) { return 1; }
+
+    for (size_t j = 0; j < ncols; j++)
+    {
+        static const uint8_t fb_types[] = {
+            [ARROW_INT64]   = ARROW_FB_INT,
+            [ARROW_FLOAT64] = ARROW_FB_FLOAT,
+            [ARROW_UTF8]    = ARROW_FB_UTF8
+        };
+
+        // name, nullable, type (union tag and table), dictionary, children (readers want this, even when empty)
+        struct _fb_field field[6] = { _FB_REF, _FB_SCALAR(1, true), _FB_SCALAR(1, fb_types[cols[j].type]), _FB_REF, _FB_NONE, _FB_REF };
+        size_t fpos[6];
+
+        if (_fb_table(b, fields + (4 * j), 6, field, fpos)
+         || _fb_string(b, fpos[0], cols[j].name)
+         || _arrow_fb_type(b, fpos[3], cols[j].type)
+         || !_fb_vector(b, fpos[5], 0, 4, 4)) {
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+// Start a message, returning where the offset to its header is (0 on failure).
+static size_t _arrow_fb_message(struct obuf *b, uint8_t type, uint64_t body_len)
+{
+    size_t pos[4];
+
+    b->len = 0;
+
+    // The root offset comes first.
+    if (_fb_zero(b, 4) == SIZE_MAX) { return 0; }
+
+    struct _fb_field message[4] = { _FB_SCALAR(2, ARROW_VERSION), _FB_SCALAR(1, type), _FB_REF, _FB_SCALAR(8, body_len) };
+    return (_fb_table(b, 0, 4, message, pos) ? 0 : pos[2]);
+}
+
+// Write a message: a continuation marker, the length of the metadata, the metadata (padded to 8 bytes), then the body.
+static int _arrow_message(FILE *fp, struct obuf *meta, const struct obuf *body, uint64_t *offset, struct _arrow_block *block)
+{
+    if (_fb_align(meta, ARROW_ALIGN, 0)) { return 1; }
+
+    uint8_t prefix[8];
+    struct obuf pre = { .data = (char *)prefix, .len = 8, .cap = 8 };
+
+    _fb_put(&pre, 0, 0xFFFFFFFF, 4);
+    _fb_put(&pre, 4, meta->len, 4);
+
+    if (fwrite(prefix, 1, 8, fp) != 8 || fwrite(meta->data, 1, meta->len, fp) != meta->len) {
+        return 1;
+    }
+
+    if (body && body->len && fwrite(body->data, 1, body->len, fp) != body->len) {
+        return 1;
+    }
+
+    if (block)
+    {
+        block->offset = *offset;
+        block->meta_len = (uint32_t)(8 + meta->len);
+        block->body_len = (body ? body->len : 0);
+    }
+
+    *offset += 8 + meta->len + (body ? body->len : 0);
+    return 0;
+}
+
+// Start a buffer at the end of a body.
+static void _arrow_buf_start(const struct obuf *body, struct _arrow_buf *buf)
+{ buf->offset = body->len; }
+
+// Finish the buffer started last, padding the body for the next one.
+static int _arrow_buf_end(struct obuf *body, struct _arrow_buf *buf)
+{
+    buf->len = body->len - buf->offset;
+    return _fb_align(body, ARROW_ALIGN, 0);
+}
+
+// Get the text of a value in a string column (numbers are formatted into `buf`).
+static const char *_arrow_text(struct xlsx *doc, const struct xlsx_value *value, char buf[32])
+{
+    switch (value->type)
+    {
+        case XLSX_TYPE_STR:   return xlsx_str(doc, value);
+        case XLSX_TYPE_LSTR:  return value->str;
+        case XLSX_TYPE_INT:   snprintf(buf, 32, "%lld", (long long)value->ival); return buf;
+        case XLSX_TYPE_FLOAT: snprintf(buf, 32, "%.15g", value->fval);          return buf;
+        case XLSX_TYPE_NULL:  break;
+    }
+
+    return "";
+}
+
+// Add the buffers for rows [`start`, `end`) of a column to a body.
+static int _arrow_column(struct xlsx *doc, size_t col, enum arrow_type type, size_t start, size_t end,
+                         struct obuf *body, struct _arrow_node *node, struct _arrow_buf *bufs)
+{
+    size_t n = end - start;
+
+    node->len = n;
+    node->nulls = 0;
+
+    for (size_t i = start; i < end; i++) {
+        node->nulls += (xlsx_row(doc, i)[col].type == XLSX_TYPE_NULL);
+    }
+
+    // The validity bitmap can be left out entirely when there are no nulls.
+    _arrow_buf_start(body, &bufs[0]);
+
+    if (node->nulls)
+    {
+        size_t at = _fb_zero(body, (n + 7) / 8);
+        if (at == SIZE_MAX) { return 1; }
+
+        for (size_t i = 0; i < n; i++)
+        {
+            if (xlsx_row(doc, start + i)[col].type != XLSX_TYPE_NULL) {
+                body->data[at + (i / 8)] |= (char)(1 << (i % 8));
+            }
+        }
+    }
+
+    if (_arrow_buf_end(body, &bufs[0])) { return 1; }
+
+    if (type != ARROW_UTF8)
+    {
+        _arrow_buf_start(body, &bufs[1]);
+
+        if (obuf_reserve(body, n * 8)) { return 1; }
+
+        for (size_t i = start; i < end; i++)
+        {
+            const struct xlsx_value *value = &xlsx_row(doc, i)[col];
+
+            int64_t ival = (value->type == XLSX_TYPE_INT ? value->ival : 0);
+            double fval = (value->type == XLSX_TYPE_FLOAT ? value->fval : (double)ival);
+
+            memcpy(&body->data[body->len], (type == ARROW_INT64 ? (void *)&ival : (void *)&fval), 8);
+            body->len += 8;
+        }
+
+        return _arrow_buf_end(body, &bufs[1]);
+    }
+
+    // Strings have `n + 1` offsets into their data, then the data.
+    _arrow_buf_start(body, &bufs[1]);
+
+    size_t offsets = _fb_zero(body, (n + 1) * 4);
+    if (offsets == SIZE_MAX || _arrow_buf_end(body, &bufs[1])) { return 1; }
+
+    _arrow_buf_start(body, &bufs[2]);
+
+    for (size_t i = start; i < end; i++)
+    {
+        char buf[32];
+        const char *text = _arrow_text(doc, &xlsx_row(doc, i)[col], buf);
+
+        if (obuf_puts(body, text)) { return 1; }
+
+        uint64_t len = body->len - bufs[2].offset;
+
+        if (len > INT32_MAX)
+        {
+            fprintf(stderr, "Error: Column %zu has too much text for one record batch (use smaller batches).\n", col);
+            return 1;
+        }
+
+        int32_t off = (int32_t)len;
+        memcpy(&body->data[offsets + 4 * (i - start + 1)], &off, 4);
+    }
+
+    return _arrow_buf_end(body, &bufs[2]);
+}
+
+// Write a record batch of rows [`start`, `end`).
+static int _arrow_batch(FILE *fp, struct xlsx *doc, const struct _arrow_col *cols, size_t ncols, size_t start, size_t end,
+                        struct obuf *meta, struct obuf *body, uint64_t *offset, struct _arrow_block *block)
+{
+    // At most 3 buffers per column.
+    struct _arrow_node nodes[ncols];
+    struct _arrow_buf bufs[3 * ncols];
+    size_t nbufs = 0;
+
+    body->len = 0;
+
+    for (size_t j = 0; j < ncols; j++)
+    {
+        if (_arrow_column(doc, j, cols[j].type, start, end, body, &nodes[j], &bufs[nbufs])) {
+            return 1;
+        }
+
+        nbufs += (cols[j].type == ARROW_UTF8 ? 3 : 2);
+    }
+
+    size_t header = _arrow_fb_message(meta, ARROW_HEADER_BATCH, body->len);
+    size_t pos[3];
+
+    // length, nodes, buffers
+    if (!header || _fb_table(meta, header, 3, (struct _fb_field[]){ _FB_SCALAR(8, end - start), _FB_REF, _FB_REF }, pos)) {
+        return 1;
+    }
+
+    size_t at = _fb_vector(meta, pos[1], ncols, 16, 8);
+    if (!at) { return 1; }
+
+    for (size_t j = 0; j < ncols; j++)
+    {
+        _fb_put(meta, at + (16 * j), nodes[j].len, 8);
+        _fb_put(meta, at + (16 * j) + 8, nodes[j].nulls, 8);
+    }
+
+    if (!(at = _fb_vector(meta, pos[2], nbufs, 16, 8))) { return 1; }
+
+    for (size_t i = 0; i < nbufs; i++)
+    {
+        _fb_put(meta, at + (16 * i), bufs[i].offset, 8);
+        _fb_put(meta, at + (16 * i) + 8, bufs[i].len, 8);
+    }
+
+    return _arrow_message(fp, meta, body, offset, block);
+}
+
+// Write the footer: the schema again and where each record batch is, then its length and the magic.
+static int _arrow_footer(FILE *fp, const struct _arrow_col *cols, size_t ncols, const struct _arrow_block *blocks, size_t nblocks, struct obuf *meta)
+{
+    size_t pos[4];
+
+    meta->len = 0;
+
+    if (_fb_zero(meta, 4) == SIZE_MAX) { return 1; }
+
+    // version, schema, dictionaries, record batches
+    if (_fb_table(meta, 0, 4, (struct _fb_field[]){ _FB_SCALAR(2, ARROW_VERSION), _FB_REF, _FB_REF, _FB_REF }, pos)
+     || _arrow_fb_schema(meta, pos[1], cols, ncols)
+     || !_fb_vector(meta, pos[2], 0, 24, 8)) {
+        return 1;
+    }
+
+    size_t at = _fb_vector(meta, pos[3], nblocks, 24, 8);
+    if (!at) { return 1; }
+
+    for (size_t i = 0; i < nblocks; i++)
+    {
+        _fb_put(meta, at + (24 * i), blocks[i].offset, 8);
+        _fb_put(meta, at + (24 * i) + 8, blocks[i].meta_len, 4);
+        _fb_put(meta, at + (24 * i) + 16, blocks[i].body_len, 8);
+    }
+
+    uint8_t tail[4];
+    struct obuf len = { .data = (char *)tail, .len = 4, .cap = 4 };
+
+    _fb_put(&len, 0, meta->len, 4);
+
+    return (fwrite(meta->data, 1, meta->len, fp) != meta->len
+         || fwrite(tail, 1, 4, fp) != 4
+         || fwrite(ARROW_MAGIC, 1, 6, fp) != 6);
+}
+
+static int _arrow_write(FILE *fp, struct xlsx *doc, const struct _arrow_col *cols, size_t ncols, size_t batch_rows, struct arrow_stats *stats)
+{
+    size_t rows = xlsx_rows(doc) - 1;
+    size_t nblocks = (rows + batch_rows - 1) / batch_rows;
+
+    struct _arrow_block *blocks = calloc(nblocks + 1, sizeof(struct _arrow_block));
+
+    if (!blocks)
+    {
+        perror("calloc");
+        return 1;
+    }
+
+    struct obuf meta = OBUF_INIT;
+    struct obuf body = OBUF_INIT;
+
+    // The magic is padded to 8 bytes at the start.
+    uint64_t offset = 8;
+    int failed = (fwrite(ARROW_MAGIC "\0\0", 1, 8, fp) != 8);
+
+    // The schema message has no body.
+    size_t header = (failed ? 0 : _arrow_fb_message(&meta, ARROW_HEADER_SCHEMA, 0));
+    failed = (!header || _arrow_fb_schema(&meta, header, cols, ncols) || _arrow_message(fp, &meta, NULL, &offset, NULL));
+
+    for (size_t i = 0; !failed && i < nblocks; i++)
+    {
+        // Row 0 names the columns.
+        size_t start = 1 + (i * batch_rows);
+        size_t end = (start + batch_rows < rows + 1 ? start + batch_rows : rows + 1);
+
+        failed = _arrow_batch(fp, doc, cols, ncols, start, end, &meta, &body, &offset, &blocks[i]);
+
+        if (DEBUG_ARROW && !failed) {
+            fprintf(stderr, "Batch %zu: rows [%zu, %zu), %llu byte body.\n", i, start, end, (unsigned long long)blocks[i].body_len);
+        }
+    }
+
+    // The stream ends with a continuation marker and no metadata, then comes the footer.
+    static const uint8_t eos[8] = { 0xFF, 0xFF, 0xFF, 0xFF, 0, 0, 0, 0 };
+
+    failed = (failed || fwrite(eos, 1, 8, fp) != 8);
+    offset += 8;
+
+    failed = (failed || _arrow_footer(fp, cols, ncols, blocks, nblocks, &meta));
+
+    if (!failed)
+    {
+        stats->rows = rows;
+        stats->batches = nblocks;
+        stats->bytes = offset + meta.len + 10;
+    }
+
+    obuf_free(&meta);
+    obuf_free(&body);
+    free(blocks);
+
+    return failed;
+}
+
+int arrow_write(const char *path, struct xlsx *doc, size_t batch_rows, struct arrow_stats *stats)
+{
+    size_t ncols = xlsx_cols(doc);
+
+    if (!xlsx_rows(doc) || !ncols || !batch_rows)
+    {
+        fprintf(stderr, "Error: Nothing to write (the sheet needs a row of column names).\n");
+        return 1;
+    }
+
+    struct _arrow_col *cols = calloc(ncols, sizeof(struct _arrow_col));
+    char **names = calloc(ncols, sizeof(char *));
+
+    int failed = (!cols || !names);
+
+    if (failed) {
+        perror("calloc");
+    }
+
+    for (size_t j = 0; !failed && j < ncols; j++)
+    {
+        char buf[32];
+
+        // Column names are copied so numbers formatted into `buf` survive.
+        if (!(names[j] = strdup(_arrow_text(doc, &xlsx_row(doc, 0)[j], buf))))
+        {
+            perror("strdup");
+            failed = 1;
+
+            break;
+        }
+
+        cols[j].name = names[j];
+        cols[j].type = arrow_infer(doc, j);
+    }
+
+    if (!failed)
+    {
+        failed = mapfile_save(path, ^(FILE *fp) {
+            return _arrow_write(fp, doc, cols, ncols, batch_rows, stats);
+        });
+    }
+
+    for (size_t j = 0; names && j < ncols; j++) {
+        free(names[j]);
+    }
+
+    free(names);
+    free(cols);
+
+    return failed;
+}
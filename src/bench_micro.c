@@ -0,0 +1,616 @@
+/* ********************************************************** */
+/* -*- bench_micro.c -*- XML and XLSX primitive benchmark -*- */
+/* ********************************************************** */
+/* Tyler Besselman (C) October 2026                           */
+/* ********************************************************** */
+
+// Times the per-node and per-cell primitives loading a workbook spends its time in, each on its own, against a fixed
+//   synthetic sheet (parsed into an XML tree) and grid. Reports ns/op, and cycles/op where perf_event_open is available.
+
+#include <strings.h>
+#include <string.h>
+#include <stdbool.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <sys/ioctl.h>
+#include <errno.h>
+#endif /* defined(__linux__) */
+
+#include <metrics.h>
+#include <synth.h>
+#include <obuf.h>
+#include <utf8.h>
+#include <xlsxint.h>
+#include <xlsx.h>
+#include <xml.h>
+
+// Columns in the synthetic sheet and grid (like the real dictionary).
+#define FIXTURE_COLS 12
+
+// Number of timed samples taken of each benchmark (the median is reported).
+#define SAMPLES 7
+
+// Most timed samples we keep (`-n` can't ask for more).
+#define MAX_SAMPLES 64
+
+// Fixed inputs every benchmark runs against. Nothing here changes once it's built.
+struct fixture {
+    // The sheet, with every cell node (in document order) and the number of nodes in the whole tree.
+    xmlNodePtr sheet;
+    xmlNodePtr *cells;
+    size_t ncells;
+    size_t nnodes;
+
+    // A grid like `xlsx_doc_at` makes (strings point into `pool`).
+    struct xlsx doc;
+    struct obuf pool;
+
+    // Cell values as they appear in a sheet (integers, then floats).
+    char **numbers;
+    size_t nints;
+    size_t nfloats;
+};
+
+// A benchmark runs its primitive once over the whole fixture, adding results to `sink` (so nothing is optimized away).
+// It returns the number of operations it did.
+struct bench {
+    const char *name;
+    size_t (*run)(const struct fixture *fx, size_t *sink);
+};
+
+// Look up the value of each cell, like `_xlsx_sheet` does.
+static size_t bench_xml_find(const struct fixture *fx, size_t *sink)
+{
+    for (size_t i = 0; i < fx->ncells; i++) {
+        (*sink) += (size_t)xml_find(fx->cells[i], "c.v.text");
+    }
+
+    return fx->ncells;
+}
+
+// Look up the reference of each cell, and its type (which most cells don't have).
+static size_t bench_xml_node_attribute(const struct fixture *fx, size_t *sink)
+{
+    for (size_t i = 0; i < fx->ncells; i++)
+    {
+        (*sink) += (size_t)xml_node_attribute(fx->cells[i], "r");
+        (*sink) += (size_t)xml_node_attribute(fx->cells[i], "t");
+    }
+
+    return fx->ncells * 2;
+}
+
+// Visit every node of the sheet.
+static size_t bench_xml_visit_tree(const struct fixture *fx, size_t *sink)
+{
+    __block size_t visited = 0;
+
+    xml_visit_tree(fx->sheet, 0, ^(xmlNodePtr node, size_t depth, size_t n) {
+        visited++;
+        return 0;
+    });
+
+    (*sink) += visited;
+    return visited;
+}
+
+// Convert integer cell values, like `_xlsx_sheet` does for cells without a type.
+static size_t bench_xlsx_value_int(const struct fixture *fx, size_t *sink)
+{
+    struct xlsx_value slot;
+
+    for (size_t i = 0; i < fx->nints; i++)
+    {
+        _xlsx_value(&slot, NULL, fx->numbers[i], i, 0);
+        (*sink) += (size_t)slot.ival;
+    }
+
+    return fx->nints;
+}
+
+// Convert float cell values.
+static size_t bench_xlsx_value_float(const struct fixture *fx, size_t *sink)
+{
+    struct xlsx_value slot;
+
+    for (size_t i = fx->nints; i < fx->nints + fx->nfloats; i++)
+    {
+        _xlsx_value(&slot, NULL, fx->numbers[i], i, 0);
+        (*sink) += (size_t)slot.fval;
+    }
+
+    return fx->nfloats;
+}
+
+// Convert string table references (cells with type "s").
+static size_t bench_xlsx_value_sref(const struct fixture *fx, size_t *sink)
+{
+    struct xlsx_value slot;
+
+    for (size_t i = 0; i < fx->nints; i++)
+    {
+        _xlsx_value(&slot, "s", fx->numbers[i], i, 0);
+        (*sink) += (size_t)slot.sref;
+    }
+
+    return fx->nints;
+}
+
+// Get the first byte of every string table cell.
+static size_t bench_xlsx_str(const struct fixture *fx, size_t *sink)
+{
+    const struct xlsx *doc = &fx->doc;
+    size_t n = doc->rows * doc->cols;
+
+    for (size_t i = 0; i < n; i++)
+    {
+        const struct xlsx_value *v = &doc->grid[i];
+
+        if (v->type == XLSX_TYPE_STR) {
+            (*sink) += (uint8_t)xlsx_str(doc, v)[0];
+        }
+    }
+
+    return n;
+}
+
+// Walk a single column.
+static size_t bench_xlsx_iter_col(const struct fixture *fx, size_t *sink)
+{
+    __block size_t seen = 0;
+
+    xlsx_iter_col((struct xlsx *)&fx->doc, 2, ^(struct xlsx_value *entry, size_t n) {
+        seen += entry->type;
+        return 0;
+    });
+
+    (*sink) += seen;
+    return xlsx_rows(&fx->doc);
+}
+
+// Walk every cell.
+static size_t bench_xlsx_foreach(const struct fixture *fx, size_t *sink)
+{
+    __block size_t seen = 0;
+
+    xlsx_foreach((struct xlsx *)&fx->doc, ^(struct xlsx_value *value, size_t row, size_t col) {
+        seen += value->type;
+        return 0;
+    });
+
+    (*sink) += seen;
+    return xlsx_rows(&fx->doc) * xlsx_cols(&fx->doc);
+}
+
+static const struct bench benches[] = {
+    { "xml_find",           bench_xml_find           },
+    { "xml_node_attribute", bench_xml_node_attribute },
+    { "xml_visit_tree",     bench_xml_visit_tree     },
+    { "xlsx_value_int",     bench_xlsx_value_int     },
+    { "xlsx_value_float",   bench_xlsx_value_float   },
+    { "xlsx_value_sref",    bench_xlsx_value_sref    },
+    { "xlsx_str",           bench_xlsx_str           },
+    { "xlsx_iter_col",      bench_xlsx_iter_col      },
+    { "xlsx_foreach",       bench_xlsx_foreach       }
+};
+
+#define NBENCHES (sizeof(benches) / sizeof(*benches))
+
+// Append `n` random characters to a buffer.
+static int put_chars(struct obuf *buf, uint64_t *state, size_t n)
+{
+    char ch[4];
+
+    for (size_t i = 0; i < n; i++)
+    {
+        if (obuf_append(buf, ch, utf8_encode(0x4E00 + synth_below(state, 6000), ch))) {
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+// Build the sheet XML (like the real dictionary's, with some cells missing) and parse it. Returns non-zero on failure.
+static int build_sheet(struct fixture *fx, size_t rows, uint64_t *state)
+{
+    struct obuf xml = OBUF_INIT;
+    int status = obuf_puts(&xml, "<worksheet xmlns=\"http://schemas.openxmlformats.org/spreadsheetml/2006/main\"><sheetData>");
+
+    for (size_t r = 1; !status && r <= rows; r++)
+    {
+        status = obuf_printf(&xml, "<row r=\"%zu\">", r);
+
+        for (size_t c = 0; !status && c < FIXTURE_COLS; c++)
+        {
+            uint64_t kind = synth_below(state, 100);
+
+            // The header row has every column, and half the cells in other rows are empty.
+            if (r > 1 && kind < 50) { continue; }
+
+            if (r == 1 || kind < 85) {
+                status = obuf_printf(&xml, "<c r=\"%c%zu\" t=\"s\"><v>%llu</v></c>", (char)('A' + c), r, (unsigned long long)synth_below(state, rows * 2));
+            } else {
+                status = obuf_printf(&xml, "<c r=\"%c%zu\"><v>%llu</v></c>", (char)('A' + c), r, (unsigned long long)synth_below(state, 100000));
+            }
+        }
+
+        status = status || obuf_puts(&xml, "</row>");
+    }
+
+    status = status || obuf_puts(&xml, "</sheetData></worksheet>");
+
+    if (status)
+    {
+        obuf_free(&xml);
+        return 1;
+    }
+
+    fx->sheet = xml_root_in(xml.data, xml.len);
+    obuf_free(&xml);
+
+    if (!fx->sheet) { return 1; }
+
+    // Collect every cell (and count every node) for the per-node benchmarks.
+    __block size_t ncells = 0;
+    __block size_t nnodes = 0;
+
+    xml_visit_tree(fx->sheet, 0, ^(xmlNodePtr node, size_t depth, size_t n) {
+        nnodes++;
+        ncells += !strcmp((const char *)node->name, "c");
+
+        return 0;
+    });
+
+    fx->cells = malloc(ncells * sizeof(xmlNodePtr));
+    fx->nnodes = nnodes;
+
+    if (!fx->cells)
+    {
+        perror("malloc");
+        return 1;
+    }
+
+    xmlNodePtr *cells = fx->cells;
+    __block size_t i = 0;
+
+    xml_visit_tree(fx->sheet, 0, ^(xmlNodePtr node, size_t depth, size_t n) {
+        if (strcmp((const char *)node->name, "c")) { return 0; }
+
+        cells[i++] = node;
+        return 1;
+    });
+
+    fx->ncells = ncells;
+    return 0;
+}
+
+// Build a grid and string table. Returns non-zero on failure.
+static int build_grid(struct fixture *fx, size_t rows, uint64_t *state)
+{
+    struct xlsx *doc = &fx->doc;
+    size_t nstrs = rows * 2;
+
+    size_t *offsets = malloc(nstrs * sizeof(size_t));
+
+    doc->strtab.base = malloc(nstrs * sizeof(char *));
+    doc->strtab.count = nstrs;
+    doc->strtab.ref = NULL;
+
+    doc->rows = rows;
+    doc->cols = FIXTURE_COLS;
+    doc->grid = malloc(rows * FIXTURE_COLS * sizeof(struct xlsx_value));
+
+    if (!offsets || !doc->strtab.base || !doc->grid)
+    {
+        perror("malloc");
+
+        free(offsets);
+        return 1;
+    }
+
+    // Offsets first, since the pool moves as it grows.
+    for (size_t i = 0; i < nstrs; i++)
+    {
+        offsets[i] = fx->pool.len;
+
+        if (put_chars(&fx->pool, state, 2 + synth_below(state, 30)) || obuf_append(&fx->pool, "", 1))
+        {
+            free(offsets);
+            return 1;
+        }
+    }
+
+    for (size_t i = 0; i < nstrs; i++) {
+        doc->strtab.base[i] = &fx->pool.data[offsets[i]];
+    }
+
+    free(offsets);
+
+    for (size_t i = 0; i < rows * FIXTURE_COLS; i++)
+    {
+        struct xlsx_value *v = &doc->grid[i];
+        uint64_t kind = synth_below(state, 100);
+
+        if (kind < 50) {
+            v->type = XLSX_TYPE_STR;
+            v->sref = synth_below(state, nstrs);
+        } else if (kind < 65) {
+            v->type = XLSX_TYPE_INT;
+            v->ival = synth_below(state, 100000);
+        } else {
+            v->type = XLSX_TYPE_NULL;
+        }
+    }
+
+    return 0;
+}
+
+// Build the number strings. Returns non-zero on failure.
+static int build_numbers(struct fixture *fx, size_t n, uint64_t *state)
+{
+    fx->numbers = calloc(n * 2, sizeof(char *));
+
+    if (!fx->numbers)
+    {
+        perror("calloc");
+        return 1;
+    }
+
+    fx->nints = n;
+    fx->nfloats = n;
+
+    for (size_t i = 0; i < n * 2; i++)
+    {
+        char buf[32];
+
+        if (i < n) {
+            snprintf(buf, sizeof(buf), "%llu", (unsigned long long)synth_below(state, (i & 1) ? 100 : 10000000));
+        } else {
+            snprintf(buf, sizeof(buf), "%.*f", (int)(1 + synth_below(state, 6)), (double)synth_below(state, 1000000) / 1000.0);
+        }
+
+        if (!(fx->numbers[i] = strdup(buf)))
+        {
+            perror("strdup");
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+static void free_fixture(struct fixture *fx)
+{
+    if (fx->sheet) { xmlFreeDoc(fx->sheet->doc); }
+    free(fx->cells);
+
+    free(fx->doc.strtab.base);
+    free(fx->doc.grid);
+    obuf_free(&fx->pool);
+
+    for (size_t i = 0; fx->numbers && i < fx->nints + fx->nfloats; i++) {
+        free(fx->numbers[i]);
+    }
+
+    free(fx->numbers);
+}
+
+// A CPU cycle counter for the calling thread (-1 if we can't have one).
+static int cycles_open(void)
+{
+#ifdef __linux__
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.size = sizeof(attr);
+    attr.config = PERF_COUNT_HW_CPU_CYCLES;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+
+    int fd = (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+
+    if (fd < 0) {
+        fprintf(stderr, "Warning: No cycle counts (perf_event_open: %s).\n", strerror(errno));
+    }
+
+    return fd;
+#else /* !defined(__linux__) */
+    fprintf(stderr, "Warning: No cycle counts (perf_event_open is Linux only).\n");
+    return -1;
+#endif /* defined(__linux__) */
+}
+
+static void cycles_start(int fd)
+{
+#ifdef __linux__
+    if (fd >= 0)
+    {
+        ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+        ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+    }
+#endif /* defined(__linux__) */
+}
+
+// Stop counting and get the count (0 if there's no counter).
+static uint64_t cycles_stop(int fd)
+{
+    uint64_t count = 0;
+
+#ifdef __linux__
+    if (fd >= 0)
+    {
+        ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+
+        if (read(fd, &count, sizeof(count)) != sizeof(count)) {
+            count = 0;
+        }
+    }
+#endif /* defined(__linux__) */
+
+    return count;
+}
+
+static int compare_double(const void *a, const void *b)
+{
+    double x = *(const double *)a;
+    double y = *(const double *)b;
+
+    return (x > y) - (x < y);
+}
+
+// Run a benchmark: warm up for `warmup_ns`, work out how many runs fill `sample_ns`, then time `nsamples` samples of that many.
+static void run(const struct bench *b, const struct fixture *fx, int fd, uint64_t warmup_ns, uint64_t sample_ns, size_t nsamples)
+{
+    volatile size_t result;
+    size_t sink = 0;
+
+    size_t ops = 0;
+    size_t warmups = 0;
+
+    // Warming up also tells us how long a run takes.
+    uint64_t start = metrics_now();
+    uint64_t elapsed;
+
+    do {
+        ops = b->run(fx, &sink);
+        warmups++;
+    } while ((elapsed = metrics_now() - start) < warmup_ns);
+
+    size_t iters = (size_t)((double)sample_ns / ((double)elapsed / warmups)) + 1;
+
+    double ns[MAX_SAMPLES];
+    double cycles[MAX_SAMPLES];
+
+    for (size_t s = 0; s < nsamples; s++)
+    {
+        cycles_start(fd);
+        uint64_t t0 = metrics_now();
+
+        for (size_t i = 0; i < iters; i++) {
+            b->run(fx, &sink);
+        }
+
+        uint64_t t1 = metrics_now();
+        uint64_t count = cycles_stop(fd);
+
+        ns[s] = (double)(t1 - t0) / ((double)iters * ops);
+        cycles[s] = (double)count / ((double)iters * ops);
+    }
+
+    result = sink;
+    (void)result;
+
+    double best = ns[0];
+
+    for (size_t s = 1; s < nsamples; s++) {
+        if (ns[s] < best) { best = ns[s]; }
+    }
+
+    qsort(ns, nsamples, sizeof(double), compare_double);
+    qsort(cycles, nsamples, sizeof(double), compare_double);
+
+    printf("%-20s %10zu %8zu %8zu %10.2f %10.2f ", b->name, ops, warmups, iters, ns[nsamples / 2], best);
+
+    if (fd >= 0) {
+        printf("%10.2f\n", cycles[nsamples / 2]);
+    } else {
+        printf("%10s\n", "-");
+    }
+}
+
+// Check whether a comma separated list has `name` in it (as a whole entry).
+static bool listed(const char *list, const char *name)
+{
+    size_t len = strlen(name);
+
+    for (const char *p = list; ; p++)
+    {
+        size_t n = strcspn(p, ",");
+        if (n == len && !memcmp(p, name, len)) { return true; }
+
+        p += n;
+        if (!*p) { return false; }
+    }
+}
+
+static void usage(const char *name)
+{
+    fprintf(stderr, "Usage: %s [-r rows] [-s seed] [-w warmup_ms] [-t sample_ms] [-n samples] [-b bench,...]\n", name);
+    fprintf(stderr, "Benchmarks are");
+
+    for (size_t b = 0; b < NBENCHES; b++) {
+        fprintf(stderr, "%s %s", (b ? "," : ""), benches[b].name);
+    }
+
+    fprintf(stderr, ".\n");
+}
+
+int main(int argc, char *const *argv)
+{
+    size_t rows = 20000;
+    uint64_t seed = 1;
+    uint64_t warmup_ms = 100;
+    uint64_t sample_ms = 100;
+    size_t nsamples = SAMPLES;
+
+    char *only = NULL;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "r:s:w:t:n:b:")) != -1)
+    {
+        switch (opt)
+        {
+            case 'r': rows = strtoul(optarg, NULL, 10); break;
+            case 's': seed = strtoull(optarg, NULL, 10); break;
+            case 'w': warmup_ms = strtoull(optarg, NULL, 10); break;
+            case 't': sample_ms = strtoull(optarg, NULL, 10); break;
+            case 'n': nsamples = strtoul(optarg, NULL, 10); break;
+            case 'b': only = optarg; break;
+            default:
+                usage(argv[0]);
+                return 1;
+        }
+    }
+
+    if (optind != argc || !rows || !nsamples || nsamples > MAX_SAMPLES)
+    {
+        usage(argv[0]);
+        return 1;
+    }
+
+    struct fixture fx = { .pool = OBUF_INIT };
+    uint64_t state = seed;
+
+    uint64_t t0 = metrics_now();
+
+    if (build_sheet(&fx, rows, &state) || build_grid(&fx, rows, &state) || build_numbers(&fx, rows, &state))
+    {
+        fprintf(stderr, "Error: Failed to build benchmark inputs!\n");
+        free_fixture(&fx);
+
+        return 1;
+    }
+
+    fprintf(stderr, "Built a %zu row sheet (%zu cells, %zu nodes) and grid in %.2fs.\n", rows, fx.ncells, fx.nnodes, (metrics_now() - t0) / 1e9);
+
+    int fd = cycles_open();
+
+    printf("%-20s %10s %8s %8s %10s %10s %10s\n", "benchmark", "ops/run", "warmups", "runs", "ns/op", "best", "cycles/op");
+
+    for (size_t b = 0; b < NBENCHES; b++)
+    {
+        if (only && !listed(only, benches[b].name)) { continue; }
+        run(&benches[b], &fx, fd, warmup_ms * 1000000ULL, sample_ms * 1000000ULL, nsamples);
+    }
+
+    if (fd >= 0) { close(fd); }
+
+    free_fixture(&fx);
+    return 0;
+}
@@ -0,0 +1,543 @@
+/* ********************************************************** */
+/* -*- bench_query.c -*- Dictionary lookup benchmark      -*- */
+/* ********************************************************** */
+/* Tyler Besselman (C) October 2026                           */
+/* ********************************************************** */
+
+// Replays a mix of queries against each lookup backend and reports throughput and latency percentiles.
+// Queries come from a file (one per line, a trailing '*' asks for completions) or are generated from the dictionary itself.
+
+#include <strings.h>
+#include <string.h>
+#include <stdbool.h>
+#include <unistd.h>
+
+#include <dindex.h>
+#include <metrics.h>
+#include <synth.h>
+#include <hist.h>
+#include <utf8.h>
+
+// Exact hits with at least this many characters are counted as long words.
+#define LONG_CHARS 5
+
+// Number of queries run before timing starts.
+#define WARMUP_QUERIES 1000
+
+// Categories of queries. Each gets its own histogram.
+enum kind {
+    KIND_HIT,
+    KIND_MISS,
+    KIND_PREFIX,
+    KIND_LONG,
+    KIND_COUNT
+};
+
+static const char *kind_names[KIND_COUNT] = { "hit", "miss", "prefix", "long" };
+
+struct query {
+    const char *str;
+    enum kind kind;
+};
+
+// A way of answering queries. Each function returns the number of results (so the work can't be skipped).
+struct backend {
+    const char *name;
+
+    size_t (*exact)(const struct dindex *idx, const char *word);
+    size_t (*prefix)(const struct dindex *idx, const char *prefix, size_t k);
+
+    // Only run this many queries if set (for anything too slow to run the full set).
+    bool limited;
+};
+
+// What xldict used to do: compare against every entry in document order.
+static size_t linear_exact(const struct dindex *idx, const char *word)
+{
+    size_t matches = 0;
+
+    for (uint32_t i = 0; i < idx->nentries; i++)
+    {
+        if (!strcmp(dindex_str(idx, idx->entries[i].word), word)) {
+            matches++;
+        }
+    }
+
+    return matches;
+}
+
+static size_t linear_prefix(const struct dindex *idx, const char *prefix, size_t k)
+{
+    size_t len = strlen(prefix);
+    size_t matches = 0;
+
+    for (uint32_t i = 0; i < idx->nwords; i++)
+    {
+        if (!strncmp(dindex_str(idx, idx->words[i].str), prefix, len)) {
+            matches++;
+        }
+    }
+
+    return matches;
+}
+
+static size_t index_exact(const struct dindex *idx, const char *word)
+{
+    return dindex_lookup(idx, word, ^(const struct dindex_entry *entry) {
+        return 0;
+    });
+}
+
+static size_t index_prefix(const struct dindex *idx, const char *prefix, size_t k)
+{
+    return dindex_prefix(idx, prefix, DINDEX_ORDER_LEX, k, ^(const struct dindex_word *word) {
+        return 0;
+    });
+}
+
+static size_t index_prefix_strokes(const struct dindex *idx, const char *prefix, size_t k)
+{
+    return dindex_prefix(idx, prefix, DINDEX_ORDER_STROKES, k, ^(const struct dindex_word *word) {
+        return 0;
+    });
+}
+
+// The "mmap" backend uses the index functions on a saved and mapped copy of the index.
+static const struct backend backends[] = {
+    { "linear",  linear_exact, linear_prefix,        true  },
+    { "hash",    index_exact,  index_prefix,         false },
+    { "strokes", index_exact,  index_prefix_strokes, false },
+    { "mmap",    index_exact,  index_prefix,         false }
+};
+
+#define NBACKENDS (sizeof(backends) / sizeof(*backends))
+
+// Work out what kind of query this is (and whether it hits).
+static enum kind classify(const struct dindex *idx, const char *query, bool prefix)
+{
+    if (prefix) { return KIND_PREFIX; }
+
+    const struct dindex_word *word = dindex_find(idx, query, strlen(query));
+
+    if (!word) { return KIND_MISS; }
+
+    return (utf8_count(query) >= LONG_CHARS ? KIND_LONG : KIND_HIT);
+}
+
+// Read queries from a file. Returns the number read, or 0 on failure.
+static size_t read_queries(const struct dindex *idx, const char *path, struct query **out)
+{
+    FILE *fp = (strcmp(path, "-") ? fopen(path, "r") : stdin);
+
+    if (!fp)
+    {
+        perror("fopen");
+        return 0;
+    }
+
+    struct query *queries = NULL;
+    size_t n = 0;
+    size_t cap = 0;
+
+    char *line = NULL;
+    size_t lcap = 0;
+    ssize_t len;
+    bool failed = false;
+
+    while ((len = getline(&line, &lcap, fp)) >= 0)
+    {
+        while (len && (line[len - 1] == '\n' || line[len - 1] == '\r')) {
+            line[--len] = 0;
+        }
+
+        if (!len) { continue; }
+
+        if (n == cap)
+        {
+            cap = (cap ? cap * 2 : 1024);
+            struct query *more = realloc(queries, cap * sizeof(struct query));
+
+            if (!more)
+            {
+                perror("realloc");
+                failed = true;
+
+                break;
+            }
+
+            queries = more;
+        }
+
+        bool prefix = (line[len - 1] == '*');
+
+        if (prefix) {
+            line[--len] = 0;
+        }
+
+        if (!(queries[n].str = strdup(line)))
+        {
+            perror("strdup");
+            failed = true;
+
+            break;
+        }
+
+        queries[n].kind = classify(idx, queries[n].str, prefix);
+        n++;
+    }
+
+    free(line);
+    if (fp != stdin) { fclose(fp); }
+
+    if (failed)
+    {
+        for (size_t i = 0; i < n; i++) {
+            free((void *)queries[i].str);
+        }
+
+        free(queries);
+        return 0;
+    }
+
+    if (!n)
+    {
+        fprintf(stderr, "Error: No queries in '%s'!\n", path);
+        return 0;
+    }
+
+    (*out) = queries;
+    return n;
+}
+
+// Generate `n` queries from the words in the dictionary. `mix` is the relative weight of each kind.
+static size_t gen_queries(const struct dindex *idx, size_t n, const unsigned int mix[KIND_COUNT], uint64_t seed, struct query **out)
+{
+    struct query *queries = calloc(n, sizeof(struct query));
+    uint32_t *longs = malloc(idx->nwords * sizeof(uint32_t) + 1);
+
+    if (!queries || !longs || !idx->nwords)
+    {
+        fprintf(stderr, "Error: Couldn't generate queries!\n");
+
+        free(queries);
+        free(longs);
+
+        return 0;
+    }
+
+    // Long words are rare, so pick them from a list.
+    size_t nlongs = 0;
+
+    for (uint32_t i = 0; i < idx->nwords; i++)
+    {
+        if (utf8_count(dindex_str(idx, idx->words[i].str)) >= LONG_CHARS) {
+            longs[nlongs++] = i;
+        }
+    }
+
+    unsigned int total = 0;
+
+    for (size_t i = 0; i < KIND_COUNT; i++) {
+        total += mix[i];
+    }
+
+    uint64_t state = seed;
+
+    for (size_t i = 0; i < n; i++)
+    {
+        uint64_t pick = synth_below(&state, total);
+        size_t kind = 0;
+
+        while (pick >= mix[kind]) {
+            pick -= mix[kind++];
+        }
+
+        const struct dindex_word *word = &idx->words[synth_below(&state, idx->nwords)];
+        const char *str = dindex_str(idx, word->str);
+
+        if (kind == KIND_LONG && nlongs) {
+            word = &idx->words[longs[synth_below(&state, nlongs)]];
+            str = dindex_str(idx, word->str);
+        }
+
+        char *query = malloc(word->len + 4);
+
+        if (!query)
+        {
+            perror("malloc");
+            n = i;
+
+            break;
+        }
+
+        if (kind == KIND_MISS) {
+            // Swap the last character for one from the private use area, which can't be in the dictionary.
+            const char *p = str;
+            const char *last = str;
+
+            while (*p)
+            {
+                last = p;
+                utf8_next(&p);
+            }
+
+            memcpy(query, str, last - str);
+            query[(last - str) + utf8_encode(0xE000 + synth_below(&state, 0x1000), &query[last - str])] = 0;
+        } else if (kind == KIND_PREFIX) {
+            // Complete on the first character or two.
+            const char *p = str;
+            utf8_next(&p);
+
+            if (*p && synth_below(&state, 2)) {
+                utf8_next(&p);
+            }
+
+            memcpy(query, str, p - str);
+            query[p - str] = 0;
+        } else {
+            memcpy(query, str, word->len + 1);
+        }
+
+        queries[i].str = query;
+        queries[i].kind = classify(idx, query, (kind == KIND_PREFIX));
+    }
+
+    free(longs);
+
+    if (!n)
+    {
+        free(queries);
+        return 0;
+    }
+
+    (*out) = queries;
+    return n;
+}
+
+// Run queries against a backend, recording each latency in the histogram for its kind. Returns the total time taken.
+static uint64_t run(const struct backend *b, const struct dindex *idx, const struct query *queries, size_t n, size_t k, struct hist hists[KIND_COUNT])
+{
+    // Results are summed up so nothing can be optimized away.
+    volatile size_t sink = 0;
+
+    for (size_t i = 0; i < n && i < WARMUP_QUERIES; i++) {
+        sink += (queries[i].kind == KIND_PREFIX ? b->prefix(idx, queries[i].str, k) : b->exact(idx, queries[i].str));
+    }
+
+    uint64_t start = metrics_now();
+
+    for (size_t i = 0; i < n; i++)
+    {
+        const struct query *q = &queries[i];
+        uint64_t t0 = metrics_now();
+
+        sink += (q->kind == KIND_PREFIX ? b->prefix(idx, q->str, k) : b->exact(idx, q->str));
+
+        hist_record(&hists[q->kind], metrics_now() - t0);
+    }
+
+    return metrics_now() - start;
+}
+
+static void print_header(void)
+{
+    printf("%-8s %-6s %10s %12s %10s %10s %10s %10s %10s %10s\n",
+        "backend", "kind", "queries", "queries/s", "mean", "p50", "p90", "p99", "p99.9", "max");
+}
+
+// Queries per second for `count` queries taking `ns` in total, or 0 if no time was measured.
+static double rate(uint64_t count, uint64_t ns)
+{ return (ns ? count / (ns / 1e9) : 0.0); }
+
+static void print_row(const char *backend, const char *kind, const struct hist *h, double qps)
+{
+    printf("%-8s %-6s %10llu %12.0f ", backend, kind, (unsigned long long)h->count, qps);
+
+    hist_print_ns(stdout, (uint64_t)hist_mean(h), 10);
+    putchar(' ');
+    hist_print_ns(stdout, hist_percentile(h, 50.0), 10);
+    putchar(' ');
+    hist_print_ns(stdout, hist_percentile(h, 90.0), 10);
+    putchar(' ');
+    hist_print_ns(stdout, hist_percentile(h, 99.0), 10);
+    putchar(' ');
+    hist_print_ns(stdout, hist_percentile(h, 99.9), 10);
+    putchar(' ');
+    hist_print_ns(stdout, h->max, 10);
+    putchar('\n');
+}
+
+// Save an index to a temporary file and map it back in.
+static struct dindex *remap(const struct dindex *idx)
+{
+    const char *dir = getenv("TMPDIR");
+    char path[1024];
+
+    snprintf(path, sizeof(path), "%s/bench_query.%d.idx", ((dir && dir[0]) ? dir : "/tmp"), (int)getpid());
+
+    if (dindex_save(idx, path)) { return NULL; }
+
+    // The mapping stays valid after the file is gone.
+    struct dindex *mapped = dindex_open(path);
+    unlink(path);
+
+    return mapped;
+}
+
+// Check whether a comma separated list has `name` in it (as a whole entry).
+static bool listed(const char *list, const char *name)
+{
+    size_t len = strlen(name);
+
+    for (const char *p = list; ; p++)
+    {
+        size_t n = strcspn(p, ",");
+        if (n == len && !memcmp(p, name, len)) { return true; }
+
+        p += n;
+        if (!*p) { return false; }
+    }
+}
+
+static void usage(const char *name)
+{
+    fprintf(stderr, "Usage: %s [-n queries] [-l linear_queries] [-q queries.txt | -m hit,miss,prefix,long] [-k count]\n", name);
+    fprintf(stderr, "       %*s [-b backend,...] [-r synthetic_rows] [-s seed] [dict.xlsx|dict.idx]\n", (int)strlen(name), "");
+    fprintf(stderr, "Backends are linear, hash, strokes (completions in stroke order), and mmap.\n");
+}
+
+int main(int argc, char *const *argv)
+{
+    size_t nqueries = 1000000;
+    size_t nlinear = 1000;
+    size_t rows = 200000;
+    size_t k = 20;
+    uint64_t seed = 1;
+
+    // Default query mix: mostly hits, some misses and completions, and a few long words.
+    unsigned int mix[KIND_COUNT] = { 70, 15, 10, 5 };
+
+    const char *qpath = NULL;
+    char *only = NULL;
+
+    int opt;
+
+    while ((opt = getopt(argc, argv, "n:l:r:s:q:m:k:b:")) != -1)
+    {
+        switch (opt)
+        {
+            case 'n': nqueries = strtoul(optarg, NULL, 10); break;
+            case 'l': nlinear = strtoul(optarg, NULL, 10); break;
+            case 'r': rows = strtoul(optarg, NULL, 10); break;
+            case 's': seed = strtoull(optarg, NULL, 10); break;
+            case 'q': qpath = optarg; break;
+            case 'k': k = strtoul(optarg, NULL, 10); break;
+            case 'b': only = optarg; break;
+            case 'm':
+                if (sscanf(optarg, "%u,%u,%u,%u", &mix[KIND_HIT], &mix[KIND_MISS], &mix[KIND_PREFIX], &mix[KIND_LONG]) != 4
+                 || !(mix[KIND_HIT] + mix[KIND_MISS] + mix[KIND_PREFIX] + mix[KIND_LONG]))
+                {
+                    fprintf(stderr, "Error: Query mix should be 4 weights, e.g. '70,15,10,5'.\n");
+                    return 1;
+                }
+
+                break;
+            default:
+                usage(argv[0]);
+                return 1;
+        }
+    }
+
+    if (argc - optind > 1)
+    {
+        usage(argv[0]);
+        return 1;
+    }
+
+    uint64_t t0 = metrics_now();
+    struct dindex *idx;
+
+    if (optind < argc) {
+        idx = dindex_load(argv[optind], false);
+    } else {
+        struct xlsx *doc = synth_dict(rows, seed);
+        if (!doc) { return 1; }
+
+        idx = dindex_build(doc, SYNTH_COL_WORD, SYNTH_COL_DEF, SYNTH_COL_STROKES);
+        xlsx_doc_free(doc);
+    }
+
+    if (!idx) { return 1; }
+
+    fprintf(stderr, "Loaded %u entries (%u words) in %.2fs.\n", idx->nentries, idx->nwords, (metrics_now() - t0) / 1e9);
+
+    struct query *queries;
+    size_t n = (qpath ? read_queries(idx, qpath, &queries) : gen_queries(idx, nqueries, mix, seed, &queries));
+
+    if (!n)
+    {
+        dindex_free(idx);
+        return 1;
+    }
+
+    struct dindex *mapped = NULL;
+    int status = 0;
+
+    print_header();
+
+    for (size_t b = 0; b < NBACKENDS; b++)
+    {
+        const struct backend *backend = &backends[b];
+        const struct dindex *target = idx;
+
+        if (only && !listed(only, backend->name)) { continue; }
+
+        if (!strcmp(backend->name, "mmap"))
+        {
+            if (!mapped && !(mapped = remap(idx)))
+            {
+                status = 1;
+                continue;
+            }
+
+            target = mapped;
+        }
+
+        struct hist hists[KIND_COUNT];
+        struct hist all;
+
+        for (size_t i = 0; i < KIND_COUNT; i++) {
+            hist_init(&hists[i]);
+        }
+
+        size_t count = ((backend->limited && nlinear < n) ? nlinear : n);
+        uint64_t elapsed = run(backend, target, queries, count, k, hists);
+
+        hist_init(&all);
+
+        for (size_t i = 0; i < KIND_COUNT; i++)
+        {
+            hist_merge(&all, &hists[i]);
+
+            // Per kind throughput only counts time spent on queries of that kind.
+            if (hists[i].count) {
+                print_row(backend->name, kind_names[i], &hists[i], rate(hists[i].count, hists[i].sum));
+            }
+        }
+
+        if (all.count) {
+            print_row(backend->name, "all", &all, rate(count, elapsed));
+        }
+    }
+
+    for (size_t i = 0; i < n; i++) {
+        free((void *)queries[i].str);
+    }
+
+    free(queries);
+
+    if (mapped) { dindex_free(mapped); }
+    dindex_free(idx);
+
+    return status;
+}
@@ -0,0 +1,567 @@
+/* ********************************************************** */
+/* -*- bitmap.c -*- Compressed bitmaps of 32 bit values   -*- */
+/* ********************************************************** */
+/* Tyler Besselman (C) October 2026                           */
+/* ********************************************************** */
+
+#include <strings.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+
+#include <bitmap.h>
+
+// Four words at a time. The compiler turns operations on these into SIMD instructions (SSE/AVX or NEON).
+typedef uint64_t _bitmap_vec __attribute__((vector_size(32)));
+
+// Arrays are always allocated to a power of 2 (at least 4), so we know when they're full from the count alone.
+static inline uint32_t _bitmap_array_cap(uint32_t card)
+{
+    uint32_t cap = 4;
+
+    while (cap < card) {
+        cap *= 2;
+    }
+
+    return cap;
+}
+
+// Allocate an array container with room for `card` values.
+static inline uint16_t *_bitmap_array(uint32_t card)
+{
+    uint16_t *array = malloc(_bitmap_array_cap(card) * sizeof(uint16_t));
+    if (!array) { perror("malloc"); }
+
+    return array;
+}
+
+// Allocate an empty bitset container.
+static inline uint64_t *_bitmap_bits(void)
+{
+    uint64_t *bits = calloc(BITMAP_WORDS, sizeof(uint64_t));
+    if (!bits) { perror("calloc"); }
+
+    return bits;
+}
+
+// Index of the container with `key` (or where it would go).
+static uint32_t _bitmap_find(const struct bitmap *bm, uint16_t key)
+{
+    uint32_t lo = 0;
+    uint32_t hi = bm->n;
+
+    while (lo < hi)
+    {
+        uint32_t mid = lo + (hi - lo) / 2;
+
+        if (bm->cs[mid].key < key) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+
+    return lo;
+}
+
+// Append a (non-empty) container to a bitmap, taking ownership of its memory.
+static int _bitmap_push(struct bitmap *bm, const struct bitmap_container *c)
+{
+    if (bm->n == bm->cap)
+    {
+        uint32_t cap = (bm->cap ? bm->cap * 2 : 4);
+        struct bitmap_container *cs = realloc(bm->cs, cap * sizeof(struct bitmap_container));
+
+        if (!cs)
+        {
+            perror("realloc");
+
+            free(c->array);
+            free(c->bits);
+
+            return 1;
+        }
+
+        bm->cs = cs;
+        bm->cap = cap;
+    }
+
+    bm->cs[bm->n++] = (*c);
+    return 0;
+}
+
+// Turn an array container into a bitset.
+static int _bitmap_to_bits(struct bitmap_container *c)
+{
+    uint64_t *bits = _bitmap_bits();
+    if (!bits) { return 1; }
+
+    for (uint32_t i = 0; i < c->card; i++) {
+        bits[c->array[i] >> 6] |= 1ULL << (c->array[i] & 63);
+    }
+
+    free(c->array);
+
+    c->array = NULL;
+    c->bits = bits;
+
+    return 0;
+}
+
+// Turn a bitset container with few enough values into an array.
+// On failure the bitset is freed so the caller is left with an empty container.
+static int _bitmap_to_array(struct bitmap_container *c)
+{
+    uint16_t *array = _bitmap_array(c->card);
+
+    if (!array)
+    {
+        free(c->bits);
+        c->bits = NULL;
+
+        return 1;
+    }
+
+    uint32_t n = 0;
+
+    for (uint32_t i = 0; i < BITMAP_WORDS; i++)
+    {
+        for (uint64_t w = c->bits[i]; w; w &= w - 1) {
+            array[n++] = (i << 6) | __builtin_ctzll(w);
+        }
+    }
+
+    free(c->bits);
+
+    c->array = array;
+    c->bits = NULL;
+
+    return 0;
+}
+
+int bitmap_add(struct bitmap *bm, uint32_t v)
+{
+    uint16_t key = v >> 16;
+    uint16_t low = v & 0xFFFF;
+
+    // Values usually come in order, so check the last container first.
+    uint32_t pos = ((bm->n && bm->cs[bm->n - 1].key <= key) ? bm->n - (bm->cs[bm->n - 1].key == key) : _bitmap_find(bm, key));
+
+    if (pos == bm->n || bm->cs[pos].key != key)
+    {
+        struct bitmap_container c = { .key = key, .card = 0, .array = _bitmap_array(1), .bits = NULL };
+
+        if (!c.array || _bitmap_push(bm, &c)) { return 1; }
+
+        // Move it into place.
+        memmove(&bm->cs[pos + 1], &bm->cs[pos], (bm->n - 1 - pos) * sizeof(struct bitmap_container));
+        bm->cs[pos] = c;
+    }
+
+    struct bitmap_container *c = &bm->cs[pos];
+
+    if (c->array)
+    {
+        uint32_t lo = c->card;
+
+        if (c->card && c->array[c->card - 1] >= low)
+        {
+            uint32_t hi = c->card;
+            lo = 0;
+
+            while (lo < hi)
+            {
+                uint32_t mid = lo + (hi - lo) / 2;
+
+                if (c->array[mid] < low) {
+                    lo = mid + 1;
+                } else {
+                    hi = mid;
+                }
+            }
+
+            if (c->array[lo] == low) { return 0; }
+        }
+
+        if (c->card < BITMAP_ARRAY_MAX)
+        {
+            if (c->card == _bitmap_array_cap(c->card))
+            {
+                uint16_t *array = realloc(c->array, _bitmap_array_cap(c->card + 1) * sizeof(uint16_t));
+
+                if (!array)
+                {
+                    perror("realloc");
+                    return 1;
+                }
+
+                c->array = array;
+            }
+
+            memmove(&c->array[lo + 1], &c->array[lo], (c->card - lo) * sizeof(uint16_t));
+
+            c->array[lo] = low;
+            c->card++;
+
+            return 0;
+        }
+
+        if (_bitmap_to_bits(c)) { return 1; }
+    }
+
+    uint64_t bit = 1ULL << (low & 63);
+
+    if (!(c->bits[low >> 6] & bit))
+    {
+        c->bits[low >> 6] |= bit;
+        c->card++;
+    }
+
+    return 0;
+}
+
+bool bitmap_contains(const struct bitmap *bm, uint32_t v)
+{
+    uint16_t key = v >> 16;
+    uint16_t low = v & 0xFFFF;
+
+    uint32_t pos = _bitmap_find(bm, key);
+    if (pos == bm->n || bm->cs[pos].key != key) { return false; }
+
+    const struct bitmap_container *c = &bm->cs[pos];
+
+    if (c->bits) { return (c->bits[low >> 6] >> (low & 63)) & 1; }
+
+    uint32_t lo = 0;
+    uint32_t hi = c->card;
+
+    while (lo < hi)
+    {
+        uint32_t mid = lo + (hi - lo) / 2;
+
+        if (c->array[mid] < low) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+
+    return (lo < c->card && c->array[lo] == low);
+}
+
+uint64_t bitmap_card(const struct bitmap *bm)
+{
+    uint64_t card = 0;
+
+    for (uint32_t i = 0; i < bm->n; i++) {
+        card += bm->cs[i].card;
+    }
+
+    return card;
+}
+
+// Combine two bitsets a vector at a time, returning the number of bits set in the result.
+#define BITMAP_BITS_OP(name, op)                                                                \
+    static uint32_t name(const uint64_t *a, const uint64_t *b, uint64_t *out)                   \
+    {                                                                                           \
+        uint32_t card = 0;                                                                      \
+                                                                                                \
+        for (size_t i = 0; i < BITMAP_WORDS; i += 4)                                            \
+        {                                                                                       \
+            _bitmap_vec x, y;                                                                   \
+                                                                                                \
+            memcpy(&x, &a[i], sizeof(x));                                                       \
+            memcpy(&y, &b[i], sizeof(y));                                                       \
+                                                                                                \
+            _bitmap_vec z = x op y;                                                             \
+            memcpy(&out[i], &z, sizeof(z));                                                     \
+                                                                                                \
+            card += __builtin_popcountll(z[0]) + __builtin_popcountll(z[1])                     \
+                  + __builtin_popcountll(z[2]) + __builtin_popcountll(z[3]);                    \
+        }                                                                                       \
+                                                                                                \
+        return card;                                                                            \
+    }
+
+BITMAP_BITS_OP(_bitmap_and_bits, &)
+BITMAP_BITS_OP(_bitmap_or_bits, |)
+
+#undef BITMAP_BITS_OP
+
+// Intersect two containers with the same key. The result may be empty.
+static int _bitmap_and_container(const struct bitmap_container *a, const struct bitmap_container *b, struct bitmap_container *r)
+{
+    (*r) = (struct bitmap_container){ .key = a->key, .card = 0, .array = NULL, .bits = NULL };
+
+    // Make sure `a` is an array if either is.
+    if (b->array && !a->array)
+    {
+        const struct bitmap_container *t = a;
+
+        a = b;
+        b = t;
+    }
+
+    if (a->array && b->array) {
+        if (!(r->array = _bitmap_array(a->card < b->card ? a->card : b->card))) { return 1; }
+
+        uint32_t i = 0;
+        uint32_t j = 0;
+
+        while (i < a->card && j < b->card)
+        {
+            if (a->array[i] < b->array[j]) {
+                i++;
+            } else if (a->array[i] > b->array[j]) {
+                j++;
+            } else {
+                r->array[r->card++] = a->array[i];
+
+                i++;
+                j++;
+            }
+        }
+    } else if (a->array) {
+        if (!(r->array = _bitmap_array(a->card))) { return 1; }
+
+        for (uint32_t i = 0; i < a->card; i++)
+        {
+            uint16_t v = a->array[i];
+
+            if ((b->bits[v >> 6] >> (v & 63)) & 1) {
+                r->array[r->card++] = v;
+            }
+        }
+    } else {
+        if (!(r->bits = _bitmap_bits())) { return 1; }
+
+        r->card = _bitmap_and_bits(a->bits, b->bits, r->bits);
+
+        if (r->card <= BITMAP_ARRAY_MAX) {
+            return _bitmap_to_array(r);
+        }
+    }
+
+    return 0;
+}
+
+// Union two containers with the same key.
+static int _bitmap_or_container(const struct bitmap_container *a, const struct bitmap_container *b, struct bitmap_container *r)
+{
+    (*r) = (struct bitmap_container){ .key = a->key, .card = 0, .array = NULL, .bits = NULL };
+
+    // Make sure `a` is an array if either is.
+    if (b->array && !a->array)
+    {
+        const struct bitmap_container *t = a;
+
+        a = b;
+        b = t;
+    }
+
+    if (a->array && b->array && a->card + b->card <= BITMAP_ARRAY_MAX) {
+        if (!(r->array = _bitmap_array(a->card + b->card))) { return 1; }
+
+        uint32_t i = 0;
+        uint32_t j = 0;
+
+        while (i < a->card || j < b->card)
+        {
+            if (j == b->card || (i < a->card && a->array[i] < b->array[j])) {
+                r->array[r->card++] = a->array[i++];
+            } else if (i == a->card || b->array[j] < a->array[i]) {
+                r->array[r->card++] = b->array[j++];
+            } else {
+                r->array[r->card++] = a->array[i];
+
+                i++;
+                j++;
+            }
+        }
+    } else if (b->bits) {
+        if (!(r->bits = _bitmap_bits())) { return 1; }
+
+        if (a->bits)
+        {
+            r->card = _bitmap_or_bits(a->bits, b->bits, r->bits);
+            return 0;
+        }
+
+        memcpy(r->bits, b->bits, BITMAP_WORDS * sizeof(uint64_t));
+        r->card = b->card;
+
+        for (uint32_t i = 0; i < a->card; i++)
+        {
+            uint16_t v = a->array[i];
+            uint64_t bit = 1ULL << (v & 63);
+
+            r->card += !(r->bits[v >> 6] & bit);
+            r->bits[v >> 6] |= bit;
+        }
+    } else {
+        // Two arrays which together may have too many values for an array.
+        if (!(r->bits = _bitmap_bits())) { return 1; }
+
+        for (uint32_t i = 0; i < a->card; i++) {
+            r->bits[a->array[i] >> 6] |= 1ULL << (a->array[i] & 63);
+        }
+
+        for (uint32_t i = 0; i < b->card; i++) {
+            r->bits[b->array[i] >> 6] |= 1ULL << (b->array[i] & 63);
+        }
+
+        for (uint32_t i = 0; i < BITMAP_WORDS; i++) {
+            r->card += __builtin_popcountll(r->bits[i]);
+        }
+
+        if (r->card <= BITMAP_ARRAY_MAX) {
+            return _bitmap_to_array(r);
+        }
+    }
+
+    return 0;
+}
+
+// Copy a single container.
+static int _bitmap_copy_container(const struct bitmap_container *c, struct bitmap_container *r)
+{
+    (*r) = (*c);
+
+    if (c->array) {
+        if (!(r->array = _bitmap_array(c->card))) { return 1; }
+        memcpy(r->array, c->array, c->card * sizeof(uint16_t));
+    } else {
+        if (!(r->bits = _bitmap_bits())) { return 1; }
+        memcpy(r->bits, c->bits, BITMAP_WORDS * sizeof(uint64_t));
+    }
+
+    return 0;
+}
+
+int bitmap_and(const struct bitmap *a, const struct bitmap *b, struct bitmap *out)
+{
+    uint32_t i = 0;
+    uint32_t j = 0;
+
+    while (i < a->n && j < b->n)
+    {
+        if (a->cs[i].key < b->cs[j].key) {
+            i++;
+        } else if (a->cs[i].key > b->cs[j].key) {
+            j++;
+        } else {
+            struct bitmap_container r;
+
+            if (_bitmap_and_container(&a->cs[i++], &b->cs[j++], &r))
+            {
+                bitmap_free(out);
+                return 1;
+            }
+
+            if (!r.card)
+            {
+                free(r.array);
+                free(r.bits);
+
+                continue;
+            }
+
+            if (_bitmap_push(out, &r))
+            {
+                bitmap_free(out);
+                return 1;
+            }
+        }
+    }
+
+    return 0;
+}
+
+int bitmap_or(const struct bitmap *a, const struct bitmap *b, struct bitmap *out)
+{
+    uint32_t i = 0;
+    uint32_t j = 0;
+
+    while (i < a->n || j < b->n)
+    {
+        struct bitmap_container r;
+        int failed;
+
+        if (j == b->n || (i < a->n && a->cs[i].key < b->cs[j].key)) {
+            failed = _bitmap_copy_container(&a->cs[i++], &r);
+        } else if (i == a->n || b->cs[j].key < a->cs[i].key) {
+            failed = _bitmap_copy_container(&b->cs[j++], &r);
+        } else {
+            failed = _bitmap_or_container(&a->cs[i++], &b->cs[j++], &r);
+        }
+
+        if (failed || _bitmap_push(out, &r))
+        {
+            bitmap_free(out);
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+int bitmap_copy(const struct bitmap *bm, struct bitmap *out)
+{
+    for (uint32_t i = 0; i < bm->n; i++)
+    {
+        struct bitmap_container r;
+
+        if (_bitmap_copy_container(&bm->cs[i], &r) || _bitmap_push(out, &r))
+        {
+            bitmap_free(out);
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+size_t bitmap_foreach(const struct bitmap *bm, int (^blk)(uint32_t v))
+{
+    size_t n = 0;
+
+    for (uint32_t i = 0; i < bm->n; i++)
+    {
+        const struct bitmap_container *c = &bm->cs[i];
+        uint32_t high = (uint32_t)c->key << 16;
+
+        if (c->array)
+        {
+            for (uint32_t j = 0; j < c->card; j++)
+            {
+                n++;
+                if (blk(high | c->array[j])) { return n; }
+            }
+
+            continue;
+        }
+
+        for (uint32_t j = 0; j < BITMAP_WORDS; j++)
+        {
+            for (uint64_t w = c->bits[j]; w; w &= w - 1)
+            {
+                n++;
+                if (blk(high | (j << 6) | __builtin_ctzll(w))) { return n; }
+            }
+        }
+    }
+
+    return n;
+}
+
+void bitmap_free(struct bitmap *bm)
+{
+    for (uint32_t i = 0; i < bm->n; i++)
+    {
+        free(bm->cs[i].array);
+        free(bm->cs[i].bits);
+    }
+
+    free(bm->cs);
+    (*bm) = BITMAP_INIT;
+}
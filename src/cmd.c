@@ -5,22 +5,292 @@
 /* ********************************************************** */
 
 #include <stdbool.h>
+#include <string.h>
+#include <stdlib.h>
 #include <stdio.h>
+#include <math.h>
 
+#include <escape.h>
 #include <xlsx.h>
 #include <xml.h>
 
 #ifdef __XLSX_STANDALONE__
-    // Test main function which reads in an XLSX file and dumps it in a grid.
-    int main(int argc, const char *const *argv)
+    // Most row filters (`-w`) which can be given at once.
+    #define EXPORT_MAX_FILTERS 16
+
+    // Exported rows are written out in chunks of about this many bytes.
+    #define EXPORT_FLUSH (1 << 16)
+
+    // Keep rows where a column equals (or with `contains`, includes) some text.
+    struct export_filter {
+        const char *name;
+        const char *text;
+        bool contains;
+
+        size_t col;
+    };
+
+    // Everything needed to export rows as they're read.
+    struct export {
+        enum escape_format fmt;
+        struct obuf out;
+
+        // Columns to write, from the `-c` argument (every column if NULL). These are resolved by name against the first row.
+        const char *select;
+        size_t *cols;
+        size_t ncols;
+
+        // Names of every column in the document (the first row).
+        char **names;
+        size_t nnames;
+
+        // For JSON, the quoted key of each selected column, back to back. Key `i` ends at `key_ends[i]`.
+        struct obuf keys;
+        size_t *key_ends;
+
+        struct export_filter filters[EXPORT_MAX_FILTERS];
+        size_t nfilters;
+    };
+
+    // Get the text of a cell. Numbers are formatted into `buf`, and empty cells are "".
+    static const char *export_text(const struct xlsx *doc, const struct xlsx_value *value, char buf[32], size_t *len)
     {
-        if (argc != 2)
+        const char *text = "";
+
+        switch (value->type)
         {
-            fprintf(stderr, "Error: Need exactly 1 argument.\n");
+            case XLSX_TYPE_NULL:  break;
+            case XLSX_TYPE_STR:   text = xlsx_str(doc, value); break;
+            case XLSX_TYPE_LSTR:  text = value->str;           break;
+            case XLSX_TYPE_INT:   snprintf(buf, 32, "%lld", (long long)value->ival); text = buf; break;
+            case XLSX_TYPE_FLOAT: snprintf(buf, 32, "%.15g", value->fval);          text = buf; break;
+        }
+
+        *len = strlen(text);
+        return text;
+    }
+
+    // Find a column by name, or by (0-based) number if no column has that name. Returns non-zero if there's no such column.
+    static int export_column(const struct export *ex, const char *name, size_t len, size_t *col)
+    {
+        for (size_t j = 0; j < ex->nnames; j++)
+        {
+            if (strlen(ex->names[j]) == len && !memcmp(ex->names[j], name, len))
+            {
+                *col = j;
+                return 0;
+            }
+        }
+
+        char *end;
+        unsigned long long j = strtoull(name, &end, 10);
+
+        if (len && end == name + len && j < ex->nnames)
+        {
+            *col = j;
+            return 0;
+        }
+
+        fprintf(stderr, "Error: Document has no column '%.*s'.\n", (int)len, name);
+        return 1;
+    }
+
+    // Read column names from the first row, and resolve selected and filtered columns against them.
+    static int export_header(struct export *ex, const struct xlsx *doc, const struct xlsx_value *row)
+    {
+        ex->nnames = xlsx_cols(doc);
+        ex->names = calloc(ex->nnames + 1, sizeof(char *));
+
+        // At most one selected column per `,` in the selection, plus one.
+        size_t max = ex->nnames;
+
+        for (const char *p = ex->select; p && *p; p++) {
+            max += (*p == ',');
+        }
+
+        ex->cols = calloc(max + 1, sizeof(size_t));
+        ex->key_ends = calloc(max + 1, sizeof(size_t));
+
+        if (!ex->names || !ex->cols || !ex->key_ends)
+        {
+            perror("calloc");
+            return 1;
+        }
+
+        for (size_t j = 0; j < ex->nnames; j++)
+        {
+            char buf[32];
+            size_t len;
+
+            if (!(ex->names[j] = strdup(export_text(doc, &row[j], buf, &len))))
+            {
+                perror("strdup");
+                return 1;
+            }
+        }
+
+        if (!ex->select) {
+            for (size_t j = 0; j < ex->nnames; j++) {
+                ex->cols[ex->ncols++] = j;
+            }
+        } else {
+            for (const char *name = ex->select; ; )
+            {
+                const char *comma = strchr(name, ',');
+                size_t len = (comma ? (size_t)(comma - name) : strlen(name));
+
+                if (export_column(ex, name, len, &ex->cols[ex->ncols++])) { return 1; }
+
+                if (!comma) { break; }
+                name = comma + 1;
+            }
+        }
+
+        for (size_t i = 0; i < ex->nfilters; i++)
+        {
+            const char *name = ex->filters[i].name;
+
+            if (export_column(ex, name, strlen(name), &ex->filters[i].col)) {
+                return 1;
+            }
+        }
+
+        // JSON lines use the names as keys. Otherwise, they make a header line.
+        for (size_t i = 0; i < ex->ncols; i++)
+        {
+            const char *name = ex->names[ex->cols[i]];
+
+            if (ex->fmt == ESCAPE_JSON) {
+                if (escape_field(&ex->keys, ESCAPE_JSON, name, strlen(name))) { return 1; }
+                ex->key_ends[i] = ex->keys.len;
+            } else {
+                if (i && obuf_append(&ex->out, (ex->fmt == ESCAPE_CSV ? "," : "\t"), 1)) { return 1; }
+                if (escape_field(&ex->out, ex->fmt, name, strlen(name))) { return 1; }
+            }
+        }
+
+        return (ex->fmt != ESCAPE_JSON && obuf_append(&ex->out, "\n", 1));
+    }
+
+    // Check whether a row passes every filter.
+    static bool export_keep(const struct export *ex, const struct xlsx *doc, const struct xlsx_value *row)
+    {
+        for (size_t i = 0; i < ex->nfilters; i++)
+        {
+            const struct export_filter *filter = &ex->filters[i];
+
+            char buf[32];
+            size_t len;
+
+            const char *text = export_text(doc, &row[filter->col], buf, &len);
+
+            if (filter->contains ? !strstr(text, filter->text) : strcmp(text, filter->text)) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    // Write out one row.
+    static int export_row(struct export *ex, const struct xlsx *doc, const struct xlsx_value *row)
+    {
+        struct obuf *out = &ex->out;
+
+        if (ex->fmt == ESCAPE_JSON && obuf_append(out, "{", 1)) {
             return 1;
         }
 
-        struct xlsx *document = xlsx_doc_at(argv[1]);
+        for (size_t i = 0; i < ex->ncols; i++)
+        {
+            const struct xlsx_value *value = &row[ex->cols[i]];
+
+            char buf[32];
+            size_t len;
+
+            const char *text = export_text(doc, value, buf, &len);
+
+            if (ex->fmt != ESCAPE_JSON)
+            {
+                if (i && obuf_append(out, (ex->fmt == ESCAPE_CSV ? "," : "\t"), 1)) { return 1; }
+
+                // Numbers never need escaping.
+                int failed = (value->type == XLSX_TYPE_STR || value->type == XLSX_TYPE_LSTR ? escape_field(out, ex->fmt, text, len) : obuf_append(out, text, len));
+                if (failed) { return 1; }
+
+                continue;
+            }
+
+            size_t key_start = (i ? ex->key_ends[i - 1] : 0);
+
+            if ((i && obuf_append(out, ",", 1))
+             || obuf_append(out, &ex->keys.data[key_start], ex->key_ends[i] - key_start)
+             || obuf_append(out, ":", 1)) {
+                return 1;
+            }
+
+            int failed;
+
+            switch (value->type)
+            {
+                case XLSX_TYPE_STR:
+                case XLSX_TYPE_LSTR:
+                    failed = escape_field(out, ESCAPE_JSON, text, len);
+                    break;
+
+                case XLSX_TYPE_INT:
+                    failed = obuf_append(out, text, len);
+                    break;
+
+                case XLSX_TYPE_FLOAT:
+                    // JSON has no infinities or NaNs.
+                    failed = (isfinite(value->fval) ? obuf_append(out, text, len) : obuf_puts(out, "null"));
+                    break;
+
+                default:
+                    failed = obuf_puts(out, "null");
+                    break;
+            }
+
+            if (failed) { return 1; }
+        }
+
+        return obuf_append(out, (ex->fmt == ESCAPE_JSON ? "}\n" : "\n"), (ex->fmt == ESCAPE_JSON ? 2 : 1));
+    }
+
+    // Stream rows straight from the sheet to stdout. The first row names the columns.
+    static int export_doc(struct export *ex, const char *path)
+    {
+        int status = xlsx_stream_at(path, ^(const struct xlsx *doc, struct xlsx_value *row, size_t n) {
+            int failed = (!n ? export_header(ex, doc, row) : (export_keep(ex, doc, row) && export_row(ex, doc, row)));
+
+            if (!failed && ex->out.len >= EXPORT_FLUSH) {
+                failed = obuf_flush(&ex->out, stdout);
+            }
+
+            return failed;
+        });
+
+        status = (status || obuf_flush(&ex->out, stdout) || fflush(stdout));
+
+        for (size_t j = 0; ex->names && j < ex->nnames; j++) {
+            free(ex->names[j]);
+        }
+
+        free(ex->names);
+        free(ex->cols);
+        free(ex->key_ends);
+
+        obuf_free(&ex->keys);
+        obuf_free(&ex->out);
+
+        return status;
+    }
+
+    // Print the whole document as a grid.
+    static int print_grid(const char *path)
+    {
+        struct xlsx *document = xlsx_doc_at(path);
         if (!document) { return 1; }
 
         printf("%4s", "");
@@ -55,6 +325,72 @@
         xlsx_doc_free(document);
         return 0;
     }
+
+    static void usage(const char *argv0)
+    {
+        fprintf(stderr, "Usage: %s file.xlsx\n", argv0);
+        fprintf(stderr, "       %s --csv|--tsv|--jsonl [-c col,...] [-w col=text] [-w col~text] file.xlsx\n", argv0);
+    }
+
+    // Test main function which reads in an XLSX file and dumps it in a grid, or exports its rows.
+    int main(int argc, const char *const *argv)
+    {
+        struct export ex = { .out = OBUF_INIT, .keys = OBUF_INIT };
+        bool export = false;
+        int i = 1;
+
+        for (; i < argc - 1; i++)
+        {
+            const char *arg = argv[i];
+
+            if (!strcmp(arg, "--csv") || !strcmp(arg, "--tsv") || !strcmp(arg, "--jsonl")) {
+                ex.fmt = (arg[2] == 'c' ? ESCAPE_CSV : (arg[2] == 't' ? ESCAPE_TSV : ESCAPE_JSON));
+                export = true;
+            } else if (!strcmp(arg, "-c") && i + 2 < argc) {
+                ex.select = argv[++i];
+            } else if (!strcmp(arg, "-w") && i + 2 < argc) {
+                const char *filter = argv[++i];
+                size_t len = strcspn(filter, "=~");
+
+                if (!filter[len] || !len || ex.nfilters == EXPORT_MAX_FILTERS)
+                {
+                    fprintf(stderr, "Error: Bad filter '%s' (or more than %d of them).\n", filter, EXPORT_MAX_FILTERS);
+                    return 1;
+                }
+
+                // The name is cut out of a copy since `argv` is const.
+                char *name = strndup(filter, len);
+
+                if (!name)
+                {
+                    perror("strndup");
+                    return 1;
+                }
+
+                ex.filters[ex.nfilters++] = (struct export_filter){
+                    .name = name,
+                    .text = &filter[len + 1],
+                    .contains = (filter[len] == '~')
+                };
+            } else {
+                break;
+            }
+        }
+
+        if (i != argc - 1 || (!export && (ex.select || ex.nfilters)))
+        {
+            usage(argv[0]);
+            return 1;
+        }
+
+        int status = (export ? export_doc(&ex, argv[i]) : print_grid(argv[i]));
+
+        for (size_t j = 0; j < ex.nfilters; j++) {
+            free((char *)ex.filters[j].name);
+        }
+
+        return status;
+    }
 #endif /* defined(__XLSX_STANDALONE__) */
 
 #ifdef __XML_STANDALONE__
@@ -10,31 +10,16 @@
 #include <errno.h>
 #include <stdio.h>
 
+#include <defparse.h>
+#include <dindex.h>
+#include <defzip.h>
+#include <metrics.h>
 #include <sqldecl.h>
 #include <sqlite.h>
+#include <trace.h>
+#include <utf8.h>
 #include <xlsx.h>
 
-// A table indexed by the first byte of a UTF-8 codepoint
-//   determining the length of the encoded char.
-static const uint8_t UTF8_TRAILING_COUNT[0x100] = {
-    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
-    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
-    2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2,
-    3, 3, 3, 3, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5
-};
-
 // A structure holding a sqlite database and the various prepared statements we use.
 struct sqlite_state {
     // The open database
@@ -63,8 +48,26 @@ struct sqlite_state {
 
     // Statement for inserting a new dictionary entry
     sqlite3_stmt *dict_insert;
+
+    // Statements for inserting the senses, examples, and citations parsed out of definitions
+    sqlite3_stmt *sense_insert;
+    sqlite3_stmt *example_insert;
+    sqlite3_stmt *cite_insert;
+
+    // Statement for inserting a cross-reference edge
+    sqlite3_stmt *xref_insert;
+
+    // Model definition text is compressed with (NULL to store it as is), and a buffer for the compressed text.
+    struct defzip *dz;
+    struct obuf zbuf;
 };
 
+// Most characters in a word we keep character info for. Longer words are skipped.
+#define CONV_MAX_CHARS 32
+
+// Rows inserted per span when tracing (see trace.h), so a trace shows the insert rate over time without a span per row.
+#define CONV_TRACE_ROWS 4096
+
 // Map used for insertion.
 // Each entry is indexed by parameter # in the corresponding insert statement
 //   and holds the index of the corresponding xlsx column to take data from.
@@ -76,6 +79,33 @@ struct insert_map {
     off_t dictmap[SQL_INS_DICT_CNT + 1];
 };
 
+// A cross-reference (like 見「...」) found in the definition of an entry.
+// Spans point into the xlsx document, so these are only good until it's freed.
+struct xref {
+    uint64_t entry;
+    int32_t sense;
+
+    // The referenced word, and the phrase introducing it.
+    struct defparse_span word;
+    struct defparse_span phrase;
+};
+
+// Cross-references collected during the insert pass.
+// They're resolved once every entry is in, since a definition can refer to an entry later in the document.
+struct xref_list {
+    struct xref *refs;
+    size_t count;
+    size_t cap;
+
+    // Dictionary id inserted for each xlsx row (0 if the row was skipped).
+    uint64_t *ids;
+};
+
+// Phrases which introduce a cross-reference, longest first (so 參見 wins over 見).
+static const char *const xref_phrases[] = {
+    "參見", "亦作", "也作", "或作", "亦稱", "也稱", "或稱", "簡稱", "俗稱", "見", "同", "通"
+};
+
 // Single character info used for inserting data into db
 struct charinfo {
     char *str;
@@ -96,13 +126,15 @@ struct dictinfo {
     char *definition;
 
     // This buffer is used for character info reference in words.
-    // At most, each entry is allowed up to 6 characters.
-    uint32_t charinfo[6];
+    // At most, each entry is allowed up to `CONV_MAX_CHARS` characters.
+    uint32_t charinfo[CONV_MAX_CHARS];
 };
 
 // Setup sqlite state for database at `path`.
 static int sqlite_setup(struct sqlite_state *state, const char *path)
 {
+    TRACE_SPAN("sqlite_setup", path);
+
     #define CHECK(stmt) if (!(stmt)) { goto fail; }
 
     state->db = sqlite_open(path, false);
@@ -123,6 +155,14 @@ static int sqlite_setup(struct sqlite_state *state, const char *path)
         // Create dictionary table
         SQL_STMT_CREATE_DICT
 
+        // Create tables for structured definitions
+        SQL_STMT_CREATE_SENSE
+        SQL_STMT_CREATE_EXAMPLE
+        SQL_STMT_CREATE_CITE
+
+        // Create cross-reference table
+        SQL_STMT_CREATE_XREF
+
         // Create indicies
         SQL_STMT_CREATE_INDEX
     ), NULL)) { goto fail; }
@@ -139,6 +179,16 @@ static int sqlite_setup(struct sqlite_state *state, const char *path)
 
     CHECK(state->dict_insert = sqlite_prepare(state->db, SQL_STMT_INSERT_DICT));
 
+    printf("Prepare insert definition statements...\n");
+
+    CHECK(state->sense_insert = sqlite_prepare(state->db, SQL_STMT_INSERT_SENSE));
+    CHECK(state->example_insert = sqlite_prepare(state->db, SQL_STMT_INSERT_EXAMPLE));
+    CHECK(state->cite_insert = sqlite_prepare(state->db, SQL_STMT_INSERT_CITE));
+
+    printf("Prepare insert cross-reference statement...\n");
+
+    CHECK(state->xref_insert = sqlite_prepare(state->db, SQL_STMT_INSERT_XREF));
+
     printf("Prepare update radical statement...\n");
 
     CHECK(state->rad_update = sqlite_prepare(state->db, SQL_STMT_UPDATE_RAD));
@@ -179,10 +229,28 @@ fail:
 // Destroy sqlite state. Remove file at original path if requested.
 static void sqlite_destroy(struct sqlite_state *state, bool do_unlink)
 {
+    sqlite3_stmt *stmts[] = {
+        state->rad_insert, state->rad_update, state->rad_find,
+        state->char_insert, state->char_update, state->char_find,
+        state->dict_insert, state->sense_insert, state->example_insert, state->cite_insert,
+        state->xref_insert
+    };
+
+    // Finalizing a NULL statement is harmless.
+    for (size_t i = 0; i < sizeof(stmts) / sizeof(*stmts); i++) {
+        sqlite3_finalize(stmts[i]);
+    }
+
     if (state->db) {
         sqlite_close(state->db);
     }
 
+    if (state->dz) {
+        defzip_free(state->dz);
+    }
+
+    obuf_free(&state->zbuf);
+
     if (state->path && do_unlink && unlink(state->path)) {
         perror("unlink");
     }
@@ -270,20 +338,215 @@ static int32_t exec_insert_stmt(sqlite3_stmt *stmt, const char *thing)
     return result;
 }
 
+// Find the radical `rad` (with `strokes` strokes, or 0 if unknown), adding or fixing up its row as needed.
+// Return index on success, negative on failure.
+static int32_t handle_rad(struct sqlite_state *sqlite, const char *rad, int strokes)
+{
+    int saved;
+
+    int32_t id = find_str(sqlite->rad_find, rad, &saved);
+    if (id < 0) { return -1; }
+
+    if (!id)
+    {
+        if (sqlite_bind_str(sqlite->rad_insert, SQL_INS_RAD_CHAR,    rad))     { return -1; }
+        if (sqlite_bind_int(sqlite->rad_insert, SQL_INS_RAD_STROKES, strokes)) { return -1; }
+
+        return exec_insert_stmt(sqlite->rad_insert, "radical");
+    }
+
+    // This radical was added (without a stroke count) before we got to its own entry.
+    if (strokes && !saved)
+    {
+        if (sqlite_bind_int(sqlite->rad_update, SQL_UPD_RAD_STROKES, strokes)) { return -1; }
+        if (sqlite_bind_int(sqlite->rad_update, SQL_UPD_RAD_ID,      id))      { return -1; }
+
+        int status = sqlite_step(sqlite->rad_update);
+        sqlite3_reset(sqlite->rad_update);
+
+        if (status != SQLITE_DONE) { return -1; }
+    }
+
+    return id;
+}
+
 // Handle single character dictionary entry. Return index on success, negative on failure.
-static int32_t handle_char(struct sqlite_state *sqlite, struct charinfo info, struct insert_map *map)
+static int32_t handle_char(struct sqlite_state *sqlite, struct charinfo info)
 {
-    if (info.strokes_ext) {
-        // This is a radical.
-    } else {
-        // This is not a radical.
+    int32_t rad = 0;
+
+    if (info.rad)
+    {
+        // Characters with no strokes outside their radical are the radical itself.
+        rad = handle_rad(sqlite, info.rad, (info.strokes_ext ? 0 : info.strokes));
+        if (rad < 0) { return -1; }
     }
 
     // We can use this to determine if the saved value is a dummy
     int strokes;
 
     int32_t id = find_str(sqlite->char_find, info.str, &strokes);
-    return exec_insert_stmt(sqlite->char_insert, "character");
+    if (id < 0) { return -1; }
+
+    // Dummy entries (from words we saw before this character) are filled in. Otherwise, each pronunciation gets its own row.
+    bool update = (id && !strokes);
+    sqlite3_stmt *stmt = (update ? sqlite->char_update : sqlite->char_insert);
+
+    #define BIND(kind, field, val) if (sqlite_bind_##kind(stmt, (update ? SQL_UPD_CHAR_##field : SQL_INS_CHAR_##field), val)) { return -1; }
+
+    BIND(int, RAD,      rad);
+    BIND(int, STROKES,  info.strokes);
+    BIND(int, XSTROKES, info.strokes_ext);
+    BIND(str, ZHUYIN,   info.zhuyin);
+    BIND(str, PINYIN,   info.pinyin);
+    BIND(str, XPRON,    info.pronoun_other);
+    BIND(int, PRON_ORD, info.pronoun_order);
+
+    #undef BIND
+
+    if (!update)
+    {
+        if (sqlite_bind_str(stmt, SQL_INS_CHAR_CHAR, info.str)) { return -1; }
+        return exec_insert_stmt(stmt, "character");
+    }
+
+    if (sqlite_bind_int(stmt, SQL_UPD_CHAR_ID, id)) { return -1; }
+
+    int status = sqlite_step(stmt);
+    sqlite3_reset(stmt);
+
+    return ((status == SQLITE_DONE) ? id : -1);
+}
+
+// Bind `len` bytes of definition text, compressing it first if we have a model. Returns non-zero on failure.
+static int bind_def(struct sqlite_state *sqlite, sqlite3_stmt *stmt, int loc, const char *str, size_t len)
+{
+    if (!sqlite->dz) { return sqlite_bind_strn(stmt, loc, str, len); }
+
+    // Each statement runs before anything else is compressed, so one buffer does for everything.
+    sqlite->zbuf.len = 0;
+
+    if (defzip_encode(sqlite->dz, str, len, &sqlite->zbuf)) { return 1; }
+    return sqlite_bind_blob(stmt, loc, sqlite->zbuf.data, sqlite->zbuf.len);
+}
+
+// Train a compression model on every definition in the document and store it in the database. Returns non-zero on failure.
+static int setup_defzip(struct sqlite_state *sqlite, struct xlsx *doc, struct insert_map *map)
+{
+    TRACE_SPAN("defzip_train", NULL);
+
+    const char **defs = calloc(xlsx_rows(doc), sizeof(const char *));
+
+    if (!defs)
+    {
+        perror("calloc");
+        return 1;
+    }
+
+    off_t col = map->dictmap[SQL_INS_DICT_DEF];
+
+    xlsx_foreach_row(doc, ^(struct xlsx_value *row, size_t i) {
+        if (i && XLSX_ISSTR(&row[col])) {
+            defs[i] = XLSX_STRVAL(doc, &row[col]);
+        }
+
+        return 0;
+    });
+
+    sqlite->dz = defzip_train(defs, xlsx_rows(doc));
+    free(defs);
+
+    return (!sqlite->dz || defzip_sqlite_store(sqlite->db, sqlite->dz));
+}
+
+// Find the phrase introducing a cross-reference which starts at `quote` (the 「) in `def`.
+static struct defparse_span xref_phrase(const char *def, const char *quote)
+{
+    for (size_t i = 0; i < sizeof(xref_phrases) / sizeof(*xref_phrases); i++)
+    {
+        size_t len = strlen(xref_phrases[i]);
+
+        if ((size_t)(quote - def) >= len && !memcmp(quote - len, xref_phrases[i], len)) {
+            return (struct defparse_span){ .str = quote - len, .len = len };
+        }
+    }
+
+    return (struct defparse_span){ .str = quote, .len = 0 };
+}
+
+// Save a cross-reference to be resolved after the insert pass. Returns non-zero on failure.
+// Quoted words without a phrase introducing them (like 「...」 in running text) aren't references, so they're ignored.
+static int add_xref(struct xref_list *xrefs, struct xref ref)
+{
+    if (!ref.phrase.len) { return 0; }
+
+    if (xrefs->count == xrefs->cap)
+    {
+        size_t cap = (xrefs->cap ? xrefs->cap * 2 : 1024);
+        struct xref *refs = realloc(xrefs->refs, cap * sizeof(struct xref));
+
+        if (!refs)
+        {
+            perror("realloc");
+            return 1;
+        }
+
+        xrefs->refs = refs;
+        xrefs->cap = cap;
+    }
+
+    xrefs->refs[xrefs->count++] = ref;
+    return 0;
+}
+
+// Insert the senses, examples, and citations from the definition of entry `id`, saving cross-references in `xrefs`.
+// Returns non-zero on failure.
+static int handle_def(struct sqlite_state *sqlite, struct xref_list *xrefs, uint64_t id, const char *def)
+{
+    __block int32_t sense = 0;
+
+    defparse(def, strlen(def), ^(const struct defparse_item *item) {
+        switch (item->kind)
+        {
+            case DEFPARSE_SENSE:
+                if (sqlite_bind_int(sqlite->sense_insert, SQL_INS_SENSE_ENTRY, id) ||
+                    sqlite_bind_int(sqlite->sense_insert, SQL_INS_SENSE_ORDER, item->sense) ||
+                    (item->pos.len ? sqlite_bind_strn(sqlite->sense_insert, SQL_INS_SENSE_POS, item->pos.str, item->pos.len)
+                                   : sqlite_bind_null(sqlite->sense_insert, SQL_INS_SENSE_POS)) ||
+                    bind_def(sqlite, sqlite->sense_insert, SQL_INS_SENSE_TEXT, item->text.str, item->text.len)) { return (sense = -1); }
+
+                sense = exec_insert_stmt(sqlite->sense_insert, "sense");
+                return (sense < 0);
+
+            case DEFPARSE_EXAMPLE:
+                if (sqlite_bind_int(sqlite->example_insert, SQL_INS_EXAMPLE_SENSE, sense) ||
+                    sqlite_bind_strn(sqlite->example_insert, SQL_INS_EXAMPLE_TEXT, item->text.str, item->text.len)) { return (sense = -1); }
+
+                if (exec_insert_stmt(sqlite->example_insert, "example") < 0) { return (sense = -1); }
+                return 0;
+
+            case DEFPARSE_CITATION:
+                if (sqlite_bind_int(sqlite->cite_insert, SQL_INS_CITE_SENSE, sense) ||
+                    sqlite_bind_strn(sqlite->cite_insert, SQL_INS_CITE_SOURCE, item->source.str, item->source.len) ||
+                    (item->text.len ? sqlite_bind_strn(sqlite->cite_insert, SQL_INS_CITE_TEXT, item->text.str, item->text.len)
+                                    : sqlite_bind_null(sqlite->cite_insert, SQL_INS_CITE_TEXT))) { return (sense = -1); }
+
+                if (exec_insert_stmt(sqlite->cite_insert, "citation") < 0) { return (sense = -1); }
+                return 0;
+
+            case DEFPARSE_XREF:
+                if (add_xref(xrefs, (struct xref){
+                    .entry = id,
+                    .sense = sense,
+                    .word = item->text,
+                    .phrase = xref_phrase(def, item->text.str - 3)
+                })) { return (sense = -1); }
+
+                return 0;
+        }
+    });
+
+    return (sense < 0);
 }
 
 
@@ -306,6 +569,73 @@ static int32_t word_charinfo(struct sqlite_state *sqlite, const char *chr)
     return exec_insert_stmt(sqlite->char_insert, "dummy character");
 }
 
+// Insert one direction of a cross-reference edge. Returns non-zero on failure.
+static int insert_xref(struct sqlite_state *sqlite, uint64_t entry, int dir, uint64_t other, const struct xref *ref)
+{
+    sqlite3_stmt *stmt = sqlite->xref_insert;
+
+    if (sqlite_bind_int64(stmt, SQL_INS_XREF_ENTRY,  entry))      { return 1; }
+    if (sqlite_bind_int(stmt,   SQL_INS_XREF_DIR,    dir))        { return 1; }
+    if (sqlite_bind_int64(stmt, SQL_INS_XREF_OTHER,  other))      { return 1; }
+    if (sqlite_bind_int(stmt,   SQL_INS_XREF_SENSE,  ref->sense)) { return 1; }
+    if (sqlite_bind_strn(stmt,  SQL_INS_XREF_PHRASE, ref->phrase.str, ref->phrase.len)) { return 1; }
+
+    int status = sqlite_step(stmt);
+    sqlite3_reset(stmt);
+
+    return (status != SQLITE_DONE);
+}
+
+// Resolve every saved cross-reference to the entries for the word it names (using an in-memory word index),
+//   inserting both a forward and a reverse edge for each. References to words not in the dictionary are dropped.
+// Returns non-zero on failure.
+static int resolve_xrefs(struct sqlite_state *sqlite, struct xlsx *doc, struct insert_map *map, struct xref_list *xrefs)
+{
+    TRACE_SPAN("resolve_xrefs", NULL);
+
+    struct dindex *idx = dindex_build(doc, map->dictmap[SQL_INS_DICT_WORD], map->dictmap[SQL_INS_DICT_DEF], -1);
+    if (!idx) { return 1; }
+
+    size_t resolved = 0;
+    size_t edges = 0;
+
+    for (size_t i = 0; i < xrefs->count; i++)
+    {
+        const struct xref *ref = &xrefs->refs[i];
+        const struct dindex_word *word = dindex_find(idx, ref->word.str, ref->word.len);
+
+        if (!word) { continue; }
+
+        bool found = false;
+
+        // Words with multiple entries (like multiple pronunciations) get an edge to each of them.
+        for (uint32_t j = 0; j < word->count; j++)
+        {
+            uint64_t target = xrefs->ids[idx->entries[idx->rows[word->first + j]].row];
+
+            // Skip entries we didn't insert, and entries mentioning themselves.
+            if (!target || target == ref->entry) { continue; }
+
+            if (insert_xref(sqlite, ref->entry, SQL_XREF_FORWARD, target, ref) ||
+                insert_xref(sqlite, target, SQL_XREF_REVERSE, ref->entry, ref))
+            {
+                dindex_free(idx);
+                return 1;
+            }
+
+            found = true;
+            edges++;
+        }
+
+        resolved += found;
+    }
+
+    fprintf(stderr, "Resolved %zu of %zu cross-references (%zu edges).\n", resolved, xrefs->count, edges);
+
+    dindex_free(idx);
+    return 0;
+}
+
 // Build the map between sql params and excel columns
 static int build_insert_map(struct xlsx *doc, struct xlsx_value *names, struct insert_map *map)
 {
@@ -376,6 +706,9 @@ static int build_insert_map(struct xlsx *doc, struct xlsx_value *names, struct i
 
     for (size_t i = 1; i < SQL_INS_DICT_CNT + 1; i++)
     {
+        // Character info is computed, and character counts can be too.
+        if (i == SQL_INS_DICT_CHAR_INFO || i == SQL_INS_DICT_CHARS) { continue; }
+
         if (map->dictmap[i] < 0)
         {
             fprintf(stderr, "Error: Missing column %zu\n", i);
@@ -387,9 +720,11 @@ static int build_insert_map(struct xlsx *doc, struct xlsx_value *names, struct i
     return 0;
 }
 
-// Insert everything in a single pass over the database
-static int do_insert_pass(struct sqlite_state *sqlite, struct xlsx *doc, struct insert_map *map)
+// Insert everything in a single pass over the database, compressing definitions if `compress` is set.
+static int do_insert_pass(struct sqlite_state *sqlite, struct xlsx *doc, struct insert_map *map, bool compress)
 {
+    TRACE_SPAN("insert_pass", NULL);
+
 /*        #define do_bind_str(p, name)                                                            \
             do {                                                                                \
                 struct xlsx_value *entry = &row[col_map[p]];                                    \
@@ -478,8 +813,8 @@ static int do_insert_pass(struct sqlite_state *sqlite, struct xlsx *doc, struct
         sval;                                                                                       \
     })
 
-    // Same as the string macro above, but not for integers.
-    // Depends on `row`, `doc`, `i`, `skipped` external variables in the loop below.
+    // Same as the string macro above, but not for integers (and empty cells are 0).
+    // Malformed numbers skip the row. Depends on `row`, `doc`, `i`, `m` external variables in the loop below.
     #define as_int_chk(idx, name) ({                                                                \
         struct xlsx_value *entry = &row[idx];                                                       \
         uint64_t ival;                                                                              \
@@ -490,13 +825,15 @@ static int do_insert_pass(struct sqlite_state *sqlite, struct xlsx *doc, struct
                                                                                                     \
             if (end[0])                                                                             \
             {                                                                                       \
-                fprintf(stderr, "Error: " name " (%s) in row '%zu' is malformed!\n", sval, i);      \
-                skipped++;                                                                          \
+                metrics_debug(m, "Error: " name " (%s) in row '%zu' is malformed!\n", sval, i);     \
+                metrics_malformed(m);                                                               \
                                                                                                     \
-                return 1;                                                                           \
+                return 0;                                                                           \
             }                                                                                       \
         } else if (entry->type == XLSX_TYPE_INT) {                                                  \
             ival = entry->ival;                                                                     \
+        } else if (entry->type == XLSX_TYPE_NULL) {                                                 \
+            ival = 0;                                                                               \
         } else {                                                                                    \
             fprintf(stderr, "Error: " name " in row '%zu' is not an int!\n", i);                    \
             return -1;                                                                              \
@@ -506,10 +843,31 @@ static int do_insert_pass(struct sqlite_state *sqlite, struct xlsx *doc, struct
     })
 
     // Some entries have weird numbers for some reason.
-    // We skip them for now.
-    __block int skipped = 0;
+    // We skip them for now, but keep count of them here (along with our progress).
+    struct metrics metrics;
+    struct metrics *m = &metrics;
+
+    metrics_init(m, "conv", xlsx_rows(doc) - 1);
 
-    // This is our insertion loop-- we go through the document once, inserting entries into all 3 tables.
+    // Cross-references found along the way (and where each row ended up), resolved after every entry is in.
+    __block struct xref_list xrefs = { 0 };
+    xrefs.ids = calloc(xlsx_rows(doc), sizeof(uint64_t));
+
+    if (!xrefs.ids)
+    {
+        perror("calloc");
+        return 1;
+    }
+
+    // Everything goes in as a single transaction, since committing each row separately is very slow.
+    if (sqlite_exec(sqlite->db, "begin;", NULL) || (compress && setup_defzip(sqlite, doc, map)))
+    {
+        free(xrefs.ids);
+        return 1;
+    }
+
+    // This is our insertion loop-- we go through the document once, inserting entries into all 3 tables
+    //   (and the senses, examples, and citations parsed from each definition into their own tables).
     // All entries have a `dict` table entry, so we first find the char/word name and definition,
     //   along with the character count.
     // If there is only a single character, it gets an entry in the character table.
@@ -517,27 +875,54 @@ static int do_insert_pass(struct sqlite_state *sqlite, struct xlsx *doc, struct
     // If there are multiple characters, we look up the id for each of them and put it into character info for easy lookup.
     // At any point, we may have to put in dummy chars/radicals for other entries to reference.
     // Only the dictionary ids are actually preserved from the xlsx document.
-    xlsx_foreach_row(doc, ^(struct xlsx_value *row, size_t i) {
+    __block struct trace_span batch = { .name = NULL };
+
+    int status = xlsx_foreach_row(doc, ^(struct xlsx_value *row, size_t i) {
+        if (!(i % CONV_TRACE_ROWS))
+        {
+            trace_end(&batch);
+            batch = trace_begin("insert_rows", NULL);
+        }
+
         // Skip column headers
-        if (!i) { return 1; }
+        if (!i) { return 0; }
 
         // Read info for next entry.
         struct dictinfo word = {
             .id = as_int_chk(map->dictmap[SQL_INS_DICT_ID], "Entry Number"),
             .str = as_str_chk(map->dictmap[SQL_INS_DICT_WORD], "Character/Word"),
-            .definition = as_str_chk(map->dictmap[SQL_INS_DICT_DEF], "Definition"),
-            .chars = as_int_chk(map->dictmap[SQL_INS_DICT_CHARS], "Character Count")
+            .definition = as_str_chk(map->dictmap[SQL_INS_DICT_DEF], "Definition")
         };
 
-        fprintf(stderr, "Preparing to insert '%s'...\n", word.str);
+        metrics_debug(m, "Preparing to insert '%s'...\n", word.str);
+        metrics_step(m, (word.str ? strlen(word.str) : 0) + (word.definition ? strlen(word.definition) : 0));
+
+        if (!word.str || !word.definition)
+        {
+            metrics_debug(m, "Warning: Row %zu has no word or no definition.\n", i);
+            metrics_skip(m);
+
+            return 0;
+        }
+
+        // Not every version of the dictionary has a character count column.
+        if (map->dictmap[SQL_INS_DICT_CHARS] >= 0) {
+            word.chars = as_int_chk(map->dictmap[SQL_INS_DICT_CHARS], "Character Count");
+        } else {
+            word.chars = utf8_count(word.str);
+        }
 
         // Buffer overflows are bad.
-        if (word.chars > 6) {
-            fprintf(stderr, "Error: '%s' in row %zu has too many characters! (max=6, found=%llu)\n", word.str, i, word.chars);
-            return -1;
+        if (word.chars > CONV_MAX_CHARS) {
+            metrics_debug(m, "Warning: '%s' in row %zu has too many characters! (max=%d, found=%llu)\n", word.str, i, CONV_MAX_CHARS, word.chars);
+            metrics_skip(m);
+
+            return 0;
         } else if (!word.chars) {
-            fprintf(stderr, "Warning: '%s' in row %zu has no characters?\n", word.str, i);
-            return 1;
+            metrics_debug(m, "Warning: '%s' in row %zu has no characters?\n", word.str, i);
+            metrics_skip(m);
+
+            return 0;
         }
 
         if (word.chars == 1) {
@@ -551,7 +936,7 @@ static int do_insert_pass(struct sqlite_state *sqlite, struct xlsx *doc, struct
                 .pinyin = as_str_chk(map->charmap[SQL_INS_CHAR_PINYIN], "Pinyin"),
                 .pronoun_other = as_str_chk(map->charmap[SQL_INS_CHAR_XPRON], "Extra Pronunciation Info"),
                 .pronoun_order = as_int_chk(map->charmap[SQL_INS_CHAR_PRON_ORD], "Prnounciation Order")
-            }), map);
+            }));
 
             if (char_id < 0) {
                 return -1;
@@ -562,7 +947,7 @@ static int do_insert_pass(struct sqlite_state *sqlite, struct xlsx *doc, struct
             // This is a multi-char entry
             // We need to copy out each char we will search for into a buffer.
             // We assume UTF-8, so 4 chars + a terminating \0
-            uint8_t next[5] = { 0, 0, 0, 0, 0 };
+            char next[5] = { 0, 0, 0, 0, 0 };
             off_t offset = 0;
 
             for (size_t i = 0; i < word.chars; i++)
@@ -570,10 +955,10 @@ static int do_insert_pass(struct sqlite_state *sqlite, struct xlsx *doc, struct
                 if (!word.str[offset])
                 {
                     // The char count doesn't match the actual string length
-                    fprintf(stderr, "Character count doesn't match word length!\n");
-                    skipped++;
+                    metrics_debug(m, "Character count doesn't match word length!\n");
+                    metrics_malformed(m);
 
-                    return 1;
+                    return 0;
                 }
 
                 // The first 8 bits determines how many bytes this char takes
@@ -582,20 +967,35 @@ static int do_insert_pass(struct sqlite_state *sqlite, struct xlsx *doc, struct
                 if (bytes > 3)
                 {
                     // This is not a valid codepoint
-                    fprintf(stderr, "Found invalid UTF-8 codepoint in word! (bytes=%zu)\n", bytes);
-                    skipped++;
+                    metrics_debug(m, "Found invalid UTF-8 codepoint in word! (bytes=%zu)\n", bytes);
+                    metrics_malformed(m);
 
-                    return 1;
+                    return 0;
                 }
 
                 memcpy(next, &word.str[offset], bytes + 1);
                 next[bytes + 1] = 0;
 
                 // Here, `next` holds the next single char.
-                word.charinfo[i] = word_charinfo(sqlite, next);
+                int32_t char_id = word_charinfo(sqlite, next);
+                if (char_id < 0) { return -1; }
+
+                word.charinfo[i] = char_id;
+                offset += bytes + 1;
             }
         }
 
+        if (sqlite_bind_int(sqlite->dict_insert, SQL_INS_DICT_ID, word.id)) { return -1; }
+        if (sqlite_bind_str(sqlite->dict_insert, SQL_INS_DICT_WORD, word.str)) { return -1; }
+        if (sqlite_bind_int(sqlite->dict_insert, SQL_INS_DICT_CHARS, word.chars)) { return -1; }
+        if (sqlite_bind_blob(sqlite->dict_insert, SQL_INS_DICT_CHAR_INFO, word.charinfo, word.chars * sizeof(uint32_t))) { return -1; }
+        if (bind_def(sqlite, sqlite->dict_insert, SQL_INS_DICT_DEF, word.definition, strlen(word.definition))) { return -1; }
+
+        if (exec_insert_stmt(sqlite->dict_insert, "dictionary entry") < 0) { return -1; }
+        if (handle_def(sqlite, &xrefs, word.id, word.definition)) { return -1; }
+
+        xrefs.ids[i] = word.id;
+
         /*
         // Is the current entry a radical (extra stroke count == 0)
         bool is_rad = false;
@@ -659,10 +1059,24 @@ static int do_insert_pass(struct sqlite_state *sqlite, struct xlsx *doc, struct
         if (sqlite_step(insert_dict_stmt) != SQLITE_DONE) { return 0; }
         sqlite3_reset(insert_dict_stmt);*/
 
-        return 1;
+        return 0;
     });
 
-    return -1;
+    trace_end(&batch);
+
+    if (!status && resolve_xrefs(sqlite, doc, map, &xrefs)) {
+        status = -1;
+    }
+
+    if (!status && sqlite_exec(sqlite->db, "commit;", NULL)) {
+        status = -1;
+    }
+
+    free(xrefs.refs);
+    free(xrefs.ids);
+
+    metrics_finish(m, (status < 0));
+    return (status < 0);
 
     #undef do_bind_str
     #undef do_bind_int
@@ -673,25 +1087,41 @@ int main(int argc, const char *const *argv)
     const char *xlsx_path = NULL;
     const char *db_path = NULL;
 
-    if (argc == 4) {
-        if (strcmp(argv[1], "-f"))
-        {
-            fprintf(stderr, "Error: Invalid 1st argument '%s'\n", argv[1]);
+    // `-f` replaces an existing database, and `-z` compresses definitions.
+    bool force = false;
+    bool compress = false;
+    int argi = 1;
+
+    for ( ; argi < argc && argv[argi][0] == '-'; argi++)
+    {
+        if (!strcmp(argv[argi], "-f")) {
+            force = true;
+        } else if (!strcmp(argv[argi], "-z")) {
+            compress = true;
+        } else {
+            fprintf(stderr, "Error: Invalid argument '%s'\n", argv[argi]);
             return 1;
         }
+    }
+
+    if (argc - argi != 2)
+    {
+        fprintf(stderr, "Usage: %s [-f] [-z] <dict.xlsx> <dict.sqlite>\n", argv[0]);
+        return 1;
+    }
+
+    xlsx_path = argv[argi];
+    db_path = argv[argi + 1];
 
-        xlsx_path = argv[2];
-        db_path = argv[3];
+    TRACE_SPAN("conv", xlsx_path);
 
+    if (force) {
         if (unlink(db_path) && errno != ENOENT)
         {
             perror("unlink");
             return 1;
         }
-    } else if (argc == 3) {
-        xlsx_path = argv[1];
-        db_path = argv[2];
-
+    } else {
         int status = access(db_path, F_OK);
 
         if (errno != ENOENT)
@@ -704,9 +1134,6 @@ int main(int argc, const char *const *argv)
 
             return 1;
         }
-    } else {
-        fprintf(stderr, "Error: Need 2 or 3 arguments.\n");
-        return 1;
     }
 
     // Open dictionary data xlsx document
@@ -722,7 +1149,7 @@ int main(int argc, const char *const *argv)
     }
 
     // Setup database with tables + prepared statements.
-    struct sqlite_state sqlite;
+    struct sqlite_state sqlite = { 0 };
 
     if (sqlite_setup(&sqlite, db_path))
     {
@@ -743,15 +1170,15 @@ int main(int argc, const char *const *argv)
         return 1;
     }
 
-    int ok = do_insert_pass(&sqlite, doc, &insert_map);
-    sqlite_destroy(&sqlite, !!ok);
+    int status = do_insert_pass(&sqlite, doc, &insert_map, compress);
+    sqlite_destroy(&sqlite, !!status);
     xlsx_doc_free(doc);
 
-    if (ok) {
+    if (!status) {
         fprintf(stderr, "Finished inserting entries from xlsx doc.\n");
     } else {
         fprintf(stderr, "Encountered errors while inserting entries.\n");
     }
 
-    return ok;
+    return status;
 }
@@ -0,0 +1,206 @@
+/* ********************************************************** */
+/* -*- defparse.c -*- Structured definition parsing       -*- */
+/* ********************************************************** */
+/* Tyler Besselman (C) October 2026                           */
+/* ********************************************************** */
+
+#include <stdbool.h>
+#include <string.h>
+
+#include <defparse.h>
+
+// Punctuation we look for (all 3 bytes in UTF-8).
+#define DEFPARSE_QUOTE_OPEN  "\xE3\x80\x8C" // 「
+#define DEFPARSE_QUOTE_CLOSE "\xE3\x80\x8D" // 」
+#define DEFPARSE_BOOK_OPEN   "\xE3\x80\x8A" // 《
+#define DEFPARSE_BOOK_CLOSE  "\xE3\x80\x8B" // 》
+#define DEFPARSE_STOP        "\xE3\x80\x82" // 。
+#define DEFPARSE_SPACE       "\xE3\x80\x80" // Fullwidth space
+#define DEFPARSE_COLON       "\xEF\xBC\x9A" // ：
+#define DEFPARSE_COMMA       "\xEF\xBC\x8C" // ，
+#define DEFPARSE_LIKE        "\xE5\xA6\x82" // 如
+
+// Most bytes allowed between a 》 and the quote it introduces (for chapters, like 《紅樓夢》第三回：「...」).
+#define DEFPARSE_CITE_GAP 32
+
+// Check if there's a 3 byte character at `s` (with `end` after the last byte we may look at).
+static inline bool _defparse_at(const char *s, const char *end, const char *c)
+{ return (end - s >= 3 && !memcmp(s, c, 3)); }
+
+// Skip spaces (ASCII or fullwidth) at the start of `[s, end)`.
+static const char *_defparse_skip(const char *s, const char *end)
+{
+    while (s < end)
+    {
+        if (*s == ' ' || *s == '\t' || *s == '\r') {
+            s++;
+        } else if (_defparse_at(s, end, DEFPARSE_SPACE)) {
+            s += 3;
+        } else {
+            break;
+        }
+    }
+
+    return s;
+}
+
+// Drop spaces (ASCII or fullwidth) from the end of `[s, end)`, returning the new end.
+static const char *_defparse_trim(const char *s, const char *end)
+{
+    while (end > s)
+    {
+        if (end[-1] == ' ' || end[-1] == '\t' || end[-1] == '\r') {
+            end--;
+        } else if (end - s >= 3 && !memcmp(end - 3, DEFPARSE_SPACE, 3)) {
+            end -= 3;
+        } else {
+            break;
+        }
+    }
+
+    return end;
+}
+
+// Find the examples, citations, and cross-references in the sense `item` (which has already been passed to `blk`).
+// Returns non-zero if `blk` asked us to stop.
+static int _defparse_sense(const struct defparse_item *item, int (^blk)(const struct defparse_item *item))
+{
+    const char *s = item->text.str;
+    const char *end = &s[item->text.len];
+
+    struct defparse_item found = {
+        .sense = item->sense,
+        .pos = item->pos,
+        .source = { .str = s, .len = 0 }
+    };
+
+    // Quotes after "如：" are examples until the end of the sentence.
+    bool examples = false;
+
+    // Where a quote would have to start to be the text of the last citation.
+    const char *quote_cite = NULL;
+
+    // Start of the outermost quote we're in (and how deeply nested we are).
+    const char *quote = NULL;
+    size_t depth = 0;
+
+    // Start of the 《source》 we're in.
+    const char *book = NULL;
+
+    while (s < end)
+    {
+        // Everything we look for starts with one of these, and they never show up in the middle of a character.
+        if ((uint8_t)*s != 0xE3 && (uint8_t)*s != 0xE5) {
+            s++;
+            continue;
+        }
+
+        if (_defparse_at(s, end, DEFPARSE_QUOTE_OPEN)) {
+            if (!depth++) { quote = s + 3; }
+        } else if (_defparse_at(s, end, DEFPARSE_QUOTE_CLOSE) && depth) {
+            if (!--depth)
+            {
+                found.text = (struct defparse_span){ .str = quote, .len = s - quote };
+
+                if (quote - 3 == quote_cite) {
+                    found.kind = DEFPARSE_CITATION;
+                } else {
+                    found.kind = (examples ? DEFPARSE_EXAMPLE : DEFPARSE_XREF);
+                    found.source.len = 0;
+                }
+
+                if (blk(&found)) { return 1; }
+            }
+        } else if (depth) {
+            // Anything else inside a quote is just part of the quote.
+        } else if (_defparse_at(s, end, DEFPARSE_BOOK_OPEN)) {
+            book = s + 3;
+        } else if (_defparse_at(s, end, DEFPARSE_BOOK_CLOSE) && book) {
+            found.source = (struct defparse_span){ .str = book, .len = s - book };
+            book = NULL;
+
+            // Citations are usually followed by what they say, like 《史記．卷一》：「...」.
+            const char *next = s + 3;
+            const char *limit = (end - next > DEFPARSE_CITE_GAP ? next + DEFPARSE_CITE_GAP : end);
+
+            while (next < limit && !_defparse_at(next, end, DEFPARSE_QUOTE_OPEN) && !_defparse_at(next, end, DEFPARSE_COLON)
+                   && !_defparse_at(next, end, DEFPARSE_STOP) && !_defparse_at(next, end, DEFPARSE_COMMA)
+                   && !_defparse_at(next, end, DEFPARSE_BOOK_OPEN)) {
+                next++;
+            }
+
+            if (_defparse_at(next, end, DEFPARSE_COLON)) { next += 3; }
+
+            if (_defparse_at(next, end, DEFPARSE_QUOTE_OPEN)) {
+                quote_cite = next;
+            } else {
+                found.kind = DEFPARSE_CITATION;
+                found.text = (struct defparse_span){ .str = next, .len = 0 };
+
+                if (blk(&found)) { return 1; }
+            }
+        } else if (_defparse_at(s, end, DEFPARSE_LIKE) && _defparse_at(s + 3, end, DEFPARSE_COLON)) {
+            examples = true;
+        } else if (_defparse_at(s, end, DEFPARSE_STOP)) {
+            examples = false;
+        }
+
+        s++;
+    }
+
+    return 0;
+}
+
+size_t defparse(const char *def, size_t len, int (^blk)(const struct defparse_item *item))
+{
+    const char *end = &def[len];
+
+    struct defparse_item item = {
+        .kind = DEFPARSE_SENSE,
+        .sense = 0,
+        .pos = { .str = def, .len = 0 },
+        .source = { .str = def, .len = 0 }
+    };
+
+    // Senses are one per line, with part of speech tags like "[名]" applying to every sense after them.
+    for (const char *line = def; line < end; )
+    {
+        const char *eol = memchr(line, '\n', end - line);
+        if (!eol) { eol = end; }
+
+        const char *s = _defparse_skip(line, eol);
+        line = eol + 1;
+
+        if (s < eol && *s == '[')
+        {
+            const char *close = memchr(s, ']', eol - s);
+
+            if (close)
+            {
+                item.pos = (struct defparse_span){ .str = s + 1, .len = close - s - 1 };
+                s = _defparse_skip(close + 1, eol);
+            }
+        }
+
+        // Skip sense numbers like "1." (which are followed by a fullwidth space).
+        const char *digits = s;
+
+        while (digits < eol && *digits >= '0' && *digits <= '9') {
+            digits++;
+        }
+
+        if (digits > s && digits < eol && *digits == '.') {
+            s = _defparse_skip(digits + 1, eol);
+        }
+
+        eol = _defparse_trim(s, eol);
+        if (s == eol) { continue; }
+
+        item.sense++;
+        item.text = (struct defparse_span){ .str = s, .len = eol - s };
+
+        if (blk(&item) || _defparse_sense(&item, blk)) { break; }
+    }
+
+    return item.sense;
+}
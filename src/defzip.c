@@ -0,0 +1,900 @@
+/* ********************************************************** */
+/* -*- defzip.c -*- Static-model definition compression   -*- */
+/* ********************************************************** */
+/* Tyler Besselman (C) October 2026                           */
+/* ********************************************************** */
+
+#include <strings.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+
+#include <defzip.h>
+#include <utf8.h>
+
+// Slots in the table counting phrases while training. Whenever it gets 3/4 full, the rarest phrases are dropped.
+#define DEFZIP_COUNT_SLOTS (1 << 21)
+
+// Marks a symbol which isn't in the model.
+#define DEFZIP_NONE UINT32_MAX
+
+// Pack up to 3 codepoints into a phrase key. Codepoints are never 0, so the length is implied.
+#define DEFZIP_KEY(a, b, c) ((uint64_t)(a) | ((uint64_t)(b) << 21) | ((uint64_t)(c) << 42))
+
+static inline uint32_t _defzip_hash(uint64_t key)
+{ return (uint32_t)((key * 0x9E3779B97F4A7C15ULL) >> 32); }
+
+// Number of bytes in the UTF-8 encoding of a codepoint.
+static inline size_t _defzip_cplen(uint32_t cp)
+{ return (cp < 0x80 ? 1 : (cp < 0x800 ? 2 : (cp < 0x10000 ? 3 : 4))); }
+
+// Decode the codepoint at `*s` (before `end`), advancing `*s` past it.
+// Anything which wouldn't encode back to the same bytes is taken a byte at a time, as `DEFZIP_RAW_BYTE | byte`.
+static inline uint32_t _defzip_next(const char **s, const char *end)
+{
+    const char *p = (*s);
+    uint32_t cp = utf8_next(&p);
+
+    if (!cp || cp >= DEFZIP_RAW_BYTE || p > end || (size_t)(p - (*s)) != _defzip_cplen(cp))
+    {
+        cp = DEFZIP_RAW_BYTE | (uint8_t)**s;
+        p = (*s) + 1;
+    }
+
+    (*s) = p;
+    return cp;
+}
+
+// Find the symbol for a phrase, returning `DEFZIP_NONE` if it isn't in the model.
+static inline uint32_t _defzip_find(const struct defzip *dz, uint64_t key)
+{
+    uint32_t mask = dz->nslots - 1;
+
+    for (uint32_t i = _defzip_hash(key) & mask; dz->slots[i].key; i = (i + 1) & mask) {
+        if (dz->slots[i].key == key) { return dz->slots[i].sym; }
+    }
+
+    return DEFZIP_NONE;
+}
+
+// Split `[s, end)` into symbols, taking the longest phrase in the model at each point.
+// Performs a block on each symbol, along with the codepoint (or raw byte) it starts with for escapes.
+static void _defzip_tokens(const struct defzip *dz, const char *s, const char *end, void (^blk)(uint32_t sym, uint32_t cp))
+{
+    while (s < end)
+    {
+        uint32_t cps[DEFZIP_PHRASE_LEN];
+        const char *after[DEFZIP_PHRASE_LEN];
+        size_t n = 0;
+
+        // Phrases never include raw bytes.
+        for (const char *p = s; n < DEFZIP_PHRASE_LEN && p < end; n++)
+        {
+            cps[n] = _defzip_next(&p, end);
+            after[n] = p;
+
+            if (cps[n] >= DEFZIP_RAW_BYTE) { n += !n; break; }
+        }
+
+        uint32_t sym = DEFZIP_NONE;
+        size_t take = 1;
+
+        for (size_t k = n; k && sym == DEFZIP_NONE; k--)
+        {
+            if (cps[k - 1] >= DEFZIP_RAW_BYTE) { continue; }
+
+            sym = _defzip_find(dz, DEFZIP_KEY(cps[0], (k > 1 ? cps[1] : 0), (k > 2 ? cps[2] : 0)));
+            take = k;
+        }
+
+        if (sym == DEFZIP_NONE)
+        {
+            sym = DEFZIP_ESCAPE;
+            take = 1;
+        }
+
+        blk(sym, cps[0]);
+        s = after[take - 1];
+    }
+}
+
+// Make a model over phrases with the given keys (where key 0 is the escape), without any codes yet.
+static struct defzip *_defzip_new(const uint64_t *keys, uint32_t nsyms)
+{
+    struct defzip *dz = calloc(1, sizeof(struct defzip));
+
+    if (!dz)
+    {
+        perror("calloc");
+        return NULL;
+    }
+
+    dz->nsyms = nsyms;
+    dz->nslots = 16;
+
+    while (dz->nslots < 2 * nsyms) {
+        dz->nslots *= 2;
+    }
+
+    dz->pool = malloc(nsyms * DEFZIP_PHRASE_LEN * 4 + 1);
+    dz->offs = malloc(nsyms * sizeof(uint32_t) + 1);
+    dz->lens = malloc(nsyms + 1);
+    dz->code_lens = calloc(nsyms + 1, 1);
+    dz->codes = calloc(nsyms + 1, sizeof(uint32_t));
+    dz->sorted = malloc(nsyms * sizeof(uint32_t) + 1);
+    dz->table = calloc(1 << DEFZIP_TABLE_BITS, sizeof(uint32_t));
+    dz->slots = calloc(dz->nslots, sizeof(struct defzip_slot));
+
+    if (!dz->pool || !dz->offs || !dz->lens || !dz->code_lens || !dz->codes || !dz->sorted || !dz->table || !dz->slots)
+    {
+        perror("malloc");
+        defzip_free(dz);
+
+        return NULL;
+    }
+
+    uint32_t off = 0;
+    uint32_t mask = dz->nslots - 1;
+
+    for (uint32_t s = 0; s < nsyms; s++)
+    {
+        dz->offs[s] = off;
+
+        for (uint64_t key = keys[s]; key; key >>= 21) {
+            off += utf8_encode(key & 0x1FFFFF, &dz->pool[off]);
+        }
+
+        dz->lens[s] = off - dz->offs[s];
+
+        if (!keys[s]) { continue; }
+
+        uint32_t i = _defzip_hash(keys[s]) & mask;
+
+        while (dz->slots[i].key) {
+            i = (i + 1) & mask;
+        }
+
+        dz->slots[i] = (struct defzip_slot){ .key = keys[s], .sym = s };
+    }
+
+    return dz;
+}
+
+// Assign canonical codes from the code length of each symbol and build the decoding tables.
+// Returns non-zero if the lengths don't make a valid prefix code.
+static int _defzip_codes(struct defzip *dz)
+{
+    memset(dz->count, 0, sizeof(dz->count));
+    memset(dz->table, 0, (1 << DEFZIP_TABLE_BITS) * sizeof(uint32_t));
+
+    dz->max_code = 0;
+
+    for (uint32_t s = 0; s < dz->nsyms; s++)
+    {
+        uint8_t len = dz->code_lens[s];
+        if (!len || len > DEFZIP_MAX_CODE) { return 1; }
+
+        dz->count[len]++;
+
+        if (len > dz->max_code) {
+            dz->max_code = len;
+        }
+    }
+
+    // Codes of each length follow on from the codes one bit shorter (Kraft's inequality must hold for this to work).
+    uint64_t code = 0;
+    uint32_t index = 0;
+
+    for (uint32_t len = 1; len <= DEFZIP_MAX_CODE; len++)
+    {
+        code <<= 1;
+
+        dz->first_code[len] = code;
+        dz->first_index[len] = index;
+
+        code += dz->count[len];
+        index += dz->count[len];
+
+        if (code > (1ULL << len)) { return 1; }
+    }
+
+    uint32_t seen[DEFZIP_MAX_CODE + 1] = { 0 };
+
+    for (uint32_t s = 0; s < dz->nsyms; s++)
+    {
+        uint8_t len = dz->code_lens[s];
+        uint32_t rank = seen[len]++;
+
+        dz->sorted[dz->first_index[len] + rank] = s;
+        dz->codes[s] = dz->first_code[len] + rank;
+
+        if (len > DEFZIP_TABLE_BITS) { continue; }
+
+        // Every entry starting with this code decodes to this symbol.
+        uint32_t start = dz->codes[s] << (DEFZIP_TABLE_BITS - len);
+
+        for (uint32_t i = 0; i < (1U << (DEFZIP_TABLE_BITS - len)); i++) {
+            dz->table[start + i] = (s << 8) | len;
+        }
+    }
+
+    return 0;
+}
+
+// Table of phrase counts kept while training. Slots are empty when `key` is 0.
+struct _defzip_count {
+    uint64_t key;
+    uint32_t count;
+};
+
+struct _defzip_counter {
+    struct _defzip_count *slots;
+    size_t used;
+
+    // Phrases seen fewer times than this are dropped the next time the table fills up.
+    uint32_t floor;
+};
+
+// Drop rare phrases until the table is at most half full. Returns non-zero on failure.
+static int _defzip_count_prune(struct _defzip_counter *c)
+{
+    uint32_t mask = DEFZIP_COUNT_SLOTS - 1;
+
+    while (c->used > DEFZIP_COUNT_SLOTS / 2)
+    {
+        struct _defzip_count *slots = calloc(DEFZIP_COUNT_SLOTS, sizeof(struct _defzip_count));
+
+        if (!slots)
+        {
+            perror("calloc");
+            return 1;
+        }
+
+        c->used = 0;
+
+        for (size_t s = 0; s < DEFZIP_COUNT_SLOTS; s++)
+        {
+            if (!c->slots[s].key || c->slots[s].count < c->floor) { continue; }
+
+            uint32_t i = _defzip_hash(c->slots[s].key) & mask;
+
+            while (slots[i].key) {
+                i = (i + 1) & mask;
+            }
+
+            slots[i] = c->slots[s];
+            c->used++;
+        }
+
+        free(c->slots);
+
+        c->slots = slots;
+        c->floor *= 2;
+    }
+
+    return 0;
+}
+
+// Count a phrase. Returns non-zero on failure.
+static int _defzip_count_add(struct _defzip_counter *c, uint64_t key)
+{
+    uint32_t mask = DEFZIP_COUNT_SLOTS - 1;
+    uint32_t i = _defzip_hash(key) & mask;
+
+    for ( ; c->slots[i].key; i = (i + 1) & mask)
+    {
+        if (c->slots[i].key == key)
+        {
+            c->slots[i].count++;
+            return 0;
+        }
+    }
+
+    c->slots[i] = (struct _defzip_count){ .key = key, .count = 1 };
+    c->used++;
+
+    return ((c->used >= DEFZIP_COUNT_SLOTS / 4 * 3) ? _defzip_count_prune(c) : 0);
+}
+
+// A candidate phrase and roughly how many codepoints it saves (occurrences times extra codepoints).
+struct _defzip_candidate {
+    uint64_t key;
+    uint64_t score;
+};
+
+static int _defzip_candidate_cmp(const void *a, const void *b)
+{
+    const struct _defzip_candidate *x = a;
+    const struct _defzip_candidate *y = b;
+
+    if (x->score != y->score) { return (x->score < y->score) - (x->score > y->score); }
+    return (x->key > y->key) - (x->key < y->key);
+}
+
+static int _defzip_u64_cmp(const void *a, const void *b)
+{
+    uint64_t x = *(const uint64_t *)a;
+    uint64_t y = *(const uint64_t *)b;
+
+    return (x > y) - (x < y);
+}
+
+// Find Huffman code lengths for `n` symbols with (non-zero) frequencies `freqs`, limited to `DEFZIP_MAX_CODE` bits.
+// Frequencies are flattened until the longest code fits. Returns non-zero on failure.
+static int _defzip_lengths(const uint64_t *freqs, uint32_t n, uint8_t *lens)
+{
+    if (n == 1)
+    {
+        lens[0] = 1;
+        return 0;
+    }
+
+    // Leaves (sorted by frequency) are nodes `0` through `n - 1`, and internal nodes follow in the order they're made.
+    // Since internal nodes are made in increasing weight order, the two smallest nodes are always at the front of one of the two runs.
+    uint64_t *order = malloc(n * sizeof(uint64_t));
+    uint64_t *weights = malloc(2 * n * sizeof(uint64_t));
+    uint32_t *parents = malloc(2 * n * sizeof(uint32_t));
+
+    if (!order || !weights || !parents)
+    {
+        perror("malloc");
+
+        free(order);
+        free(weights);
+        free(parents);
+
+        return 1;
+    }
+
+    // Frequencies fit in 40 bits, so sort (frequency, symbol) pairs as single values.
+    for (uint32_t i = 0; i < n; i++) {
+        order[i] = (freqs[i] << 24) | i;
+    }
+
+    qsort(order, n, sizeof(uint64_t), _defzip_u64_cmp);
+
+    for (uint32_t shift = 0; ; shift++)
+    {
+        for (uint32_t i = 0; i < n; i++) {
+            weights[i] = (order[i] >> (24 + shift)) | 1;
+        }
+
+        uint32_t leaf = 0;
+        uint32_t node = n;
+
+        for (uint32_t next = n; next < 2 * n - 1; next++)
+        {
+            uint32_t pick[2];
+
+            for (size_t j = 0; j < 2; j++) {
+                pick[j] = ((leaf < n && (node >= next || weights[leaf] <= weights[node])) ? leaf++ : node++);
+            }
+
+            weights[next] = weights[pick[0]] + weights[pick[1]];
+            parents[pick[0]] = parents[pick[1]] = next;
+        }
+
+        // Depths only depend on parents, which always come later. Reuse `weights` to hold them.
+        uint32_t longest = 0;
+        weights[2 * n - 2] = 0;
+
+        for (uint32_t i = 2 * n - 2; i-- > 0; )
+        {
+            weights[i] = weights[parents[i]] + 1;
+
+            if (i < n && weights[i] > longest) {
+                longest = weights[i];
+            }
+        }
+
+        if (longest > DEFZIP_MAX_CODE) { continue; }
+
+        for (uint32_t i = 0; i < n; i++) {
+            lens[order[i] & 0xFFFFFF] = weights[i];
+        }
+
+        break;
+    }
+
+    free(order);
+    free(weights);
+    free(parents);
+
+    return 0;
+}
+
+struct defzip *defzip_train(const char *const *strs, size_t n)
+{
+    // Single codepoints are counted exactly, and phrases approximately.
+    uint32_t *singles = calloc(DEFZIP_RAW_BYTE, sizeof(uint32_t));
+    struct _defzip_counter counter = { .slots = calloc(DEFZIP_COUNT_SLOTS, sizeof(struct _defzip_count)), .used = 0, .floor = 2 };
+
+    uint64_t *keys = NULL;
+    uint64_t *freqs = NULL;
+    struct _defzip_candidate *candidates = NULL;
+    struct defzip *dz = NULL;
+
+    if (!singles || !counter.slots)
+    {
+        perror("calloc");
+        goto done;
+    }
+
+    for (size_t i = 0; i < n; i++)
+    {
+        if (!strs[i]) { continue; }
+
+        const char *s = strs[i];
+        const char *end = &s[strlen(s)];
+
+        // The previous 2 codepoints, with raw bytes (which are never part of a phrase) as 0.
+        uint32_t prev[2] = { 0, 0 };
+
+        while (s < end)
+        {
+            uint32_t cp = _defzip_next(&s, end);
+
+            if (cp >= DEFZIP_RAW_BYTE) {
+                cp = 0;
+            } else {
+                singles[cp]++;
+            }
+
+            if (cp && prev[1] && _defzip_count_add(&counter, DEFZIP_KEY(prev[1], cp, 0))) { goto done; }
+            if (cp && prev[1] && prev[0] && _defzip_count_add(&counter, DEFZIP_KEY(prev[0], prev[1], cp))) { goto done; }
+
+            prev[0] = prev[1];
+            prev[1] = cp;
+        }
+    }
+
+    // Keep the phrases which save the most.
+    size_t ncandidates = 0;
+    candidates = malloc(counter.used * sizeof(struct _defzip_candidate) + 1);
+
+    if (!candidates)
+    {
+        perror("malloc");
+        goto done;
+    }
+
+    for (size_t s = 0; s < DEFZIP_COUNT_SLOTS; s++)
+    {
+        const struct _defzip_count *c = &counter.slots[s];
+        if (!c->key || c->count < DEFZIP_MIN_COUNT) { continue; }
+
+        candidates[ncandidates++] = (struct _defzip_candidate){
+            .key = c->key,
+            .score = (uint64_t)c->count * ((c->key >> 42) ? 2 : 1)
+        };
+    }
+
+    qsort(candidates, ncandidates, sizeof(struct _defzip_candidate), _defzip_candidate_cmp);
+
+    if (ncandidates > DEFZIP_MAX_PHRASES) {
+        ncandidates = DEFZIP_MAX_PHRASES;
+    }
+
+    // Symbols are the escape, every codepoint we saw, then the phrases.
+    uint32_t nsyms = 1 + ncandidates;
+
+    for (uint32_t cp = 1; cp < DEFZIP_RAW_BYTE; cp++) {
+        nsyms += !!singles[cp];
+    }
+
+    keys = malloc(nsyms * sizeof(uint64_t));
+    freqs = calloc(nsyms, sizeof(uint64_t));
+
+    if (!keys || !freqs)
+    {
+        perror("malloc");
+        goto done;
+    }
+
+    uint32_t k = 0;
+    keys[k++] = 0;
+
+    for (uint32_t cp = 1; cp < DEFZIP_RAW_BYTE; cp++) {
+        if (singles[cp]) { keys[k++] = cp; }
+    }
+
+    for (size_t c = 0; c < ncandidates; c++) {
+        keys[k++] = candidates[c].key;
+    }
+
+    // Count how often each symbol is actually used once phrases are taken greedily.
+    dz = _defzip_new(keys, nsyms);
+    if (!dz) { goto done; }
+
+    for (size_t i = 0; i < n; i++)
+    {
+        if (!strs[i]) { continue; }
+
+        _defzip_tokens(dz, strs[i], &strs[i][strlen(strs[i])], ^(uint32_t sym, uint32_t cp) {
+            freqs[sym]++;
+        });
+    }
+
+    // Drop anything which is never used (except the escape, which we always want a code for).
+    uint32_t used = 1;
+    freqs[0] += !freqs[0];
+
+    for (uint32_t s = 1; s < nsyms; s++)
+    {
+        if (!freqs[s]) { continue; }
+
+        keys[used] = keys[s];
+        freqs[used++] = freqs[s];
+    }
+
+    defzip_free(dz);
+    dz = _defzip_new(keys, used);
+
+    if (dz && (_defzip_lengths(freqs, used, dz->code_lens) || _defzip_codes(dz)))
+    {
+        defzip_free(dz);
+        dz = NULL;
+    }
+
+    if (DEBUG_DEFZIP && dz) {
+        fprintf(stderr, "Trained compression model on %zu strings (%u symbols, %zu phrases, longest code %u bits).\n", n, dz->nsyms, ncandidates, dz->max_code);
+    }
+
+done:
+    free(singles);
+    free(counter.slots);
+    free(candidates);
+    free(keys);
+    free(freqs);
+
+    return dz;
+}
+
+int defzip_encode(const struct defzip *dz, const char *str, size_t len, struct obuf *out)
+{
+    // The worst case is an escaped raw byte (up to 45 bits) for every byte, plus the length.
+    if (obuf_reserve(out, len * 6 + 16)) { return 1; }
+
+    uint8_t *data = (uint8_t *)out->data;
+    __block size_t o = out->len;
+
+    // The decoded length comes first (7 bits at a time, low bits first), so decoding knows how much to allocate.
+    size_t v = len;
+
+    do {
+        data[o++] = (v & 0x7F) | ((v > 0x7F) ? 0x80 : 0);
+        v >>= 7;
+    } while (v);
+
+    // Bits are written most significant first, and there are never more than 7 bits left over between symbols.
+    __block uint64_t acc = 0;
+    __block uint32_t nbits = 0;
+
+    _defzip_tokens(dz, str, &str[len], ^(uint32_t sym, uint32_t cp) {
+        acc = (acc << dz->code_lens[sym]) | dz->codes[sym];
+        nbits += dz->code_lens[sym];
+
+        if (sym == DEFZIP_ESCAPE)
+        {
+            acc = (acc << DEFZIP_ESCAPE_BITS) | cp;
+            nbits += DEFZIP_ESCAPE_BITS;
+        }
+
+        while (nbits >= 8)
+        {
+            nbits -= 8;
+            data[o++] = (uint8_t)(acc >> nbits);
+        }
+    });
+
+    if (nbits) {
+        data[o++] = (uint8_t)(acc << (8 - nbits));
+    }
+
+    out->len = o;
+    return 0;
+}
+
+char *defzip_decode(const struct defzip *dz, const uint8_t *data, size_t size, size_t *len)
+{
+    size_t n = 0;
+    size_t i = 0;
+
+    for (uint32_t shift = 0; ; shift += 7)
+    {
+        if (i >= size || shift > 56) { return NULL; }
+
+        n |= (size_t)(data[i] & 0x7F) << shift;
+        if (!(data[i++] & 0x80)) { break; }
+    }
+
+    // Every symbol takes at least a bit and decodes to at most a whole phrase, so don't trust a length the data can't hold.
+    if (n / (8 * DEFZIP_PHRASE_LEN * 4) > size - i) { return NULL; }
+
+    char *buf = malloc(n + 1);
+
+    if (!buf)
+    {
+        perror("malloc");
+        return NULL;
+    }
+
+    const uint8_t *p = &data[i];
+    const uint8_t *end = &data[size];
+
+    // Input bits are kept left aligned in `bits`. Past the end of the data we read zeros,
+    //   so we keep track of how many bits were real to catch truncated data.
+    uint64_t bits = 0;
+    uint32_t nbits = 0;
+    size_t avail = (size - i) * 8;
+    size_t consumed = 0;
+    size_t o = 0;
+
+    while (o < n)
+    {
+        // Every symbol (and its escaped codepoint) fits in what's left after a refill.
+        while (nbits <= 56)
+        {
+            bits |= (uint64_t)((p < end) ? *p++ : 0) << (56 - nbits);
+            nbits += 8;
+        }
+
+        uint32_t entry = dz->table[bits >> (64 - DEFZIP_TABLE_BITS)];
+        uint32_t sym = entry >> 8;
+        uint32_t clen = entry & 0xFF;
+
+        // Longer codes are found one length at a time.
+        if (!entry)
+        {
+            for (clen = DEFZIP_TABLE_BITS + 1; clen <= dz->max_code; clen++)
+            {
+                uint32_t code = bits >> (64 - clen);
+
+                if (code - dz->first_code[clen] < dz->count[clen]) {
+                    sym = dz->sorted[dz->first_index[clen] + (code - dz->first_code[clen])];
+                    break;
+                }
+            }
+
+            if (clen > dz->max_code) { goto malformed; }
+        }
+
+        bits <<= clen;
+        nbits -= clen;
+        consumed += clen;
+
+        if (sym == DEFZIP_ESCAPE)
+        {
+            uint32_t cp = bits >> (64 - DEFZIP_ESCAPE_BITS);
+
+            bits <<= DEFZIP_ESCAPE_BITS;
+            nbits -= DEFZIP_ESCAPE_BITS;
+            consumed += DEFZIP_ESCAPE_BITS;
+
+            if (cp >= DEFZIP_RAW_BYTE) {
+                buf[o++] = (char)(cp & 0xFF);
+            } else if (o + _defzip_cplen(cp) <= n) {
+                o += utf8_encode(cp, &buf[o]);
+            } else {
+                goto malformed;
+            }
+        } else {
+            if (o + dz->lens[sym] > n) { goto malformed; }
+
+            memcpy(&buf[o], &dz->pool[dz->offs[sym]], dz->lens[sym]);
+            o += dz->lens[sym];
+        }
+
+        if (consumed > avail) { goto malformed; }
+    }
+
+    buf[n] = 0;
+    (*len) = n;
+
+    return buf;
+
+malformed:
+    free(buf);
+    return NULL;
+}
+
+int defzip_save(const struct defzip *dz, struct obuf *out)
+{
+    uint8_t hdr[9];
+
+    memcpy(hdr, DEFZIP_MAGIC, 4);
+    hdr[4] = DEFZIP_VERSION;
+
+    for (size_t i = 0; i < 4; i++) {
+        hdr[5 + i] = (uint8_t)(dz->nsyms >> (8 * i));
+    }
+
+    if (obuf_append(out, hdr, sizeof(hdr))) { return 1; }
+
+    // Each symbol is its code length, then its length in bytes and the bytes themselves.
+    for (uint32_t s = 0; s < dz->nsyms; s++)
+    {
+        uint8_t lens[2] = { dz->code_lens[s], dz->lens[s] };
+
+        if (obuf_append(out, lens, 2) || obuf_append(out, &dz->pool[dz->offs[s]], dz->lens[s])) { return 1; }
+    }
+
+    return 0;
+}
+
+struct defzip *defzip_load(const uint8_t *data, size_t size)
+{
+    if (size < 9 || memcmp(data, DEFZIP_MAGIC, 4) || data[4] != DEFZIP_VERSION)
+    {
+        fprintf(stderr, "Error: Compression model has the wrong magic or version!\n");
+        return NULL;
+    }
+
+    uint32_t nsyms = data[5] | (data[6] << 8) | (data[7] << 16) | ((uint32_t)data[8] << 24);
+
+    // Every symbol takes at least 2 bytes.
+    if (!nsyms || nsyms > (size - 9) / 2)
+    {
+        fprintf(stderr, "Error: Compression model is truncated!\n");
+        return NULL;
+    }
+
+    uint64_t *keys = malloc(nsyms * sizeof(uint64_t));
+    uint8_t *code_lens = malloc(nsyms);
+
+    if (!keys || !code_lens)
+    {
+        perror("malloc");
+
+        free(keys);
+        free(code_lens);
+
+        return NULL;
+    }
+
+    size_t i = 9;
+    bool valid = true;
+
+    for (uint32_t s = 0; s < nsyms && valid; s++)
+    {
+        if (size - i < 2 || size - i - 2 < data[i + 1])
+        {
+            valid = false;
+            break;
+        }
+
+        code_lens[s] = data[i];
+
+        const char *str = (const char *)&data[i + 2];
+        const char *end = &str[data[i + 1]];
+
+        i += 2 + data[i + 1];
+
+        // Each phrase has to be 1 to 3 whole codepoints (and only the escape has none).
+        keys[s] = 0;
+
+        for (uint32_t shift = 0; str < end && valid; shift += 21)
+        {
+            uint32_t cp = _defzip_next(&str, end);
+
+            valid = (cp < DEFZIP_RAW_BYTE && shift < 21 * DEFZIP_PHRASE_LEN);
+            keys[s] |= (uint64_t)cp << shift;
+        }
+
+        valid = valid && (!keys[s] == !s);
+    }
+
+    struct defzip *dz = NULL;
+
+    if (!valid) {
+        fprintf(stderr, "Error: Compression model is malformed!\n");
+    } else if ((dz = _defzip_new(keys, nsyms))) {
+        memcpy(dz->code_lens, code_lens, nsyms);
+
+        if (_defzip_codes(dz))
+        {
+            fprintf(stderr, "Error: Compression model has invalid code lengths!\n");
+
+            defzip_free(dz);
+            dz = NULL;
+        }
+    }
+
+    free(keys);
+    free(code_lens);
+
+    return dz;
+}
+
+int defzip_sqlite_store(sqlite3 *db, const struct defzip *dz)
+{
+    struct obuf buf = OBUF_INIT;
+    sqlite3_stmt *stmt = NULL;
+
+    int failed = defzip_save(dz, &buf)
+        || sqlite_exec(db, "create table " DEFZIP_SQL_TABLE "(" DEFZIP_SQL_FIELD " blob not null) strict;", NULL)
+        || !(stmt = sqlite_prepare(db, "insert into " DEFZIP_SQL_TABLE "(" DEFZIP_SQL_FIELD ") values(?1);"))
+        || sqlite_bind_blob(stmt, 1, buf.data, buf.len)
+        || sqlite_step(stmt) != SQLITE_DONE;
+
+    sqlite3_finalize(stmt);
+    obuf_free(&buf);
+
+    return failed;
+}
+
+// SQL function decompressing a blob with the model it was registered with. Anything else is passed through.
+static void _defzip_sql_decode(sqlite3_context *ctx, int argc, sqlite3_value **argv)
+{
+    if (sqlite3_value_type(argv[0]) != SQLITE_BLOB)
+    {
+        sqlite3_result_value(ctx, argv[0]);
+        return;
+    }
+
+    size_t len;
+    char *str = defzip_decode(sqlite3_user_data(ctx), sqlite3_value_blob(argv[0]), sqlite3_value_bytes(argv[0]), &len);
+
+    if (!str)
+    {
+        sqlite3_result_error(ctx, DEFZIP_SQL_FUNC ": malformed data", -1);
+        return;
+    }
+
+    sqlite3_result_text(ctx, str, (int)len, free);
+}
+
+static void _defzip_sql_free(void *dz)
+{ defzip_free(dz); }
+
+int defzip_sqlite_attach(sqlite3 *db, bool *found)
+{
+    (*found) = false;
+
+    sqlite3_stmt *stmt = sqlite_prepare(db, "select count(*) from sqlite_master where type = 'table' and name = '" DEFZIP_SQL_TABLE "';");
+    if (!stmt) { return 1; }
+
+    bool exists = (sqlite_step(stmt) == SQLITE_ROW && sqlite3_column_int(stmt, 0));
+    sqlite3_finalize(stmt);
+
+    if (!exists) { return 0; }
+
+    if (!(stmt = sqlite_prepare(db, "select " DEFZIP_SQL_FIELD " from " DEFZIP_SQL_TABLE " limit 1;"))) { return 1; }
+
+    struct defzip *dz = NULL;
+
+    if (sqlite_step(stmt) == SQLITE_ROW) {
+        dz = defzip_load(sqlite3_column_blob(stmt, 0), sqlite3_column_bytes(stmt, 0));
+    } else {
+        fprintf(stderr, "Error: Compression model table is empty!\n");
+    }
+
+    sqlite3_finalize(stmt);
+    if (!dz) { return 1; }
+
+    // The model is freed along with the function (even if registering it fails).
+    int code = sqlite3_create_function_v2(db, DEFZIP_SQL_FUNC, 1, SQLITE_UTF8 | SQLITE_DETERMINISTIC, dz, _defzip_sql_decode, NULL, NULL, _defzip_sql_free);
+
+    if (code != SQLITE_OK)
+    {
+        _sqlerror("sqlite3_create_function_v2", code);
+        return 1;
+    }
+
+    (*found) = true;
+    return 0;
+}
+
+void defzip_free(struct defzip *dz)
+{
+    free(dz->pool);
+    free(dz->offs);
+    free(dz->lens);
+    free(dz->code_lens);
+    free(dz->codes);
+    free(dz->sorted);
+    free(dz->table);
+    free(dz->slots);
+
+    free(dz);
+}
@@ -0,0 +1,127 @@
+/* ********************************************************** */
+/* -*- dictdiff.c -*- Make and apply dictionary patches   -*- */
+/* ********************************************************** */
+/* Tyler Besselman (C) October 2026                           */
+/* ********************************************************** */
+
+// Compare two snapshots of the dictionary (workbooks, or databases from xlsx2sql) by 字詞號 and write a patch of
+//   inserts, deletes, and changed columns between them. With `-a`, apply a patch to a database in place instead.
+
+#include <strings.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+
+#include <dpatch.h>
+#include <mapfile.h>
+#include <sqldict.h>
+
+static void print_stats(const char *what, const struct dpatch_stats *stats)
+{
+    printf("%s %zu inserts, %zu deletes, and %zu updates (%zu changed fields).\n", what, stats->inserts, stats->deletes, stats->updates, stats->fields);
+}
+
+static int make_patch(const char *old_path, const char *new_path, const char *path)
+{
+    struct dsnap *old = dsnap_load(old_path);
+    struct dsnap *new = (old ? dsnap_load(new_path) : NULL);
+
+    if (!new)
+    {
+        if (old) { dsnap_free(old); }
+        return 1;
+    }
+
+    struct obuf patch = OBUF_INIT;
+    struct dpatch_stats stats;
+
+    int status = dpatch_diff(old, new, &patch, &stats);
+
+    if (!status)
+    {
+        status = mapfile_save(path, ^(FILE *fp) {
+            return (int)(fwrite(patch.data, 1, patch.len, fp) != patch.len);
+        });
+    }
+
+    if (!status)
+    {
+        print_stats("Patch has", &stats);
+        printf("Wrote %zu bytes to '%s'.\n", patch.len, path);
+    }
+
+    obuf_free(&patch);
+    dsnap_free(old);
+    dsnap_free(new);
+
+    return status;
+}
+
+static int apply_patch(const char *db_path, const char *path)
+{
+    // Opening a database which isn't there would make an empty one.
+    if (!sqldict_is_file(db_path))
+    {
+        fprintf(stderr, "Error: '%s' is not a database!\n", db_path);
+        return 1;
+    }
+
+    FILE *fp = fopen(path, "rb");
+
+    if (!fp)
+    {
+        perror("fopen");
+        return 1;
+    }
+
+    struct obuf patch = OBUF_INIT;
+    char buf[65536];
+    size_t n;
+
+    int status = 0;
+
+    while (!status && (n = fread(buf, 1, sizeof(buf), fp))) {
+        status = obuf_append(&patch, buf, n);
+    }
+
+    if (ferror(fp))
+    {
+        perror("fread");
+        status = 1;
+    }
+
+    fclose(fp);
+
+    sqlite3 *db = (status ? NULL : sqlite_open(db_path, false));
+    struct dpatch_stats stats;
+
+    status = status || !db || dpatch_apply(db, (const uint8_t *)patch.data, patch.len, &stats);
+
+    if (db) { sqlite_close(db); }
+
+    if (!status) {
+        print_stats("Applied", &stats);
+    } else if (db) {
+        fprintf(stderr, "Error: Patch was not applied (the database is unchanged).\n");
+    }
+
+    obuf_free(&patch);
+    return status;
+}
+
+int main(int argc, const char *const *argv)
+{
+    if (argc == 4 && !strcmp(argv[1], "-a")) {
+        return apply_patch(argv[2], argv[3]);
+    }
+
+    if (argc != 4)
+    {
+        fprintf(stderr, "Usage: %s old.xlsx|old.sqlite new.xlsx|new.sqlite patch.zdp\n", argv[0]);
+        fprintf(stderr, "       %s -a dict.sqlite patch.zdp\n", argv[0]);
+
+        return 1;
+    }
+
+    return make_patch(argv[1], argv[2], argv[3]);
+}
@@ -0,0 +1,841 @@
+/* ********************************************************** */
+/* -*- dindex.c -*- In-memory dictionary lookup index     -*- */
+/* ********************************************************** */
+/* Tyler Besselman (C) October 2026                           */
+/* ********************************************************** */
+
+#include <strings.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+#include <dindex.h>
+#include <utf8.h>
+
+// Mixing constants for the hash function (from wyhash/murmur).
+#define HASH_K0 0xA0761D6478BD642FULL
+#define HASH_K1 0xE7037ED1A0B428DBULL
+#define HASH_K2 0xFF51AFD7ED558CCDULL
+#define HASH_K3 0xC4CEB9FE1A85EC53ULL
+
+static inline uint64_t _hash_mix(uint64_t a, uint64_t b)
+{
+    __uint128_t r = (__uint128_t)a * b;
+    return (uint64_t)r ^ (uint64_t)(r >> 64);
+}
+
+uint64_t dindex_hash(const char *str, size_t len)
+{
+    uint64_t h = HASH_K0 ^ (len * HASH_K1);
+    uint64_t v;
+
+    // Words are mostly 3-12 bytes, so this loop runs at most once or twice.
+    while (len >= 8)
+    {
+        memcpy(&v, str, 8);
+        h = _hash_mix(h ^ v, HASH_K1);
+
+        str += 8;
+        len -= 8;
+    }
+
+    if (len)
+    {
+        v = 0;
+        memcpy(&v, str, len);
+
+        h = _hash_mix(h ^ v, HASH_K0);
+    }
+
+    // Final avalanche so the low bits (used for the table index) depend on everything.
+    h ^= h >> 33;
+    h *= HASH_K2;
+    h ^= h >> 33;
+    h *= HASH_K3;
+    h ^= h >> 33;
+
+    return h;
+}
+
+// Round up to the next power of 2.
+static uint32_t _pow2(uint32_t n)
+{
+    uint32_t p = 1;
+
+    while (p < n) {
+        p <<= 1;
+    }
+
+    return p;
+}
+
+// Key for sorting words.
+struct _dindex_key {
+    const char *str;
+    uint32_t id;
+};
+
+// Compare sort keys. `strcmp` compares bytes as unsigned, which is codepoint order for UTF-8.
+static int _dindex_key_cmp(const void *a, const void *b)
+{ return strcmp(((const struct _dindex_key *)a)->str, ((const struct _dindex_key *)b)->str); }
+
+// Probe for a word in the table, returning the slot index it occupies or the empty slot it would go in.
+// Returns `nslots` if every slot is full (only possible in a corrupt file), so probing always ends.
+static uint32_t _dindex_probe(const struct dindex *idx, uint32_t hash, const char *word, size_t len)
+{
+    uint32_t mask = idx->nslots - 1;
+    uint32_t i = hash & mask;
+
+    for (uint32_t probes = 0; idx->slots[i].word; probes++)
+    {
+        if (probes == idx->nslots) { return idx->nslots; }
+
+        const struct dindex_slot *slot = &idx->slots[i];
+
+        if (slot->hash == hash)
+        {
+            const struct dindex_word *entry = &idx->words[slot->word - 1];
+
+            if (entry->len == len && !memcmp(dindex_str(idx, entry->str), word, len)) {
+                return i;
+            }
+        }
+
+        i = (i + 1) & mask;
+    }
+
+    return i;
+}
+
+// Sort words into codepoint order, remapping the word references in `entries` and `slots`.
+static int _dindex_sort(struct dindex *idx, struct dindex_word *words, struct dindex_entry *entries, struct dindex_slot *slots)
+{
+    struct _dindex_key *keys = malloc(idx->nwords * sizeof(struct _dindex_key) + 1);
+    struct dindex_word *sorted = malloc(idx->nwords * sizeof(struct dindex_word) + 1);
+    uint32_t *map = malloc(idx->nwords * sizeof(uint32_t) + 1);
+
+    if (!keys || !sorted || !map)
+    {
+        perror("malloc");
+
+        free(keys);
+        free(sorted);
+        free(map);
+
+        return 1;
+    }
+
+    for (uint32_t i = 0; i < idx->nwords; i++) {
+        keys[i] = (struct _dindex_key){ .str = dindex_str(idx, words[i].str), .id = i };
+    }
+
+    qsort(keys, idx->nwords, sizeof(struct _dindex_key), _dindex_key_cmp);
+
+    for (uint32_t i = 0; i < idx->nwords; i++)
+    {
+        sorted[i] = words[keys[i].id];
+        map[keys[i].id] = i;
+    }
+
+    memcpy(words, sorted, idx->nwords * sizeof(struct dindex_word));
+
+    for (uint32_t i = 0; i < idx->nentries; i++) {
+        entries[i].word = map[entries[i].word];
+    }
+
+    for (uint32_t i = 0; i < idx->nslots; i++)
+    {
+        if (slots[i].word) {
+            slots[i].word = map[slots[i].word - 1] + 1;
+        }
+    }
+
+    free(keys);
+    free(sorted);
+    free(map);
+
+    return 0;
+}
+
+// Fill in stroke counts for multi-character words from the counts for their characters.
+static void _dindex_strokes(struct dindex *idx, struct dindex_word *words)
+{
+    // We need to know all single characters before we can add anything up.
+    for (uint32_t i = 0; i < idx->nwords; i++)
+    {
+        if (!words[i].strokes) {
+            words[i].strokes = DINDEX_STROKES_UNKNOWN;
+        }
+    }
+
+    for (uint32_t i = 0; i < idx->nwords; i++)
+    {
+        const char *str = dindex_str(idx, words[i].str);
+        const char *end = str + words[i].len;
+
+        // Single characters already have their own count.
+        const char *next = str;
+        utf8_next(&next);
+
+        if (next >= end) { continue; }
+
+        uint32_t strokes = 0;
+
+        while (str < end)
+        {
+            const char *chr = str;
+            utf8_next(&str);
+
+            const struct dindex_word *w = dindex_find(idx, chr, str - chr);
+            strokes += (w ? w->strokes : DINDEX_STROKES_UNKNOWN);
+        }
+
+        words[i].strokes = strokes;
+    }
+}
+
+// Fill in the children of `nodes[n]`, which has a prefix of `depth` bytes.
+// `next` is the first free node, and we return the first free node once we're done.
+static uint32_t _dindex_trie(const struct dindex *idx, struct dindex_node *nodes, uint32_t next, uint32_t n, size_t depth)
+{
+    uint32_t lo = nodes[n].lo;
+    uint32_t hi = nodes[n].hi;
+
+    // A word which is exactly this prefix sorts before anything longer.
+    if (lo < hi && idx->words[lo].len == depth) { lo++; }
+
+    nodes[n].child = next;
+    nodes[n].nchild = 0;
+
+    // Group words by the codepoint following the prefix. Each group is one child.
+    for (uint32_t i = lo; i < hi; )
+    {
+        const char *str = dindex_str(idx, idx->words[i].str) + depth;
+        const char *end = str;
+
+        uint32_t cp = utf8_next(&end);
+        size_t bytes = end - str;
+
+        uint32_t j = i + 1;
+
+        while (j < hi && !memcmp(dindex_str(idx, idx->words[j].str) + depth, str, bytes)) {
+            j++;
+        }
+
+        nodes[next++] = (struct dindex_node){
+            .cp = cp,
+            .child = 0,
+            .nchild = 0,
+            .lo = i,
+            .hi = j
+        };
+
+        nodes[n].nchild++;
+        i = j;
+    }
+
+    // Now that all children are contiguous, fill in each of their subtrees.
+    for (uint32_t c = nodes[n].child; c < nodes[n].child + nodes[n].nchild; c++)
+    {
+        const char *str = dindex_str(idx, idx->words[nodes[c].lo].str) + depth;
+        const char *end = str;
+        utf8_next(&end);
+
+        next = _dindex_trie(idx, nodes, next, c, depth + (end - str));
+    }
+
+    return next;
+}
+
+// Build the prefix trie for a sorted index.
+static int _dindex_build_trie(struct dindex *idx)
+{
+    // There can't be more nodes than codepoints in all words (plus the root).
+    size_t max = 1;
+
+    for (uint32_t i = 0; i < idx->nwords; i++) {
+        max += utf8_count(dindex_str(idx, idx->words[i].str));
+    }
+
+    struct dindex_node *nodes = malloc(max * sizeof(struct dindex_node));
+
+    if (!nodes)
+    {
+        perror("malloc");
+        return 1;
+    }
+
+    nodes[0] = (struct dindex_node){
+        .cp = 0,
+        .child = 0,
+        .nchild = 0,
+        .lo = 0,
+        .hi = idx->nwords
+    };
+
+    uint32_t nnodes = _dindex_trie(idx, nodes, 1, 0, 0);
+
+    // Give back what we didn't need (there are usually a lot fewer nodes than codepoints).
+    struct dindex_node *shrunk = realloc(nodes, nnodes * sizeof(struct dindex_node));
+
+    idx->nodes = (shrunk ? shrunk : nodes);
+    idx->nnodes = nnodes;
+
+    return 0;
+}
+
+struct dindex *dindex_build(struct xlsx *doc, size_t names, size_t defs, off_t strokes)
+{
+    if (xlsx_rows(doc) > UINT32_MAX)
+    {
+        fprintf(stderr, "Error: Document has too many rows to index!\n");
+        return NULL;
+    }
+
+    struct dindex *idx = calloc(1, sizeof(struct dindex));
+
+    if (!idx)
+    {
+        perror("calloc");
+        return NULL;
+    }
+
+    // We need an upper bound on the pool size before we start, so just count everything.
+    __block size_t pool_size = 0;
+    __block uint32_t nentries = 0;
+
+    xlsx_foreach_row(doc, ^(struct xlsx_value *row, size_t n) {
+        // Skip column headers and anything without a word.
+        if (!n || !XLSX_ISSTR(&row[names])) { return 0; }
+
+        pool_size += strlen(XLSX_STRVAL(doc, &row[names])) + 1;
+
+        if (XLSX_ISSTR(&row[defs])) {
+            pool_size += strlen(XLSX_STRVAL(doc, &row[defs])) + 1;
+        }
+
+        nentries++;
+        return 0;
+    });
+
+    if (pool_size > UINT32_MAX)
+    {
+        fprintf(stderr, "Error: Document has too much text to index!\n");
+        free(idx);
+
+        return NULL;
+    }
+
+    // We know how big everything is except the word table (which can't have more than one per entry).
+    // Keep the table at most half full so probe sequences stay short.
+    uint32_t nslots = _pow2(nentries * 2 + 1);
+
+    // The pool is padded so comparing a few bytes past the end of the last string is safe.
+    char *pool = malloc(pool_size + 4);
+    struct dindex_entry *entries = malloc(nentries * sizeof(struct dindex_entry) + 1);
+    struct dindex_word *words = malloc(nentries * sizeof(struct dindex_word) + 1);
+    uint32_t *rows = malloc(nentries * sizeof(uint32_t) + 1);
+    struct dindex_slot *slots = calloc(nslots, sizeof(struct dindex_slot));
+
+    idx->pool = pool;
+    idx->entries = entries;
+    idx->words = words;
+    idx->rows = rows;
+    idx->slots = slots;
+    idx->nslots = nslots;
+
+    if (!pool || !entries || !words || !rows || !slots)
+    {
+        perror("malloc");
+        dindex_free(idx);
+
+        return NULL;
+    }
+
+    // Fill in entries and words in a single pass. Words only get copied into the pool once.
+    __block size_t pool_off = 0;
+    __block uint32_t nwords = 0;
+    __block uint32_t i = 0;
+
+    xlsx_foreach_row(doc, ^(struct xlsx_value *row, size_t n) {
+        if (!n || !XLSX_ISSTR(&row[names])) { return 0; }
+
+        const char *word = XLSX_STRVAL(doc, &row[names]);
+        size_t len = strlen(word);
+
+        uint32_t hash = (uint32_t)dindex_hash(word, len);
+        uint32_t s = _dindex_probe(idx, hash, word, len);
+
+        if (!slots[s].word)
+        {
+            memcpy(&pool[pool_off], word, len + 1);
+
+            words[nwords] = (struct dindex_word){
+                .str = pool_off,
+                .len = len,
+                .first = 0,
+                .count = 0,
+                .strokes = 0
+            };
+
+            pool_off += len + 1;
+
+            slots[s].hash = hash;
+            slots[s].word = ++nwords;
+        }
+
+        struct dindex_word *w = &words[slots[s].word - 1];
+        w->count++;
+
+        // Stroke counts are only given for single characters.
+        if (strokes >= 0 && row[strokes].type == XLSX_TYPE_INT)
+        {
+            const char *end = word;
+            utf8_next(&end);
+
+            if (!(*end)) {
+                w->strokes = row[strokes].ival;
+            }
+        }
+
+        // Keep the word index here temporarily. We use this below to group entries by word.
+        entries[i] = (struct dindex_entry){
+            .word = slots[s].word - 1,
+            .def = DINDEX_NONE,
+            .row = n
+        };
+
+        if (XLSX_ISSTR(&row[defs]))
+        {
+            const char *def = XLSX_STRVAL(doc, &row[defs]);
+            size_t dlen = strlen(def);
+
+            memcpy(&pool[pool_off], def, dlen + 1);
+            entries[i].def = pool_off;
+
+            pool_off += dlen + 1;
+        }
+
+        // Need to set this as we go for `_dindex_probe` to see new words.
+        idx->nwords = nwords;
+
+        i++;
+        return 0;
+    });
+
+    idx->pool_size = pool_off;
+    idx->nentries = nentries;
+
+    // Prefix search needs words in order, and everything after here refers to words by their final index.
+    if (_dindex_sort(idx, words, entries, slots))
+    {
+        dindex_free(idx);
+        return NULL;
+    }
+
+    // Assign each word its range in `rows`, then fill the ranges in document order.
+    uint32_t first = 0;
+
+    for (uint32_t w = 0; w < nwords; w++)
+    {
+        words[w].first = first;
+        first += words[w].count;
+        words[w].count = 0;
+    }
+
+    for (uint32_t e = 0; e < nentries; e++)
+    {
+        struct dindex_word *w = &words[entries[e].word];
+
+        rows[w->first + w->count++] = e;
+        entries[e].word = w->str;
+    }
+
+    _dindex_strokes(idx, words);
+
+    if (_dindex_build_trie(idx))
+    {
+        dindex_free(idx);
+        return NULL;
+    }
+
+    if (DEBUG_DINDEX) {
+        fprintf(stderr, "Indexed %u entries (%u unique words, %u slots, %u trie nodes, pool=%zu bytes).\n", nentries, nwords, nslots, idx->nnodes, pool_off);
+    }
+
+    return idx;
+}
+
+const struct dindex_word *dindex_find(const struct dindex *idx, const char *word, size_t len)
+{
+    uint32_t hash = (uint32_t)dindex_hash(word, len);
+    uint32_t s = _dindex_probe(idx, hash, word, len);
+
+    return ((s < idx->nslots && idx->slots[s].word) ? &idx->words[idx->slots[s].word - 1] : NULL);
+}
+
+size_t dindex_lookup(const struct dindex *idx, const char *word, int (^blk)(const struct dindex_entry *entry))
+{
+    const struct dindex_word *w = dindex_find(idx, word, strlen(word));
+    if (!w) { return 0; }
+
+    for (uint32_t i = 0; i < w->count; i++)
+    {
+        if (blk(&idx->entries[idx->rows[w->first + i]])) {
+            return i + 1;
+        }
+    }
+
+    return w->count;
+}
+
+// Compare words for stroke order (ties are broken by codepoint order, which is index order).
+static inline bool _dindex_stroke_lt(const struct dindex *idx, uint32_t a, uint32_t b)
+{
+    uint32_t sa = idx->words[a].strokes;
+    uint32_t sb = idx->words[b].strokes;
+
+    return (sa < sb || (sa == sb && a < b));
+}
+
+// Restore the (max) heap property below `i` in a heap of `n` word indicies.
+static void _dindex_sift(const struct dindex *idx, uint32_t *heap, size_t n, size_t i)
+{
+    while (true)
+    {
+        size_t largest = i;
+        size_t l = 2 * i + 1;
+        size_t r = l + 1;
+
+        if (l < n && _dindex_stroke_lt(idx, heap[largest], heap[l])) { largest = l; }
+        if (r < n && _dindex_stroke_lt(idx, heap[largest], heap[r])) { largest = r; }
+
+        if (largest == i) { return; }
+
+        uint32_t tmp = heap[i];
+        heap[i] = heap[largest];
+        heap[largest] = tmp;
+
+        i = largest;
+    }
+}
+
+size_t dindex_prefix(const struct dindex *idx, const char *prefix, enum dindex_order order, size_t k, int (^blk)(const struct dindex_word *word))
+{
+    const struct dindex_node *node = &idx->nodes[0];
+
+    // Walk down the trie one codepoint at a time.
+    while (*prefix)
+    {
+        uint32_t cp = utf8_next(&prefix);
+
+        uint32_t lo = node->child;
+        uint32_t hi = node->child + node->nchild;
+
+        while (lo < hi)
+        {
+            uint32_t mid = lo + (hi - lo) / 2;
+
+            if (idx->nodes[mid].cp < cp) {
+                lo = mid + 1;
+            } else {
+                hi = mid;
+            }
+        }
+
+        if (lo >= node->child + node->nchild || idx->nodes[lo].cp != cp) {
+            return 0;
+        }
+
+        node = &idx->nodes[lo];
+    }
+
+    size_t total = node->hi - node->lo;
+    if (k > total) { k = total; }
+
+    // Nothing wanted, but the caller still gets the count.
+    if (!k) { return total; }
+
+    if (order == DINDEX_ORDER_LEX)
+    {
+        // Words are already in order, so this is just the start of the range.
+        for (uint32_t i = node->lo; i < node->lo + k; i++)
+        {
+            if (blk(&idx->words[i])) {
+                break;
+            }
+        }
+
+        return total;
+    }
+
+    // Otherwise, keep the best `k` words we've seen in a max heap so each candidate costs O(log k).
+    uint32_t *heap = malloc(k * sizeof(uint32_t));
+
+    if (!heap)
+    {
+        perror("malloc");
+        return 0;
+    }
+
+    size_t n = 0;
+
+    for (uint32_t i = node->lo; i < node->hi; i++)
+    {
+        if (n < k) {
+            heap[n++] = i;
+
+            // Heapify once it's full.
+            if (n == k) {
+                for (size_t j = k / 2; j-- > 0; ) {
+                    _dindex_sift(idx, heap, n, j);
+                }
+            }
+        } else if (_dindex_stroke_lt(idx, i, heap[0])) {
+            heap[0] = i;
+            _dindex_sift(idx, heap, n, 0);
+        }
+    }
+
+    // Heapify in case we never filled up, then sort in place (ascending).
+    for (size_t j = n / 2; j-- > 0; ) {
+        _dindex_sift(idx, heap, n, j);
+    }
+
+    for (size_t end = n; end > 1; end--)
+    {
+        uint32_t tmp = heap[0];
+        heap[0] = heap[end - 1];
+        heap[end - 1] = tmp;
+
+        _dindex_sift(idx, heap, end - 1, 0);
+    }
+
+    for (size_t i = 0; i < n; i++)
+    {
+        if (blk(&idx->words[heap[i]])) {
+            break;
+        }
+    }
+
+    free(heap);
+    return total;
+}
+
+int dindex_save(const struct dindex *idx, const char *path)
+{
+    struct dindex_header header;
+    mapfile_header_init(&header.file, DINDEX_MAGIC, DINDEX_VERSION, sizeof(struct dindex_header));
+
+    header.nentries = idx->nentries;
+    header.nwords = idx->nwords;
+    header.nslots = idx->nslots;
+    header.nnodes = idx->nnodes;
+
+    mapfile_section(&header.file, &header.pool,    idx->pool_size);
+    mapfile_section(&header.file, &header.entries, idx->nentries * sizeof(struct dindex_entry));
+    mapfile_section(&header.file, &header.words,   idx->nwords * sizeof(struct dindex_word));
+    mapfile_section(&header.file, &header.rows,    idx->nentries * sizeof(uint32_t));
+    mapfile_section(&header.file, &header.slots,   idx->nslots * sizeof(struct dindex_slot));
+    mapfile_section(&header.file, &header.nodes,   idx->nnodes * sizeof(struct dindex_node));
+
+    // Anyone mapping the old index never sees a partial file.
+    int failed = mapfile_save(path, ^(FILE *fp) {
+        return (fwrite(&header, sizeof(struct dindex_header), 1, fp) != 1)
+            || mapfile_write(fp, &header.pool,    idx->pool)
+            || mapfile_write(fp, &header.entries, idx->entries)
+            || mapfile_write(fp, &header.words,   idx->words)
+            || mapfile_write(fp, &header.rows,    idx->rows)
+            || mapfile_write(fp, &header.slots,   idx->slots)
+            || mapfile_write(fp, &header.nodes,   idx->nodes);
+    });
+
+    if (failed) { return 1; }
+
+    if (DEBUG_DINDEX) {
+        fprintf(stderr, "Wrote index to '%s' (%llu bytes).\n", path, (unsigned long long)header.file.size);
+    }
+
+    return 0;
+}
+
+bool dindex_is_file(const char *path)
+{ return mapfile_is(path, DINDEX_MAGIC); }
+
+// Check every reference inside a mapped index is in bounds, so nothing read through it can leave the mapping.
+// Strings only need to start inside the pool, since the pool ends with a `\0`.
+static bool _dindex_valid(const struct dindex *idx)
+{
+    for (uint32_t i = 0; i < idx->nentries; i++)
+    {
+        const struct dindex_entry *entry = &idx->entries[i];
+
+        if (entry->word >= idx->pool_size) { return false; }
+        if (entry->def != DINDEX_NONE && entry->def >= idx->pool_size) { return false; }
+        if (idx->rows[i] >= idx->nentries) { return false; }
+    }
+
+    for (uint32_t i = 0; i < idx->nwords; i++)
+    {
+        const struct dindex_word *word = &idx->words[i];
+
+        if (word->str >= idx->pool_size || word->len >= idx->pool_size - word->str) { return false; }
+        if (word->first > idx->nentries || word->count > idx->nentries - word->first) { return false; }
+    }
+
+    // Probing needs at least one empty slot to stop at.
+    bool empty = false;
+
+    for (uint32_t i = 0; i < idx->nslots; i++)
+    {
+        if (idx->slots[i].word > idx->nwords) { return false; }
+        empty = empty || !idx->slots[i].word;
+    }
+
+    for (uint32_t i = 0; i < idx->nnodes; i++)
+    {
+        const struct dindex_node *node = &idx->nodes[i];
+
+        if (node->child > idx->nnodes || node->nchild > idx->nnodes - node->child) { return false; }
+        if (node->lo > node->hi || node->hi > idx->nwords) { return false; }
+    }
+
+    return empty;
+}
+
+struct dindex *dindex_open(const char *path)
+{
+    size_t size;
+    void *map = mapfile_open(path, "index", DINDEX_MAGIC, DINDEX_VERSION, sizeof(struct dindex_header), &size);
+
+    if (!map) { return NULL; }
+
+    const struct dindex_header *header = map;
+    const char *base = map;
+
+    bool ok = (header->nslots && !(header->nslots & (header->nslots - 1)) && header->nnodes)
+        && mapfile_section_ok(&header->file, &header->pool,    header->pool.size)
+        && (header->pool.size && base[header->pool.offset + header->pool.size - 1] == 0)
+        && mapfile_section_ok(&header->file, &header->entries, (uint64_t)header->nentries * sizeof(struct dindex_entry))
+        && mapfile_section_ok(&header->file, &header->words,   (uint64_t)header->nwords * sizeof(struct dindex_word))
+        && mapfile_section_ok(&header->file, &header->rows,    (uint64_t)header->nentries * sizeof(uint32_t))
+        && mapfile_section_ok(&header->file, &header->slots,   (uint64_t)header->nslots * sizeof(struct dindex_slot))
+        && mapfile_section_ok(&header->file, &header->nodes,   (uint64_t)header->nnodes * sizeof(struct dindex_node));
+
+    if (!ok) {
+        fprintf(stderr, "Error: Index file '%s' is corrupt!\n", path);
+    }
+
+    struct dindex *idx = (ok ? calloc(1, sizeof(struct dindex)) : NULL);
+
+    if (!idx)
+    {
+        if (ok) { perror("calloc"); }
+        mapfile_close(map, size);
+
+        return NULL;
+    }
+
+    idx->pool = &base[header->pool.offset];
+    idx->pool_size = header->pool.size;
+
+    idx->entries = (const struct dindex_entry *)&base[header->entries.offset];
+    idx->nentries = header->nentries;
+
+    idx->words = (const struct dindex_word *)&base[header->words.offset];
+    idx->nwords = header->nwords;
+
+    idx->rows = (const uint32_t *)&base[header->rows.offset];
+
+    idx->slots = (const struct dindex_slot *)&base[header->slots.offset];
+    idx->nslots = header->nslots;
+
+    idx->nodes = (const struct dindex_node *)&base[header->nodes.offset];
+    idx->nnodes = header->nnodes;
+
+    idx->map = map;
+    idx->map_size = size;
+
+    if (!_dindex_valid(idx))
+    {
+        fprintf(stderr, "Error: Index file '%s' is corrupt!\n", path);
+        dindex_free(idx);
+
+        return NULL;
+    }
+
+    return idx;
+}
+
+struct dindex *dindex_load_xlsx(const char *path, bool verbose)
+{
+    struct xlsx *doc = xlsx_doc_at(path);
+    if (!doc) { return NULL; }
+
+    off_t names = -1;
+    off_t defs = -1;
+    off_t strokes = -1;
+
+    struct xlsx_value *header = xlsx_row(doc, 0);
+
+    for (size_t i = 0; i < xlsx_cols(doc); i++)
+    {
+        struct xlsx_value *val = &header[i];
+
+        if (val->type != XLSX_TYPE_STR)
+        {
+            fprintf(stderr, "Error: Column header is not a string! (type=%d)\n", val->type);
+            continue;
+        }
+
+        if (verbose) {
+            printf("%zu: '%s'\n", i, xlsx_str(doc, val));
+        }
+
+        if (!strcmp("字詞名", xlsx_str(doc, val))) {
+            names = i;
+        } else if (!strcmp("釋義", xlsx_str(doc, val))) {
+            defs = i;
+        } else if (!strcmp("總筆畫數", xlsx_str(doc, val))) {
+            strokes = i;
+        }
+    }
+
+    if ((names < 0) || (defs < 0))
+    {
+        fprintf(stderr, "Error: Missing names or definitions.\n");
+        xlsx_doc_free(doc);
+
+        return NULL;
+    }
+
+    // Build the lookup index. It holds copies of everything we need, so the document can go.
+    struct dindex *idx = dindex_build(doc, names, defs, strokes);
+    xlsx_doc_free(doc);
+
+    return idx;
+}
+
+struct dindex *dindex_load(const char *path, bool verbose)
+{
+    if (dindex_is_file(path)) {
+        return dindex_open(path);
+    } else {
+        return dindex_load_xlsx(path, verbose);
+    }
+}
+
+void dindex_free(struct dindex *idx)
+{
+    if (idx->map) {
+        mapfile_close(idx->map, idx->map_size);
+    } else {
+        free((void *)idx->pool);
+        free((void *)idx->entries);
+        free((void *)idx->words);
+        free((void *)idx->rows);
+        free((void *)idx->slots);
+        free((void *)idx->nodes);
+    }
+
+    free(idx);
+}
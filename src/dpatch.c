@@ -0,0 +1,993 @@
+/* ********************************************************** */
+/* -*- dpatch.c -*- Binary patches between dictionaries   -*- */
+/* ********************************************************** */
+/* Tyler Besselman (C) October 2026                           */
+/* ********************************************************** */
+
+#include <strings.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+
+#include <dpatch.h>
+#include <fnv.h>
+#include <sqldict.h>
+#include <xlsx.h>
+
+// Add a value to a row hash (FNV-1a, like the checksum at the end of a patch).
+// Integers are hashed as 8 little endian bytes, and strings are preceded by their length.
+static uint32_t _dpatch_hash_value(uint32_t h, uint8_t type, int64_t ival, const char *str, uint32_t len)
+{
+    uint8_t bytes[8];
+    h = fnv1a(h, &type, 1);
+
+    if (type == DPATCH_INT)
+    {
+        for (size_t i = 0; i < 8; i++) {
+            bytes[i] = ((uint64_t)ival >> (i * 8)) & 0xFF;
+        }
+
+        h = fnv1a(h, bytes, 8);
+    } else if (type == DPATCH_STR) {
+        for (size_t i = 0; i < 4; i++) {
+            bytes[i] = (len >> (i * 8)) & 0xFF;
+        }
+
+        h = fnv1a(h, bytes, 4);
+        h = fnv1a(h, str, len);
+    }
+
+    return h;
+}
+
+// Hash every value in a row except the key, in the order given by `map` (snapshot column of each patch column).
+static uint32_t _dpatch_row_hash(const struct dsnap *snap, const struct dpatch_value *row, const size_t *map, size_t ncols, size_t key)
+{
+    uint32_t h = FNV_INIT;
+
+    for (size_t c = 0; c < ncols; c++)
+    {
+        if (c == key) { continue; }
+
+        const struct dpatch_value *v = &row[map[c]];
+        h = _dpatch_hash_value(h, v->type, v->ival, (v->type == DPATCH_STR ? dsnap_str(snap, v) : NULL), v->len);
+    }
+
+    return h;
+}
+
+static int _dsnap_key_cmp(const void *a, const void *b)
+{
+    int64_t x = ((const struct dsnap_key *)a)->key;
+    int64_t y = ((const struct dsnap_key *)b)->key;
+
+    return (x > y) - (x < y);
+}
+
+// Grow an array to hold at least `n` elements. Returns non-zero on failure.
+static int _dpatch_grow(void **array, size_t *cap, size_t n, size_t size)
+{
+    if (n <= *cap) { return 0; }
+
+    size_t new_cap = ((*cap) ? (*cap) : 1024);
+
+    while (new_cap < n) {
+        new_cap *= 2;
+    }
+
+    void *new_array = realloc(*array, new_cap * size);
+
+    if (!new_array)
+    {
+        perror("realloc");
+        return 1;
+    }
+
+    (*array) = new_array;
+    (*cap) = new_cap;
+
+    return 0;
+}
+
+// Add a string value to a snapshot's pool (followed by a `\0`, so it can be printed). Returns non-zero on failure.
+static int _dsnap_str(struct dsnap *snap, struct dpatch_value *v, const char *str, size_t len)
+{
+    if (len > UINT32_MAX)
+    {
+        fprintf(stderr, "Error: String value is too long!\n");
+        return 1;
+    }
+
+    v->type = DPATCH_STR;
+    v->ival = snap->pool.len;
+    v->len = len;
+
+    return obuf_append(&snap->pool, str, len) || obuf_append(&snap->pool, "", 1);
+}
+
+// Sort rows by key once they're all loaded. Returns non-zero if any key shows up twice.
+static int _dsnap_sort(struct dsnap *snap)
+{
+    snap->order = malloc(snap->nrows * sizeof(struct dsnap_key) + 1);
+
+    if (!snap->order)
+    {
+        perror("malloc");
+        return 1;
+    }
+
+    for (size_t r = 0; r < snap->nrows; r++) {
+        snap->order[r] = (struct dsnap_key){ .key = snap->values[r * snap->ncols + snap->key].ival, .row = r };
+    }
+
+    qsort(snap->order, snap->nrows, sizeof(struct dsnap_key), _dsnap_key_cmp);
+
+    for (size_t r = 1; r < snap->nrows; r++)
+    {
+        if (snap->order[r].key == snap->order[r - 1].key)
+        {
+            fprintf(stderr, "Error: Key %s %lld shows up more than once!\n", DPATCH_KEY, (long long)snap->order[r].key);
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+// Load a workbook, naming and skipping columns the way xlsx2sql does.
+static int _dsnap_xlsx(struct dsnap *snap, const char *path)
+{
+    struct xlsx *doc = xlsx_doc_at(path);
+    if (!doc) { return 1; }
+
+    if (xlsx_rows(doc) > UINT32_MAX || !xlsx_rows(doc))
+    {
+        fprintf(stderr, "Error: Document has %s rows!\n", (xlsx_rows(doc) ? "too many" : "no"));
+        xlsx_doc_free(doc);
+
+        return 1;
+    }
+
+    struct xlsx_value *header = xlsx_row(doc, 0);
+    size_t *cols = calloc(xlsx_cols(doc) + 1, sizeof(size_t));
+
+    // Room for every column of the workbook (some may be skipped).
+    snap->cols = calloc(xlsx_cols(doc) + 1, sizeof(char *));
+
+    int failed = (!cols || !snap->cols);
+
+    if (failed) {
+        perror("calloc");
+    }
+
+    // Columns with nothing in them aren't in the table xlsx2sql makes, so we don't have them either.
+    for (size_t col = 0; col < xlsx_cols(doc) && !failed; col++)
+    {
+        bool empty = !xlsx_iter_col(doc, col, ^(struct xlsx_value *entry, size_t i) {
+            return (i && entry->type != XLSX_TYPE_NULL);
+        });
+
+        if (empty) { continue; }
+
+        if (!XLSX_ISSTR(&header[col]))
+        {
+            fprintf(stderr, "Error: Column %zu has improper header\n", col + 1);
+            failed = 1;
+
+            break;
+        }
+
+        // Names are cut off at the first space, like xlsx2sql.
+        const char *name = XLSX_STRVAL(doc, &header[col]);
+        const char *space = strchr(name, ' ');
+
+        char *copy = strndup(name, (space ? (size_t)(space - name) : strlen(name)));
+
+        if (!copy)
+        {
+            perror("strndup");
+            failed = 1;
+
+            break;
+        }
+
+        if (!strcmp(copy, DPATCH_KEY)) {
+            snap->key = snap->ncols;
+        }
+
+        cols[snap->ncols] = col;
+        snap->cols[snap->ncols++] = copy;
+    }
+
+    if (!failed && snap->key == SIZE_MAX)
+    {
+        fprintf(stderr, "Error: Document has no '%s' column!\n", DPATCH_KEY);
+        failed = 1;
+    }
+
+    snap->nrows = xlsx_rows(doc) - 1;
+    snap->values = (failed ? NULL : calloc(snap->nrows * snap->ncols + 1, sizeof(struct dpatch_value)));
+
+    if (!failed && !snap->values)
+    {
+        perror("calloc");
+        failed = 1;
+    }
+
+    for (size_t r = 0; r < snap->nrows && !failed; r++)
+    {
+        struct xlsx_value *row = xlsx_row(doc, r + 1);
+        struct dpatch_value *values = &snap->values[r * snap->ncols];
+
+        for (size_t c = 0; c < snap->ncols && !failed; c++)
+        {
+            struct xlsx_value *cell = &row[cols[c]];
+
+            if (cell->type == XLSX_TYPE_INT) {
+                values[c] = (struct dpatch_value){ .type = DPATCH_INT, .ival = cell->ival };
+            } else if (XLSX_ISSTR(cell)) {
+                const char *str = XLSX_STRVAL(doc, cell);
+                failed = _dsnap_str(snap, &values[c], str, strlen(str));
+            } else if (cell->type == XLSX_TYPE_FLOAT) {
+                fprintf(stderr, "Error: Row %zu has a floating point value in column '%s'!\n", r + 2, snap->cols[c]);
+                failed = 1;
+            }
+        }
+
+        if (!failed && values[snap->key].type != DPATCH_INT)
+        {
+            fprintf(stderr, "Error: Row %zu has no %s!\n", r + 2, DPATCH_KEY);
+            failed = 1;
+        }
+    }
+
+    free(cols);
+    xlsx_doc_free(doc);
+
+    return failed;
+}
+
+// Load a database from xlsx2sql, taking every column of the first table with a key column (except its row id).
+static int _dsnap_sqlite(struct dsnap *snap, const char *path)
+{
+    sqlite3 *db = sqlite_open(path, true);
+    if (!db) { return 1; }
+
+    sqlite3_stmt *tables = sqlite_prepare(db, "select name from sqlite_master where type = 'table' order by rowid;");
+    sqlite3_stmt *info = sqlite_prepare(db, "select name, pk from pragma_table_info(?1);");
+
+    char *table = NULL;
+    int failed = (!tables || !info);
+
+    while (!failed && !table && sqlite_step(tables) == SQLITE_ROW)
+    {
+        const char *name = (const char *)sqlite3_column_text(tables, 0);
+        if (sqlite_bind_str(info, 1, name)) { failed = 1; break; }
+
+        for (size_t c = 0; c < snap->ncols; c++) {
+            free(snap->cols[c]);
+        }
+
+        snap->ncols = 0;
+        snap->key = SIZE_MAX;
+
+        while (!failed && sqlite_step(info) == SQLITE_ROW)
+        {
+            if (sqlite3_column_int(info, 1)) { continue; }
+
+            char **cols = realloc(snap->cols, (snap->ncols + 1) * sizeof(char *));
+            char *col = strdup((const char *)sqlite3_column_text(info, 0));
+
+            if (!cols || !col)
+            {
+                perror("strdup");
+
+                if (cols) { snap->cols = cols; }
+                free(col);
+
+                failed = 1;
+                break;
+            }
+
+            if (!strcmp(col, DPATCH_KEY)) {
+                snap->key = snap->ncols;
+            }
+
+            snap->cols = cols;
+            snap->cols[snap->ncols++] = col;
+        }
+
+        sqlite3_reset(info);
+
+        if (snap->key != SIZE_MAX) {
+            table = sqlite3_mprintf("%s", name);
+        }
+    }
+
+    sqlite3_finalize(tables);
+    sqlite3_finalize(info);
+
+    if (!failed && !table)
+    {
+        fprintf(stderr, "Error: No table in '%s' has a '%s' column!\n", path, DPATCH_KEY);
+        failed = 1;
+    }
+
+    // select "a", "b", ... from "table";
+    struct obuf query = OBUF_INIT;
+
+    for (size_t c = 0; c < snap->ncols && !failed; c++)
+    {
+        char *col = sqlite3_mprintf("%s\"%w\"", (c ? ", " : "select "), snap->cols[c]);
+
+        failed = (!col || obuf_puts(&query, col));
+        sqlite3_free(col);
+    }
+
+    char *from = (failed ? NULL : sqlite3_mprintf(" from \"%w\";", table));
+    failed = failed || !from || obuf_append(&query, from, strlen(from) + 1);
+
+    sqlite3_stmt *stmt = (failed ? NULL : sqlite_prepare(db, query.data));
+    size_t cap = 0;
+
+    failed = failed || !stmt;
+
+    while (!failed && sqlite_step(stmt) == SQLITE_ROW)
+    {
+        if (snap->nrows >= UINT32_MAX || _dpatch_grow((void **)&snap->values, &cap, (snap->nrows + 1) * snap->ncols, sizeof(struct dpatch_value)))
+        {
+            failed = 1;
+            break;
+        }
+
+        struct dpatch_value *values = &snap->values[snap->nrows * snap->ncols];
+
+        for (size_t c = 0; c < snap->ncols && !failed; c++)
+        {
+            switch (sqlite3_column_type(stmt, c))
+            {
+                case SQLITE_NULL:
+                    values[c] = (struct dpatch_value){ .type = DPATCH_NULL };
+                    break;
+                case SQLITE_INTEGER:
+                    values[c] = (struct dpatch_value){ .type = DPATCH_INT, .ival = sqlite3_column_int64(stmt, c) };
+                    break;
+                case SQLITE_TEXT:
+                    failed = _dsnap_str(snap, &values[c], (const char *)sqlite3_column_text(stmt, c), sqlite3_column_bytes(stmt, c));
+                    break;
+                default:
+                    fprintf(stderr, "Error: Column '%s' of '%s' holds something other than text or integers!\n", snap->cols[c], table);
+                    failed = 1;
+            }
+        }
+
+        if (!failed && values[snap->key].type != DPATCH_INT)
+        {
+            fprintf(stderr, "Error: Row %zu of '%s' has no %s!\n", snap->nrows + 1, table, DPATCH_KEY);
+            failed = 1;
+        }
+
+        snap->nrows++;
+    }
+
+    sqlite3_finalize(stmt);
+    sqlite3_free(from);
+    sqlite3_free(table);
+    obuf_free(&query);
+    sqlite_close(db);
+
+    return failed;
+}
+
+struct dsnap *dsnap_load(const char *path)
+{
+    struct dsnap *snap = calloc(1, sizeof(struct dsnap));
+
+    if (!snap)
+    {
+        perror("calloc");
+        return NULL;
+    }
+
+    snap->pool = OBUF_INIT;
+    snap->key = SIZE_MAX;
+
+    int failed = (sqldict_is_file(path) ? _dsnap_sqlite(snap, path) : _dsnap_xlsx(snap, path));
+
+    if (failed || _dsnap_sort(snap))
+    {
+        dsnap_free(snap);
+        return NULL;
+    }
+
+    if (DEBUG_DPATCH) {
+        fprintf(stderr, "Loaded %zu rows with %zu columns from '%s'.\n", snap->nrows, snap->ncols, path);
+    }
+
+    return snap;
+}
+
+void dsnap_free(struct dsnap *snap)
+{
+    for (size_t c = 0; c < snap->ncols; c++) {
+        free(snap->cols[c]);
+    }
+
+    obuf_free(&snap->pool);
+
+    free(snap->cols);
+    free(snap->values);
+    free(snap->order);
+    free(snap);
+}
+
+// Append a variable length number (7 bits at a time, low bits first). Returns non-zero on failure.
+static int _dpatch_put_varint(struct obuf *buf, uint64_t v)
+{
+    uint8_t bytes[10];
+    size_t n = 0;
+
+    do {
+        bytes[n++] = (v & 0x7F) | ((v > 0x7F) ? 0x80 : 0);
+        v >>= 7;
+    } while (v);
+
+    return obuf_append(buf, bytes, n);
+}
+
+// Signed numbers are zigzag encoded first, so small negative numbers stay small.
+static inline uint64_t _dpatch_zigzag(int64_t v)
+{ return ((uint64_t)v << 1) ^ (uint64_t)(v >> 63); }
+
+static inline int64_t _dpatch_unzigzag(uint64_t v)
+{ return (int64_t)(v >> 1) ^ -(int64_t)(v & 1); }
+
+static int _dpatch_put_u32(struct obuf *buf, uint32_t v)
+{
+    uint8_t bytes[4] = { v & 0xFF, (v >> 8) & 0xFF, (v >> 16) & 0xFF, (v >> 24) & 0xFF };
+    return obuf_append(buf, bytes, 4);
+}
+
+static int _dpatch_put_value(struct obuf *buf, const struct dsnap *snap, const struct dpatch_value *v)
+{
+    if (obuf_append(buf, &v->type, 1)) { return 1; }
+
+    if (v->type == DPATCH_INT) {
+        return _dpatch_put_varint(buf, _dpatch_zigzag(v->ival));
+    } else if (v->type == DPATCH_STR) {
+        return _dpatch_put_varint(buf, v->len) || obuf_append(buf, dsnap_str(snap, v), v->len);
+    }
+
+    return 0;
+}
+
+static bool _dpatch_value_eq(const struct dsnap *a, const struct dpatch_value *x, const struct dsnap *b, const struct dpatch_value *y)
+{
+    if (x->type != y->type) { return false; }
+
+    if (x->type == DPATCH_INT) { return x->ival == y->ival; }
+    if (x->type == DPATCH_STR) { return x->len == y->len && !memcmp(dsnap_str(a, x), dsnap_str(b, y), x->len); }
+
+    return true;
+}
+
+int dpatch_diff(const struct dsnap *old, const struct dsnap *new, struct obuf *out, struct dpatch_stats *stats)
+{
+    // Patches use the column order of the new snapshot, so find where each column is in the old one.
+    size_t *map = calloc(new->ncols + 1, sizeof(size_t));
+
+    if (!map)
+    {
+        perror("calloc");
+        return 1;
+    }
+
+    int failed = (old->ncols != new->ncols);
+
+    for (size_t c = 0; c < new->ncols && !failed; c++)
+    {
+        failed = 1;
+
+        for (size_t o = 0; o < old->ncols && failed; o++)
+        {
+            if (!strcmp(new->cols[c], old->cols[o]))
+            {
+                map[c] = o;
+                failed = 0;
+            }
+        }
+    }
+
+    if (failed) {
+        fprintf(stderr, "Error: Snapshots have different columns (a patch can only change rows)!\n");
+    }
+
+    memset(stats, 0, sizeof(struct dpatch_stats));
+
+    // Operations go in their own buffer, since the header needs to know how many there are.
+    struct obuf ops = OBUF_INIT;
+    size_t nops = 0;
+
+    int64_t last = 0;
+    size_t i = 0;
+    size_t j = 0;
+
+    while (!failed && (i < old->nrows || j < new->nrows))
+    {
+        const struct dsnap_key *o = (i < old->nrows ? &old->order[i] : NULL);
+        const struct dsnap_key *n = (j < new->nrows ? &new->order[j] : NULL);
+
+        const struct dpatch_value *orow = (o ? &old->values[o->row * old->ncols] : NULL);
+        const struct dpatch_value *nrow = (n ? &new->values[n->row * new->ncols] : NULL);
+
+        int64_t key;
+
+        if (o && (!n || o->key < n->key))
+        {
+            // Only in the old snapshot.
+            key = o->key;
+            i++;
+
+            failed = obuf_append(&ops, &(uint8_t){ DPATCH_OP_DELETE }, 1)
+                || _dpatch_put_varint(&ops, _dpatch_zigzag(key - last))
+                || _dpatch_put_u32(&ops, _dpatch_row_hash(old, orow, map, new->ncols, new->key));
+
+            stats->deletes++;
+        } else if (!o || n->key < o->key) {
+            // Only in the new snapshot.
+            key = n->key;
+            j++;
+
+            failed = obuf_append(&ops, &(uint8_t){ DPATCH_OP_INSERT }, 1) || _dpatch_put_varint(&ops, _dpatch_zigzag(key - last));
+
+            for (size_t c = 0; c < new->ncols && !failed; c++) {
+                failed = (c != new->key && _dpatch_put_value(&ops, new, &nrow[c]));
+            }
+
+            stats->inserts++;
+        } else {
+            // In both, so only the columns which differ are written (if any do).
+            key = n->key;
+            i++;
+            j++;
+
+            size_t changed = 0;
+
+            for (size_t c = 0; c < new->ncols; c++) {
+                changed += !_dpatch_value_eq(old, &orow[map[c]], new, &nrow[c]);
+            }
+
+            if (!changed) { continue; }
+
+            failed = obuf_append(&ops, &(uint8_t){ DPATCH_OP_UPDATE }, 1)
+                || _dpatch_put_varint(&ops, _dpatch_zigzag(key - last))
+                || _dpatch_put_u32(&ops, _dpatch_row_hash(old, orow, map, new->ncols, new->key))
+                || _dpatch_put_varint(&ops, changed);
+
+            for (size_t c = 0; c < new->ncols && !failed; c++)
+            {
+                if (_dpatch_value_eq(old, &orow[map[c]], new, &nrow[c])) { continue; }
+                failed = _dpatch_put_varint(&ops, c) || _dpatch_put_value(&ops, new, &nrow[c]);
+            }
+
+            stats->updates++;
+            stats->fields += changed;
+        }
+
+        last = key;
+        nops++;
+    }
+
+    // Header: magic, version, columns (by name), key column, and the number of operations.
+    size_t start = out->len;
+    failed = failed || obuf_append(out, DPATCH_MAGIC, strlen(DPATCH_MAGIC)) || _dpatch_put_varint(out, DPATCH_VERSION) || _dpatch_put_varint(out, new->ncols);
+
+    for (size_t c = 0; c < new->ncols && !failed; c++) {
+        failed = _dpatch_put_varint(out, strlen(new->cols[c])) || obuf_puts(out, new->cols[c]);
+    }
+
+    failed = failed || _dpatch_put_varint(out, new->key) || _dpatch_put_varint(out, nops) || obuf_append(out, ops.data, ops.len);
+
+    // Checksum of everything before it, so a truncated or damaged download is caught before anything changes.
+    failed = failed || _dpatch_put_u32(out, fnv1a(FNV_INIT, &out->data[start], out->len - start));
+
+    obuf_free(&ops);
+    free(map);
+    return failed;
+}
+
+// Patch reader. Any read past the end marks it failed (and reads zeros from then on).
+struct _dpatch_reader {
+    const uint8_t *p;
+    const uint8_t *end;
+    bool failed;
+};
+
+static uint64_t _dpatch_varint(struct _dpatch_reader *r)
+{
+    uint64_t v = 0;
+
+    for (uint32_t shift = 0; r->p < r->end && shift < 64; shift += 7)
+    {
+        uint8_t b = *r->p++;
+        v |= (uint64_t)(b & 0x7F) << shift;
+
+        if (!(b & 0x80)) { return v; }
+    }
+
+    r->failed = true;
+    return 0;
+}
+
+static const uint8_t *_dpatch_bytes(struct _dpatch_reader *r, uint64_t n)
+{
+    if (r->failed || (uint64_t)(r->end - r->p) < n)
+    {
+        r->failed = true;
+        return NULL;
+    }
+
+    const uint8_t *p = r->p;
+    r->p += n;
+
+    return p;
+}
+
+static uint32_t _dpatch_u32(struct _dpatch_reader *r)
+{
+    const uint8_t *p = _dpatch_bytes(r, 4);
+    return (p ? (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24) : 0);
+}
+
+// Read a value from a patch and bind it to parameter `loc` of `stmt`. Returns non-zero on failure.
+static int _dpatch_bind_value(struct _dpatch_reader *r, sqlite3_stmt *stmt, int loc)
+{
+    const uint8_t *type = _dpatch_bytes(r, 1);
+    if (!type) { return 1; }
+
+    if ((*type) == DPATCH_INT)
+    {
+        int64_t v = _dpatch_unzigzag(_dpatch_varint(r));
+        return r->failed || sqlite_bind_int64(stmt, loc, v);
+    } else if ((*type) == DPATCH_STR) {
+        uint64_t len = _dpatch_varint(r);
+        const uint8_t *str = _dpatch_bytes(r, len);
+
+        return !str || sqlite_bind_strn(stmt, loc, (const char *)str, len);
+    } else if ((*type) == DPATCH_NULL) {
+        return sqlite_bind_null(stmt, loc);
+    }
+
+    r->failed = true;
+    return 1;
+}
+
+// Statements used to apply a patch to a table.
+struct _dpatch_stmts {
+    sqlite3_stmt *select;
+    sqlite3_stmt *delete;
+    sqlite3_stmt *insert;
+
+    // One per column, setting only that column.
+    sqlite3_stmt **update;
+    size_t ncols;
+};
+
+static void _dpatch_stmts_free(struct _dpatch_stmts *s)
+{
+    sqlite3_finalize(s->select);
+    sqlite3_finalize(s->delete);
+    sqlite3_finalize(s->insert);
+
+    for (size_t c = 0; c < s->ncols && s->update; c++) {
+        sqlite3_finalize(s->update[c]);
+    }
+
+    free(s->update);
+}
+
+// Find the first table with every column of a patch, and prepare our statements on it. Returns non-zero on failure.
+static int _dpatch_prepare(sqlite3 *db, char *const *cols, size_t ncols, size_t key, struct _dpatch_stmts *s)
+{
+    sqlite3_stmt *tables = sqlite_prepare(db, "select name from sqlite_master where type = 'table' order by rowid;");
+    sqlite3_stmt *info = sqlite_prepare(db, "select count(*) from pragma_table_info(?1) where name = ?2;");
+
+    char *table = NULL;
+    int failed = (!tables || !info);
+
+    while (!failed && !table && sqlite_step(tables) == SQLITE_ROW)
+    {
+        const char *name = (const char *)sqlite3_column_text(tables, 0);
+        bool found = true;
+
+        for (size_t c = 0; c < ncols && found && !failed; c++)
+        {
+            failed = sqlite_bind_str(info, 1, name) || sqlite_bind_str(info, 2, cols[c]) || sqlite_step(info) != SQLITE_ROW;
+            found = (!failed && sqlite3_column_int(info, 0));
+
+            sqlite3_reset(info);
+        }
+
+        if (found && !failed) {
+            table = sqlite3_mprintf("%s", name);
+        }
+    }
+
+    sqlite3_finalize(tables);
+    sqlite3_finalize(info);
+
+    if (!failed && !table)
+    {
+        fprintf(stderr, "Error: No table has every column the patch changes!\n");
+        failed = 1;
+    }
+
+    // select "a", "b", ... from "table" where "key" = ?1;
+    // insert into "table" ("a", "b", ...) values (?1, ?2, ...);
+    // Patches don't carry sheet rows (every row after an insert or delete would move), so inserted rows get a new `id`.
+    struct obuf select = OBUF_INIT;
+    struct obuf insert = OBUF_INIT;
+
+    s->ncols = ncols;
+    s->update = calloc(ncols + 1, sizeof(sqlite3_stmt *));
+
+    if (!failed && !s->update)
+    {
+        perror("calloc");
+        failed = 1;
+    }
+
+    for (size_t c = 0; c < ncols && !failed; c++)
+    {
+        char *sel = sqlite3_mprintf("%s\"%w\"", (c ? ", " : "select "), cols[c]);
+        char *ins = sqlite3_mprintf("%s\"%w\"", (c ? ", " : ""), cols[c]);
+        char *upd = sqlite3_mprintf("update \"%w\" set \"%w\" = ?1 where \"%w\" = ?2;", table, cols[c], cols[key]);
+
+        failed = (!sel || !ins || !upd || obuf_puts(&select, sel) || obuf_puts(&insert, ins));
+
+        if (!failed && c != key) {
+            failed = !(s->update[c] = sqlite_prepare(db, upd));
+        }
+
+        sqlite3_free(sel);
+        sqlite3_free(ins);
+        sqlite3_free(upd);
+    }
+
+    failed = failed || obuf_append(&insert, "", 1);
+
+    if (!failed)
+    {
+        char *sel = sqlite3_mprintf(" from \"%w\" where \"%w\" = ?1;", table, cols[key]);
+        char *ins = sqlite3_mprintf("insert into \"%w\" (%s) values (?1", table, insert.data);
+        char *del = sqlite3_mprintf("delete from \"%w\" where \"%w\" = ?1;", table, cols[key]);
+
+        // Every row we touch is found by key, so make sure that's indexed (xlsx2sql does this already).
+        char *idx = sqlite3_mprintf("create index if not exists \"%w_%w\" on \"%w\"(\"%w\");", table, cols[key], table, cols[key]);
+
+        struct obuf values = OBUF_INIT;
+        failed = (!sel || !ins || !del || !idx || obuf_puts(&select, sel) || obuf_puts(&values, ins));
+
+        for (size_t c = 1; c < ncols && !failed; c++) {
+            failed = obuf_printf(&values, ", ?%zu", c + 1);
+        }
+
+        failed = failed || obuf_append(&values, ");", 3) || obuf_append(&select, "", 1) || sqlite_exec(db, idx, NULL);
+
+        failed = failed || !(s->select = sqlite_prepare(db, select.data))
+                        || !(s->insert = sqlite_prepare(db, values.data))
+                        || !(s->delete = sqlite_prepare(db, del));
+
+        sqlite3_free(sel);
+        sqlite3_free(ins);
+        sqlite3_free(del);
+        sqlite3_free(idx);
+        obuf_free(&values);
+    }
+
+    sqlite3_free(table);
+    obuf_free(&select);
+    obuf_free(&insert);
+
+    return failed;
+}
+
+// Look up the row with a key, checking it's there (or not) as expected, and that its contents hash to `hash`.
+// Returns non-zero if it isn't what the patch was made from.
+static int _dpatch_check(struct _dpatch_stmts *s, size_t key, int64_t k, bool exists, uint32_t hash)
+{
+    int status = (sqlite_bind_int64(s->select, 1, k) ? SQLITE_ERROR : sqlite_step(s->select));
+    int failed = (status != SQLITE_ROW && status != SQLITE_DONE);
+
+    if (!failed && (status == SQLITE_ROW) != exists)
+    {
+        fprintf(stderr, "Error: Entry %s %lld is %s!\n", DPATCH_KEY, (long long)k, (exists ? "missing" : "already there"));
+        failed = 1;
+    }
+
+    if (!failed && exists)
+    {
+        uint32_t h = FNV_INIT;
+
+        for (size_t c = 0; c < s->ncols && !failed; c++)
+        {
+            if (c == key) { continue; }
+
+            switch (sqlite3_column_type(s->select, c))
+            {
+                case SQLITE_NULL:
+                    h = _dpatch_hash_value(h, DPATCH_NULL, 0, NULL, 0);
+                    break;
+                case SQLITE_INTEGER:
+                    h = _dpatch_hash_value(h, DPATCH_INT, sqlite3_column_int64(s->select, c), NULL, 0);
+                    break;
+                case SQLITE_TEXT:
+                    h = _dpatch_hash_value(h, DPATCH_STR, 0, (const char *)sqlite3_column_text(s->select, c), sqlite3_column_bytes(s->select, c));
+                    break;
+                default:
+                    failed = 1;
+            }
+        }
+
+        if (failed || h != hash)
+        {
+            fprintf(stderr, "Error: Entry %s %lld isn't what the patch was made from!\n", DPATCH_KEY, (long long)k);
+            failed = 1;
+        }
+    }
+
+    sqlite3_reset(s->select);
+    return failed;
+}
+
+// Run a statement which returns no rows, then reset it. Returns non-zero on failure.
+static int _dpatch_exec(sqlite3_stmt *stmt)
+{
+    int status = sqlite_step(stmt);
+
+    sqlite3_reset(stmt);
+    sqlite3_clear_bindings(stmt);
+
+    return (status != SQLITE_DONE);
+}
+
+int dpatch_apply(sqlite3 *db, const uint8_t *patch, size_t size, struct dpatch_stats *stats)
+{
+    size_t mlen = strlen(DPATCH_MAGIC);
+    memset(stats, 0, sizeof(struct dpatch_stats));
+
+    if (size < mlen + 4 || memcmp(patch, DPATCH_MAGIC, mlen))
+    {
+        fprintf(stderr, "Error: Not a dictionary patch!\n");
+        return 1;
+    }
+
+    struct _dpatch_reader body = { .p = &patch[size - 4], .end = &patch[size], .failed = false };
+
+    if (_dpatch_u32(&body) != fnv1a(FNV_INIT, patch, size - 4))
+    {
+        fprintf(stderr, "Error: Patch is damaged (bad checksum)!\n");
+        return 1;
+    }
+
+    struct _dpatch_reader r = { .p = &patch[mlen], .end = &patch[size - 4], .failed = false };
+    uint64_t version = _dpatch_varint(&r);
+
+    if (r.failed || version != DPATCH_VERSION)
+    {
+        fprintf(stderr, "Error: Patch has unknown version %llu (expected %d)!\n", (unsigned long long)version, DPATCH_VERSION);
+        return 1;
+    }
+
+    uint64_t ncols = _dpatch_varint(&r);
+    char **cols = (ncols && ncols < 4096 ? calloc(ncols, sizeof(char *)) : NULL);
+
+    int failed = !cols;
+
+    for (size_t c = 0; c < ncols && !failed; c++)
+    {
+        uint64_t len = _dpatch_varint(&r);
+        const uint8_t *name = _dpatch_bytes(&r, len);
+
+        failed = (!name || !(cols[c] = strndup((const char *)name, len)));
+    }
+
+    uint64_t key = _dpatch_varint(&r);
+    uint64_t nops = _dpatch_varint(&r);
+
+    if (failed || r.failed || key >= ncols)
+    {
+        fprintf(stderr, "Error: Patch header is malformed!\n");
+        failed = 1;
+    }
+
+    // Everything happens in one transaction, so either the whole patch applies or none of it does.
+    struct _dpatch_stmts s = { 0 };
+    bool began = false;
+
+    if (!failed) {
+        failed = sqlite_exec(db, "begin immediate;", NULL);
+        began = !failed;
+    }
+
+    failed = failed || _dpatch_prepare(db, cols, ncols, key, &s);
+
+    int64_t k = 0;
+
+    for (uint64_t i = 0; i < nops && !failed; i++)
+    {
+        const uint8_t *op = _dpatch_bytes(&r, 1);
+        k += _dpatch_unzigzag(_dpatch_varint(&r));
+
+        if (!op || r.failed)
+        {
+            failed = 1;
+            break;
+        }
+
+        if ((*op) == DPATCH_OP_DELETE) {
+            uint32_t hash = _dpatch_u32(&r);
+
+            failed = r.failed || _dpatch_check(&s, key, k, true, hash)
+                || sqlite_bind_int64(s.delete, 1, k) || _dpatch_exec(s.delete);
+
+            stats->deletes++;
+        } else if ((*op) == DPATCH_OP_INSERT) {
+            failed = _dpatch_check(&s, key, k, false, 0) || sqlite_bind_int64(s.insert, key + 1, k);
+
+            for (size_t c = 0; c < ncols && !failed; c++) {
+                failed = (c != key && _dpatch_bind_value(&r, s.insert, c + 1));
+            }
+
+            failed = failed || _dpatch_exec(s.insert);
+            stats->inserts++;
+        } else if ((*op) == DPATCH_OP_UPDATE) {
+            uint32_t hash = _dpatch_u32(&r);
+            uint64_t changed = _dpatch_varint(&r);
+
+            failed = r.failed || _dpatch_check(&s, key, k, true, hash);
+
+            for (uint64_t j = 0; j < changed && !failed; j++)
+            {
+                uint64_t c = _dpatch_varint(&r);
+
+                if (r.failed || c >= ncols || c == key)
+                {
+                    failed = 1;
+                    break;
+                }
+
+                failed = _dpatch_bind_value(&r, s.update[c], 1) || sqlite_bind_int64(s.update[c], 2, k) || _dpatch_exec(s.update[c]);
+            }
+
+            stats->updates++;
+            stats->fields += changed;
+        } else {
+            fprintf(stderr, "Error: Patch has unknown operation '%c'!\n", *op);
+            failed = 1;
+        }
+    }
+
+    if (!failed && r.p != r.end)
+    {
+        fprintf(stderr, "Error: Patch has trailing data!\n");
+        failed = 1;
+    }
+
+    if (r.failed) {
+        fprintf(stderr, "Error: Patch is malformed!\n");
+    }
+
+    _dpatch_stmts_free(&s);
+
+    if (began) {
+        failed = sqlite_exec(db, (failed ? "rollback;" : "commit;"), NULL) || failed;
+    }
+
+    for (size_t c = 0; c < ncols && cols; c++) {
+        free(cols[c]);
+    }
+
+    free(cols);
+    return failed;
+}
@@ -0,0 +1,65 @@
+/* ********************************************************** */
+/* -*- epoch.c -*- Epoch based reclamation for readers    -*- */
+/* ********************************************************** */
+/* Tyler Besselman (C) October 2026                           */
+/* ********************************************************** */
+
+#include <string.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <time.h>
+
+#include <epoch.h>
+
+// How long a writer sleeps between checks on readers it's waiting for (in nanoseconds).
+#define EPOCH_POLL_NS 100000
+
+int epoch_init(struct epoch *e, size_t nreaders)
+{
+    void *readers;
+
+    if ((errno = posix_memalign(&readers, EPOCH_LINE, (nreaders ? nreaders : 1) * sizeof(struct epoch_reader))))
+    {
+        perror("posix_memalign");
+        return 1;
+    }
+
+    memset(readers, 0, (nreaders ? nreaders : 1) * sizeof(struct epoch_reader));
+
+    atomic_init(&e->now, 1);
+    e->readers = readers;
+    e->nreaders = nreaders;
+
+    return 0;
+}
+
+void epoch_synchronize(struct epoch *e)
+{
+    // Whatever the caller swapped out is only visible to readers which entered before the epoch moves on.
+    atomic_thread_fence(memory_order_seq_cst);
+    uint64_t next = atomic_fetch_add(&e->now, 1) + 1;
+
+    for (size_t i = 0; i < e->nreaders; i++)
+    {
+        uint64_t seen;
+
+        // Readers which have left or entered since are fine, and each reader leaves soon (a single request).
+        while ((seen = atomic_load(&e->readers[i].epoch)) && seen < next)
+        {
+            struct timespec ts = { .tv_sec = 0, .tv_nsec = EPOCH_POLL_NS };
+            nanosleep(&ts, NULL);
+        }
+    }
+
+    // Readers may have been done with the old data just now, so the caller's frees must come after this.
+    atomic_thread_fence(memory_order_seq_cst);
+}
+
+void epoch_free(struct epoch *e)
+{
+    free(e->readers);
+
+    e->readers = NULL;
+    e->nreaders = 0;
+}
@@ -0,0 +1,164 @@
+/* ********************************************************** */
+/* -*- escape.c -*- Escaping text fields for CSV/TSV/JSON -*- */
+/* ********************************************************** */
+/* Tyler Besselman (C) October 2026                           */
+/* ********************************************************** */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <escape.h>
+
+// A word with every byte set to `b`.
+#define _ESCAPE_BYTES(b) (0x0101010101010101ULL * (uint8_t)(b))
+
+// Flag (set the top bit of) bytes in a word which are below `n` (at most 0x80).
+// Borrows can flag extra bytes above a real one, but the lowest flag is always real, and nothing is flagged if no byte is below `n`.
+static inline uint64_t _escape_below(uint64_t x, uint8_t n)
+{ return (x - _ESCAPE_BYTES(n)) & ~x & _ESCAPE_BYTES(0x80); }
+
+// Flag bytes in a word equal to `c` (with the same caveat).
+static inline uint64_t _escape_eq(uint64_t x, uint8_t c)
+{ return _escape_below(x ^ _ESCAPE_BYTES(c), 1); }
+
+// Check whether a single byte needs escaping in a format.
+static inline bool _escape_special(enum escape_format fmt, uint8_t c)
+{
+    switch (fmt)
+    {
+        case ESCAPE_CSV:  return (c == ',' || c == '"' || c == '\n' || c == '\r');
+        case ESCAPE_TSV:  return (c == '\t' || c == '\n' || c == '\r' || c == '\\');
+        case ESCAPE_JSON: return (c < 0x20 || c == '"' || c == '\\');
+    }
+
+    return true;
+}
+
+// Flag bytes in a word which might need escaping. Control characters are checked coarsely, so a flag only means "look closer".
+static inline uint64_t _escape_flags(enum escape_format fmt, uint64_t x)
+{
+    switch (fmt)
+    {
+        case ESCAPE_CSV:  return _escape_eq(x, ',') | _escape_eq(x, '"') | _escape_below(x, '\r' + 1);
+        case ESCAPE_TSV:  return _escape_eq(x, '\\') | _escape_below(x, '\r' + 1);
+        case ESCAPE_JSON: return _escape_eq(x, '"') | _escape_eq(x, '\\') | _escape_below(x, 0x20);
+    }
+
+    return ~0ULL;
+}
+
+size_t escape_span(enum escape_format fmt, const char *str, size_t len)
+{
+    size_t i = 0;
+
+    for (; i + 8 <= len; i += 8)
+    {
+        uint64_t word;
+        memcpy(&word, &str[i], 8);
+
+        uint64_t flags = _escape_flags(fmt, word);
+        if (!flags) { continue; }
+
+        // The lowest flag is the first byte worth a look on little endian machines. Otherwise, check the whole word.
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+        size_t j = i + (__builtin_ctzll(flags) >> 3);
+#else
+        size_t j = i;
+#endif
+
+        for (; j < i + 8; j++)
+        {
+            if (_escape_special(fmt, str[j])) {
+                return j;
+            }
+        }
+    }
+
+    for (; i < len; i++)
+    {
+        if (_escape_special(fmt, str[i])) {
+            return i;
+        }
+    }
+
+    return len;
+}
+
+// Quote a CSV field, doubling any quotes inside.
+static int _escape_csv(struct obuf *out, const char *str, size_t len)
+{
+    const char *end = str + len;
+    const char *quote;
+
+    if (obuf_append(out, "\"", 1)) { return 1; }
+
+    for (; (quote = memchr(str, '"', end - str)); str = quote + 1)
+    {
+        // This writes the quote, then one more.
+        if (obuf_append(out, str, quote + 1 - str) || obuf_append(out, "\"", 1)) {
+            return 1;
+        }
+    }
+
+    return (obuf_append(out, str, end - str) || obuf_append(out, "\"", 1));
+}
+
+int escape_field(struct obuf *out, enum escape_format fmt, const char *str, size_t len)
+{
+    static const char hex[] = "0123456789abcdef";
+
+    // Most fields grow by at most their quotes.
+    if (obuf_reserve(out, len + 2)) { return 1; }
+
+    size_t run = escape_span(fmt, str, len);
+
+    if (fmt == ESCAPE_CSV) {
+        return (run == len ? obuf_append(out, str, len) : _escape_csv(out, str, len));
+    }
+
+    if (fmt == ESCAPE_JSON) {
+        out->data[out->len++] = '"';
+    }
+
+    while (true)
+    {
+        if (obuf_append(out, str, run)) { return 1; }
+
+        str += run;
+        len -= run;
+
+        if (!len) { break; }
+
+        unsigned char c = *str;
+        char esc[6] = { '\\' };
+        size_t n = 2;
+
+        switch (c)
+        {
+            case '"':  esc[1] = '"';  break;
+            case '\\': esc[1] = '\\'; break;
+            case '\n': esc[1] = 'n';  break;
+            case '\r': esc[1] = 'r';  break;
+            case '\t': esc[1] = 't';  break;
+            default:
+                // Only JSON escapes other control characters.
+                esc[1] = 'u';
+                esc[2] = '0';
+                esc[3] = '0';
+                esc[4] = hex[c >> 4];
+                esc[5] = hex[c & 0xF];
+                n = 6;
+                break;
+        }
+
+        if (obuf_append(out, esc, n)) { return 1; }
+
+        str++;
+        len--;
+
+        run = escape_span(fmt, str, len);
+    }
+
+    return (fmt == ESCAPE_JSON ? obuf_append(out, "\"", 1) : 0);
+}
@@ -0,0 +1,288 @@
+/* ********************************************************** */
+/* -*- evloop.c -*- Readiness based event loop            -*- */
+/* ********************************************************** */
+/* Tyler Besselman (C) October 2026                           */
+/* ********************************************************** */
+
+#include <strings.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <errno.h>
+#include <stdio.h>
+
+#include <evloop.h>
+
+#if EVLOOP_USE_EPOLL
+
+#include <sys/epoll.h>
+
+struct evloop {
+    int epfd;
+
+    // Kernel side events from the last wait.
+    struct epoll_event *ready;
+    int nready;
+};
+
+struct evloop *evloop_create(void)
+{
+    struct evloop *loop = calloc(1, sizeof(struct evloop));
+
+    if (!loop)
+    {
+        perror("calloc");
+        return NULL;
+    }
+
+    if ((loop->epfd = epoll_create1(EPOLL_CLOEXEC)) < 0)
+    {
+        perror("epoll_create1");
+        free(loop);
+
+        return NULL;
+    }
+
+    return loop;
+}
+
+static int _evloop_ctl(struct evloop *loop, int op, int fd, unsigned int events, void *data)
+{
+    struct epoll_event ev = { .events = 0, .data.ptr = data };
+
+    if (events & EVLOOP_READ)  { ev.events |= EPOLLIN | EPOLLRDHUP; }
+    if (events & EVLOOP_WRITE) { ev.events |= EPOLLOUT; }
+
+    if (epoll_ctl(loop->epfd, op, fd, &ev))
+    {
+        perror("epoll_ctl");
+        return 1;
+    }
+
+    return 0;
+}
+
+int evloop_add(struct evloop *loop, int fd, unsigned int events, void *data)
+{ return _evloop_ctl(loop, EPOLL_CTL_ADD, fd, events, data); }
+
+int evloop_mod(struct evloop *loop, int fd, unsigned int events, void *data)
+{ return _evloop_ctl(loop, EPOLL_CTL_MOD, fd, events, data); }
+
+int evloop_del(struct evloop *loop, int fd)
+{
+    if (epoll_ctl(loop->epfd, EPOLL_CTL_DEL, fd, NULL))
+    {
+        perror("epoll_ctl");
+        return 1;
+    }
+
+    return 0;
+}
+
+int evloop_wait(struct evloop *loop, struct evloop_event *events, int max, int timeout)
+{
+    if (max > loop->nready)
+    {
+        struct epoll_event *ready = realloc(loop->ready, max * sizeof(struct epoll_event));
+
+        if (!ready)
+        {
+            perror("realloc");
+            return -1;
+        }
+
+        loop->ready = ready;
+        loop->nready = max;
+    }
+
+    int n = epoll_wait(loop->epfd, loop->ready, max, timeout);
+
+    if (n < 0)
+    {
+        // Treat being interrupted by a signal as a timeout.
+        if (errno == EINTR) { return 0; }
+
+        perror("epoll_wait");
+        return -1;
+    }
+
+    for (int i = 0; i < n; i++)
+    {
+        uint32_t ev = loop->ready[i].events;
+
+        events[i].data = loop->ready[i].data.ptr;
+        events[i].events = 0;
+
+        if (ev & EPOLLIN)  { events[i].events |= EVLOOP_READ; }
+        if (ev & EPOLLOUT) { events[i].events |= EVLOOP_WRITE; }
+        if (ev & (EPOLLHUP | EPOLLRDHUP | EPOLLERR)) { events[i].events |= EVLOOP_READ | EVLOOP_HUP; }
+    }
+
+    return n;
+}
+
+void evloop_free(struct evloop *loop)
+{
+    close(loop->epfd);
+    free(loop->ready);
+    free(loop);
+}
+
+#else /* !EVLOOP_USE_EPOLL */
+
+#include <poll.h>
+
+// Without epoll we keep the whole set here and hand it to poll each time.
+struct evloop {
+    struct pollfd *fds;
+    void **data;
+
+    size_t count;
+    size_t cap;
+
+    // Where to start scanning on the next wait, so no descriptor gets starved.
+    size_t next;
+};
+
+struct evloop *evloop_create(void)
+{
+    struct evloop *loop = calloc(1, sizeof(struct evloop));
+
+    if (!loop) {
+        perror("calloc");
+    }
+
+    return loop;
+}
+
+static short _evloop_events(unsigned int events)
+{
+    short ev = 0;
+
+    if (events & EVLOOP_READ)  { ev |= POLLIN; }
+    if (events & EVLOOP_WRITE) { ev |= POLLOUT; }
+
+    return ev;
+}
+
+static ssize_t _evloop_find(struct evloop *loop, int fd)
+{
+    for (size_t i = 0; i < loop->count; i++)
+    {
+        if (loop->fds[i].fd == fd) {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+int evloop_add(struct evloop *loop, int fd, unsigned int events, void *data)
+{
+    if (loop->count == loop->cap)
+    {
+        size_t cap = (loop->cap ? loop->cap * 2 : 16);
+
+        struct pollfd *fds = realloc(loop->fds, cap * sizeof(struct pollfd));
+        if (fds) { loop->fds = fds; }
+
+        void **ptrs = realloc(loop->data, cap * sizeof(void *));
+        if (ptrs) { loop->data = ptrs; }
+
+        if (!fds || !ptrs)
+        {
+            perror("realloc");
+            return 1;
+        }
+
+        loop->cap = cap;
+    }
+
+    loop->fds[loop->count] = (struct pollfd){ .fd = fd, .events = _evloop_events(events), .revents = 0 };
+    loop->data[loop->count] = data;
+    loop->count++;
+
+    return 0;
+}
+
+int evloop_mod(struct evloop *loop, int fd, unsigned int events, void *data)
+{
+    ssize_t i = _evloop_find(loop, fd);
+
+    if (i < 0)
+    {
+        fprintf(stderr, "Error: File descriptor %d is not in event loop!\n", fd);
+        return 1;
+    }
+
+    loop->fds[i].events = _evloop_events(events);
+    loop->data[i] = data;
+
+    return 0;
+}
+
+int evloop_del(struct evloop *loop, int fd)
+{
+    ssize_t i = _evloop_find(loop, fd);
+
+    if (i < 0)
+    {
+        fprintf(stderr, "Error: File descriptor %d is not in event loop!\n", fd);
+        return 1;
+    }
+
+    // Order doesn't matter, so just move the last one into this slot.
+    loop->count--;
+    loop->fds[i] = loop->fds[loop->count];
+    loop->data[i] = loop->data[loop->count];
+
+    return 0;
+}
+
+int evloop_wait(struct evloop *loop, struct evloop_event *events, int max, int timeout)
+{
+    int n = poll(loop->fds, loop->count, timeout);
+
+    if (n < 0)
+    {
+        if (errno == EINTR) { return 0; }
+
+        perror("poll");
+        return -1;
+    }
+
+    int found = 0;
+
+    if (loop->next >= loop->count) {
+        loop->next = 0;
+    }
+
+    for (size_t j = 0; j < loop->count && found < n && found < max; j++)
+    {
+        size_t i = (loop->next + j) % loop->count;
+        short ev = loop->fds[i].revents;
+
+        if (!ev) { continue; }
+
+        events[found].data = loop->data[i];
+        events[found].events = 0;
+
+        if (ev & POLLIN)  { events[found].events |= EVLOOP_READ; }
+        if (ev & POLLOUT) { events[found].events |= EVLOOP_WRITE; }
+        if (ev & (POLLHUP | POLLERR | POLLNVAL)) { events[found].events |= EVLOOP_READ | EVLOOP_HUP; }
+
+        loop->fds[i].revents = 0;
+        found++;
+    }
+
+    loop->next++;
+    return found;
+}
+
+void evloop_free(struct evloop *loop)
+{
+    free(loop->fds);
+    free(loop->data);
+    free(loop);
+}
+
+#endif /* !EVLOOP_USE_EPOLL */
@@ -0,0 +1,515 @@
+/* ********************************************************** */
+/* -*- facets.c -*- Bitmap indexes over character data    -*- */
+/* ********************************************************** */
+/* Tyler Besselman (C) October 2026                           */
+/* ********************************************************** */
+
+#include <sys/types.h>
+#include <errno.h>
+#include <strings.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+
+#include <facets.h>
+#include <utf8.h>
+
+// Pinyin initials, longest first so "zh" is found before "z".
+static const char *const _facets_initials[] = {
+    "zh", "ch", "sh",
+    "b", "p", "m", "f", "d", "t", "n", "l", "g", "k", "h", "j", "q", "x", "r", "z", "c", "s", "y", "w"
+};
+
+// Map a pinyin codepoint to the plain (lowercase) letter it is, with 'v' for 'ü'. Returns 0 for anything else.
+static char _facets_letter(uint32_t cp)
+{
+    if (cp >= 'A' && cp <= 'Z') { cp += 'a' - 'A'; }
+    if (cp >= 'a' && cp <= 'z') { return (char)cp; }
+
+    switch (cp)
+    {
+        case 0x0101: case 0x00E1: case 0x01CE: case 0x00E0: return 'a';
+        case 0x0113: case 0x00E9: case 0x011B: case 0x00E8: case 0x00EA: return 'e';
+        case 0x012B: case 0x00ED: case 0x01D0: case 0x00EC: return 'i';
+        case 0x014D: case 0x00F3: case 0x01D2: case 0x00F2: return 'o';
+        case 0x016B: case 0x00FA: case 0x01D4: case 0x00F9: return 'u';
+        case 0x00FC: case 0x01D6: case 0x01D8: case 0x01DA: case 0x01DC: return 'v';
+        case 0x0144: case 0x0148: case 0x01F9: return 'n';
+        case 0x1E3F: return 'm';
+        default: return 0;
+    }
+}
+
+// Write the first syllable of some pinyin to `out` without tones, skipping anything before it. Returns the length.
+static size_t _facets_plain(const char *py, char *out)
+{
+    size_t n = 0;
+    char c = 0;
+
+    while (*py && !(c = _facets_letter(utf8_next(&py)))) {}
+
+    while (c && n < FACETS_SOUND_LEN - 1)
+    {
+        out[n++] = c;
+        c = (*py ? _facets_letter(utf8_next(&py)) : 0);
+    }
+
+    out[n] = 0;
+    return n;
+}
+
+// Spell a plain final for display and lookup (with 'ü' for 'v').
+static void _facets_spell(const char *plain, char *out, size_t cap)
+{
+    size_t n = 0;
+
+    for (; *plain && n + 3 < cap; plain++)
+    {
+        if (*plain == 'v') {
+            n += utf8_encode(0xFC, &out[n]);
+        } else {
+            out[n++] = *plain;
+        }
+    }
+
+    out[n] = 0;
+}
+
+// Split some pinyin into its initial (which may be empty) and final.
+static void _facets_pinyin(const char *py, char *initial, char *final)
+{
+    char plain[FACETS_SOUND_LEN];
+    _facets_plain(py, plain);
+
+    initial[0] = 0;
+
+    for (size_t i = 0; i < sizeof(_facets_initials) / sizeof(*_facets_initials); i++)
+    {
+        size_t len = strlen(_facets_initials[i]);
+
+        // Syllables like "er" have no initial, and "m" and "n" can be whole syllables.
+        if (!strncmp(plain, _facets_initials[i], len) && plain[len])
+        {
+            memcpy(initial, plain, len);
+            initial[len] = 0;
+
+            break;
+        }
+    }
+
+    // Pinyin writes 'ü' as 'u' after these, but the final is the same as in "lüe".
+    char *rest = &plain[strlen(initial)];
+    if (initial[0] && strchr("jqxy", initial[0]) && rest[0] == 'u') { rest[0] = 'v'; }
+
+    _facets_spell(rest, final, FACETS_SOUND_LEN);
+}
+
+// Find the index of `key` in an attribute (or where it would go).
+static uint32_t _facets_find(const struct facets_attr *attr, const char *key)
+{
+    uint32_t lo = 0;
+    uint32_t hi = attr->n;
+
+    while (lo < hi)
+    {
+        uint32_t mid = lo + (hi - lo) / 2;
+
+        if (strcmp(attr->keys[mid], key) < 0) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+
+    return lo;
+}
+
+// Look up the bitmap for a value of an attribute, returning NULL if no character has it.
+static const struct bitmap *_facets_get(const struct facets_attr *attr, const char *key)
+{
+    uint32_t i = _facets_find(attr, key);
+    return ((i < attr->n && !strcmp(attr->keys[i], key)) ? &attr->maps[i] : NULL);
+}
+
+// Add character `id` to the bitmap for a value of an attribute, adding the value if it's new.
+static int _facets_add(struct facets_attr *attr, const char *key, uint32_t id)
+{
+    uint32_t i = _facets_find(attr, key);
+
+    if (i == attr->n || strcmp(attr->keys[i], key))
+    {
+        if (attr->n == attr->cap)
+        {
+            uint32_t cap = (attr->cap ? attr->cap * 2 : 16);
+
+            char **keys = realloc(attr->keys, cap * sizeof(char *));
+            if (keys) { attr->keys = keys; }
+
+            struct bitmap *maps = realloc(attr->maps, cap * sizeof(struct bitmap));
+            if (maps) { attr->maps = maps; }
+
+            if (!keys || !maps)
+            {
+                perror("realloc");
+                return 1;
+            }
+
+            attr->cap = cap;
+        }
+
+        char *copy = strdup(key);
+
+        if (!copy)
+        {
+            perror("strdup");
+            return 1;
+        }
+
+        memmove(&attr->keys[i + 1], &attr->keys[i], (attr->n - i) * sizeof(char *));
+        memmove(&attr->maps[i + 1], &attr->maps[i], (attr->n - i) * sizeof(struct bitmap));
+
+        attr->keys[i] = copy;
+        attr->maps[i] = BITMAP_INIT;
+        attr->n++;
+    }
+
+    return bitmap_add(&attr->maps[i], id);
+}
+
+static void _facets_attr_free(struct facets_attr *attr)
+{
+    for (uint32_t i = 0; i < attr->n; i++)
+    {
+        free(attr->keys[i]);
+        bitmap_free(&attr->maps[i]);
+    }
+
+    free(attr->keys);
+    free(attr->maps);
+}
+
+struct facets *facets_build(struct xlsx *doc)
+{
+    off_t names = -1;
+    off_t radicals = -1;
+    off_t strokes = -1;
+    off_t xstrokes = -1;
+    off_t pinyin = -1;
+
+    struct xlsx_value *header = xlsx_row(doc, 0);
+
+    for (size_t i = 0; i < xlsx_cols(doc); i++)
+    {
+        if (!XLSX_ISSTR(&header[i])) { continue; }
+        const char *name = XLSX_STRVAL(doc, &header[i]);
+
+        if (!strcmp("字詞名", name)) {
+            names = i;
+        } else if (!strcmp("部首字", name)) {
+            radicals = i;
+        } else if (!strcmp("總筆畫數", name)) {
+            strokes = i;
+        } else if (!strcmp("部首外筆畫數", name)) {
+            xstrokes = i;
+        } else if (!strcmp("漢語拼音", name)) {
+            pinyin = i;
+        }
+    }
+
+    if (names < 0)
+    {
+        fprintf(stderr, "Error: Missing names.\n");
+        return NULL;
+    }
+
+    struct facets *fc = calloc(1, sizeof(struct facets));
+    size_t rows = xlsx_rows(doc);
+
+    if (fc)
+    {
+        fc->chars = malloc(rows * sizeof(*fc->chars) + 1);
+        fc->rows = malloc(rows * sizeof(uint32_t) + 1);
+    }
+
+    if (!fc || !fc->chars || !fc->rows)
+    {
+        perror("malloc");
+
+        if (fc) { facets_free(fc); }
+        return NULL;
+    }
+
+    int failed = 0;
+
+    for (size_t r = 1; r < rows && !failed; r++)
+    {
+        struct xlsx_value *row = xlsx_row(doc, r);
+        if (!XLSX_ISSTR(&row[names])) { continue; }
+
+        // Only single characters are indexed.
+        const char *word = XLSX_STRVAL(doc, &row[names]);
+        const char *end = word;
+
+        if (!*word || (utf8_next(&end), *end)) { continue; }
+
+        uint32_t id = fc->n++;
+
+        memcpy(fc->chars[id], word, end - word);
+        fc->chars[id][end - word] = 0;
+        fc->rows[id] = r;
+
+        failed = bitmap_add(&fc->all, id);
+
+        if (!failed && radicals >= 0 && XLSX_ISSTR(&row[radicals])) {
+            failed = _facets_add(&fc->radicals, XLSX_STRVAL(doc, &row[radicals]), id);
+        }
+
+        if (!failed && strokes >= 0 && row[strokes].type == XLSX_TYPE_INT && row[strokes].ival >= 0 && row[strokes].ival < FACETS_MAX_STROKES) {
+            failed = bitmap_add(&fc->strokes[row[strokes].ival], id);
+        }
+
+        if (!failed && xstrokes >= 0 && row[xstrokes].type == XLSX_TYPE_INT && row[xstrokes].ival >= 0 && row[xstrokes].ival < FACETS_MAX_STROKES) {
+            failed = bitmap_add(&fc->xstrokes[row[xstrokes].ival], id);
+        }
+
+        if (!failed && pinyin >= 0 && XLSX_ISSTR(&row[pinyin]))
+        {
+            char initial[FACETS_SOUND_LEN];
+            char final[FACETS_SOUND_LEN];
+
+            _facets_pinyin(XLSX_STRVAL(doc, &row[pinyin]), initial, final);
+
+            // Characters we can't make sense of the pinyin for are left out of both.
+            if (final[0]) {
+                failed = (_facets_add(&fc->initials, initial, id) || _facets_add(&fc->finals, final, id));
+            }
+        }
+    }
+
+    if (failed)
+    {
+        facets_free(fc);
+        return NULL;
+    }
+
+    if (DEBUG_FACETS) {
+        fprintf(stderr, "Indexed %u characters (%u radicals, %u initials, %u finals).\n", fc->n, fc->radicals.n, fc->initials.n, fc->finals.n);
+    }
+
+    return fc;
+}
+
+struct facets *facets_load(const char *path)
+{
+    struct xlsx *doc = xlsx_doc_at(path);
+    if (!doc) { return NULL; }
+
+    struct facets *fc = facets_build(doc);
+    xlsx_doc_free(doc);
+
+    return fc;
+}
+
+// Parse a stroke count at the start of `s`, leaving `end` just past it. Returns 1 unless it is plain digits below FACETS_MAX_STROKES.
+static int _facets_strokes(const char *s, char **end, unsigned long *out)
+{
+    if (*s < '0' || *s > '9') { return 1; }
+
+    errno = 0;
+    (*out) = strtoul(s, end, 10);
+
+    return (errno || (*out) >= FACETS_MAX_STROKES);
+}
+
+// Replace `acc` with `acc | bm`.
+static int _facets_or(struct bitmap *acc, const struct bitmap *bm)
+{
+    struct bitmap r = BITMAP_INIT;
+
+    if (bitmap_or(acc, bm, &r)) { return 1; }
+
+    bitmap_free(acc);
+    (*acc) = r;
+
+    return 0;
+}
+
+// Build the bitmap for a single term (`attr:value,value...`, with `len` bytes) in `out`.
+static int _facets_term(const struct facets *fc, const char *term, size_t len, struct bitmap *out)
+{
+    const char *colon = memchr(term, ':', len);
+
+    if (!colon || colon == term)
+    {
+        fprintf(stderr, "Error: Filter terms look like 'attr:value' (not '%.*s')!\n", (int)len, term);
+        return 1;
+    }
+
+    size_t alen = colon - term;
+
+    const struct facets_attr *attr = NULL;
+    const struct bitmap *counts = NULL;
+
+    #define IS_ATTR(name) (alen == strlen(name) && !memcmp(term, name, alen))
+
+    if (IS_ATTR("rad")) {
+        attr = &fc->radicals;
+    } else if (IS_ATTR("initial")) {
+        attr = &fc->initials;
+    } else if (IS_ATTR("final")) {
+        attr = &fc->finals;
+    } else if (IS_ATTR("strokes")) {
+        counts = fc->strokes;
+    } else if (IS_ATTR("xstrokes")) {
+        counts = fc->xstrokes;
+    } else {
+        fprintf(stderr, "Error: Unknown filter attribute '%.*s'!\n", (int)alen, term);
+        return 1;
+    }
+
+    #undef IS_ATTR
+
+    const char *end = &term[len];
+
+    for (const char *value = colon + 1; value < end; )
+    {
+        const char *comma = memchr(value, ',', end - value);
+        if (!comma) { comma = end; }
+
+        char buf[FACETS_VALUE_MAX];
+
+        if (comma - value >= FACETS_VALUE_MAX)
+        {
+            fprintf(stderr, "Error: Filter value '%.*s' is too long!\n", (int)(comma - value), value);
+            return 1;
+        }
+
+        memcpy(buf, value, comma - value);
+        buf[comma - value] = 0;
+
+        value = comma + 1;
+
+        if (attr)
+        {
+            // Pinyin is matched without tones.
+            char plain[FACETS_SOUND_LEN];
+            char spelled[FACETS_SOUND_LEN];
+
+            const char *key = buf;
+
+            if (attr != &fc->radicals)
+            {
+                _facets_plain(buf, plain);
+                _facets_spell(plain, spelled, sizeof(spelled));
+
+                key = spelled;
+            }
+
+            const struct bitmap *bm = _facets_get(attr, key);
+            if (bm && _facets_or(out, bm)) { return 1; }
+
+            continue;
+        }
+
+        unsigned long lo;
+        unsigned long hi;
+        char *rest;
+
+        bool bad = _facets_strokes(buf, &rest, &lo);
+        hi = lo;
+
+        // An open range ("3-") runs to the highest stroke count.
+        if (!bad && *rest == '-')
+        {
+            if (rest[1]) {
+                bad = _facets_strokes(&rest[1], &rest, &hi);
+            } else {
+                hi = FACETS_MAX_STROKES - 1;
+                rest++;
+            }
+        }
+
+        if (bad || *rest || lo > hi)
+        {
+            fprintf(stderr, "Error: Bad stroke count '%s'!\n", buf);
+            return 1;
+        }
+
+        for (unsigned long s = lo; s <= hi; s++)
+        {
+            if (counts[s].n && _facets_or(out, &counts[s])) { return 1; }
+        }
+    }
+
+    return 0;
+}
+
+int facets_filter(const struct facets *fc, const char *filter, struct bitmap *out)
+{
+    struct bitmap acc = BITMAP_INIT;
+    bool first = true;
+
+    for (const char *term = filter; *term; )
+    {
+        while (*term == ' ') {
+            term++;
+        }
+
+        size_t len = strcspn(term, " ");
+        if (!len) { break; }
+
+        struct bitmap bm = BITMAP_INIT;
+
+        if (_facets_term(fc, term, len, &bm))
+        {
+            bitmap_free(&bm);
+            bitmap_free(&acc);
+
+            return 1;
+        }
+
+        term += len;
+
+        if (first) {
+            acc = bm;
+            first = false;
+
+            continue;
+        }
+
+        struct bitmap r = BITMAP_INIT;
+        int failed = bitmap_and(&acc, &bm, &r);
+
+        bitmap_free(&acc);
+        bitmap_free(&bm);
+
+        if (failed) { return 1; }
+        acc = r;
+    }
+
+    // No terms means everything matches.
+    if (first) { return bitmap_copy(&fc->all, out); }
+
+    (*out) = acc;
+    return 0;
+}
+
+void facets_free(struct facets *fc)
+{
+    free(fc->chars);
+    free(fc->rows);
+
+    bitmap_free(&fc->all);
+
+    _facets_attr_free(&fc->radicals);
+    _facets_attr_free(&fc->initials);
+    _facets_attr_free(&fc->finals);
+
+    for (size_t s = 0; s < FACETS_MAX_STROKES; s++)
+    {
+        bitmap_free(&fc->strokes[s]);
+        bitmap_free(&fc->xstrokes[s]);
+    }
+
+    free(fc);
+}
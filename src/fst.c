@@ -0,0 +1,1218 @@
+/* ********************************************************** */
+/* -*- fst.c -*- Finite state transducer over words       -*- */
+/* ********************************************************** */
+/* Tyler Besselman (C) October 2026                           */
+/* ********************************************************** */
+
+#include <strings.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+
+#include <fnv.h>
+#include <fst.h>
+
+// Address used for "no node yet" while building.
+#define _FST_NONE UINT64_MAX
+
+// A transition while building. `addr` is where its target ends in the output (see `_fst_compile`).
+struct _fst_trans {
+    uint64_t out;
+    uint64_t addr;
+    uint8_t input;
+};
+
+// A node on the path of the last key added, which later keys may still add transitions to.
+// Its last transition (`last_input`) has no target yet, since the node it leads to isn't finished either.
+struct _fst_unode {
+    struct _fst_trans *trans;
+    uint32_t ntrans;
+    size_t cap;
+
+    bool final;
+    uint64_t final_out;
+
+    bool has_last;
+    uint8_t last_input;
+    uint64_t last_out;
+};
+
+// A node which has been written, kept so identical nodes are only written once.
+// Its transitions are `rtrans[first]` through `rtrans[first + ntrans - 1]`.
+struct _fst_reg {
+    uint64_t hash;
+    uint64_t addr;
+    uint64_t final_out;
+    uint32_t first;
+    uint32_t ntrans;
+    bool final;
+};
+
+struct fst_builder {
+    // Nodes written so far. They're written children first, each one reversed, and the whole thing is reversed at the end,
+    //   so in the finished FST every node comes before its children and reads forwards.
+    struct obuf buf;
+    struct obuf tmp;
+
+    // Unfinished nodes. `stack[0]` is the root, and `stack[i]` is reached by the first `i` bytes of the last key.
+    struct _fst_unode *stack;
+    uint32_t depth;
+    uint32_t stack_cap;
+
+    // Last key added.
+    struct obuf prev;
+    uint64_t nkeys;
+
+    // Open addressing (linear probing) hash table of written nodes (index + 1; 0 is empty). `nslots` is a power of 2.
+    uint32_t *slots;
+    uint32_t nslots;
+
+    struct _fst_reg *reg;
+    uint32_t nreg;
+    size_t reg_cap;
+
+    struct _fst_trans *rtrans;
+    size_t nrtrans;
+    size_t rtrans_cap;
+};
+
+// Grow an array to hold at least `n` elements. Returns non-zero on failure.
+static int _fst_grow(void **array, size_t *cap, size_t n, size_t size)
+{
+    if (n <= *cap) { return 0; }
+
+    size_t new_cap = ((*cap) ? (*cap) : 16);
+
+    while (new_cap < n) {
+        new_cap *= 2;
+    }
+
+    void *new_array = realloc(*array, new_cap * size);
+
+    if (!new_array)
+    {
+        perror("realloc");
+        return 1;
+    }
+
+    (*array) = new_array;
+    (*cap) = new_cap;
+
+    return 0;
+}
+
+struct fst_builder *fst_builder_new(void)
+{
+    struct fst_builder *b = calloc(1, sizeof(struct fst_builder));
+
+    if (!b)
+    {
+        perror("calloc");
+        return NULL;
+    }
+
+    b->buf = OBUF_INIT;
+    b->tmp = OBUF_INIT;
+    b->prev = OBUF_INIT;
+
+    b->nslots = 1024;
+    b->slots = calloc(b->nslots, sizeof(uint32_t));
+    b->stack = calloc(16, sizeof(struct _fst_unode));
+    b->stack_cap = 16;
+
+    if (!b->slots || !b->stack)
+    {
+        perror("calloc");
+        fst_builder_free(b);
+
+        return NULL;
+    }
+
+    // The root is always there.
+    b->depth = 1;
+
+    return b;
+}
+
+// Push a node onto the unfinished stack. Returns NULL on failure.
+static struct _fst_unode *_fst_push(struct fst_builder *b)
+{
+    if (b->depth == b->stack_cap)
+    {
+        struct _fst_unode *stack = realloc(b->stack, b->stack_cap * 2 * sizeof(struct _fst_unode));
+
+        if (!stack)
+        {
+            perror("realloc");
+            return NULL;
+        }
+
+        memset(&stack[b->stack_cap], 0, b->stack_cap * sizeof(struct _fst_unode));
+
+        b->stack = stack;
+        b->stack_cap *= 2;
+    }
+
+    // Transition arrays are kept (and reused) when nodes are popped.
+    struct _fst_unode *node = &b->stack[b->depth++];
+
+    node->ntrans = 0;
+    node->final = false;
+    node->final_out = 0;
+    node->has_last = false;
+    node->last_out = 0;
+
+    return node;
+}
+
+static uint64_t _fst_node_hash(const struct _fst_unode *node)
+{
+    // FNV-1a over the node's fields.
+    uint64_t h = 14695981039346656037ULL;
+
+    #define MIX(v) do { h ^= (uint64_t)(v); h *= 1099511628211ULL; } while (0)
+
+    MIX(node->final);
+    MIX(node->final_out);
+
+    for (uint32_t i = 0; i < node->ntrans; i++)
+    {
+        MIX(node->trans[i].input);
+        MIX(node->trans[i].out);
+        MIX(node->trans[i].addr);
+    }
+
+    #undef MIX
+
+    return h;
+}
+
+static bool _fst_node_eq(const struct fst_builder *b, const struct _fst_reg *reg, const struct _fst_unode *node)
+{
+    if (reg->final != node->final || reg->final_out != node->final_out || reg->ntrans != node->ntrans) { return false; }
+
+    for (uint32_t i = 0; i < node->ntrans; i++)
+    {
+        const struct _fst_trans *a = &b->rtrans[reg->first + i];
+        const struct _fst_trans *t = &node->trans[i];
+
+        if (a->input != t->input || a->out != t->out || a->addr != t->addr) { return false; }
+    }
+
+    return true;
+}
+
+// Append a variable length number (7 bits at a time, low bits first). Returns non-zero on failure.
+static int _fst_put_varint(struct obuf *buf, uint64_t v)
+{
+    uint8_t bytes[10];
+    size_t n = 0;
+
+    do {
+        bytes[n++] = (v & 0x7F) | ((v > 0x7F) ? 0x80 : 0);
+        v >>= 7;
+    } while (v);
+
+    return obuf_append(buf, bytes, n);
+}
+
+// Number of bytes needed to hold `v` (0 for 0).
+static inline uint8_t _fst_width(uint64_t v)
+{
+    uint8_t n = 0;
+
+    for ( ; v; v >>= 8) {
+        n++;
+    }
+
+    return n;
+}
+
+// Append `v` as `width` little endian bytes. Returns non-zero on failure.
+static int _fst_put_fixed(struct obuf *buf, uint64_t v, uint8_t width)
+{
+    uint8_t bytes[8];
+
+    for (uint8_t i = 0; i < width; i++) {
+        bytes[i] = (v >> (i * 8)) & 0xFF;
+    }
+
+    return obuf_append(buf, bytes, width);
+}
+
+// Write a finished node (or find an identical one already written), returning its address (`_FST_NONE` on failure).
+// While building, a node's address is where it ends in `buf`, so a transition's distance is `start - addr` (where `start` is
+//   where its own node starts in `buf`), which stays the same once everything is reversed.
+static uint64_t _fst_compile(struct fst_builder *b, const struct _fst_unode *node)
+{
+    uint64_t hash = _fst_node_hash(node);
+    uint32_t mask = b->nslots - 1;
+    uint32_t s = hash & mask;
+
+    for ( ; b->slots[s]; s = (s + 1) & mask)
+    {
+        const struct _fst_reg *reg = &b->reg[b->slots[s] - 1];
+        if (reg->hash == hash && _fst_node_eq(b, reg, node)) { return reg->addr; }
+    }
+
+    uint64_t start = b->buf.len;
+    struct obuf *tmp = &b->tmp;
+    tmp->len = 0;
+
+    uint8_t flags = (node->final ? FST_FINAL : 0) | (node->final_out ? FST_FOUT : 0);
+    bool failed = false;
+
+    if (node->ntrans == 1)
+    {
+        const struct _fst_trans *t = &node->trans[0];
+        uint64_t dist = start - t->addr;
+
+        flags |= FST_ONE | (t->out ? FST_OUT : 0) | (dist ? 0 : FST_NEXT);
+
+        failed = obuf_append(tmp, &flags, 1)
+            || (node->final_out && _fst_put_varint(tmp, node->final_out))
+            || obuf_append(tmp, &t->input, 1)
+            || (t->out && _fst_put_varint(tmp, t->out))
+            || (dist && _fst_put_varint(tmp, dist));
+    } else {
+        flags |= (node->ntrans ? FST_TABLE : 0);
+
+        failed = obuf_append(tmp, &flags, 1) || (node->final_out && _fst_put_varint(tmp, node->final_out));
+
+        if (node->ntrans && !failed)
+        {
+            uint64_t max_out = 0;
+            uint64_t max_dist = 0;
+
+            for (uint32_t i = 0; i < node->ntrans; i++)
+            {
+                if (node->trans[i].out > max_out) { max_out = node->trans[i].out; }
+                if (start - node->trans[i].addr > max_dist) { max_dist = start - node->trans[i].addr; }
+            }
+
+            uint8_t header[2] = { node->ntrans - 1, (_fst_width(max_out) << 4) | _fst_width(max_dist) };
+            failed = obuf_append(tmp, header, 2);
+
+            for (uint32_t i = 0; i < node->ntrans && !failed; i++) {
+                failed = obuf_append(tmp, &node->trans[i].input, 1);
+            }
+
+            for (uint32_t i = 0; i < node->ntrans && !failed; i++) {
+                failed = _fst_put_fixed(tmp, node->trans[i].out, header[1] >> 4);
+            }
+
+            for (uint32_t i = 0; i < node->ntrans && !failed; i++) {
+                failed = _fst_put_fixed(tmp, start - node->trans[i].addr, header[1] & 0xF);
+            }
+        }
+    }
+
+    if (failed || obuf_reserve(&b->buf, tmp->len)) { return _FST_NONE; }
+
+    for (size_t i = 0; i < tmp->len; i++) {
+        b->buf.data[b->buf.len + i] = tmp->data[tmp->len - 1 - i];
+    }
+
+    b->buf.len += tmp->len;
+
+    // Remember the node so later copies of it point here instead.
+    if (_fst_grow((void **)&b->reg, &b->reg_cap, b->nreg + 1, sizeof(struct _fst_reg))) { return _FST_NONE; }
+    if (_fst_grow((void **)&b->rtrans, &b->rtrans_cap, b->nrtrans + node->ntrans, sizeof(struct _fst_trans))) { return _FST_NONE; }
+
+    if (node->ntrans) {
+        memcpy(&b->rtrans[b->nrtrans], node->trans, node->ntrans * sizeof(struct _fst_trans));
+    }
+
+    b->reg[b->nreg] = (struct _fst_reg){
+        .hash = hash,
+        .addr = b->buf.len,
+        .final_out = node->final_out,
+        .first = b->nrtrans,
+        .ntrans = node->ntrans,
+        .final = node->final
+    };
+
+    b->nrtrans += node->ntrans;
+    b->slots[s] = ++b->nreg;
+
+    // Keep the table at most half full.
+    if (b->nreg * 2 > b->nslots)
+    {
+        uint32_t nslots = b->nslots * 2;
+        uint32_t *slots = calloc(nslots, sizeof(uint32_t));
+
+        if (!slots)
+        {
+            perror("calloc");
+            return _FST_NONE;
+        }
+
+        for (uint32_t i = 0; i < b->nreg; i++)
+        {
+            uint32_t j = b->reg[i].hash & (nslots - 1);
+
+            while (slots[j]) {
+                j = (j + 1) & (nslots - 1);
+            }
+
+            slots[j] = i + 1;
+        }
+
+        free(b->slots);
+        b->slots = slots;
+        b->nslots = nslots;
+    }
+
+    return b->buf.len;
+}
+
+// Add a transition to a node. Returns non-zero on failure.
+static int _fst_add_trans(struct _fst_unode *node, uint8_t input, uint64_t out, uint64_t addr)
+{
+    if (_fst_grow((void **)&node->trans, &node->cap, node->ntrans + 1, sizeof(struct _fst_trans))) { return 1; }
+
+    node->trans[node->ntrans++] = (struct _fst_trans){ .out = out, .addr = addr, .input = input };
+
+    return 0;
+}
+
+// Write every unfinished node deeper than `depth`, since no later key can reach them. Returns non-zero on failure.
+static int _fst_freeze(struct fst_builder *b, uint32_t depth)
+{
+    uint64_t addr = _FST_NONE;
+
+    while (b->depth > depth + 1)
+    {
+        struct _fst_unode *node = &b->stack[b->depth - 1];
+
+        // Its last transition leads to the node we just wrote.
+        if (node->has_last && _fst_add_trans(node, node->last_input, node->last_out, addr)) { return 1; }
+
+        node->has_last = false;
+        addr = _fst_compile(b, node);
+
+        if (addr == _FST_NONE) { return 1; }
+        b->depth--;
+    }
+
+    struct _fst_unode *node = &b->stack[depth];
+
+    if (addr != _FST_NONE && node->has_last)
+    {
+        if (_fst_add_trans(node, node->last_input, node->last_out, addr)) { return 1; }
+        node->has_last = false;
+    }
+
+    return 0;
+}
+
+// Add `p` to everything leaving a node (used when part of an output moves down past it).
+static void _fst_push_output(struct _fst_unode *node, uint64_t p)
+{
+    if (node->final) { node->final_out += p; }
+
+    for (uint32_t i = 0; i < node->ntrans; i++) {
+        node->trans[i].out += p;
+    }
+
+    if (node->has_last) { node->last_out += p; }
+}
+
+int fst_builder_add(struct fst_builder *b, const char *key, size_t len, uint64_t value)
+{
+    const uint8_t *bytes = (const uint8_t *)key;
+
+    if (b->nkeys)
+    {
+        size_t n = (b->prev.len < len ? b->prev.len : len);
+        int cmp = (n ? memcmp(b->prev.data, key, n) : 0);
+
+        if (cmp > 0 || (!cmp && b->prev.len >= len))
+        {
+            fprintf(stderr, "Error: FST keys must be added in increasing order (found '%.*s' after '%.*s')!\n", (int)len, key, (int)b->prev.len, b->prev.data);
+            return 1;
+        }
+    }
+
+    // Only the first key can be empty.
+    if (!len)
+    {
+        b->stack[0].final = true;
+        b->stack[0].final_out = value;
+        b->nkeys++;
+
+        return 0;
+    }
+
+    // Follow the prefix this key shares with the last one. Each shared transition keeps only the part of its output
+    //   common to both keys, and pushes the rest down to the next node.
+    uint32_t i = 0;
+    uint64_t out = value;
+
+    while (i < len && b->stack[i].has_last && b->stack[i].last_input == bytes[i])
+    {
+        struct _fst_unode *node = &b->stack[i];
+        uint64_t common = (node->last_out < out ? node->last_out : out);
+
+        if (node->last_out > common) {
+            _fst_push_output(&b->stack[i + 1], node->last_out - common);
+        }
+
+        node->last_out = common;
+        out -= common;
+
+        i++;
+    }
+
+    if (_fst_freeze(b, i)) { return 1; }
+
+    // Then add a new chain of nodes for the rest of the key, with the rest of its output on the first transition.
+    b->stack[i].has_last = true;
+    b->stack[i].last_input = bytes[i];
+    b->stack[i].last_out = out;
+
+    for (size_t j = i + 1; j <= len; j++)
+    {
+        struct _fst_unode *node = _fst_push(b);
+        if (!node) { return 1; }
+
+        if (j == len) {
+            node->final = true;
+        } else {
+            node->has_last = true;
+            node->last_input = bytes[j];
+        }
+    }
+
+    b->prev.len = 0;
+    if (obuf_append(&b->prev, key, len)) { return 1; }
+
+    b->nkeys++;
+    return 0;
+}
+
+struct fst *fst_builder_finish(struct fst_builder *b)
+{
+    struct fst *fst = NULL;
+    uint64_t root = _FST_NONE;
+
+    if (!_fst_freeze(b, 0)) {
+        root = _fst_compile(b, &b->stack[0]);
+    }
+
+    if (root != _FST_NONE) {
+        fst = calloc(1, sizeof(struct fst));
+    }
+
+    uint8_t *data = (fst ? malloc(b->buf.len) : NULL);
+
+    if (!data)
+    {
+        if (root != _FST_NONE) { perror("malloc"); }
+
+        free(fst);
+        fst_builder_free(b);
+
+        return NULL;
+    }
+
+    // Everything was written backwards.
+    for (size_t i = 0; i < b->buf.len; i++) {
+        data[i] = b->buf.data[b->buf.len - 1 - i];
+    }
+
+    fst->data = data;
+    fst->size = b->buf.len;
+    fst->root = b->buf.len - root;
+    fst->nkeys = b->nkeys;
+    fst->buf = data;
+
+    if (DEBUG_FST) {
+        fprintf(stderr, "Built FST over %llu keys (%zu bytes, %u unique nodes).\n", (unsigned long long)fst->nkeys, fst->size, b->nreg);
+    }
+
+    fst_builder_free(b);
+    return fst;
+}
+
+void fst_builder_free(struct fst_builder *b)
+{
+    for (uint32_t i = 0; i < b->stack_cap && b->stack; i++) {
+        free(b->stack[i].trans);
+    }
+
+    obuf_free(&b->buf);
+    obuf_free(&b->tmp);
+    obuf_free(&b->prev);
+
+    free(b->stack);
+    free(b->slots);
+    free(b->reg);
+    free(b->rtrans);
+    free(b);
+}
+
+// Hash every word of an index (with the number of entries it has) in order.
+// An FST built from one index only fits another if they have the same words with the same entries.
+static uint64_t _fst_words_hash(const struct dindex *idx)
+{
+    uint32_t h = FNV_INIT;
+
+    for (uint32_t w = 0; w < idx->nwords; w++)
+    {
+        const struct dindex_word *word = &idx->words[w];
+
+        h = fnv1a(h, &word->len, sizeof(word->len));
+        h = fnv1a(h, dindex_str(idx, word->str), word->len);
+        h = fnv1a(h, &word->count, sizeof(word->count));
+    }
+
+    return h;
+}
+
+struct fst *fst_build(const struct dindex *idx)
+{
+    // The word table is one allocation: `first` (with one past the end), then `strokes`.
+    void *words_buf = malloc((idx->nwords + 1) * sizeof(uint32_t) + idx->nwords * sizeof(uint16_t));
+
+    if (!words_buf)
+    {
+        perror("malloc");
+        return NULL;
+    }
+
+    uint32_t *first = words_buf;
+    uint16_t *strokes = (uint16_t *)&first[idx->nwords + 1];
+
+    struct fst_builder *b = fst_builder_new();
+
+    if (!b)
+    {
+        free(words_buf);
+        return NULL;
+    }
+
+    // Words are already sorted in byte order, and their entries are grouped in the same order.
+    // Values are ordinals, so they grow along with the keys and mostly cancel out along shared prefixes.
+    for (uint32_t w = 0; w < idx->nwords; w++)
+    {
+        const struct dindex_word *word = &idx->words[w];
+
+        first[w] = word->first;
+        strokes[w] = (word->strokes > UINT16_MAX ? UINT16_MAX : word->strokes);
+
+        if (fst_builder_add(b, dindex_str(idx, word->str), word->len, w))
+        {
+            fst_builder_free(b);
+            free(words_buf);
+
+            return NULL;
+        }
+    }
+
+    first[idx->nwords] = idx->nentries;
+
+    struct fst *fst = fst_builder_finish(b);
+
+    if (!fst)
+    {
+        free(words_buf);
+        return NULL;
+    }
+
+    fst->first = first;
+    fst->strokes = strokes;
+    fst->nentries = idx->nentries;
+    fst->words_hash = _fst_words_hash(idx);
+    fst->words_buf = words_buf;
+
+    return fst;
+}
+
+// A node as read from the FST.
+struct _fst_node {
+    bool final;
+    uint64_t final_out;
+
+    // Offset just past the node (distances to targets are from here).
+    uint64_t end;
+    uint32_t ntrans;
+
+    // FST_ONE
+    uint8_t input;
+    uint64_t out;
+    uint64_t dist;
+
+    // FST_TABLE
+    const uint8_t *inputs;
+    const uint8_t *outs;
+    const uint8_t *dists;
+    uint8_t out_width;
+    uint8_t dist_width;
+};
+
+// Read a variable length number at `*p`. Returns false if it runs past `end`.
+static inline bool _fst_varint(const uint8_t **p, const uint8_t *end, uint64_t *out)
+{
+    uint64_t v = 0;
+
+    for (uint32_t shift = 0; (*p) < end && shift < 64; shift += 7)
+    {
+        uint8_t b = *(*p)++;
+        v |= (uint64_t)(b & 0x7F) << shift;
+
+        if (!(b & 0x80))
+        {
+            (*out) = v;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static inline uint64_t _fst_fixed(const uint8_t *p, uint8_t width)
+{
+    uint64_t v = 0;
+
+    for (uint8_t i = 0; i < width; i++) {
+        v |= (uint64_t)p[i] << (i * 8);
+    }
+
+    return v;
+}
+
+// Read the node at `pos`. Returns false if it's out of bounds or malformed.
+static bool _fst_node(const struct fst *fst, uint64_t pos, struct _fst_node *node)
+{
+    if (pos >= fst->size) { return false; }
+
+    const uint8_t *p = &fst->data[pos];
+    const uint8_t *end = &fst->data[fst->size];
+    uint8_t flags = *p++;
+
+    node->final = (flags & FST_FINAL);
+    node->final_out = 0;
+    node->ntrans = 0;
+    node->inputs = NULL;
+
+    if ((flags & FST_FOUT) && !_fst_varint(&p, end, &node->final_out)) { return false; }
+
+    if (flags & FST_ONE)
+    {
+        if (p == end) { return false; }
+
+        node->ntrans = 1;
+        node->input = *p++;
+        node->out = 0;
+        node->dist = 0;
+
+        if ((flags & FST_OUT) && !_fst_varint(&p, end, &node->out)) { return false; }
+        if (!(flags & FST_NEXT) && !_fst_varint(&p, end, &node->dist)) { return false; }
+    } else if (flags & FST_TABLE) {
+        if (end - p < 2) { return false; }
+
+        node->ntrans = (uint32_t)p[0] + 1;
+        node->out_width = p[1] >> 4;
+        node->dist_width = p[1] & 0xF;
+        p += 2;
+
+        if (node->out_width > 8 || node->dist_width > 8) { return false; }
+        if ((uint64_t)(end - p) < (uint64_t)node->ntrans * (1 + node->out_width + node->dist_width)) { return false; }
+
+        node->inputs = p;
+        node->outs = node->inputs + node->ntrans;
+        node->dists = node->outs + node->ntrans * node->out_width;
+
+        p = node->dists + node->ntrans * node->dist_width;
+    }
+
+    node->end = p - fst->data;
+    return true;
+}
+
+// Get transition `i` of a node.
+static inline void _fst_trans(const struct _fst_node *node, uint32_t i, uint8_t *input, uint64_t *out, uint64_t *target)
+{
+    if (node->ntrans == 1 && !node->inputs)
+    {
+        (*input) = node->input;
+        (*out) = node->out;
+        (*target) = node->end + node->dist;
+
+        return;
+    }
+
+    (*input) = node->inputs[i];
+    (*out) = _fst_fixed(&node->outs[i * node->out_width], node->out_width);
+    (*target) = node->end + _fst_fixed(&node->dists[i * node->dist_width], node->dist_width);
+}
+
+// Find the first transition of a node with an input of at least `byte` (or `node->ntrans` if there isn't one).
+static inline uint32_t _fst_seek(const struct _fst_node *node, uint8_t byte)
+{
+    if (!node->inputs) {
+        return ((node->ntrans && node->input >= byte) ? 0 : node->ntrans);
+    }
+
+    // Inputs are sorted, and there are at most 256 of them.
+    uint32_t i = 0;
+
+    while (i < node->ntrans && node->inputs[i] < byte) {
+        i++;
+    }
+
+    return i;
+}
+
+bool fst_get(const struct fst *fst, const char *key, size_t len, uint64_t *value)
+{
+    struct _fst_node node = { 0 };
+    uint64_t pos = fst->root;
+    uint64_t total = 0;
+
+    for (size_t i = 0; i < len; i++)
+    {
+        if (!_fst_node(fst, pos, &node)) { return false; }
+
+        uint8_t byte = key[i];
+        uint32_t t = _fst_seek(&node, byte);
+
+        uint8_t input;
+        uint64_t out;
+
+        if (t == node.ntrans) { return false; }
+        _fst_trans(&node, t, &input, &out, &pos);
+
+        if (input != byte) { return false; }
+        total += out;
+    }
+
+    if (!_fst_node(fst, pos, &node) || !node.final) { return false; }
+
+    (*value) = total + node.final_out;
+    return true;
+}
+
+// A node being walked through during iteration, with the next transition to follow and the output so far.
+struct _fst_frame {
+    struct _fst_node node;
+    uint32_t next;
+    uint64_t out;
+};
+
+// Compare the first `len` bytes of a key against a bound.
+static inline int _fst_cmp(const char *key, size_t len, const char *bound, size_t blen)
+{
+    int cmp = memcmp(key, bound, (len < blen ? len : blen));
+    return (cmp ? cmp : (len > blen) - (len < blen));
+}
+
+// Walk keys in `[lo, hi)` in order, stopping after `k` of them.
+static size_t _fst_iter(const struct fst *fst, const char *lo, const char *hi, size_t k, int (^blk)(const char *key, size_t len, uint64_t value))
+{
+    size_t lolen = (lo ? strlen(lo) : 0);
+    size_t hilen = (hi ? strlen(hi) : 0);
+
+    __block struct _fst_frame *frames = NULL;
+    __block size_t frames_cap = 0;
+
+    __block char *key = NULL;
+    __block size_t key_cap = 0;
+
+    __block size_t n = 0;
+    bool done = (!k);
+
+    // Enter a node at depth `d` (its key is the first `d` bytes of `key`), and emit its key if it's final and `emit` is set.
+    // Every key after a key at or past `hi` is too, so that ends the walk. Returns 0 once the walk should stop.
+    int (^enter)(uint64_t, size_t, uint64_t, bool) = ^(uint64_t pos, size_t d, uint64_t out, bool emit) {
+        if (_fst_grow((void **)&frames, &frames_cap, d + 1, sizeof(struct _fst_frame))) { return 0; }
+        if (_fst_grow((void **)&key, &key_cap, d + 1, 1)) { return 0; }
+
+        struct _fst_frame *frame = &frames[d];
+
+        frame->next = 0;
+        frame->out = out;
+
+        if (!_fst_node(fst, pos, &frame->node)) { return 0; }
+        if (hi && _fst_cmp(key, d, hi, hilen) >= 0) { return 0; }
+
+        if (emit && frame->node.final)
+        {
+            key[d] = 0;
+            n++;
+
+            if (blk(key, d, out + frame->node.final_out) || n >= k) { return 0; }
+        }
+
+        return 1;
+    };
+
+    // Rather than start from the root, go straight to the first key at least `lo`.
+    // Nodes along the way are left at their first transition past `lo`.
+    size_t depth = 0;
+    done = done || !enter(fst->root, 0, 0, !lolen);
+
+    for ( ; depth < lolen && !done; depth++)
+    {
+        struct _fst_frame *frame = &frames[depth];
+        uint32_t t = _fst_seek(&frame->node, lo[depth]);
+
+        frame->next = t;
+        if (t == frame->node.ntrans) { break; }
+
+        uint8_t input;
+        uint64_t out;
+        uint64_t target;
+
+        _fst_trans(&frame->node, t, &input, &out, &target);
+        if (input != (uint8_t)lo[depth]) { break; }
+
+        frame->next++;
+        key[depth] = input;
+
+        done = !enter(target, depth + 1, frame->out + out, (depth + 1 == lolen));
+    }
+
+    // Everything from here on is past `lo`, so walk the rest in order.
+    for (size_t top = depth; !done; )
+    {
+        struct _fst_frame *frame = &frames[top];
+
+        if (frame->next >= frame->node.ntrans)
+        {
+            if (!top) { break; }
+
+            top--;
+            continue;
+        }
+
+        uint8_t input;
+        uint64_t out;
+        uint64_t target;
+
+        _fst_trans(&frame->node, frame->next++, &input, &out, &target);
+        key[top] = input;
+
+        done = !enter(target, top + 1, frame->out + out, true);
+        top++;
+    }
+
+    free(frames);
+    free(key);
+
+    return n;
+}
+
+size_t fst_range(const struct fst *fst, const char *lo, const char *hi, int (^blk)(const char *key, size_t len, uint64_t value))
+{ return _fst_iter(fst, lo, hi, SIZE_MAX, blk); }
+
+// Find the smallest key past every key starting with `prefix`: the prefix with its last byte (that can be) incremented.
+// `*hi` is set to NULL if there's no such key (nothing past the prefix), and must be freed. Returns non-zero on failure.
+static int _fst_prefix_end(const char *prefix, char **hi)
+{
+    size_t len = strlen(prefix);
+    (*hi) = malloc(len + 1);
+
+    if (!*hi)
+    {
+        perror("malloc");
+        return 1;
+    }
+
+    memcpy(*hi, prefix, len + 1);
+
+    while (len && (uint8_t)(*hi)[len - 1] == 0xFF) {
+        (*hi)[--len] = 0;
+    }
+
+    if (len) {
+        (*hi)[len - 1]++;
+    } else {
+        free(*hi);
+        (*hi) = NULL;
+    }
+
+    return 0;
+}
+
+size_t fst_prefix(const struct fst *fst, const char *prefix, size_t k, int (^blk)(const char *key, size_t len, uint64_t value))
+{
+    char *hi;
+    if (_fst_prefix_end(prefix, &hi)) { return 0; }
+
+    size_t n = _fst_iter(fst, prefix, hi, k, blk);
+    free(hi);
+
+    return n;
+}
+
+bool fst_fits(const struct fst *fst, const struct dindex *idx)
+{
+    return (fst->first && fst->nkeys == idx->nwords && fst->nentries == idx->nentries
+         && !fst->first[0] && fst->first[fst->nkeys] == idx->nentries
+         && fst->words_hash == _fst_words_hash(idx));
+}
+
+// Find the word for a key from `fst_build`, checking the word table (which may come from a file) as we go.
+// Returns false if there's no such word.
+static bool _fst_word(const struct fst *fst, uint64_t w, uint32_t *first, uint32_t *count)
+{
+    if (w >= fst->nkeys) { return false; }
+
+    uint32_t lo = fst->first[w];
+    uint32_t hi = fst->first[w + 1];
+
+    if (lo > hi || hi > fst->nentries) { return false; }
+
+    (*first) = lo;
+    (*count) = hi - lo;
+
+    return true;
+}
+
+// Get the value of the first key at least `key` (or `fallback` if every key is smaller).
+static uint64_t _fst_ceil(const struct fst *fst, const char *key, uint64_t fallback)
+{
+    __block uint64_t found = fallback;
+
+    _fst_iter(fst, key, NULL, 1, ^(const char *k, size_t len, uint64_t value) {
+        found = value;
+        return 1;
+    });
+
+    return found;
+}
+
+size_t fst_lookup(const struct fst *fst, const struct dindex *idx, const char *word, int (^blk)(const struct dindex_entry *entry))
+{
+    uint64_t w;
+    uint32_t first, count;
+
+    if (!fst_get(fst, word, strlen(word), &w) || !_fst_word(fst, w, &first, &count)) { return 0; }
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        uint32_t e = idx->rows[first + i];
+        if (e >= idx->nentries) { return i; }
+
+        if (blk(&idx->entries[e])) {
+            break;
+        }
+    }
+
+    return count;
+}
+
+// Restore the (max) heap property below `i` in a heap of `n` words, each packed as its stroke count above its ordinal.
+// Packed words compare the same way `dindex_prefix` orders words by strokes.
+static void _fst_sift(uint64_t *heap, size_t n, size_t i)
+{
+    while (true)
+    {
+        size_t l = 2 * i + 1;
+        size_t r = l + 1;
+        size_t largest = i;
+
+        if (l < n && heap[largest] < heap[l]) { largest = l; }
+        if (r < n && heap[largest] < heap[r]) { largest = r; }
+
+        if (largest == i) { return; }
+
+        uint64_t tmp = heap[i];
+        heap[i] = heap[largest];
+        heap[largest] = tmp;
+
+        i = largest;
+    }
+}
+
+size_t fst_complete(const struct fst *fst, const struct dindex *idx, const char *prefix, enum dindex_order order, size_t k, int (^blk)(const char *word, size_t len, uint32_t strokes))
+{
+    char *hi;
+    if (_fst_prefix_end(prefix, &hi)) { return 0; }
+
+    if (order == DINDEX_ORDER_LEX)
+    {
+        // Words with the prefix are a run of ordinals, so counting them doesn't need to walk them.
+        uint64_t lo_w = _fst_ceil(fst, prefix, fst->nkeys);
+        uint64_t hi_w = (hi ? _fst_ceil(fst, hi, fst->nkeys) : fst->nkeys);
+
+        size_t total = (hi_w > lo_w ? hi_w - lo_w : 0);
+
+        if (total && k)
+        {
+            _fst_iter(fst, prefix, hi, k, ^(const char *key, size_t len, uint64_t w) {
+                return blk(key, len, (w < fst->nkeys ? fst->strokes[w] : DINDEX_STROKES_UNKNOWN));
+            });
+        }
+
+        free(hi);
+        return total;
+    }
+
+    // Otherwise, keep the best `k` words we've seen in a max heap, as `dindex_prefix` does.
+    uint64_t *heap = (k ? malloc(k * sizeof(uint64_t)) : NULL);
+
+    if (k && !heap)
+    {
+        perror("malloc");
+        free(hi);
+
+        return 0;
+    }
+
+    __block size_t n = 0;
+
+    size_t total = _fst_iter(fst, prefix, hi, SIZE_MAX, ^(const char *key, size_t len, uint64_t w) {
+        if (w >= fst->nkeys || !k) { return 0; }
+
+        uint64_t packed = ((uint64_t)fst->strokes[w] << 32) | w;
+
+        if (n < k) {
+            heap[n++] = packed;
+
+            // Heapify once it's full.
+            if (n == k) {
+                for (size_t j = k / 2; j-- > 0; ) {
+                    _fst_sift(heap, n, j);
+                }
+            }
+        } else if (packed < heap[0]) {
+            heap[0] = packed;
+            _fst_sift(heap, n, 0);
+        }
+
+        return 0;
+    });
+
+    free(hi);
+
+    // Heapify in case we never filled up, then sort in place (ascending).
+    for (size_t j = n / 2; j-- > 0; ) {
+        _fst_sift(heap, n, j);
+    }
+
+    for (size_t end = n; end > 1; end--)
+    {
+        uint64_t tmp = heap[0];
+        heap[0] = heap[end - 1];
+        heap[end - 1] = tmp;
+
+        _fst_sift(heap, end - 1, 0);
+    }
+
+    // The FST only gives words while walking, so get them back from their first entry.
+    for (size_t i = 0; i < n; i++)
+    {
+        uint32_t w = (uint32_t)heap[i];
+        uint32_t first, count;
+
+        if (!_fst_word(fst, w, &first, &count) || !count || idx->rows[first] >= idx->nentries) { continue; }
+
+        const char *word = dindex_str(idx, idx->entries[idx->rows[first]].word);
+
+        if (blk(word, strlen(word), (uint32_t)(heap[i] >> 32))) {
+            break;
+        }
+    }
+
+    free(heap);
+    return total;
+}
+
+int fst_save(const struct fst *fst, const char *path)
+{
+    struct fst_header header;
+    mapfile_header_init(&header.file, FST_MAGIC, FST_VERSION, sizeof(struct fst_header));
+
+    header.root = fst->root;
+    header.nkeys = fst->nkeys;
+    header.nentries = fst->nentries;
+    header.words_hash = fst->words_hash;
+
+    mapfile_section(&header.file, &header.data,    fst->size);
+    mapfile_section(&header.file, &header.first,   (fst->first ? (fst->nkeys + 1) * sizeof(uint32_t) : 0));
+    mapfile_section(&header.file, &header.strokes, (fst->first ? fst->nkeys * sizeof(uint16_t) : 0));
+
+    int failed = mapfile_save(path, ^(FILE *fp) {
+        return (fwrite(&header, sizeof(struct fst_header), 1, fp) != 1)
+            || mapfile_write(fp, &header.data, fst->data)
+            || (fst->first && mapfile_write(fp, &header.first, fst->first))
+            || (fst->first && mapfile_write(fp, &header.strokes, fst->strokes));
+    });
+
+    if (failed) { return 1; }
+
+    if (DEBUG_FST) {
+        fprintf(stderr, "Wrote FST to '%s' (%llu bytes).\n", path, (unsigned long long)header.file.size);
+    }
+
+    return 0;
+}
+
+struct fst *fst_open(const char *path)
+{
+    size_t size;
+    void *map = mapfile_open(path, "FST", FST_MAGIC, FST_VERSION, sizeof(struct fst_header), &size);
+
+    if (!map) { return NULL; }
+
+    const struct fst_header *header = map;
+    const uint8_t *base = map;
+
+    bool ok = mapfile_section_ok(&header->file, &header->data, header->data.size) && (header->root < header->data.size);
+
+    // The word table is all or nothing.
+    bool words = (header->first.size != 0);
+
+    if (ok && words)
+    {
+        ok = (header->nkeys < UINT32_MAX && header->nentries <= UINT32_MAX)
+          && mapfile_section_ok(&header->file, &header->first, (header->nkeys + 1) * sizeof(uint32_t))
+          && mapfile_section_ok(&header->file, &header->strokes, header->nkeys * sizeof(uint16_t));
+    }
+
+    if (!ok) {
+        fprintf(stderr, "Error: FST file '%s' is corrupt!\n", path);
+    }
+
+    struct fst *fst = (ok ? calloc(1, sizeof(struct fst)) : NULL);
+
+    if (!fst)
+    {
+        if (ok) { perror("calloc"); }
+        mapfile_close(map, size);
+
+        return NULL;
+    }
+
+    fst->data = &base[header->data.offset];
+    fst->size = header->data.size;
+    fst->root = header->root;
+    fst->nkeys = header->nkeys;
+
+    if (words)
+    {
+        fst->first = (const uint32_t *)&base[header->first.offset];
+        fst->strokes = (const uint16_t *)&base[header->strokes.offset];
+        fst->nentries = header->nentries;
+        fst->words_hash = header->words_hash;
+    }
+
+    fst->map = map;
+    fst->map_size = size;
+
+    return fst;
+}
+
+void fst_free(struct fst *fst)
+{
+    if (fst->map) {
+        mapfile_close(fst->map, fst->map_size);
+    }
+
+    free(fst->buf);
+    free(fst->words_buf);
+    free(fst);
+}
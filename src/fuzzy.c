@@ -0,0 +1,354 @@
+/* ********************************************************** */
+/* -*- fuzzy.c -*- Approximate word lookup                -*- */
+/* ********************************************************** */
+/* Tyler Besselman (C) October 2026                           */
+/* ********************************************************** */
+
+#include <strings.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+#include <fuzzy.h>
+#include <utf8.h>
+
+// Longest word we ever need to decode (anything longer is filtered out by length first).
+#define FUZZY_BUF_LEN (FUZZY_MAX_LEN + FUZZY_MAX_DIST)
+
+// Decode up to `max` codepoints from a string. Returns the total number of codepoints (even if more than `max`).
+static size_t _fuzzy_decode(const char *str, uint32_t *out, size_t max)
+{
+    size_t n = 0;
+
+    while (*str)
+    {
+        uint32_t cp = utf8_next(&str);
+
+        if (n < max) {
+            out[n] = cp;
+        }
+
+        n++;
+    }
+
+    return n;
+}
+
+static int _fuzzy_pair_cmp(const void *a, const void *b)
+{
+    uint64_t x = *(const uint64_t *)a;
+    uint64_t y = *(const uint64_t *)b;
+
+    return (x > y) - (x < y);
+}
+
+struct fuzzy *fuzzy_build(const struct dindex *idx)
+{
+    struct fuzzy *fz = calloc(1, sizeof(struct fuzzy));
+
+    if (!fz)
+    {
+        perror("calloc");
+        return NULL;
+    }
+
+    fz->idx = idx;
+
+    // Collect every (codepoint, word) pair as a single key, so sorting groups words by codepoint in order.
+    size_t npairs = 0;
+    size_t cap = idx->nwords * 4 + 1;
+
+    uint64_t *pairs = malloc(cap * sizeof(uint64_t));
+    fz->lens = malloc(idx->nwords + 1);
+
+    if (!pairs || !fz->lens)
+    {
+        perror("malloc");
+
+        free(pairs);
+        fuzzy_free(fz);
+
+        return NULL;
+    }
+
+    for (uint32_t w = 0; w < idx->nwords; w++)
+    {
+        uint32_t cps[UINT8_MAX];
+        size_t len = _fuzzy_decode(dindex_str(idx, idx->words[w].str), cps, UINT8_MAX);
+
+        fz->lens[w] = (len > UINT8_MAX ? UINT8_MAX : len);
+
+        for (size_t i = 0; i < fz->lens[w]; i++)
+        {
+            bool seen = false;
+
+            for (size_t j = 0; j < i && !seen; j++) {
+                seen = (cps[j] == cps[i]);
+            }
+
+            if (seen) { continue; }
+
+            if (npairs == cap)
+            {
+                cap *= 2;
+                uint64_t *more = realloc(pairs, cap * sizeof(uint64_t));
+
+                if (!more)
+                {
+                    perror("realloc");
+
+                    free(pairs);
+                    fuzzy_free(fz);
+
+                    return NULL;
+                }
+
+                pairs = more;
+            }
+
+            pairs[npairs++] = ((uint64_t)cps[i] << 32) | w;
+        }
+    }
+
+    qsort(pairs, npairs, sizeof(uint64_t), _fuzzy_pair_cmp);
+
+    // Count distinct codepoints so we can size everything exactly.
+    uint32_t ncps = 0;
+
+    for (size_t i = 0; i < npairs; i++)
+    {
+        if (!i || (pairs[i] >> 32) != (pairs[i - 1] >> 32)) {
+            ncps++;
+        }
+    }
+
+    fz->cps = malloc(ncps * sizeof(uint32_t) + 1);
+    fz->offsets = malloc((ncps + 1) * sizeof(uint32_t));
+    fz->postings = malloc(npairs * sizeof(uint32_t) + 1);
+    fz->ncps = ncps;
+
+    if (!fz->cps || !fz->offsets || !fz->postings)
+    {
+        perror("malloc");
+
+        free(pairs);
+        fuzzy_free(fz);
+
+        return NULL;
+    }
+
+    uint32_t c = 0;
+
+    for (size_t i = 0; i < npairs; i++)
+    {
+        if (!i || (pairs[i] >> 32) != (pairs[i - 1] >> 32))
+        {
+            fz->cps[c] = pairs[i] >> 32;
+            fz->offsets[c++] = i;
+        }
+
+        fz->postings[i] = (uint32_t)pairs[i];
+    }
+
+    fz->offsets[ncps] = npairs;
+    free(pairs);
+
+    if (DEBUG_FUZZY) {
+        fprintf(stderr, "Fuzzy index has %u codepoints, %zu postings.\n", ncps, npairs);
+    }
+
+    return fz;
+}
+
+// Find the word list for a codepoint. Returns false if no word has it.
+static bool _fuzzy_postings(const struct fuzzy *fz, uint32_t cp, const uint32_t **start, const uint32_t **end)
+{
+    uint32_t lo = 0;
+    uint32_t hi = fz->ncps;
+
+    while (lo < hi)
+    {
+        uint32_t mid = lo + (hi - lo) / 2;
+
+        if (fz->cps[mid] < cp) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+
+    if (lo >= fz->ncps || fz->cps[lo] != cp) { return false; }
+
+    (*start) = &fz->postings[fz->offsets[lo]];
+    (*end) = &fz->postings[fz->offsets[lo + 1]];
+
+    return true;
+}
+
+// Levenshtein distance between two codepoint strings, giving up (and returning `max + 1`) once it must exceed `max`.
+static size_t _fuzzy_distance(const uint32_t *a, size_t n, const uint32_t *b, size_t m, size_t max)
+{
+    size_t row[FUZZY_BUF_LEN + 1];
+
+    for (size_t j = 0; j <= m; j++) {
+        row[j] = j;
+    }
+
+    for (size_t i = 1; i <= n; i++)
+    {
+        size_t diag = row[0];
+        size_t best = i;
+
+        row[0] = i;
+
+        for (size_t j = 1; j <= m; j++)
+        {
+            size_t up = row[j];
+            size_t cost = diag + (a[i - 1] != b[j - 1]);
+
+            if (up + 1 < cost) { cost = up + 1; }
+            if (row[j - 1] + 1 < cost) { cost = row[j - 1] + 1; }
+
+            diag = up;
+            row[j] = cost;
+
+            if (cost < best) { best = cost; }
+        }
+
+        // Every cell in a row is a lower bound for the final distance.
+        if (best > max) { return max + 1; }
+    }
+
+    return row[m];
+}
+
+size_t fuzzy_lookup(const struct fuzzy *fz, const char *word, size_t max_dist, size_t k, int (^blk)(const struct dindex_word *word, size_t dist))
+{
+    const struct dindex *idx = fz->idx;
+
+    uint32_t query[FUZZY_MAX_LEN];
+    size_t qlen = _fuzzy_decode(word, query, FUZZY_MAX_LEN);
+
+    if (!qlen || qlen > FUZZY_MAX_LEN || !k) { return 0; }
+    if (max_dist > FUZZY_MAX_DIST) { max_dist = FUZZY_MAX_DIST; }
+
+    // Walk the word lists for each distinct codepoint in the query together, in word order.
+    struct {
+        const uint32_t *next;
+        const uint32_t *end;
+    } lists[FUZZY_MAX_LEN];
+
+    size_t nlists = 0;
+    size_t distinct = 0;
+
+    for (size_t i = 0; i < qlen; i++)
+    {
+        bool seen = false;
+
+        for (size_t j = 0; j < i && !seen; j++) {
+            seen = (query[j] == query[i]);
+        }
+
+        if (seen) { continue; }
+
+        distinct++;
+
+        if (_fuzzy_postings(fz, query[i], &lists[nlists].next, &lists[nlists].end)) {
+            nlists++;
+        }
+    }
+
+    // The first `k` matches at each distance (words come in order, so these are the ones we want).
+    uint32_t *found = malloc((max_dist + 1) * k * sizeof(uint32_t));
+    size_t counts[FUZZY_MAX_DIST + 1] = { 0 };
+
+    if (!found)
+    {
+        perror("malloc");
+        return 0;
+    }
+
+    // Once we have `k` matches within some distance, anything further away is useless.
+    size_t cutoff = max_dist;
+    bool done = false;
+
+    while (!done)
+    {
+        uint32_t w = UINT32_MAX;
+
+        for (size_t i = 0; i < nlists; i++)
+        {
+            if (lists[i].next < lists[i].end && *lists[i].next < w) {
+                w = *lists[i].next;
+            }
+        }
+
+        if (w == UINT32_MAX) { break; }
+
+        // Count how many query codepoints this word has, moving past it in each list.
+        size_t shared = 0;
+
+        for (size_t i = 0; i < nlists; i++)
+        {
+            if (lists[i].next < lists[i].end && *lists[i].next == w)
+            {
+                lists[i].next++;
+                shared++;
+            }
+        }
+
+        if (shared + cutoff < distinct) { continue; }
+        if (fz->lens[w] > qlen + cutoff || fz->lens[w] + cutoff < qlen) { continue; }
+
+        uint32_t cps[FUZZY_BUF_LEN];
+        size_t len = _fuzzy_decode(dindex_str(idx, idx->words[w].str), cps, FUZZY_BUF_LEN);
+        size_t dist = _fuzzy_distance(query, qlen, cps, len, cutoff);
+
+        if (dist > cutoff || counts[dist] >= k) { continue; }
+
+        found[dist * k + counts[dist]++] = w;
+
+        // Tighten the cutoff to just below the nearest distance we have enough matches within.
+        size_t total = 0;
+
+        for (size_t d = 0; d <= cutoff; d++)
+        {
+            total += counts[d];
+
+            if (total >= k)
+            {
+                done = !d;
+                cutoff = d - 1;
+
+                break;
+            }
+        }
+    }
+
+    size_t n = 0;
+
+    for (size_t d = 0; d <= max_dist && n < k; d++)
+    {
+        for (size_t i = 0; i < counts[d] && n < k; i++)
+        {
+            n++;
+
+            if (blk(&idx->words[found[d * k + i]], d))
+            {
+                free(found);
+                return n;
+            }
+        }
+    }
+
+    free(found);
+    return n;
+}
+
+void fuzzy_free(struct fuzzy *fz)
+{
+    free(fz->cps);
+    free(fz->offsets);
+    free(fz->postings);
+    free(fz->lens);
+    free(fz);
+}
@@ -0,0 +1,868 @@
+/* ********************************************************** */
+/* -*- genxlsx.c -*- Generate synthetic dictionary XLSX   -*- */
+/* ********************************************************** */
+/* Tyler Besselman (C) October 2026                           */
+/* ********************************************************** */
+
+// Write a workbook shaped like the MOE dictionary (same headers, types, and sparse columns) with any number of rows,
+//   so loaders and converters can be measured well past the size of the real thing. The same seed always gives the same file.
+// Rows are written as they're generated (the sheet and string table go through temporary files), so memory use doesn't grow with
+//   the number of rows. Only small repeating values (attributes, radicals, single characters, and their readings) are shared.
+
+#include <strings.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+
+#include <metrics.h>
+#include <synth.h>
+#include <obuf.h>
+#include <fnv.h>
+#include <utf8.h>
+#include <xzip.h>
+
+// Characters are drawn from the CJK unified ideographs block (U+4E00 - U+9FA5).
+#define GEN_CHAR_BASE 0x4E00
+#define GEN_CHARS     20902
+
+// Percentage of rows which are single characters, and another reading of a recent word.
+#define GEN_SINGLE_PCT 10
+#define GEN_REPEAT_PCT 3
+
+// Percentage of words with a similar word, an opposite word, a variant reading, or a definition pointing at another word.
+#define GEN_SIMILAR_PCT 8
+#define GEN_OPPOSITE_PCT 3
+#define GEN_VARIANT_PCT 2
+#define GEN_XREF_PCT 5
+
+// Percentage of characters with a variant form.
+#define GEN_ALT_PCT 5
+
+// Number of recent words kept around for repeats and cross references (a power of 2).
+#define GEN_RECENT 4096
+
+// Longest word we make (in characters).
+#define GEN_WORD_MAX 12
+
+// Rows are written to the sheet once this many bytes are buffered.
+#define GEN_FLUSH 65536
+
+// Columns of the sheet, in the same order as the real dictionary.
+enum {
+    GEN_COL_ATTR,
+    GEN_COL_ID,
+    GEN_COL_WORD,
+    GEN_COL_NCHARS,
+    GEN_COL_RADICAL,
+    GEN_COL_STROKES,
+    GEN_COL_XSTROKES,
+    GEN_COL_PRON_ORD,
+    GEN_COL_ZHUYIN,
+    GEN_COL_VAR_TYPE,
+    GEN_COL_VAR_ZHUYIN,
+    GEN_COL_PINYIN,
+    GEN_COL_VAR_PINYIN,
+    GEN_COL_SIMILAR,
+    GEN_COL_OPPOSITE,
+    GEN_COL_DEF,
+    GEN_COL_XPRON,
+    GEN_COL_ALT,
+    GEN_NCOLS
+};
+
+static const char *const col_names[GEN_NCOLS] = {
+    [GEN_COL_ATTR]       = "字詞屬性",
+    [GEN_COL_ID]         = "字詞號",
+    [GEN_COL_WORD]       = "字詞名",
+    [GEN_COL_NCHARS]     = "字數",
+    [GEN_COL_RADICAL]    = "部首字",
+    [GEN_COL_STROKES]    = "總筆畫數",
+    [GEN_COL_XSTROKES]   = "部首外筆畫數",
+    [GEN_COL_PRON_ORD]   = "多音排序",
+    [GEN_COL_ZHUYIN]     = "注音一式",
+    [GEN_COL_VAR_TYPE]   = "變體類型 1:變 2:又音 3:語音 4:讀音",
+    [GEN_COL_VAR_ZHUYIN] = "變體注音",
+    [GEN_COL_PINYIN]     = "漢語拼音",
+    [GEN_COL_VAR_PINYIN] = "變體漢語拼音",
+    [GEN_COL_SIMILAR]    = "相似詞",
+    [GEN_COL_OPPOSITE]   = "相反詞",
+    [GEN_COL_DEF]        = "釋義",
+    [GEN_COL_XPRON]      = "多音參見訊息",
+    [GEN_COL_ALT]        = "異體字"
+};
+
+static const char *const var_types[] = { "1:變", "2:又音", "3:語音", "4:讀音" };
+
+// Radicals characters are filed under (with their stroke counts).
+static const struct { const char *str; int strokes; } radicals[] = {
+    { "人", 2 }, { "刀", 2 }, { "力", 2 }, { "口", 3 }, { "土", 3 }, { "女", 3 }, { "子", 3 }, { "宀", 3 },
+    { "山", 3 }, { "巾", 3 }, { "广", 3 }, { "彳", 3 }, { "心", 4 }, { "手", 4 }, { "攴", 4 }, { "日", 4 },
+    { "木", 4 }, { "水", 4 }, { "火", 4 }, { "犬", 4 }, { "玉", 5 }, { "田", 5 }, { "目", 5 }, { "石", 5 },
+    { "示", 5 }, { "禾", 5 }, { "竹", 6 }, { "米", 6 }, { "糸", 6 }, { "肉", 6 }, { "艸", 6 }, { "虫", 6 },
+    { "衣", 6 }, { "言", 7 }, { "貝", 7 }, { "足", 7 }, { "車", 7 }, { "辵", 7 }, { "金", 8 }, { "門", 8 },
+    { "阜", 8 }, { "雨", 8 }, { "頁", 9 }, { "食", 9 }, { "馬", 10 }, { "魚", 11 }, { "鳥", 11 }
+};
+
+// Syllables are an initial and a final. Pinyin for finals with no initial is spelled differently (`bare`).
+static const struct { const char *zhuyin; const char *pinyin; } initials[] = {
+    { "",   ""   }, { "ㄅ", "b"  }, { "ㄆ", "p"  }, { "ㄇ", "m"  }, { "ㄈ", "f"  }, { "ㄉ", "d"  }, { "ㄊ", "t"  },
+    { "ㄋ", "n"  }, { "ㄌ", "l"  }, { "ㄍ", "g"  }, { "ㄎ", "k"  }, { "ㄏ", "h"  }, { "ㄓ", "zh" }, { "ㄔ", "ch" },
+    { "ㄕ", "sh" }, { "ㄖ", "r"  }, { "ㄗ", "z"  }, { "ㄘ", "c"  }, { "ㄙ", "s"  }
+};
+
+static const struct { const char *zhuyin; const char *pinyin; const char *bare; } finals[] = {
+    { "ㄚ",   "a",   "a"    }, { "ㄛ",   "o",   "o"    }, { "ㄜ",   "e",   "e"    }, { "ㄞ",   "ai",  "ai"   },
+    { "ㄟ",   "ei",  "ei"   }, { "ㄠ",   "ao",  "ao"   }, { "ㄡ",   "ou",  "ou"   }, { "ㄢ",   "an",  "an"   },
+    { "ㄣ",   "en",  "en"   }, { "ㄤ",   "ang", "ang"  }, { "ㄥ",   "eng", "eng"  }, { "ㄨ",   "u",   "wu"   },
+    { "ㄨㄛ", "uo",  "wo"   }, { "ㄨㄢ", "uan", "wan"  }, { "ㄨㄥ", "ong", "weng" }
+};
+
+// Tone marks (for the four tones). Zhuyin marks follow the syllable, and pinyin marks go on a vowel.
+static const char *const zhuyin_tones[4] = { "", "ˊ", "ˇ", "ˋ" };
+
+static const char *const pinyin_tones[4][4] = {
+    { "ā", "á", "ǎ", "à" },
+    { "ē", "é", "ě", "è" },
+    { "ō", "ó", "ǒ", "ò" },
+    { "ū", "ú", "ǔ", "ù" }
+};
+
+#define countof(a) (sizeof(a) / sizeof((a)[0]))
+
+// The shared string table, written to a temporary file as strings are added.
+struct gen_strings {
+    FILE *fp;
+
+    // References to strings (from cells), and strings in the table.
+    uint64_t count;
+    uint32_t unique;
+
+    // Strings which are shared, and an open addressing hash table of (offset + 1) into `pool` and their index.
+    // `nslots` is a power of 2.
+    struct obuf pool;
+
+    uint32_t *slots;
+    uint32_t *srefs;
+    uint32_t nslots;
+    uint32_t nshared;
+};
+
+// A recent word, for other readings and cross references.
+struct gen_recent {
+    char word[GEN_WORD_MAX * 4 + 1];
+    uint32_t sref;
+
+    // Readings of this word so far.
+    uint32_t readings;
+};
+
+// Everything needed while generating rows.
+struct gen_state {
+    uint64_t rand;
+
+    struct gen_strings strings;
+
+    struct gen_recent recent[GEN_RECENT];
+    size_t nrecent;
+
+    // Number of times each character has been an entry.
+    uint32_t seen[GEN_CHARS];
+
+    // Buffers for the current row.
+    struct obuf zhuyin, pinyin;
+    struct obuf var_zhuyin, var_pinyin;
+    struct obuf scratch;
+};
+
+// A reading of a character (one syllable).
+struct gen_syllable {
+    uint8_t initial;
+    uint8_t final;
+    uint8_t tone;
+};
+
+// Pick a character. Low codepoints are much more common, so lots of words share characters (and prefixes).
+static uint32_t gen_char(uint64_t *state)
+{
+    double u = (double)(synth_rand(state) >> 11) / (double)(1ULL << 53);
+    return GEN_CHAR_BASE + (uint32_t)(u * u * u * GEN_CHARS);
+}
+
+// Fixed random bits for a character (and a reading of it), so a character always looks the same.
+static uint64_t char_bits(uint32_t cp, uint32_t k)
+{
+    uint64_t state = ((uint64_t)cp << 8) | k;
+    return synth_rand(&state);
+}
+
+static uint32_t char_readings(uint32_t cp)
+{
+    uint64_t pct = char_bits(cp, 0) % 100;
+    return 1 + (pct < 12) + (pct < 3);
+}
+
+static struct gen_syllable char_syllable(uint32_t cp, uint32_t k)
+{
+    uint64_t bits = char_bits(cp, k + 1);
+
+    return (struct gen_syllable){
+        .initial = bits % countof(initials),
+        .final = (bits >> 8) % countof(finals),
+        .tone = (bits >> 16) % 4
+    };
+}
+
+// Append a syllable's zhuyin.
+static int put_zhuyin(struct obuf *buf, struct gen_syllable syl)
+{
+    return (obuf_puts(buf, initials[syl.initial].zhuyin) || obuf_puts(buf, finals[syl.final].zhuyin) || obuf_puts(buf, zhuyin_tones[syl.tone]));
+}
+
+// Append a syllable's pinyin, with the tone mark on `a` or `e` if there is one, then `o`, then `u`.
+static int put_pinyin(struct obuf *buf, struct gen_syllable syl)
+{
+    const char *fin = (syl.initial ? finals[syl.final].pinyin : finals[syl.final].bare);
+
+    if (obuf_puts(buf, initials[syl.initial].pinyin)) { return 1; }
+
+    const char *mark = strpbrk(fin, "ae");
+    if (!mark) { mark = strchr(fin, 'o'); }
+    if (!mark) { mark = strchr(fin, 'u'); }
+
+    size_t vowel = (*mark == 'a' ? 0 : (*mark == 'e' ? 1 : (*mark == 'o' ? 2 : 3)));
+
+    return (obuf_append(buf, fin, mark - fin) || obuf_puts(buf, pinyin_tones[vowel][syl.tone]) || obuf_puts(buf, &mark[1]));
+}
+
+// Set `zhuyin` and `pinyin` to the readings of a word (reading `k` of the character at `alt`), with syllables separated like
+//   the real dictionary. Both are left `\0` terminated. Returns non-zero on failure.
+static int put_readings(struct obuf *zhuyin, struct obuf *pinyin, const char *word, size_t alt, uint32_t k)
+{
+    const char *p = word;
+
+    zhuyin->len = 0;
+    pinyin->len = 0;
+
+    for (size_t i = 0; *p; i++)
+    {
+        uint32_t cp = utf8_next(&p);
+        struct gen_syllable syl = char_syllable(cp, (i == alt ? k : 0));
+
+        // Another reading of a character which only has one just changes the tone.
+        if (i == alt && k >= char_readings(cp)) {
+            syl.tone = (syl.tone + k) % 4;
+        }
+
+        if (i && (obuf_puts(zhuyin, "　") || obuf_puts(pinyin, " "))) { return 1; }
+        if (put_zhuyin(zhuyin, syl) || put_pinyin(pinyin, syl)) { return 1; }
+    }
+
+    return (obuf_append(zhuyin, "", 1) || obuf_append(pinyin, "", 1));
+}
+
+// Append `n` random characters, with a comma every so often.
+static int put_text(struct obuf *buf, uint64_t *state, size_t n)
+{
+    char ch[4];
+
+    for (size_t i = 0; i < n; i++)
+    {
+        if (i && i + 1 < n && !synth_below(state, 9) && obuf_puts(buf, "，")) { return 1; }
+        if (obuf_append(buf, ch, utf8_encode(gen_char(state), ch))) { return 1; }
+    }
+
+    return 0;
+}
+
+// Make a word of `n` characters.
+static void gen_word(uint64_t *state, char *word, size_t n)
+{
+    for (size_t i = 0; i < n; i++) {
+        word += utf8_encode(gen_char(state), word);
+    }
+
+    (*word) = 0;
+}
+
+// Pick the length of a compound word (mostly 2 characters, then 4 character idioms, then 3).
+static size_t gen_word_len(uint64_t *state)
+{
+    uint64_t pct = synth_below(state, 100);
+
+    if (pct < 52) { return 2; }
+    if (pct < 70) { return 3; }
+    if (pct < 92) { return 4; }
+    if (pct < 97) { return 5 + synth_below(state, 3); }
+
+    return 8 + synth_below(state, GEN_WORD_MAX - 7);
+}
+
+// Pick a recent word (NULL if there aren't any yet).
+static struct gen_recent *gen_pick_recent(struct gen_state *gen)
+{
+    if (!gen->nrecent) { return NULL; }
+
+    size_t n = (gen->nrecent < GEN_RECENT ? gen->nrecent : GEN_RECENT);
+    return &gen->recent[(gen->nrecent - 1 - synth_below(&gen->rand, n)) & (GEN_RECENT - 1)];
+}
+
+// Append a definition. Single characters sometimes get a part of speech, and some words just point at another.
+static int put_def(struct obuf *buf, struct gen_state *gen, bool single)
+{
+    static const char *const parts[] = { "[名]", "[動]", "[形]", "[副]" };
+    static const char *const numbers[] = { "1.", "2.", "3.", "4.", "5." };
+
+    uint64_t *state = &gen->rand;
+    struct gen_recent *other = gen_pick_recent(gen);
+
+    if (!single && other && synth_below(state, 100) < GEN_XREF_PCT)
+    {
+        const char *fmt = (synth_below(state, 2) ? "同「%s」。" : "見「%s」條。");
+        return obuf_printf(buf, fmt, other->word);
+    }
+
+    if (single && synth_below(state, 2) && obuf_printf(buf, "%s\n", parts[synth_below(state, countof(parts))])) { return 1; }
+
+    uint64_t pct = synth_below(state, 100);
+    size_t senses = (pct < 65 ? 1 : (pct < 90 ? 2 : 3 + synth_below(state, 3)));
+
+    for (size_t s = 0; s < senses; s++)
+    {
+        if (s && obuf_puts(buf, "\n")) { return 1; }
+        if (obuf_printf(buf, "%s　", numbers[s]) || put_text(buf, state, 6 + synth_below(state, 35))) { return 1; }
+
+        if (other && synth_below(state, 100) < 30) {
+            if (obuf_printf(buf, "。如：「%s」", other->word)) { return 1; }
+        }
+
+        if (obuf_puts(buf, "。")) { return 1; }
+    }
+
+    return 0;
+}
+
+static uint32_t pow2(uint32_t n)
+{
+    uint32_t p = 16;
+
+    while (p < n) {
+        p *= 2;
+    }
+
+    return p;
+}
+
+// Add a string to the table (no string we make needs escaping), returning its index.
+static uint32_t strings_add(struct gen_strings *strs, const char *str)
+{
+    strs->count++;
+
+    fputs("<si><t>", strs->fp);
+    fputs(str, strs->fp);
+    fputs("</t></si>", strs->fp);
+
+    return strs->unique++;
+}
+
+// Add a string to the table only if it isn't there already, returning its index (`UINT32_MAX` on failure).
+static uint32_t strings_share(struct gen_strings *strs, const char *str)
+{
+    if (strs->nshared >= strs->nslots / 4 * 3)
+    {
+        // Grow the table, putting everything back in.
+        uint32_t nslots = pow2(strs->nslots * 2);
+        uint32_t *slots = calloc(nslots, sizeof(uint32_t));
+        uint32_t *srefs = calloc(nslots, sizeof(uint32_t));
+
+        if (!slots || !srefs)
+        {
+            perror("calloc");
+
+            free(slots);
+            free(srefs);
+
+            return UINT32_MAX;
+        }
+
+        for (uint32_t i = 0; i < strs->nslots; i++)
+        {
+            if (!strs->slots[i]) { continue; }
+
+            const char *other = &strs->pool.data[strs->slots[i] - 1];
+            uint32_t s = fnv1a(FNV_INIT, other, strlen(other)) & (nslots - 1);
+
+            while (slots[s]) {
+                s = (s + 1) & (nslots - 1);
+            }
+
+            slots[s] = strs->slots[i];
+            srefs[s] = strs->srefs[i];
+        }
+
+        free(strs->slots);
+        free(strs->srefs);
+
+        strs->slots = slots;
+        strs->srefs = srefs;
+        strs->nslots = nslots;
+    }
+
+    size_t len = strlen(str);
+    uint32_t mask = strs->nslots - 1;
+    uint32_t s = fnv1a(FNV_INIT, str, len) & mask;
+
+    for ( ; strs->slots[s]; s = (s + 1) & mask)
+    {
+        if (!strcmp(&strs->pool.data[strs->slots[s] - 1], str))
+        {
+            strs->count++;
+            return strs->srefs[s];
+        }
+    }
+
+    uint32_t off = strs->pool.len;
+    if (obuf_append(&strs->pool, str, len + 1)) { return UINT32_MAX; }
+
+    strs->slots[s] = off + 1;
+    strs->srefs[s] = strings_add(strs, str);
+    strs->nshared++;
+
+    return strs->srefs[s];
+}
+
+// Header of the string table. Counts are rewritten in place once we know them, so they're zero padded to a fixed width.
+#define SST_HEADER "<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"yes\"?>\n"                            \
+                   "<sst xmlns=\"http://schemas.openxmlformats.org/spreadsheetml/2006/main\" count=\"%010llu\" " \
+                   "uniqueCount=\"%010llu\">"
+
+// Append a cell holding a number.
+static int put_int(struct obuf *row, size_t col, size_t r, long long v)
+{ return obuf_printf(row, "<c r=\"%c%zu\"><v>%lld</v></c>", (char)('A' + col), r, v); }
+
+// Append a cell holding a string from the table.
+static int put_sref(struct obuf *row, size_t col, size_t r, uint32_t sref)
+{ return (sref == UINT32_MAX || obuf_printf(row, "<c r=\"%c%zu\" t=\"s\"><v>%u</v></c>", (char)('A' + col), r, sref)); }
+
+// Append a cell holding a new string.
+static int put_str(struct gen_state *gen, struct obuf *row, size_t col, size_t r, const char *str)
+{ return put_sref(row, col, r, strings_add(&gen->strings, str)); }
+
+// Append a cell holding a string which is shared with any other cell holding the same string.
+static int put_share(struct gen_state *gen, struct obuf *row, size_t col, size_t r, const char *str)
+{ return put_sref(row, col, r, strings_share(&gen->strings, str)); }
+
+// Generate the row numbered `r` in the sheet for entry `id`, appending its cells to `row`. Returns non-zero on failure.
+static int gen_row(struct gen_state *gen, struct obuf *row, size_t r, size_t id)
+{
+    uint64_t *state = &gen->rand;
+    uint64_t kind = synth_below(state, 100);
+
+    struct gen_recent *repeat = (kind < GEN_REPEAT_PCT ? gen_pick_recent(gen) : NULL);
+    bool single = (!repeat && kind < GEN_REPEAT_PCT + GEN_SINGLE_PCT);
+
+    char word[GEN_WORD_MAX * 4 + 1];
+    uint32_t word_sref;
+    uint32_t cp = 0;
+
+    // Which reading of the word this is (of the character at `alt`), and how many it has so far.
+    uint32_t reading = 0;
+    uint32_t readings = 1;
+    size_t alt = 0;
+
+    if (repeat) {
+        // Another reading of a recent word (which shares the same string).
+        strcpy(word, repeat->word);
+        word_sref = repeat->sref;
+
+        reading = repeat->readings++;
+        readings = repeat->readings;
+        alt = synth_below(state, utf8_count(word));
+    } else if (single) {
+        cp = gen_char(state);
+        word[utf8_encode(cp, word)] = 0;
+
+        readings = char_readings(cp);
+        reading = gen->seen[cp - GEN_CHAR_BASE]++ % readings;
+        word_sref = strings_share(&gen->strings, word);
+    } else {
+        gen_word(state, word, gen_word_len(state));
+        word_sref = strings_add(&gen->strings, word);
+    }
+
+    if (obuf_printf(row, "<row r=\"%zu\">", r) || put_share(gen, row, GEN_COL_ATTR, r, (single ? "單字" : "複詞"))) { return 1; }
+    if (put_int(row, GEN_COL_ID, r, id) || put_sref(row, GEN_COL_WORD, r, word_sref)) { return 1; }
+    if (put_int(row, GEN_COL_NCHARS, r, utf8_count(word))) { return 1; }
+
+    if (single)
+    {
+        uint64_t bits = char_bits(cp, 0);
+        size_t rad = (bits >> 8) % countof(radicals);
+        int xstrokes = (bits >> 16) % 18;
+
+        if (put_share(gen, row, GEN_COL_RADICAL, r, radicals[rad].str)) { return 1; }
+        if (put_int(row, GEN_COL_STROKES, r, radicals[rad].strokes + xstrokes) || put_int(row, GEN_COL_XSTROKES, r, xstrokes)) { return 1; }
+    }
+
+    if (readings > 1 && put_int(row, GEN_COL_PRON_ORD, r, reading + 1)) { return 1; }
+
+    // Readings of single characters repeat a lot, so they're shared.
+    int (*put_reading)(struct gen_state *, struct obuf *, size_t, size_t, const char *) = (single ? put_share : put_str);
+    bool variant = (synth_below(state, 100) < GEN_VARIANT_PCT);
+
+    if (put_readings(&gen->zhuyin, &gen->pinyin, word, alt, reading)) { return 1; }
+    if (variant && put_readings(&gen->var_zhuyin, &gen->var_pinyin, word, 0, 1 + synth_below(state, 3))) { return 1; }
+
+    if (put_reading(gen, row, GEN_COL_ZHUYIN, r, gen->zhuyin.data)) { return 1; }
+
+    if (variant)
+    {
+        if (put_share(gen, row, GEN_COL_VAR_TYPE, r, var_types[synth_below(state, countof(var_types))])) { return 1; }
+        if (put_str(gen, row, GEN_COL_VAR_ZHUYIN, r, gen->var_zhuyin.data)) { return 1; }
+    }
+
+    if (put_reading(gen, row, GEN_COL_PINYIN, r, gen->pinyin.data)) { return 1; }
+    if (variant && put_str(gen, row, GEN_COL_VAR_PINYIN, r, gen->var_pinyin.data)) { return 1; }
+
+    // Similar and opposite words are a few recent words.
+    const size_t related[] = { GEN_COL_SIMILAR, GEN_COL_OPPOSITE };
+    const uint64_t related_pct[] = { GEN_SIMILAR_PCT, GEN_OPPOSITE_PCT };
+
+    struct obuf *scratch = &gen->scratch;
+
+    for (size_t i = 0; i < countof(related); i++)
+    {
+        if (single || !gen->nrecent || synth_below(state, 100) >= related_pct[i]) { continue; }
+
+        size_t n = 1 + synth_below(state, 3);
+        scratch->len = 0;
+
+        for (size_t j = 0; j < n; j++)
+        {
+            if (j && obuf_puts(scratch, "、")) { return 1; }
+            if (obuf_puts(scratch, gen_pick_recent(gen)->word)) { return 1; }
+        }
+
+        if (obuf_append(scratch, "", 1) || put_str(gen, row, related[i], r, scratch->data)) { return 1; }
+    }
+
+    scratch->len = 0;
+
+    if (put_def(scratch, gen, single) || obuf_append(scratch, "", 1) || put_str(gen, row, GEN_COL_DEF, r, scratch->data)) { return 1; }
+
+    // Characters with more than one reading list all of them.
+    if (single && readings > 1)
+    {
+        static const char *const numbers[] = { "（一）", "（二）", "（三）" };
+
+        scratch->len = 0;
+
+        for (uint32_t k = 0; k < readings; k++)
+        {
+            if (k && obuf_puts(scratch, "　")) { return 1; }
+            if (obuf_puts(scratch, numbers[k]) || put_zhuyin(scratch, char_syllable(cp, k))) { return 1; }
+        }
+
+        if (obuf_append(scratch, "", 1) || put_share(gen, row, GEN_COL_XPRON, r, scratch->data)) { return 1; }
+    }
+
+    if (single && synth_below(state, 100) < GEN_ALT_PCT)
+    {
+        char alt_char[5];
+        alt_char[utf8_encode(gen_char(state), alt_char)] = 0;
+
+        if (put_share(gen, row, GEN_COL_ALT, r, alt_char)) { return 1; }
+    }
+
+    // Remember compound words for repeats and cross references.
+    if (!single && !repeat)
+    {
+        struct gen_recent *slot = &gen->recent[gen->nrecent++ & (GEN_RECENT - 1)];
+
+        strcpy(slot->word, word);
+        slot->sref = word_sref;
+        slot->readings = 1;
+    }
+
+    return obuf_puts(row, "</row>");
+}
+
+// Write the sheet and string table for `rows` entries to temporary files. Returns non-zero on failure.
+static int gen_sheet(struct gen_state *gen, size_t rows, FILE *sheet)
+{
+    struct obuf row = OBUF_INIT;
+
+    struct metrics m;
+    metrics_init(&m, "genxlsx", rows);
+
+    int status = (fprintf(gen->strings.fp, SST_HEADER, 0ULL, 0ULL) < 0);
+
+    status = status || obuf_puts(&row, "<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"yes\"?>\n"
+                                       "<worksheet xmlns=\"http://schemas.openxmlformats.org/spreadsheetml/2006/main\" "
+                                       "xmlns:r=\"http://schemas.openxmlformats.org/officeDocument/2006/relationships\">");
+
+    status = status || obuf_printf(&row, "<dimension ref=\"A1:%c%zu\"/><sheetData><row r=\"1\">", (char)('A' + GEN_NCOLS - 1), rows + 1);
+
+    for (size_t c = 0; !status && c < GEN_NCOLS; c++) {
+        status = put_sref(&row, c, 1, strings_share(&gen->strings, col_names[c]));
+    }
+
+    status = status || obuf_puts(&row, "</row>");
+
+    size_t id = 1;
+
+    for (size_t r = 1; !status && r <= rows; r++)
+    {
+        size_t start = row.len;
+
+        status = gen_row(gen, &row, r + 1, id);
+        metrics_step(&m, row.len - start);
+
+        // Some numbers are skipped, like in the real dictionary.
+        id += 1 + (synth_below(&gen->rand, 100) ? 0 : 1 + synth_below(&gen->rand, 3));
+
+        if (!status && row.len >= GEN_FLUSH) {
+            status = obuf_flush(&row, sheet);
+        }
+    }
+
+    status = status || obuf_puts(&row, "</sheetData></worksheet>") || obuf_flush(&row, sheet);
+    status = status || fputs("</sst>", gen->strings.fp) < 0;
+
+    // Now we know how many strings there are.
+    if (!status)
+    {
+        status = (fseek(gen->strings.fp, 0, SEEK_SET) ||
+                  fprintf(gen->strings.fp, SST_HEADER, (unsigned long long)gen->strings.count, (unsigned long long)gen->strings.unique) < 0);
+    }
+
+    status = status || fflush(gen->strings.fp) || fflush(sheet) || ferror(gen->strings.fp) || ferror(sheet);
+
+    if (status) {
+        fprintf(stderr, "Error: Failed to write sheet data!\n");
+    }
+
+    metrics_finish(&m, status);
+
+    obuf_free(&row);
+    return status;
+}
+
+// Fixed parts of the workbook.
+static const char *const content_types =
+    "<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"yes\"?>\n"
+    "<Types xmlns=\"http://schemas.openxmlformats.org/package/2006/content-types\">"
+    "<Default Extension=\"rels\" ContentType=\"application/vnd.openxmlformats-package.relationships+xml\"/>"
+    "<Default Extension=\"xml\" ContentType=\"application/xml\"/>"
+    "<Override PartName=\"/xl/workbook.xml\" ContentType=\"application/vnd.openxmlformats-officedocument.spreadsheetml.sheet.main+xml\"/>"
+    "<Override PartName=\"/xl/worksheets/sheet1.xml\" ContentType=\"application/vnd.openxmlformats-officedocument.spreadsheetml.worksheet+xml\"/>"
+    "<Override PartName=\"/xl/sharedStrings.xml\" ContentType=\"application/vnd.openxmlformats-officedocument.spreadsheetml.sharedStrings+xml\"/>"
+    "</Types>";
+
+static const char *const package_rels =
+    "<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"yes\"?>\n"
+    "<Relationships xmlns=\"http://schemas.openxmlformats.org/package/2006/relationships\">"
+    "<Relationship Id=\"rId1\" Type=\"http://schemas.openxmlformats.org/officeDocument/2006/relationships/officeDocument\" Target=\"xl/workbook.xml\"/>"
+    "</Relationships>";
+
+static const char *const workbook =
+    "<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"yes\"?>\n"
+    "<workbook xmlns=\"http://schemas.openxmlformats.org/spreadsheetml/2006/main\" "
+    "xmlns:r=\"http://schemas.openxmlformats.org/officeDocument/2006/relationships\">"
+    "<sheets><sheet name=\"Sheet1\" sheetId=\"1\" r:id=\"rId1\"/></sheets>"
+    "</workbook>";
+
+static const char *const workbook_rels =
+    "<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"yes\"?>\n"
+    "<Relationships xmlns=\"http://schemas.openxmlformats.org/package/2006/relationships\">"
+    "<Relationship Id=\"rId1\" Type=\"http://schemas.openxmlformats.org/officeDocument/2006/relationships/worksheet\" Target=\"worksheets/sheet1.xml\"/>"
+    "<Relationship Id=\"rId2\" Type=\"http://schemas.openxmlformats.org/officeDocument/2006/relationships/sharedStrings\" Target=\"sharedStrings.xml\"/>"
+    "</Relationships>";
+
+// Add a file to an archive, compressed at `level` (0 stores it). The source is freed either way. Returns non-zero on failure.
+static int zadd(zip_t *archive, const char *name, zip_source_t *src, int level)
+{
+    if (!src)
+    {
+        zerror("zip_source", archive);
+        return 1;
+    }
+
+    zip_int64_t i = zip_file_add(archive, name, src, ZIP_FL_ENC_UTF_8 | ZIP_FL_OVERWRITE);
+
+    if (i < 0)
+    {
+        zerror("zip_file_add", archive);
+        zip_source_free(src);
+
+        return 1;
+    }
+
+    if (zip_set_file_compression(archive, i, (level ? ZIP_CM_DEFLATE : ZIP_CM_STORE), level))
+    {
+        zerror("zip_set_file_compression", archive);
+        return 1;
+    }
+
+    return 0;
+}
+
+// Add a temporary file to an archive (which owns it after this, even on failure). Returns non-zero on failure.
+static int zadd_file(zip_t *archive, const char *name, FILE *fp, int level)
+{
+    zip_source_t *src = zip_source_filep(archive, fp, 0, -1);
+
+    if (!src) { fclose(fp); }
+    return zadd(archive, name, src, level);
+}
+
+// Generate a workbook with `rows` entries at `path`. Returns non-zero on failure.
+static int genxlsx(const char *path, size_t rows, uint64_t seed, int level)
+{
+    struct gen_state *gen = calloc(1, sizeof(struct gen_state));
+
+    FILE *sheet = tmpfile();
+    FILE *sst = tmpfile();
+
+    if (!gen || !sheet || !sst)
+    {
+        perror(gen ? "tmpfile" : "calloc");
+
+        if (sheet) { fclose(sheet); }
+        if (sst) { fclose(sst); }
+
+        free(gen);
+        return 1;
+    }
+
+    // Everything else starts out zeroed (which is an empty `obuf`).
+    gen->rand = seed;
+    gen->strings.fp = sst;
+
+    int status = gen_sheet(gen, rows, sheet);
+
+    uint64_t count = gen->strings.count;
+    uint32_t unique = gen->strings.unique;
+
+    obuf_free(&gen->strings.pool);
+    free(gen->strings.slots);
+    free(gen->strings.srefs);
+
+    obuf_free(&gen->zhuyin);
+    obuf_free(&gen->pinyin);
+    obuf_free(&gen->var_zhuyin);
+    obuf_free(&gen->var_pinyin);
+    obuf_free(&gen->scratch);
+
+    free(gen);
+
+    int error;
+    zip_t *archive = (status ? NULL : zip_open(path, ZIP_CREATE | ZIP_TRUNCATE, &error));
+
+    if (!archive)
+    {
+        if (!status) { _zerror("zip_open", error); }
+
+        fclose(sheet);
+        fclose(sst);
+
+        return 1;
+    }
+
+    // Small parts are always compressed.
+    const struct { const char *name; const char *data; } parts[] = {
+        { "[Content_Types].xml",        content_types },
+        { "_rels/.rels",                package_rels  },
+        { "xl/workbook.xml",            workbook      },
+        { "xl/_rels/workbook.xml.rels", workbook_rels }
+    };
+
+    for (size_t i = 0; !status && i < countof(parts); i++) {
+        status = zadd(archive, parts[i].name, zip_source_buffer(archive, parts[i].data, strlen(parts[i].data), 0), 9);
+    }
+
+    // The archive owns these once they're added.
+    if (!status)
+    {
+        status = zadd_file(archive, "xl/worksheets/sheet1.xml", sheet, level);
+        sheet = NULL;
+    }
+
+    if (!status)
+    {
+        status = zadd_file(archive, "xl/sharedStrings.xml", sst, level);
+        sst = NULL;
+    }
+
+    // Everything is actually compressed and written here.
+    if (!status && zip_close(archive))
+    {
+        zerror("zip_close", archive);
+        status = 1;
+    }
+
+    if (status) { zip_discard(archive); }
+    if (sheet) { fclose(sheet); }
+    if (sst) { fclose(sst); }
+
+    if (!status) {
+        printf("Wrote %zu rows (%u distinct strings, %llu references) to '%s'.\n", rows, unique, (unsigned long long)count, path);
+    }
+
+    return status;
+}
+
+// Parse a row count like `5000`, `200k`, or `10M`. Returns 0 if it isn't one.
+static size_t parse_rows(const char *str)
+{
+    char *end;
+    unsigned long long n = strtoull(str, &end, 10);
+
+    if (end == str) { return 0; }
+
+    if (!strcasecmp(end, "k")) {
+        n *= 1000;
+    } else if (!strcasecmp(end, "m")) {
+        n *= 1000000;
+    } else if (end[0]) {
+        return 0;
+    }
+
+    return n;
+}
+
+int main(int argc, const char *const *argv)
+{
+    uint64_t seed = 1;
+    int level = 6;
+    int i = 1;
+
+    for ( ; i + 1 < argc && (!strcmp(argv[i], "-s") || !strcmp(argv[i], "-z")); i += 2)
+    {
+        char *end;
+        unsigned long long v = strtoull(argv[i + 1], &end, 10);
+
+        if (end == argv[i + 1] || end[0] || (argv[i][1] == 'z' && v > 9))
+        {
+            fprintf(stderr, "Error: Bad value '%s' for %s!\n", argv[i + 1], argv[i]);
+            return 1;
+        }
+
+        if (argv[i][1] == 's') {
+            seed = v;
+        } else {
+            level = (int)v;
+        }
+    }
+
+    size_t rows = (argc - i == 2 ? parse_rows(argv[i]) : 0);
+
+    if (!rows)
+    {
+        fprintf(stderr, "Usage: %s [-s seed] [-z level] rows out.xlsx\n", argv[0]);
+        fprintf(stderr, "       Rows may have a k or M suffix (e.g. 10M). Level 0 stores the sheet uncompressed.\n");
+
+        return 1;
+    }
+
+    return genxlsx(argv[i + 1], rows, seed, level);
+}
@@ -0,0 +1,82 @@
+/* ********************************************************** */
+/* -*- hist.c -*- Log-linear latency histograms           -*- */
+/* ********************************************************** */
+/* Tyler Besselman (C) October 2026                           */
+/* ********************************************************** */
+
+#include <strings.h>
+#include <string.h>
+#include <math.h>
+
+#include <hist.h>
+
+void hist_init(struct hist *h)
+{
+    memset(h, 0, sizeof(struct hist));
+    h->min = UINT64_MAX;
+}
+
+void hist_merge(struct hist *dst, const struct hist *src)
+{
+    for (size_t i = 0; i < HIST_BUCKETS; i++) {
+        dst->counts[i] += src->counts[i];
+    }
+
+    dst->count += src->count;
+    dst->sum += src->sum;
+
+    if (src->min < dst->min) { dst->min = src->min; }
+    if (src->max > dst->max) { dst->max = src->max; }
+}
+
+uint64_t hist_bucket_max(size_t bucket)
+{
+    if (bucket < HIST_SUB_COUNT) { return bucket; }
+
+    // Undo `hist_bucket`: the group gives the shift, and the rest gives the top bits of the value.
+    unsigned int shift = (bucket >> HIST_SUB_BITS) - 1;
+    uint64_t top = (bucket & (HIST_SUB_COUNT - 1)) | HIST_SUB_COUNT;
+
+    return ((top + 1) << shift) - 1;
+}
+
+uint64_t hist_percentile(const struct hist *h, double p)
+{
+    if (!h->count) { return 0; }
+
+    // The rank of the value we want (at least the first one).
+    uint64_t rank = (uint64_t)ceil((p / 100.0) * h->count);
+    if (!rank) { rank = 1; }
+
+    uint64_t seen = 0;
+
+    for (size_t i = 0; i < HIST_BUCKETS; i++)
+    {
+        seen += h->counts[i];
+
+        if (seen >= rank)
+        {
+            // Buckets can extend past anything actually recorded.
+            uint64_t value = hist_bucket_max(i);
+            return (value > h->max ? h->max : value);
+        }
+    }
+
+    return h->max;
+}
+
+double hist_mean(const struct hist *h)
+{ return (h->count ? (double)h->sum / h->count : 0.0); }
+
+void hist_print_ns(FILE *out, uint64_t ns, int width)
+{
+    if (ns < 10000) {
+        fprintf(out, "%*lluns", width - 2, (unsigned long long)ns);
+    } else if (ns < 10000000) {
+        fprintf(out, "%*.1fus", width - 2, ns / 1e3);
+    } else if (ns < 10000000000ULL) {
+        fprintf(out, "%*.1fms", width - 2, ns / 1e6);
+    } else {
+        fprintf(out, "%*.2fs ", width - 2, ns / 1e9);
+    }
+}
@@ -0,0 +1,242 @@
+/* ********************************************************** */
+/* -*- json.c -*- Minimal JSON reading and writing        -*- */
+/* ********************************************************** */
+/* Tyler Besselman (C) October 2026                           */
+/* ********************************************************** */
+
+#include <strings.h>
+#include <string.h>
+#include <stdlib.h>
+
+#include <escape.h>
+#include <json.h>
+#include <utf8.h>
+
+// Enable debug messages
+#define DEBUG_JSON 0
+
+// Position in the object currently being parsed.
+struct _json_parser {
+    const char *p;
+    const char *end;
+
+    // Decoded strings are written here (it has room for everything already).
+    char *out;
+};
+
+static void _json_ws(struct _json_parser *ps)
+{
+    while (ps->p < ps->end && (*ps->p == ' ' || *ps->p == '\t' || *ps->p == '\n' || *ps->p == '\r')) {
+        ps->p++;
+    }
+}
+
+// Parse 4 hex digits of a `\u` escape.
+static int _json_hex4(struct _json_parser *ps, uint32_t *value)
+{
+    if (ps->end - ps->p < 4) { return 1; }
+
+    (*value) = 0;
+
+    for (int i = 0; i < 4; i++)
+    {
+        char c = *ps->p++;
+        (*value) <<= 4;
+
+        if (c >= '0' && c <= '9') {
+            (*value) |= c - '0';
+        } else if (c >= 'a' && c <= 'f') {
+            (*value) |= c - 'a' + 10;
+        } else if (c >= 'A' && c <= 'F') {
+            (*value) |= c - 'A' + 10;
+        } else {
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+// Decode the string at the current position (starting at the opening quote).
+// The decoded string is never longer than the quoted input, so it always fits in the output.
+static int _json_str(struct _json_parser *ps, const char **str, size_t *len)
+{
+    if (ps->p >= ps->end || *ps->p != '"') { return 1; }
+    ps->p++;
+
+    char *start = ps->out;
+
+    while (ps->p < ps->end && *ps->p != '"')
+    {
+        const char *run = ps->p;
+
+        // Copy everything up to the next escape or quote in one go.
+        while (ps->p < ps->end && *ps->p != '"' && *ps->p != '\\')
+        {
+            // Raw control characters aren't allowed in strings.
+            if ((unsigned char)*ps->p < 0x20) { return 1; }
+
+            ps->p++;
+        }
+
+        memcpy(ps->out, run, ps->p - run);
+        ps->out += ps->p - run;
+
+        if (ps->p >= ps->end || *ps->p == '"') { break; }
+
+        // Skip the backslash.
+        if (++ps->p >= ps->end) { return 1; }
+
+        uint32_t cp;
+
+        switch (*ps->p++)
+        {
+            case '"':  *ps->out++ = '"';  break;
+            case '\\': *ps->out++ = '\\'; break;
+            case '/':  *ps->out++ = '/';  break;
+            case 'b':  *ps->out++ = '\b'; break;
+            case 'f':  *ps->out++ = '\f'; break;
+            case 'n':  *ps->out++ = '\n'; break;
+            case 'r':  *ps->out++ = '\r'; break;
+            case 't':  *ps->out++ = '\t'; break;
+            case 'u':
+                if (_json_hex4(ps, &cp)) { return 1; }
+
+                // Characters outside the BMP come as a surrogate pair.
+                if (cp >= 0xD800 && cp < 0xDC00)
+                {
+                    uint32_t lo;
+
+                    if (ps->end - ps->p < 2 || ps->p[0] != '\\' || ps->p[1] != 'u') { return 1; }
+                    ps->p += 2;
+
+                    if (_json_hex4(ps, &lo) || lo < 0xDC00 || lo >= 0xE000) { return 1; }
+                    cp = 0x10000 + ((cp - 0xD800) << 10) + (lo - 0xDC00);
+                } else if (cp >= 0xDC00 && cp < 0xE000) {
+                    return 1;
+                }
+
+                ps->out += utf8_encode(cp, ps->out);
+                break;
+            default:
+                return 1;
+        }
+    }
+
+    if (ps->p >= ps->end) { return 1; }
+    ps->p++;
+
+    (*str) = start;
+    (*len) = ps->out - start;
+    *ps->out++ = 0;
+
+    return 0;
+}
+
+// Check if the input at the current position starts with a literal, consuming it if so.
+static bool _json_literal(struct _json_parser *ps, const char *lit)
+{
+    size_t len = strlen(lit);
+
+    if ((size_t)(ps->end - ps->p) < len || memcmp(ps->p, lit, len)) { return false; }
+
+    ps->p += len;
+    return true;
+}
+
+static int _json_value(struct _json_parser *ps, struct json_value *val)
+{
+    (*val) = (struct json_value){ .raw = ps->p };
+
+    if (ps->p >= ps->end) { return 1; }
+
+    if (*ps->p == '"') {
+        val->type = JSON_STRING;
+        if (_json_str(ps, &val->str, &val->len)) { return 1; }
+    } else if (_json_literal(ps, "true")) {
+        val->type = JSON_BOOL;
+        val->b = true;
+    } else if (_json_literal(ps, "false")) {
+        val->type = JSON_BOOL;
+    } else if (_json_literal(ps, "null")) {
+        val->type = JSON_NULL;
+    } else if (*ps->p == '-' || (*ps->p >= '0' && *ps->p <= '9')) {
+        // strtod needs a terminated string, so copy the number out first.
+        const char *start = ps->p;
+        char num[64];
+
+        while (ps->p < ps->end && strchr("+-.0123456789eE", *ps->p)) {
+            ps->p++;
+        }
+
+        if ((size_t)(ps->p - start) >= sizeof(num)) { return 1; }
+
+        memcpy(num, start, ps->p - start);
+        num[ps->p - start] = 0;
+
+        char *end;
+        val->type = JSON_NUMBER;
+        val->num = strtod(num, &end);
+
+        if ((*end)) { return 1; }
+    } else {
+        // Nested objects and arrays aren't supported.
+        if (DEBUG_JSON) {
+            fprintf(stderr, "Error: Unsupported JSON value starting with '%c'.\n", *ps->p);
+        }
+
+        return 1;
+    }
+
+    val->raw_len = ps->p - val->raw;
+    return 0;
+}
+
+int json_object(const char *json, size_t len, struct obuf *scratch, int (^blk)(const char *key, const struct json_value *val))
+{
+    // Decoded strings (with terminators) always fit in the space taken by the input.
+    scratch->len = 0;
+    if (obuf_reserve(scratch, len + 1)) { return 1; }
+
+    struct _json_parser ps = { .p = json, .end = json + len, .out = scratch->data };
+
+    _json_ws(&ps);
+    if (ps.p >= ps.end || *ps.p++ != '{') { return 1; }
+    _json_ws(&ps);
+
+    if (ps.p < ps.end && *ps.p == '}') {
+        ps.p++;
+    } else {
+        for (;;)
+        {
+            const char *key;
+            size_t key_len;
+            struct json_value val;
+
+            if (_json_str(&ps, &key, &key_len)) { return 1; }
+            _json_ws(&ps);
+
+            if (ps.p >= ps.end || *ps.p++ != ':') { return 1; }
+            _json_ws(&ps);
+
+            if (_json_value(&ps, &val) || blk(key, &val)) { return 1; }
+            _json_ws(&ps);
+
+            if (ps.p >= ps.end) { return 1; }
+            if (*ps.p == '}') { ps.p++; break; }
+            if (*ps.p++ != ',') { return 1; }
+
+            _json_ws(&ps);
+        }
+    }
+
+    // Nothing but whitespace may follow the object.
+    _json_ws(&ps);
+    return (ps.p != ps.end);
+}
+
+int json_string_n(struct obuf *out, const char *str, size_t len)
+{ return escape_field(out, ESCAPE_JSON, str, len); }
+
+int json_string(struct obuf *out, const char *str)
+{ return json_string_n(out, str, strlen(str)); }
@@ -0,0 +1,207 @@
+/* ********************************************************** */
+/* -*- mapfile.c -*- Helpers for mmap'd data files        -*- */
+/* ********************************************************** */
+/* Tyler Besselman (C) October 2026                           */
+/* ********************************************************** */
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <strings.h>
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+
+#include <mapfile.h>
+
+void mapfile_header_init(struct mapfile_header *header, const char *magic, uint32_t version, size_t header_size)
+{
+    memset(header, 0, header_size);
+
+    memcpy(header->magic, magic, sizeof(header->magic));
+    header->version = version;
+    header->byte_order = MAPFILE_BYTE_ORDER;
+    header->size = header_size;
+}
+
+void mapfile_section(struct mapfile_header *header, struct mapfile_section *section, size_t size)
+{ mapfile_section_align(header, section, size, MAPFILE_ALIGN); }
+
+void mapfile_section_align(struct mapfile_header *header, struct mapfile_section *section, size_t size, size_t align)
+{
+    section->offset = (header->size + align - 1) & ~(uint64_t)(align - 1);
+    section->size = size;
+
+    header->size = section->offset + size;
+}
+
+int mapfile_write(FILE *fp, const struct mapfile_section *section, const void *data)
+{
+    static const char zero[MAPFILE_ALIGN] = { 0 };
+    long pos = ftell(fp);
+
+    if (pos < 0 || (uint64_t)pos > section->offset)
+    {
+        fprintf(stderr, "Error: File section is out of place!\n");
+        return 1;
+    }
+
+    // Padding can be longer than `zero` for sections with a larger alignment.
+    for (uint64_t pad = section->offset - pos; pad; )
+    {
+        size_t n = (pad < sizeof(zero) ? pad : sizeof(zero));
+
+        if (fwrite(zero, 1, n, fp) != n) { return 1; }
+        pad -= n;
+    }
+
+    if (fwrite(data, 1, section->size, fp) != section->size) { return 1; }
+
+    return 0;
+}
+
+int mapfile_save(const char *path, int (^blk)(FILE *fp))
+{
+    size_t tmplen = strlen(path) + 5;
+    char tmp[tmplen];
+    snprintf(tmp, tmplen, "%s.tmp", path);
+
+    FILE *fp = fopen(tmp, "wb");
+
+    if (!fp)
+    {
+        perror("fopen");
+        return 1;
+    }
+
+    // Keep the error from a failed write, since closing and removing the file can change errno.
+    // Failures which aren't from the system (like a section out of place) have already been reported.
+    errno = 0;
+
+    int failed = blk(fp);
+    int err = errno;
+
+    if (failed && err) {
+        fprintf(stderr, "fwrite: %s\n", strerror(err));
+    }
+
+    // Make sure the data is on disk before the rename makes it visible, or a crash could leave a truncated file in place.
+    if (!failed && fflush(fp))
+    {
+        perror("fwrite");
+        failed = 1;
+    }
+
+    if (!failed && fsync(fileno(fp)))
+    {
+        perror("fsync");
+        failed = 1;
+    }
+
+    if (fclose(fp))
+    {
+        perror("fclose");
+        failed = 1;
+    }
+
+    if (!failed && rename(tmp, path))
+    {
+        perror("rename");
+        failed = 1;
+    }
+
+    if (failed)
+    {
+        unlink(tmp);
+        return 1;
+    }
+
+    return 0;
+}
+
+bool mapfile_is(const char *path, const char *magic)
+{
+    char buf[8];
+    FILE *fp = fopen(path, "rb");
+
+    if (!fp) { return false; }
+
+    bool match = (fread(buf, 1, sizeof(buf), fp) == sizeof(buf) && !memcmp(buf, magic, sizeof(buf)));
+    fclose(fp);
+
+    return match;
+}
+
+void *mapfile_open(const char *path, const char *what, const char *magic, uint32_t version, size_t header_size, size_t *size)
+{
+    int fd = open(path, O_RDONLY);
+
+    if (fd < 0)
+    {
+        perror("open");
+        return NULL;
+    }
+
+    struct stat st;
+
+    if (fstat(fd, &st))
+    {
+        perror("fstat");
+        close(fd);
+
+        return NULL;
+    }
+
+    if ((size_t)st.st_size < header_size)
+    {
+        fprintf(stderr, "Error: The %s file '%s' is truncated!\n", what, path);
+        close(fd);
+
+        return NULL;
+    }
+
+    // Pages are only read in as they're touched.
+    void *map = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+
+    if (map == MAP_FAILED)
+    {
+        perror("mmap");
+        return NULL;
+    }
+
+    const struct mapfile_header *header = map;
+    bool ok = false;
+
+    if (memcmp(header->magic, magic, sizeof(header->magic))) {
+        fprintf(stderr, "Error: '%s' is not a %s file!\n", path, what);
+    } else if (header->version != version) {
+        fprintf(stderr, "Error: The %s file '%s' has version %u (expected %u)!\n", what, path, header->version, version);
+    } else if (header->byte_order != MAPFILE_BYTE_ORDER) {
+        fprintf(stderr, "Error: The %s file '%s' was built on a host with a different byte order!\n", what, path);
+    } else if (header->size != (uint64_t)st.st_size) {
+        fprintf(stderr, "Error: The %s file '%s' is the wrong size!\n", what, path);
+    } else {
+        ok = true;
+    }
+
+    if (!ok)
+    {
+        munmap(map, st.st_size);
+        return NULL;
+    }
+
+    (*size) = st.st_size;
+    return map;
+}
+
+bool mapfile_section_ok(const struct mapfile_header *header, const struct mapfile_section *section, uint64_t size)
+{
+    return (section->offset % MAPFILE_ALIGN == 0)
+        && (section->size == size)
+        && (section->offset <= header->size)
+        && (section->size <= header->size - section->offset);
+}
+
+void mapfile_close(void *map, size_t size)
+{ munmap(map, size); }
@@ -0,0 +1,132 @@
+/* ********************************************************** */
+/* -*- metrics.c -*- Progress and metrics reporting       -*- */
+/* ********************************************************** */
+/* Tyler Besselman (C) October 2026                           */
+/* ********************************************************** */
+
+#include <strings.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <time.h>
+
+#include <metrics.h>
+
+#define NSEC_PER_MSEC 1000000ULL
+#define NSEC_PER_SEC  1000000000ULL
+
+uint64_t metrics_now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t)ts.tv_sec * NSEC_PER_SEC + ts.tv_nsec;
+}
+
+// Check if an environment variable is set to something truthy.
+static bool _metrics_env_flag(const char *name)
+{
+    const char *value = getenv(name);
+    return (value && value[0] && strcmp(value, "0"));
+}
+
+void metrics_init(struct metrics *m, const char *name, size_t total)
+{
+    m->name = name;
+    m->total = total;
+
+    m->done = 0;
+    m->bytes = 0;
+    m->skipped = 0;
+    m->malformed = 0;
+
+    m->tty = isatty(STDERR_FILENO);
+    m->verbose = _metrics_env_flag(METRICS_ENV_VERBOSE);
+    m->interval = (m->tty ? METRICS_INTERVAL_TTY : METRICS_INTERVAL_FILE) * NSEC_PER_MSEC;
+
+    m->start = metrics_now();
+    m->last = m->start;
+}
+
+// Scale a byte count to something readable, returning the unit used.
+static const char *_metrics_scale(double *bytes)
+{
+    static const char *units[] = { "B", "KiB", "MiB", "GiB" };
+    size_t i = 0;
+
+    while ((*bytes) >= 1024.0 && i < (sizeof(units) / sizeof(*units)) - 1)
+    {
+        (*bytes) /= 1024.0;
+        i++;
+    }
+
+    return units[i];
+}
+
+// Print a single progress line based on the current time.
+static void _metrics_line(struct metrics *m, uint64_t now, bool final)
+{
+    double elapsed = (double)(now - m->start) / NSEC_PER_SEC;
+    double rate = (elapsed > 0.0 ? m->done / elapsed : 0.0);
+
+    double bytes = m->bytes;
+    const char *unit = _metrics_scale(&bytes);
+
+    fprintf(stderr, "%s[%s] %zu", (m->tty ? "\r" : ""), m->name, m->done);
+
+    if (m->total) {
+        fprintf(stderr, "/%zu (%.1f%%)", m->total, (100.0 * m->done) / m->total);
+    }
+
+    fprintf(stderr, " rows, %.0f rows/s, %.1f %s", rate, bytes, unit);
+
+    if (m->skipped || m->malformed) {
+        fprintf(stderr, ", %zu skipped, %zu malformed", m->skipped, m->malformed);
+    }
+
+    if (!final && m->total && rate > 0.0 && m->done < m->total) {
+        fprintf(stderr, ", ETA %.0fs", (m->total - m->done) / rate);
+    } else if (final) {
+        fprintf(stderr, " in %.2fs", elapsed);
+    }
+
+    // Pad over anything left from a longer previous line.
+    fputs((m->tty && !final) ? "    " : "\n", stderr);
+}
+
+void metrics_poll(struct metrics *m)
+{
+    uint64_t now = metrics_now();
+    if (now - m->last < m->interval) { return; }
+
+    _metrics_line(m, now, false);
+    m->last = now;
+}
+
+void metrics_finish(struct metrics *m, int status)
+{
+    uint64_t now = metrics_now();
+    double elapsed = (double)(now - m->start) / NSEC_PER_SEC;
+
+    _metrics_line(m, now, true);
+
+    // The summary goes to a file if one is requested, so it can be consumed by other tools.
+    const char *path = getenv(METRICS_ENV_SUMMARY);
+    FILE *out = stderr;
+
+    if (path && path[0] && !(out = fopen(path, "w")))
+    {
+        perror("fopen");
+        out = stderr;
+    }
+
+    fprintf(out, "{\"task\":\"%s\",\"status\":\"%s\",\"rows\":%zu,\"total\":%zu,"
+                 "\"skipped\":%zu,\"malformed\":%zu,\"bytes\":%zu,"
+                 "\"elapsed_s\":%.6f,\"rows_per_s\":%.1f,\"bytes_per_s\":%.1f}\n",
+        m->name, (status ? "error" : "ok"), m->done, m->total,
+        m->skipped, m->malformed, m->bytes,
+        elapsed, (elapsed > 0.0 ? m->done / elapsed : 0.0), (elapsed > 0.0 ? m->bytes / elapsed : 0.0));
+
+    if (out != stderr) {
+        fclose(out);
+    }
+}
@@ -0,0 +1,97 @@
+/* ********************************************************** */
+/* -*- obuf.c -*- Growable output buffers                 -*- */
+/* ********************************************************** */
+/* Tyler Besselman (C) October 2026                           */
+/* ********************************************************** */
+
+#include <strings.h>
+#include <string.h>
+#include <stdlib.h>
+
+#include <obuf.h>
+
+int obuf_reserve(struct obuf *buf, size_t n)
+{
+    if (buf->len + n <= buf->cap) { return 0; }
+
+    size_t cap = (buf->cap ? buf->cap : 256);
+
+    while (cap < buf->len + n) {
+        cap *= 2;
+    }
+
+    char *data = realloc(buf->data, cap);
+
+    if (!data)
+    {
+        perror("realloc");
+        return 1;
+    }
+
+    buf->data = data;
+    buf->cap = cap;
+
+    return 0;
+}
+
+int obuf_append(struct obuf *buf, const void *data, size_t n)
+{
+    if (obuf_reserve(buf, n)) { return 1; }
+
+    memcpy(&buf->data[buf->len], data, n);
+    buf->len += n;
+
+    return 0;
+}
+
+int obuf_puts(struct obuf *buf, const char *str)
+{ return obuf_append(buf, str, strlen(str)); }
+
+int obuf_printf(struct obuf *buf, const char *fmt, ...)
+{
+    va_list args;
+
+    // Try to fit everything in what we have already first.
+    va_start(args, fmt);
+    int n = vsnprintf(buf->data ? &buf->data[buf->len] : NULL, buf->cap - buf->len, fmt, args);
+    va_end(args);
+
+    if (n < 0)
+    {
+        perror("vsnprintf");
+        return 1;
+    }
+
+    if ((size_t)n >= buf->cap - buf->len)
+    {
+        // Need room for the terminating `\0` as well, even though we don't keep it.
+        if (obuf_reserve(buf, n + 1)) { return 1; }
+
+        va_start(args, fmt);
+        vsnprintf(&buf->data[buf->len], buf->cap - buf->len, fmt, args);
+        va_end(args);
+    }
+
+    buf->len += n;
+    return 0;
+}
+
+int obuf_flush(struct obuf *buf, FILE *out)
+{
+    size_t len = buf->len;
+    buf->len = 0;
+
+    if (len && fwrite(buf->data, 1, len, out) != len)
+    {
+        perror("fwrite");
+        return 1;
+    }
+
+    return 0;
+}
+
+void obuf_free(struct obuf *buf)
+{
+    free(buf->data);
+    (*buf) = OBUF_INIT;
+}
@@ -0,0 +1,190 @@
+/* ********************************************************** */
+/* -*- pool.c -*- Simple thread pool for parallel loops   -*- */
+/* ********************************************************** */
+/* Tyler Besselman (C) October 2026                           */
+/* ********************************************************** */
+
+#include <stdatomic.h>
+#include <string.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include <pool.h>
+
+struct pool {
+    // Worker threads (there are `nthreads - 1` of them; the caller is the last thread)
+    pthread_t *threads;
+    size_t nthreads;
+
+    // Protects everything below except `next`.
+    pthread_mutex_t lock;
+
+    // Signaled when there is new work (or we're shutting down) and when workers finish.
+    pthread_cond_t work;
+    pthread_cond_t done;
+
+    // The current job. Workers claim iterations by incrementing `next`.
+    void (^blk)(size_t i);
+    size_t count;
+    atomic_size_t next;
+
+    // Number of workers still running the current job.
+    size_t active;
+
+    // Incremented for each job so workers can tell new work from spurious wakeups.
+    uint64_t generation;
+
+    // Set when the pool is being destroyed.
+    bool quit;
+};
+
+size_t pool_ncpus(void)
+{
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return (n > 0 ? n : 1);
+}
+
+// Claim and run iterations of the current job until there are none left.
+static void _pool_run(struct pool *pool)
+{
+    size_t i;
+
+    while ((i = atomic_fetch_add_explicit(&pool->next, 1, memory_order_relaxed)) < pool->count) {
+        pool->blk(i);
+    }
+}
+
+static void *_pool_worker(void *arg)
+{
+    struct pool *pool = arg;
+    uint64_t seen = 0;
+
+    pthread_mutex_lock(&pool->lock);
+
+    while (true)
+    {
+        while (!pool->quit && pool->generation == seen) {
+            pthread_cond_wait(&pool->work, &pool->lock);
+        }
+
+        if (pool->quit) { break; }
+        seen = pool->generation;
+
+        pthread_mutex_unlock(&pool->lock);
+        _pool_run(pool);
+        pthread_mutex_lock(&pool->lock);
+
+        if (!(--pool->active)) {
+            pthread_cond_signal(&pool->done);
+        }
+    }
+
+    pthread_mutex_unlock(&pool->lock);
+    return NULL;
+}
+
+struct pool *pool_create(size_t threads)
+{
+    struct pool *pool = calloc(1, sizeof(struct pool));
+
+    if (!pool)
+    {
+        perror("calloc");
+        return NULL;
+    }
+
+    pool->nthreads = (threads ? threads : pool_ncpus());
+    pool->threads = calloc(pool->nthreads, sizeof(pthread_t));
+
+    if (!pool->threads)
+    {
+        perror("calloc");
+        free(pool);
+
+        return NULL;
+    }
+
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->work, NULL);
+    pthread_cond_init(&pool->done, NULL);
+
+    atomic_init(&pool->next, 0);
+
+    for (size_t i = 0; i < pool->nthreads - 1; i++)
+    {
+        int err = pthread_create(&pool->threads[i], NULL, _pool_worker, pool);
+
+        if (err)
+        {
+            fprintf(stderr, "pthread_create: %s\n", strerror(err));
+
+            // Just run with the threads we managed to start.
+            pool->nthreads = i + 1;
+            break;
+        }
+    }
+
+    return pool;
+}
+
+size_t pool_threads(struct pool *pool)
+{ return pool->nthreads; }
+
+void pool_apply(struct pool *pool, size_t count, void (^blk)(size_t i))
+{
+    // Not worth waking anyone up for.
+    if (pool->nthreads == 1 || count < 2)
+    {
+        for (size_t i = 0; i < count; i++) {
+            blk(i);
+        }
+
+        return;
+    }
+
+    pthread_mutex_lock(&pool->lock);
+
+    pool->blk = blk;
+    pool->count = count;
+    pool->active = pool->nthreads - 1;
+    atomic_store(&pool->next, 0);
+
+    pool->generation++;
+    pthread_cond_broadcast(&pool->work);
+    pthread_mutex_unlock(&pool->lock);
+
+    // Help out while we wait.
+    _pool_run(pool);
+
+    pthread_mutex_lock(&pool->lock);
+
+    while (pool->active) {
+        pthread_cond_wait(&pool->done, &pool->lock);
+    }
+
+    pool->blk = NULL;
+    pthread_mutex_unlock(&pool->lock);
+}
+
+void pool_destroy(struct pool *pool)
+{
+    pthread_mutex_lock(&pool->lock);
+    pool->quit = true;
+    pthread_cond_broadcast(&pool->work);
+    pthread_mutex_unlock(&pool->lock);
+
+    for (size_t i = 0; i < pool->nthreads - 1; i++) {
+        pthread_join(pool->threads[i], NULL);
+    }
+
+    pthread_cond_destroy(&pool->done);
+    pthread_cond_destroy(&pool->work);
+    pthread_mutex_destroy(&pool->lock);
+
+    free(pool->threads);
+    free(pool);
+}
@@ -0,0 +1,802 @@
+/* ********************************************************** */
+/* -*- sarray.c -*- Suffix array over definition text     -*- */
+/* ********************************************************** */
+/* Tyler Besselman (C) October 2026                           */
+/* ********************************************************** */
+
+#include <stdatomic.h>
+#include <strings.h>
+#include <string.h>
+#include <stdio.h>
+
+#include <sarray.h>
+#include <pool.h>
+#include <utf8.h>
+
+// Codepoints we can decode are below this (anything invalid decodes as `UTF8_INVALID`).
+#define SARRAY_CP_LIMIT 0x200000
+
+// Entries and text positions handled per parallel task during the build.
+#define SARRAY_ENTRY_CHUNK  4096
+#define SARRAY_TEXT_CHUNK   (1 << 18)
+
+// Searches with more occurrences than `nentries / SARRAY_COUNT_RATIO` count entries in a table instead of sorting.
+#define SARRAY_COUNT_RATIO  16
+
+// Fill in bucket boundaries for each symbol: where each bucket starts, or one past where it ends if `end` is set.
+static void _sais_buckets(const int32_t *s, size_t n, int32_t *bkt, size_t k, bool end)
+{
+    memset(bkt, 0, k * sizeof(int32_t));
+
+    for (size_t i = 0; i < n; i++) {
+        bkt[s[i]]++;
+    }
+
+    int32_t sum = 0;
+
+    for (size_t c = 0; c < k; c++)
+    {
+        sum += bkt[c];
+        bkt[c] = (end ? sum : sum - bkt[c]);
+    }
+}
+
+// Check if position `i` is a leftmost S-type position.
+static inline bool _sais_lms(const uint8_t *t, int32_t i)
+{ return (i > 0 && t[i] && !t[i - 1]); }
+
+// Induce the order of L-type suffixes from sorted LMS suffixes, then S-type suffixes from those.
+static void _sais_induce(const int32_t *s, int32_t *sa, const uint8_t *t, size_t n, int32_t *bkt, size_t k)
+{
+    _sais_buckets(s, n, bkt, k, false);
+
+    for (size_t i = 0; i < n; i++)
+    {
+        int32_t j = sa[i] - 1;
+
+        if (sa[i] > 0 && !t[j]) {
+            sa[bkt[s[j]]++] = j;
+        }
+    }
+
+    _sais_buckets(s, n, bkt, k, true);
+
+    for (size_t i = n; i-- > 0; )
+    {
+        int32_t j = sa[i] - 1;
+
+        if (sa[i] > 0 && t[j]) {
+            sa[--bkt[s[j]]] = j;
+        }
+    }
+}
+
+// Build the suffix array of `s` (`n` symbols below `k`, where the last is a unique 0) with SA-IS (Nong, Zhang & Chan).
+// Returns non-zero on failure.
+static int _sais(const int32_t *s, int32_t *sa, size_t n, size_t k)
+{
+    if (n == 1)
+    {
+        sa[0] = 0;
+        return 0;
+    }
+
+    // Suffix types (1 for S-type, 0 for L-type).
+    uint8_t *t = malloc(n);
+    int32_t *bkt = malloc(k * sizeof(int32_t));
+
+    if (!t || !bkt)
+    {
+        perror("malloc");
+
+        free(t);
+        free(bkt);
+
+        return 1;
+    }
+
+    t[n - 1] = 1;
+    t[n - 2] = 0;
+
+    for (size_t i = n - 2; i-- > 0; ) {
+        t[i] = (s[i] < s[i + 1] || (s[i] == s[i + 1] && t[i + 1]));
+    }
+
+    // Sort LMS substrings by placing them at the ends of their buckets and inducing.
+    _sais_buckets(s, n, bkt, k, true);
+
+    for (size_t i = 0; i < n; i++) {
+        sa[i] = -1;
+    }
+
+    for (size_t i = 1; i < n; i++)
+    {
+        if (_sais_lms(t, i)) {
+            sa[--bkt[s[i]]] = i;
+        }
+    }
+
+    _sais_induce(s, sa, t, n, bkt, k);
+
+    // Move the sorted LMS substrings to the front.
+    size_t n1 = 0;
+
+    for (size_t i = 0; i < n; i++)
+    {
+        if (_sais_lms(t, sa[i])) {
+            sa[n1++] = sa[i];
+        }
+    }
+
+    for (size_t i = n1; i < n; i++) {
+        sa[i] = -1;
+    }
+
+    // Name each LMS substring by its rank (equal substrings get equal names).
+    int32_t name = 0;
+    int32_t prev = -1;
+
+    for (size_t i = 0; i < n1; i++)
+    {
+        int32_t pos = sa[i];
+        bool diff = false;
+
+        for (size_t d = 0; d < n; d++)
+        {
+            if (prev < 0 || s[pos + d] != s[prev + d] || t[pos + d] != t[prev + d]) {
+                diff = true;
+                break;
+            } else if (d > 0 && (_sais_lms(t, pos + d) || _sais_lms(t, prev + d))) {
+                break;
+            }
+        }
+
+        if (diff)
+        {
+            name++;
+            prev = pos;
+        }
+
+        // LMS positions are at least 2 apart, so this can't collide.
+        sa[n1 + pos / 2] = name - 1;
+    }
+
+    for (size_t i = n, j = n; i-- > n1; )
+    {
+        if (sa[i] >= 0) {
+            sa[--j] = sa[i];
+        }
+    }
+
+    // Sort the reduced string (recursively if any names repeat).
+    int32_t *s1 = &sa[n - n1];
+
+    if ((size_t)name < n1) {
+        if (_sais(s1, sa, n1, name))
+        {
+            free(t);
+            free(bkt);
+
+            return 1;
+        }
+    } else {
+        for (size_t i = 0; i < n1; i++) {
+            sa[s1[i]] = i;
+        }
+    }
+
+    // Place the sorted LMS suffixes and induce everything else from them.
+    _sais_buckets(s, n, bkt, k, true);
+
+    for (size_t i = 1, j = 0; i < n; i++)
+    {
+        if (_sais_lms(t, i)) {
+            s1[j++] = i;
+        }
+    }
+
+    for (size_t i = 0; i < n1; i++) {
+        sa[i] = s1[sa[i]];
+    }
+
+    for (size_t i = n1; i < n; i++) {
+        sa[i] = -1;
+    }
+
+    for (size_t i = n1; i-- > 0; )
+    {
+        int32_t j = sa[i];
+
+        sa[i] = -1;
+        sa[--bkt[s[j]]] = j;
+    }
+
+    _sais_induce(s, sa, t, n, bkt, k);
+
+    free(t);
+    free(bkt);
+
+    return 0;
+}
+
+// Fill in text, ranks, and entry starts for the definitions in `idx`.
+static int _sarray_text(struct sarray *sa, struct pool *pool, uint32_t *starts)
+{
+    const struct dindex *idx = sa->idx;
+    size_t nchunks = (idx->nentries + SARRAY_ENTRY_CHUNK - 1) / SARRAY_ENTRY_CHUNK;
+
+    // Which codepoints appear (set from every thread at once).
+    _Atomic uint64_t *seen = calloc(SARRAY_CP_LIMIT / 64, sizeof(uint64_t));
+    uint32_t *ranks = malloc(SARRAY_CP_LIMIT * sizeof(uint32_t));
+
+    if (!seen || !ranks)
+    {
+        perror("malloc");
+
+        free((void *)seen);
+        free(ranks);
+
+        return 1;
+    }
+
+    // Count the codepoints in each definition (plus its separator).
+    pool_apply(pool, nchunks, ^(size_t c) {
+        uint32_t end = (c + 1) * SARRAY_ENTRY_CHUNK;
+        if (end > idx->nentries) { end = idx->nentries; }
+
+        for (uint32_t e = c * SARRAY_ENTRY_CHUNK; e < end; e++)
+        {
+            starts[e] = 0;
+
+            if (idx->entries[e].def == DINDEX_NONE) { continue; }
+
+            const char *def = dindex_str(idx, idx->entries[e].def);
+
+            while (*def)
+            {
+                uint32_t cp = utf8_next(&def);
+
+                atomic_fetch_or_explicit(&seen[cp / 64], 1ULL << (cp % 64), memory_order_relaxed);
+                starts[e]++;
+            }
+
+            starts[e]++;
+        }
+    });
+
+    // Turn lengths into offsets.
+    uint64_t n = 0;
+
+    for (uint32_t e = 0; e < idx->nentries; e++)
+    {
+        uint32_t len = starts[e];
+
+        starts[e] = n;
+        n += len;
+    }
+
+    starts[idx->nentries] = n;
+
+    // Leave room for the sentinel.
+    if (++n > INT32_MAX)
+    {
+        fprintf(stderr, "Error: Too much definition text for a suffix array!\n");
+
+        free((void *)seen);
+        free(ranks);
+
+        return 1;
+    }
+
+    uint32_t ncps = 0;
+
+    for (uint32_t cp = 0; cp < SARRAY_CP_LIMIT; cp++)
+    {
+        if (seen[cp / 64] & (1ULL << (cp % 64))) {
+            ncps++;
+        }
+    }
+
+    uint32_t *cps = malloc(ncps * sizeof(uint32_t) + 1);
+    int32_t *text = malloc(n * sizeof(int32_t));
+
+    sa->cps = cps;
+    sa->text = text;
+
+    if (!cps || !text)
+    {
+        perror("malloc");
+
+        free((void *)seen);
+        free(ranks);
+
+        return 1;
+    }
+
+    for (uint32_t cp = 0, r = 0; cp < SARRAY_CP_LIMIT; cp++)
+    {
+        if (seen[cp / 64] & (1ULL << (cp % 64)))
+        {
+            cps[r] = cp;
+            ranks[cp] = SARRAY_FIRST_RANK + r++;
+        }
+    }
+
+    free((void *)seen);
+
+    pool_apply(pool, nchunks, ^(size_t c) {
+        uint32_t end = (c + 1) * SARRAY_ENTRY_CHUNK;
+        if (end > idx->nentries) { end = idx->nentries; }
+
+        for (uint32_t e = c * SARRAY_ENTRY_CHUNK; e < end; e++)
+        {
+            if (idx->entries[e].def == DINDEX_NONE) { continue; }
+
+            const char *def = dindex_str(idx, idx->entries[e].def);
+            int32_t *p = &text[starts[e]];
+
+            while (*def) {
+                *p++ = ranks[utf8_next(&def)];
+            }
+
+            (*p) = SARRAY_SEPARATOR;
+        }
+    });
+
+    text[n - 1] = SARRAY_SENTINEL;
+    free(ranks);
+
+    sa->ncps = ncps;
+    sa->n = n;
+
+    return 0;
+}
+
+// Build the LCP array with Kasai's algorithm. The permuted LCP is built in chunks of text positions in parallel.
+// Each chunk starts its running match from scratch, which only costs a little repeated comparison at the boundaries.
+static int _sarray_lcp(struct sarray *sa, struct pool *pool, uint32_t *lcp)
+{
+    const int32_t *text = sa->text;
+    const int32_t *suffixes = sa->sa;
+    uint32_t n = sa->n;
+
+    // phi[p] is the suffix before p in suffix array order. It's overwritten with PLCP[p] in place.
+    int32_t *phi = malloc(n * sizeof(int32_t));
+
+    if (!phi)
+    {
+        perror("malloc");
+        return 1;
+    }
+
+    size_t nchunks = (n + SARRAY_TEXT_CHUNK - 1) / SARRAY_TEXT_CHUNK;
+
+    pool_apply(pool, nchunks, ^(size_t c) {
+        uint32_t end = (c + 1) * SARRAY_TEXT_CHUNK;
+        if (end > n) { end = n; }
+
+        for (uint32_t i = c * SARRAY_TEXT_CHUNK; i < end; i++) {
+            phi[suffixes[i]] = (i ? suffixes[i - 1] : -1);
+        }
+    });
+
+    pool_apply(pool, nchunks, ^(size_t c) {
+        uint32_t end = (c + 1) * SARRAY_TEXT_CHUNK;
+        if (end > n) { end = n; }
+
+        uint32_t h = 0;
+
+        for (uint32_t i = c * SARRAY_TEXT_CHUNK; i < end; i++)
+        {
+            int32_t j = phi[i];
+
+            // The sentinel is unique, so this always stops before the end of the text.
+            if (j < 0) {
+                h = 0;
+            } else {
+                while (text[i + h] == text[j + h]) {
+                    h++;
+                }
+            }
+
+            phi[i] = h;
+            if (h) { h--; }
+        }
+    });
+
+    pool_apply(pool, nchunks, ^(size_t c) {
+        uint32_t end = (c + 1) * SARRAY_TEXT_CHUNK;
+        if (end > n) { end = n; }
+
+        for (uint32_t i = c * SARRAY_TEXT_CHUNK; i < end; i++) {
+            lcp[i] = phi[suffixes[i]];
+        }
+    });
+
+    free(phi);
+    return 0;
+}
+
+struct sarray *sarray_build(const struct dindex *idx, size_t threads)
+{
+    struct sarray *sa = calloc(1, sizeof(struct sarray));
+    uint32_t *starts = malloc((idx->nentries + 1) * sizeof(uint32_t));
+    struct pool *pool = pool_create(threads);
+
+    if (!sa || !starts || !pool)
+    {
+        if (!sa || !starts) { perror("malloc"); }
+        if (pool) { pool_destroy(pool); }
+
+        free(sa);
+        free(starts);
+
+        return NULL;
+    }
+
+    sa->idx = idx;
+    sa->starts = starts;
+    sa->nentries = idx->nentries;
+    sa->pool_size = idx->pool_size;
+
+    if (_sarray_text(sa, pool, starts))
+    {
+        pool_destroy(pool);
+        sarray_free(sa);
+
+        return NULL;
+    }
+
+    int32_t *suffixes = malloc(sa->n * sizeof(int32_t));
+    uint32_t *lcp = malloc(sa->n * sizeof(uint32_t));
+
+    sa->sa = suffixes;
+    sa->lcp = lcp;
+
+    if (!suffixes || !lcp)
+    {
+        perror("malloc");
+
+        pool_destroy(pool);
+        sarray_free(sa);
+
+        return NULL;
+    }
+
+    if (_sais(sa->text, suffixes, sa->n, sa->ncps + SARRAY_FIRST_RANK) || _sarray_lcp(sa, pool, lcp))
+    {
+        pool_destroy(pool);
+        sarray_free(sa);
+
+        return NULL;
+    }
+
+    pool_destroy(pool);
+
+    if (DEBUG_SARRAY) {
+        fprintf(stderr, "Built suffix array over %u codepoints of definitions (%u distinct).\n", sa->n, sa->ncps);
+    }
+
+    return sa;
+}
+
+// Convert a phrase to ranks in `out` (which has room for `strlen(phrase)` symbols).
+// Returns the length, or 0 if the phrase has a codepoint which never appears (so it can't match).
+static size_t _sarray_pattern(const struct sarray *sa, const char *phrase, int32_t *out)
+{
+    size_t m = 0;
+
+    while (*phrase)
+    {
+        uint32_t cp = utf8_next(&phrase);
+
+        uint32_t lo = 0;
+        uint32_t hi = sa->ncps;
+
+        while (lo < hi)
+        {
+            uint32_t mid = lo + (hi - lo) / 2;
+
+            if (sa->cps[mid] < cp) {
+                lo = mid + 1;
+            } else {
+                hi = mid;
+            }
+        }
+
+        if (lo >= sa->ncps || sa->cps[lo] != cp) { return 0; }
+
+        out[m++] = SARRAY_FIRST_RANK + lo;
+    }
+
+    return m;
+}
+
+// Find the first suffix whose first `m` symbols are at least the pattern (or greater than it if `upper` is set).
+// The pattern never matches past a separator or the sentinel, so comparisons never run off the end of the text.
+static uint32_t _sarray_bound(const struct sarray *sa, const int32_t *p, size_t m, bool upper)
+{
+    uint32_t lo = 0;
+    uint32_t hi = sa->n;
+
+    // Everything between lo and hi shares at least min(llcp, hlcp) symbols with the pattern, so we can skip those.
+    size_t llcp = 0;
+    size_t hlcp = 0;
+
+    while (lo < hi)
+    {
+        uint32_t mid = lo + (hi - lo) / 2;
+        const int32_t *suffix = &sa->text[sa->sa[mid]];
+
+        size_t h = (llcp < hlcp ? llcp : hlcp);
+
+        while (h < m && suffix[h] == p[h]) {
+            h++;
+        }
+
+        if (h == m ? upper : suffix[h] < p[h]) {
+            lo = mid + 1;
+            llcp = h;
+        } else {
+            hi = mid;
+            hlcp = h;
+        }
+    }
+
+    return lo;
+}
+
+size_t sarray_count(const struct sarray *sa, const char *phrase)
+{
+    int32_t *p = malloc((strlen(phrase) + 1) * sizeof(int32_t));
+
+    if (!p)
+    {
+        perror("malloc");
+        return 0;
+    }
+
+    size_t m = _sarray_pattern(sa, phrase, p);
+    size_t count = (m ? _sarray_bound(sa, p, m, true) - _sarray_bound(sa, p, m, false) : 0);
+
+    free(p);
+    return count;
+}
+
+uint32_t sarray_entry(const struct sarray *sa, uint32_t pos)
+{
+    // Find the last entry starting at or before `pos` (entries with no definition share a start with the next one).
+    uint32_t lo = 0;
+    uint32_t hi = sa->nentries;
+
+    while (lo < hi)
+    {
+        uint32_t mid = lo + (hi - lo) / 2;
+
+        if (sa->starts[mid] <= pos) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+
+    return lo - 1;
+}
+
+static int _sarray_u32_cmp(const void *a, const void *b)
+{
+    uint32_t x = *(const uint32_t *)a;
+    uint32_t y = *(const uint32_t *)b;
+
+    return (x > y) - (x < y);
+}
+
+size_t sarray_search(const struct sarray *sa, const char *phrase, int (^blk)(const struct dindex_entry *entry, size_t count))
+{
+    int32_t *p = malloc((strlen(phrase) + 1) * sizeof(int32_t));
+
+    if (!p)
+    {
+        perror("malloc");
+        return 0;
+    }
+
+    size_t m = _sarray_pattern(sa, phrase, p);
+    uint32_t lo = (m ? _sarray_bound(sa, p, m, false) : sa->n);
+    uint32_t hi = lo;
+
+    // Matches are contiguous, and the LCP array tells us where they end without a second search.
+    if (lo < sa->n && !memcmp(&sa->text[sa->sa[lo]], p, m * sizeof(int32_t)))
+    {
+        hi = lo + 1;
+
+        while (hi < sa->n && sa->lcp[hi] >= m) {
+            hi++;
+        }
+    }
+
+    free(p);
+
+    size_t total = hi - lo;
+    if (!total) { return 0; }
+
+    if (total > sa->nentries / SARRAY_COUNT_RATIO) {
+        // Lots of matches, so count per entry in a table and walk it in order.
+        uint32_t *counts = calloc(sa->nentries, sizeof(uint32_t));
+
+        if (!counts)
+        {
+            perror("calloc");
+            return 0;
+        }
+
+        for (uint32_t i = lo; i < hi; i++) {
+            counts[sarray_entry(sa, sa->sa[i])]++;
+        }
+
+        for (uint32_t e = 0; e < sa->nentries; e++)
+        {
+            if (counts[e] && blk(&sa->idx->entries[e], counts[e])) {
+                break;
+            }
+        }
+
+        free(counts);
+    } else {
+        // Otherwise sort the entries for each match and group them.
+        uint32_t *entries = malloc(total * sizeof(uint32_t));
+
+        if (!entries)
+        {
+            perror("malloc");
+            return 0;
+        }
+
+        for (uint32_t i = lo; i < hi; i++) {
+            entries[i - lo] = sarray_entry(sa, sa->sa[i]);
+        }
+
+        qsort(entries, total, sizeof(uint32_t), _sarray_u32_cmp);
+
+        for (size_t i = 0; i < total; )
+        {
+            size_t j = i + 1;
+
+            while (j < total && entries[j] == entries[i]) {
+                j++;
+            }
+
+            if (blk(&sa->idx->entries[entries[i]], j - i)) {
+                break;
+            }
+
+            i = j;
+        }
+
+        free(entries);
+    }
+
+    return total;
+}
+
+int sarray_save(const struct sarray *sa, const char *path)
+{
+    struct sarray_header header;
+    mapfile_header_init(&header.file, SARRAY_MAGIC, SARRAY_VERSION, sizeof(struct sarray_header));
+
+    header.pool_size = sa->pool_size;
+    header.n = sa->n;
+    header.ncps = sa->ncps;
+    header.nentries = sa->nentries;
+
+    mapfile_section(&header.file, &header.cps,    sa->ncps * sizeof(uint32_t));
+    mapfile_section(&header.file, &header.text,   sa->n * sizeof(int32_t));
+    mapfile_section(&header.file, &header.sa,     sa->n * sizeof(int32_t));
+    mapfile_section(&header.file, &header.lcp,    sa->n * sizeof(uint32_t));
+    mapfile_section(&header.file, &header.starts, (sa->nentries + 1) * sizeof(uint32_t));
+
+    int failed = mapfile_save(path, ^(FILE *fp) {
+        return (fwrite(&header, sizeof(struct sarray_header), 1, fp) != 1)
+            || mapfile_write(fp, &header.cps,    sa->cps)
+            || mapfile_write(fp, &header.text,   sa->text)
+            || mapfile_write(fp, &header.sa,     sa->sa)
+            || mapfile_write(fp, &header.lcp,    sa->lcp)
+            || mapfile_write(fp, &header.starts, sa->starts);
+    });
+
+    if (failed) { return 1; }
+
+    if (DEBUG_SARRAY) {
+        fprintf(stderr, "Wrote suffix array to '%s' (%llu bytes).\n", path, (unsigned long long)header.file.size);
+    }
+
+    return 0;
+}
+
+struct sarray *sarray_open(const char *path, const struct dindex *idx)
+{
+    size_t size;
+    void *map = mapfile_open(path, "suffix array", SARRAY_MAGIC, SARRAY_VERSION, sizeof(struct sarray_header), &size);
+
+    if (!map) { return NULL; }
+
+    const struct sarray_header *header = map;
+    const char *base = map;
+
+    bool ok = (header->n > 0)
+        && mapfile_section_ok(&header->file, &header->cps,    (uint64_t)header->ncps * sizeof(uint32_t))
+        && mapfile_section_ok(&header->file, &header->text,   (uint64_t)header->n * sizeof(int32_t))
+        && mapfile_section_ok(&header->file, &header->sa,     (uint64_t)header->n * sizeof(int32_t))
+        && mapfile_section_ok(&header->file, &header->lcp,    (uint64_t)header->n * sizeof(uint32_t))
+        && mapfile_section_ok(&header->file, &header->starts, ((uint64_t)header->nentries + 1) * sizeof(uint32_t))
+        && ((const int32_t *)&base[header->text.offset])[header->n - 1] == SARRAY_SENTINEL;
+
+    if (ok)
+    {
+        // Searches index the text by suffix array entries, and entries by where they start, without checking either.
+        const int32_t *suffixes = (const int32_t *)&base[header->sa.offset];
+        const uint32_t *starts = (const uint32_t *)&base[header->starts.offset];
+
+        for (uint32_t i = 0; i < header->n && ok; i++) {
+            ok = (suffixes[i] >= 0 && (uint32_t)suffixes[i] < header->n);
+        }
+
+        ok = ok && !starts[0];
+
+        for (uint32_t e = 0; e < header->nentries && ok; e++) {
+            ok = (starts[e] <= starts[e + 1] && starts[e + 1] <= header->n);
+        }
+    }
+
+    if (!ok) {
+        fprintf(stderr, "Error: Suffix array file '%s' is corrupt!\n", path);
+    } else if (header->nentries != idx->nentries || header->pool_size != idx->pool_size) {
+        fprintf(stderr, "Error: Suffix array file '%s' was built from a different dictionary!\n", path);
+        ok = false;
+    }
+
+    struct sarray *sa = (ok ? calloc(1, sizeof(struct sarray)) : NULL);
+
+    if (!sa)
+    {
+        if (ok) { perror("calloc"); }
+        mapfile_close(map, size);
+
+        return NULL;
+    }
+
+    sa->idx = idx;
+    sa->pool_size = header->pool_size;
+
+    sa->cps = (const uint32_t *)&base[header->cps.offset];
+    sa->ncps = header->ncps;
+
+    sa->text = (const int32_t *)&base[header->text.offset];
+    sa->n = header->n;
+
+    sa->sa = (const int32_t *)&base[header->sa.offset];
+    sa->lcp = (const uint32_t *)&base[header->lcp.offset];
+
+    sa->starts = (const uint32_t *)&base[header->starts.offset];
+    sa->nentries = header->nentries;
+
+    sa->map = map;
+    sa->map_size = size;
+
+    return sa;
+}
+
+void sarray_free(struct sarray *sa)
+{
+    if (sa->map) {
+        mapfile_close(sa->map, sa->map_size);
+    } else {
+        free((void *)sa->cps);
+        free((void *)sa->text);
+        free((void *)sa->sa);
+        free((void *)sa->lcp);
+        free((void *)sa->starts);
+    }
+
+    free(sa);
+}
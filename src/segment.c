@@ -0,0 +1,552 @@
+/* ********************************************************** */
+/* -*- segment.c -*- Dictionary driven text segmentation  -*- */
+/* ********************************************************** */
+/* Tyler Besselman (C) October 2026                           */
+/* ********************************************************** */
+
+#include <strings.h>
+#include <string.h>
+#include <stdio.h>
+
+#include <segment.h>
+#include <utf8.h>
+
+// Marks the end of the free cell list.
+#define SEGMENT_NIL UINT32_MAX
+
+// A word to insert into the trie (with its bytes reversed for backward matching).
+struct _segment_key {
+    const uint8_t *str;
+    uint32_t len;
+};
+
+// State used while building the trie. Free cells are kept in a doubly linked list in address order.
+struct _segment_builder {
+    struct segment_cell *cells;
+    uint32_t ncells;
+
+    uint32_t *prev;
+    uint32_t *next;
+    uint32_t head;
+    uint32_t tail;
+
+    uint32_t max_base;
+
+    const struct _segment_key *keys;
+};
+
+static int _segment_key_cmp(const void *a, const void *b)
+{
+    const struct _segment_key *x = a;
+    const struct _segment_key *y = b;
+
+    int c = memcmp(x->str, y->str, (x->len < y->len ? x->len : y->len));
+    return (c ? c : (x->len > y->len) - (x->len < y->len));
+}
+
+// Make sure there are at least `need` cells, adding the new ones to the end of the free list.
+static int _segment_grow(struct _segment_builder *b, size_t need)
+{
+    if (need <= b->ncells) { return 0; }
+
+    size_t ncells = (b->ncells ? b->ncells : 1024);
+
+    while (ncells < need) {
+        ncells *= 2;
+    }
+
+    if (ncells > SEGMENT_WORD)
+    {
+        fprintf(stderr, "Error: Segmentation trie is too large!\n");
+        return 1;
+    }
+
+    struct segment_cell *cells = realloc(b->cells, ncells * sizeof(struct segment_cell));
+    if (cells) { b->cells = cells; }
+
+    uint32_t *prev = realloc(b->prev, ncells * sizeof(uint32_t));
+    if (prev) { b->prev = prev; }
+
+    uint32_t *next = realloc(b->next, ncells * sizeof(uint32_t));
+    if (next) { b->next = next; }
+
+    if (!cells || !prev || !next)
+    {
+        perror("realloc");
+        return 1;
+    }
+
+    for (uint32_t i = b->ncells; i < ncells; i++)
+    {
+        b->cells[i] = (struct segment_cell){ .base = 0, .check = SEGMENT_FREE };
+
+        b->prev[i] = b->tail;
+        b->next[i] = SEGMENT_NIL;
+
+        if (b->tail == SEGMENT_NIL) {
+            b->head = i;
+        } else {
+            b->next[b->tail] = i;
+        }
+
+        b->tail = i;
+    }
+
+    b->ncells = ncells;
+    return 0;
+}
+
+// Claim a free cell for a child of state `s`.
+static void _segment_take(struct _segment_builder *b, uint32_t t, uint32_t s)
+{
+    if (b->prev[t] == SEGMENT_NIL) {
+        b->head = b->next[t];
+    } else {
+        b->next[b->prev[t]] = b->next[t];
+    }
+
+    if (b->next[t] == SEGMENT_NIL) {
+        b->tail = b->prev[t];
+    } else {
+        b->prev[b->next[t]] = b->prev[t];
+    }
+
+    b->cells[t].check = s;
+}
+
+// Find a base where every label in `labels` (sorted, at least one) lands on a free cell. Returns SEGMENT_NIL on failure.
+static uint32_t _segment_base(struct _segment_builder *b, const uint8_t *labels, size_t n)
+{
+    for (uint32_t t = b->head; t != SEGMENT_NIL; t = b->next[t])
+    {
+        if (t <= labels[0]) { continue; }
+
+        uint32_t base = t - labels[0];
+
+        // Keep room for a transition on any byte past every base.
+        if (_segment_grow(b, (size_t)base + 0x100)) { return SEGMENT_NIL; }
+
+        bool fits = true;
+
+        for (size_t i = 1; i < n && fits; i++) {
+            fits = (b->cells[base + labels[i]].check == SEGMENT_FREE);
+        }
+
+        if (fits) { return base; }
+    }
+
+    // Nothing fits, so start past the end (where everything is free).
+    uint32_t base = b->ncells;
+    if (_segment_grow(b, (size_t)base + 0x100)) { return SEGMENT_NIL; }
+
+    return base;
+}
+
+// Fill in state `s`, which is reached by the first `depth` bytes of every key in `keys[lo]` through `keys[hi - 1]`.
+static int _segment_insert(struct _segment_builder *b, uint32_t s, size_t lo, size_t hi, size_t depth)
+{
+    // Keys are sorted, so a key ending here comes first.
+    if (lo < hi && b->keys[lo].len == depth)
+    {
+        b->cells[s].base |= SEGMENT_WORD;
+        lo++;
+    }
+
+    if (lo == hi) { return 0; }
+
+    uint8_t labels[0x100];
+    size_t n = 0;
+
+    for (size_t i = lo; i < hi; i++)
+    {
+        uint8_t c = b->keys[i].str[depth];
+
+        if (!n || labels[n - 1] != c) {
+            labels[n++] = c;
+        }
+    }
+
+    uint32_t base = _segment_base(b, labels, n);
+    if (base == SEGMENT_NIL) { return 1; }
+
+    b->cells[s].base |= base;
+
+    if (base > b->max_base) {
+        b->max_base = base;
+    }
+
+    // Claim every child before filling any of them in, so they can't be handed out again.
+    for (size_t i = 0; i < n; i++) {
+        _segment_take(b, base + labels[i], s);
+    }
+
+    size_t i = lo;
+
+    for (size_t c = 0; c < n; c++)
+    {
+        size_t j = i;
+
+        while (j < hi && b->keys[j].str[depth] == labels[c]) {
+            j++;
+        }
+
+        if (_segment_insert(b, base + labels[c], i, j, depth + 1)) { return 1; }
+        i = j;
+    }
+
+    return 0;
+}
+
+struct segmenter *segment_create(const struct dindex *idx, enum segment_mode mode)
+{
+    struct segmenter *seg = calloc(1, sizeof(struct segmenter));
+    struct _segment_key *keys = malloc(idx->nwords * sizeof(struct _segment_key) + 1);
+
+    // Reversed copies of every word for backward matching.
+    uint8_t *reversed = NULL;
+    size_t total = 0;
+
+    if (mode == SEGMENT_BACKWARD)
+    {
+        for (uint32_t w = 0; w < idx->nwords; w++) {
+            total += idx->words[w].len;
+        }
+
+        reversed = malloc(total + 1);
+    }
+
+    if (!seg || !keys || (mode == SEGMENT_BACKWARD && !reversed))
+    {
+        perror("malloc");
+
+        free(seg);
+        free(keys);
+        free(reversed);
+
+        return NULL;
+    }
+
+    seg->idx = idx;
+    seg->mode = mode;
+
+    size_t nkeys = 0;
+    size_t off = 0;
+
+    for (uint32_t w = 0; w < idx->nwords; w++)
+    {
+        const struct dindex_word *word = &idx->words[w];
+        const uint8_t *str = (const uint8_t *)dindex_str(idx, word->str);
+
+        if (!word->len) { continue; }
+
+        if (reversed)
+        {
+            for (uint32_t i = 0; i < word->len; i++) {
+                reversed[off + i] = str[word->len - 1 - i];
+            }
+
+            str = &reversed[off];
+            off += word->len;
+        }
+
+        keys[nkeys++] = (struct _segment_key){ .str = str, .len = word->len };
+    }
+
+    // Words are already in byte order, but their reversals aren't.
+    if (reversed) {
+        qsort(keys, nkeys, sizeof(struct _segment_key), _segment_key_cmp);
+    }
+
+    struct _segment_builder b = {
+        .head = SEGMENT_NIL,
+        .tail = SEGMENT_NIL,
+        .keys = keys
+    };
+
+    int failed = _segment_grow(&b, 0x100);
+
+    if (!failed)
+    {
+        // The root is never a transition target, so it must not be handed out as a child.
+        _segment_take(&b, 0, 0);
+        failed = _segment_insert(&b, 0, 0, nkeys, 0);
+    }
+
+    free(keys);
+    free(reversed);
+    free(b.prev);
+    free(b.next);
+
+    if (failed)
+    {
+        free(b.cells);
+        free(seg);
+
+        return NULL;
+    }
+
+    // Everything past the largest base (plus a transition on any byte) is unused.
+    uint32_t ncells = b.max_base + 0x100;
+    struct segment_cell *shrunk = realloc(b.cells, ncells * sizeof(struct segment_cell));
+
+    seg->cells = (shrunk ? shrunk : b.cells);
+    seg->ncells = ncells;
+
+    if (DEBUG_SEGMENT) {
+        fprintf(stderr, "Built segmentation trie over %zu words (%u cells).\n", nkeys, ncells);
+    }
+
+    return seg;
+}
+
+static inline bool _segment_space(uint8_t c)
+{ return (c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\v' || c == '\f'); }
+
+static inline bool _segment_alnum(uint8_t c)
+{ return ((c >= '0' && c <= '9') || ((c | 0x20) >= 'a' && (c | 0x20) <= 'z')); }
+
+// Length of the character at `text[i]` (which must be before `end`). Invalid sequences are a single byte.
+static inline size_t _segment_char(const uint8_t *text, size_t i, size_t end)
+{
+    size_t bytes = UTF8_TRAILING_COUNT[text[i]];
+
+    if (text[i] < 0x80 || !bytes || bytes > 3 || (text[i] & 0xC0) == 0x80 || i + bytes >= end) { return 1; }
+
+    for (size_t j = 1; j <= bytes; j++)
+    {
+        if ((text[i + j] & 0xC0) != 0x80) { return 1; }
+    }
+
+    return bytes + 1;
+}
+
+// Length of the token starting at `text[i]` when the dictionary has nothing there.
+static inline size_t _segment_unknown(const uint8_t *text, size_t i, size_t end)
+{
+    if (!_segment_alnum(text[i])) { return _segment_char(text, i, end); }
+
+    size_t j = i + 1;
+
+    while (j < end && _segment_alnum(text[j])) {
+        j++;
+    }
+
+    return j - i;
+}
+
+// Start of the token ending at `text[i - 1]` when the dictionary has nothing there (with the run starting at `start`).
+static inline size_t _segment_unknown_back(const uint8_t *text, size_t start, size_t i)
+{
+    size_t j = i - 1;
+
+    if (_segment_alnum(text[j]))
+    {
+        while (j > start && _segment_alnum(text[j - 1])) {
+            j--;
+        }
+
+        return j;
+    }
+
+    // Back up over continuation bytes to the start of the character, if it really is one.
+    while (j > start && (text[j] & 0xC0) == 0x80 && i - j < 4) {
+        j--;
+    }
+
+    return (_segment_char(text, j, i) == i - j ? j : i - 1);
+}
+
+// Longest word starting at `text[i]` (0 if there are none).
+static inline size_t _segment_longest(const struct segment_cell *cells, const uint8_t *text, size_t i, size_t end)
+{
+    uint32_t s = 0;
+    size_t best = 0;
+
+    for (size_t j = i; j < end; j++)
+    {
+        if (!(s = segment_next(cells, s, text[j]))) { break; }
+
+        if (cells[s].base & SEGMENT_WORD) {
+            best = j + 1 - i;
+        }
+    }
+
+    return best;
+}
+
+// Split a run of text with no whitespace, adding tokens to `buf` starting at `*n`.
+static void _segment_run(const struct segmenter *seg, const uint8_t *text, size_t start, size_t end, struct segment_buf *buf, size_t *n)
+{
+    const struct segment_cell *cells = seg->cells;
+    uint32_t *tokens = buf->tokens;
+    size_t nt = (*n);
+
+    switch (seg->mode)
+    {
+        case SEGMENT_FORWARD: {
+            for (size_t i = start; i < end; )
+            {
+                size_t len = _segment_longest(cells, text, i, end);
+
+                if (!len) {
+                    len = _segment_unknown(text, i, end);
+                }
+
+                tokens[2 * nt] = i;
+                tokens[2 * nt + 1] = i + len;
+                nt++;
+
+                i += len;
+            }
+        } break;
+        case SEGMENT_BACKWARD: {
+            // Token starts come out right to left, so collect them first.
+            uint32_t *starts = buf->next;
+            size_t k = 0;
+
+            for (size_t i = end; i > start; )
+            {
+                uint32_t s = 0;
+                size_t from = i;
+
+                for (size_t j = i; j > start; j--)
+                {
+                    if (!(s = segment_next(cells, s, text[j - 1]))) { break; }
+
+                    if (cells[s].base & SEGMENT_WORD) {
+                        from = j - 1;
+                    }
+                }
+
+                if (from == i) {
+                    from = _segment_unknown_back(text, start, i);
+                }
+
+                starts[k++] = from;
+                i = from;
+            }
+
+            for (size_t m = k; m > 0; m--)
+            {
+                tokens[2 * nt] = starts[m - 1];
+                tokens[2 * nt + 1] = (m > 1 ? starts[m - 2] : end);
+                nt++;
+            }
+        } break;
+        case SEGMENT_DAG: {
+            // Fewest tokens from each position to the end of the run, and the length of the first one.
+            uint32_t *cost = buf->cost;
+            uint32_t *next = buf->next;
+
+            cost[end] = 0;
+
+            for (size_t i = end; i-- > start; )
+            {
+                size_t len = _segment_unknown(text, i, end);
+                uint32_t best = cost[i + len] + 1;
+
+                uint32_t s = 0;
+
+                for (size_t j = i; j < end; j++)
+                {
+                    if (!(s = segment_next(cells, s, text[j]))) { break; }
+                    if (!(cells[s].base & SEGMENT_WORD)) { continue; }
+
+                    size_t l = j + 1 - i;
+                    uint32_t c = cost[j + 1] + 1;
+
+                    if (c < best || (c == best && l > len))
+                    {
+                        best = c;
+                        len = l;
+                    }
+                }
+
+                cost[i] = best;
+                next[i] = len;
+            }
+
+            for (size_t i = start; i < end; i += next[i])
+            {
+                tokens[2 * nt] = i;
+                tokens[2 * nt + 1] = i + next[i];
+                nt++;
+            }
+        } break;
+    }
+
+    (*n) = nt;
+}
+
+int segment_text(const struct segmenter *seg, const char *text, size_t len, struct segment_buf *buf, size_t *ntokens)
+{
+    if (len >= UINT32_MAX)
+    {
+        fprintf(stderr, "Error: Text is too long to segment at once!\n");
+        return 1;
+    }
+
+    if (buf->cap < len + 1)
+    {
+        size_t cap = (buf->cap ? buf->cap : 4096);
+
+        while (cap < len + 1) {
+            cap *= 2;
+        }
+
+        uint32_t *tokens = realloc(buf->tokens, 2 * cap * sizeof(uint32_t));
+        if (tokens) { buf->tokens = tokens; }
+
+        uint32_t *cost = realloc(buf->cost, cap * sizeof(uint32_t));
+        if (cost) { buf->cost = cost; }
+
+        uint32_t *next = realloc(buf->next, cap * sizeof(uint32_t));
+        if (next) { buf->next = next; }
+
+        if (!tokens || !cost || !next)
+        {
+            perror("realloc");
+            return 1;
+        }
+
+        buf->cap = cap;
+    }
+
+    const uint8_t *str = (const uint8_t *)text;
+    size_t n = 0;
+
+    for (size_t i = 0; i < len; )
+    {
+        while (i < len && _segment_space(str[i])) {
+            i++;
+        }
+
+        size_t start = i;
+
+        while (i < len && !_segment_space(str[i])) {
+            i++;
+        }
+
+        if (start < i) {
+            _segment_run(seg, str, start, i, buf, &n);
+        }
+    }
+
+    (*ntokens) = n;
+    return 0;
+}
+
+void segment_buf_free(struct segment_buf *buf)
+{
+    free(buf->tokens);
+    free(buf->cost);
+    free(buf->next);
+
+    (*buf) = SEGMENT_BUF_INIT;
+}
+
+void segment_free(struct segmenter *seg)
+{
+    free(seg->cells);
+    free(seg);
+}
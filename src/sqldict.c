@@ -0,0 +1,337 @@
+/* ********************************************************** */
+/* -*- sqldict.c -*- Dictionary queries against sqlite    -*- */
+/* ********************************************************** */
+/* Tyler Besselman (C) October 2026                           */
+/* ********************************************************** */
+
+#include <strings.h>
+#include <string.h>
+#include <limits.h>
+#include <stdlib.h>
+
+#include <sqldict.h>
+#include <defzip.h>
+
+// Columns we look for, in order of preference for each (as named by `xlsx2sql` first, then by `conv`).
+enum {
+    SQLDICT_COL_WORD,
+    SQLDICT_COL_DEF,
+    SQLDICT_COL_ZHUYIN,
+    SQLDICT_COL_PINYIN,
+    SQLDICT_COL_STROKES,
+    SQLDICT_NCOLS
+};
+
+static const char *const _sqldict_names[SQLDICT_NCOLS][3] = {
+    [SQLDICT_COL_WORD]    = { "字詞名",   "字詞",     NULL },
+    [SQLDICT_COL_DEF]     = { "釋義",     "釋義資料", NULL },
+    [SQLDICT_COL_ZHUYIN]  = { "注音一式", "注音",     NULL },
+    [SQLDICT_COL_PINYIN]  = { "漢語拼音", "漢拼",     NULL },
+    [SQLDICT_COL_STROKES] = { "總筆畫數", "筆畫數",   NULL }
+};
+
+bool sqldict_is_file(const char *path)
+{
+    char buf[sizeof(SQLDICT_MAGIC)];
+    FILE *fp = fopen(path, "rb");
+
+    if (!fp) { return false; }
+
+    bool match = (fread(buf, 1, sizeof(buf), fp) == sizeof(buf) && !memcmp(buf, SQLDICT_MAGIC, sizeof(buf)));
+    fclose(fp);
+
+    return match;
+}
+
+// Find the first table with (at least) word and definition columns, filling in its name and the name of each column we know.
+// Names are allocated with `sqlite3_mprintf`, and missing columns are left NULL. `sheet_rows` is set if the table has an
+//   `id` column (as tables from `xlsx2sql` do). Returns non-zero if there is no such table.
+static int _sqldict_schema(sqlite3 *db, char **table, char **cols, bool *sheet_rows)
+{
+    sqlite3_stmt *tables = sqlite_prepare(db, "select name from sqlite_master where type = 'table' order by rowid;");
+    sqlite3_stmt *info = sqlite_prepare(db, "select name from pragma_table_info(?1);");
+
+    int found = 0;
+
+    while (tables && info && !found && sqlite_step(tables) == SQLITE_ROW)
+    {
+        const char *name = (const char *)sqlite3_column_text(tables, 0);
+        size_t rank[SQLDICT_NCOLS];
+
+        for (size_t c = 0; c < SQLDICT_NCOLS; c++)
+        {
+            sqlite3_free(cols[c]);
+
+            cols[c] = NULL;
+            rank[c] = SIZE_MAX;
+        }
+
+        (*sheet_rows) = false;
+
+        if (sqlite_bind_str(info, 1, name)) { break; }
+
+        while (sqlite_step(info) == SQLITE_ROW)
+        {
+            const char *col = (const char *)sqlite3_column_text(info, 0);
+
+            if (!strcmp(col, "id")) {
+                (*sheet_rows) = true;
+            }
+
+            for (size_t c = 0; c < SQLDICT_NCOLS; c++)
+            {
+                for (size_t i = 0; _sqldict_names[c][i] && i < rank[c]; i++)
+                {
+                    if (strcmp(col, _sqldict_names[c][i])) { continue; }
+
+                    sqlite3_free(cols[c]);
+
+                    cols[c] = sqlite3_mprintf("%s", col);
+                    rank[c] = i;
+                }
+            }
+        }
+
+        sqlite3_reset(info);
+
+        if (cols[SQLDICT_COL_WORD] && cols[SQLDICT_COL_DEF])
+        {
+            (*table) = sqlite3_mprintf("%s", name);
+            found = 1;
+        }
+    }
+
+    sqlite3_finalize(tables);
+    sqlite3_finalize(info);
+
+    if (!found) {
+        fprintf(stderr, "Error: No table has both word (字詞名) and definition (釋義) columns!\n");
+    }
+
+    return !found;
+}
+
+// Check if there is an index starting with `col` on `table` (otherwise every lookup scans the whole table).
+static bool _sqldict_indexed(sqlite3 *db, const char *table, const char *col)
+{
+    sqlite3_stmt *stmt = sqlite_prepare(db, "select count(*) from pragma_index_list(?1) as l, pragma_index_info(l.name) as i where i.seqno = 0 and i.name = ?2;");
+    if (!stmt) { return false; }
+
+    bool indexed = (!sqlite_bind_str(stmt, 1, table) && !sqlite_bind_str(stmt, 2, col)
+        && sqlite_step(stmt) == SQLITE_ROW && sqlite3_column_int(stmt, 0) > 0);
+
+    sqlite3_finalize(stmt);
+    return indexed;
+}
+
+// Prepare a statement from a query made with `sqlite3_mprintf`, freeing the query.
+static sqlite3_stmt *_sqldict_prepare(sqlite3 *db, char *query)
+{
+    if (!query)
+    {
+        fprintf(stderr, "Error: Out of memory building query!\n");
+        return NULL;
+    }
+
+    sqlite3_stmt *stmt = sqlite_prepare(db, query);
+    sqlite3_free(query);
+
+    return stmt;
+}
+
+struct sqldict *sqldict_open(const char *path)
+{
+    struct sqldict *sd = calloc(1, sizeof(struct sqldict));
+
+    if (!sd)
+    {
+        perror("calloc");
+        return NULL;
+    }
+
+    if (!(sd->db = sqlite_open(path, 1)))
+    {
+        free(sd);
+        return NULL;
+    }
+
+    char *table = NULL;
+    char *cols[SQLDICT_NCOLS] = { NULL };
+
+    // Databases from `conv -z` have compressed definitions, which are decompressed as they're read.
+    bool compressed = false;
+
+    // Memory use is bounded by the page cache, no matter how big the dictionary is.
+    char *pragma = sqlite3_mprintf("pragma cache_size = -%d;", SQLDICT_CACHE_KIB);
+    int failed = (!pragma || sqlite_exec(sd->db, pragma, NULL) || defzip_sqlite_attach(sd->db, &compressed) || _sqldict_schema(sd->db, &table, cols, &sd->sheet_rows));
+
+    sqlite3_free(pragma);
+
+    if (!failed)
+    {
+        const char *word = cols[SQLDICT_COL_WORD];
+        const char *zhuyin = cols[SQLDICT_COL_ZHUYIN];
+        const char *pinyin = cols[SQLDICT_COL_PINYIN];
+
+        if (!_sqldict_indexed(sd->db, table, word)) {
+            fprintf(stderr, "Warning: Column '%s' of '%s' has no index, so every lookup will scan the whole table.\n", word, table);
+        }
+
+        // Every entry query selects the same columns (in the order of `struct sqldict_entry`).
+        char *entry = sqlite3_mprintf("select rowid, \"%w\", %s(\"%w\"), %s%w%s, %s%w%s from \"%w\"",
+            word, (compressed ? DEFZIP_SQL_FUNC : ""), cols[SQLDICT_COL_DEF],
+            (zhuyin ? "\"" : ""), (zhuyin ? zhuyin : "null"), (zhuyin ? "\"" : ""),
+            (pinyin ? "\"" : ""), (pinyin ? pinyin : "null"), (pinyin ? "\"" : ""),
+            table);
+
+        // Stroke counts are only known for single characters, and words without one sort last.
+        char *strokes = (cols[SQLDICT_COL_STROKES] ? sqlite3_mprintf("min(\"%w\")", cols[SQLDICT_COL_STROKES]) : sqlite3_mprintf("null"));
+
+        // Every string with a prefix sorts before the prefix followed by 0xF5 (which can't appear in UTF-8).
+        char *range = sqlite3_mprintf("from \"%w\" where \"%w\" >= ?1 and \"%w\" < ?2", table, word, word);
+
+        if (!entry || !strokes || !range)
+        {
+            fprintf(stderr, "Error: Out of memory building query!\n");
+            failed = 1;
+        } else {
+            failed = !(sd->exact = _sqldict_prepare(sd->db, sqlite3_mprintf("%s where \"%w\" = ?1 order by rowid;", entry, word)))
+                || !(sd->prefix[DINDEX_ORDER_LEX] = _sqldict_prepare(sd->db,
+                    sqlite3_mprintf("select \"%w\", %s as n %s group by \"%w\" order by \"%w\" limit ?3;", word, strokes, range, word, word)))
+                || !(sd->prefix[DINDEX_ORDER_STROKES] = _sqldict_prepare(sd->db,
+                    sqlite3_mprintf("select \"%w\", %s as n %s group by \"%w\" order by n is null, n, \"%w\" limit ?3;", word, strokes, range, word, word)))
+                || !(sd->count = _sqldict_prepare(sd->db, sqlite3_mprintf("select count(distinct \"%w\") %s;", word, range)));
+        }
+
+        if (!failed && (zhuyin || pinyin))
+        {
+            // Either column is matched, so each can use its own index.
+            char *where = ((zhuyin && pinyin) ? sqlite3_mprintf("\"%w\" = ?1 or \"%w\" = ?1", zhuyin, pinyin)
+                                              : sqlite3_mprintf("\"%w\" = ?1", (zhuyin ? zhuyin : pinyin)));
+
+            failed = !(sd->pron = _sqldict_prepare(sd->db, (where ? sqlite3_mprintf("%s where %s order by rowid limit ?2;", entry, where) : NULL)));
+            sqlite3_free(where);
+        }
+
+        if (DEBUG_SQLDICT && !failed) {
+            fprintf(stderr, "Using table '%s' (word '%s', definition '%s').\n", table, word, cols[SQLDICT_COL_DEF]);
+        }
+
+        sqlite3_free(entry);
+        sqlite3_free(strokes);
+        sqlite3_free(range);
+    }
+
+    sqlite3_free(table);
+
+    for (size_t c = 0; c < SQLDICT_NCOLS; c++) {
+        sqlite3_free(cols[c]);
+    }
+
+    if (failed)
+    {
+        sqldict_close(sd);
+        return NULL;
+    }
+
+    return sd;
+}
+
+// Run an entry query (which must already be bound), performing a block on each row.
+static size_t _sqldict_entries(sqlite3_stmt *stmt, int (^blk)(const struct sqldict_entry *entry))
+{
+    size_t n = 0;
+
+    while (sqlite_step(stmt) == SQLITE_ROW)
+    {
+        struct sqldict_entry entry = {
+            .row = sqlite3_column_int64(stmt, 0),
+            .word = (const char *)sqlite3_column_text(stmt, 1),
+            .def = (const char *)sqlite3_column_text(stmt, 2),
+            .zhuyin = (const char *)sqlite3_column_text(stmt, 3),
+            .pinyin = (const char *)sqlite3_column_text(stmt, 4)
+        };
+
+        if (!entry.word) { continue; }
+
+        n++;
+        if (blk(&entry)) { break; }
+    }
+
+    sqlite3_reset(stmt);
+    return n;
+}
+
+// Clamp a result count for binding.
+static inline int _sqldict_limit(size_t k)
+{ return (k > INT_MAX ? INT_MAX : (int)k); }
+
+size_t sqldict_lookup(struct sqldict *sd, const char *word, int (^blk)(const struct sqldict_entry *entry))
+{
+    if (sqlite_bind_str(sd->exact, 1, word)) { return 0; }
+    return _sqldict_entries(sd->exact, blk);
+}
+
+size_t sqldict_prefix(struct sqldict *sd, const char *prefix, enum dindex_order order, size_t k, int (^blk)(const char *word, int64_t strokes))
+{
+    // The prefix comes straight from the user, so this is allocated rather than put on the stack.
+    char *end = sqlite3_mprintf("%s%c", prefix, 0xF5);
+
+    if (!end)
+    {
+        fprintf(stderr, "Error: Out of memory building query!\n");
+        return 0;
+    }
+
+    sqlite3_stmt *count = sd->count;
+    sqlite3_stmt *stmt = sd->prefix[order];
+
+    size_t total = 0;
+
+    if (!sqlite_bind_str(count, 1, prefix) && !sqlite_bind_str(count, 2, end))
+    {
+        total = (sqlite_step(count) == SQLITE_ROW ? (size_t)sqlite3_column_int64(count, 0) : 0);
+        sqlite3_reset(count);
+    }
+
+    if (total && k && !sqlite_bind_str(stmt, 1, prefix) && !sqlite_bind_str(stmt, 2, end) && !sqlite_bind_int(stmt, 3, _sqldict_limit(k)))
+    {
+        while (sqlite_step(stmt) == SQLITE_ROW)
+        {
+            const char *word = (const char *)sqlite3_column_text(stmt, 0);
+            int64_t strokes = (sqlite3_column_type(stmt, 1) == SQLITE_NULL ? -1 : sqlite3_column_int64(stmt, 1));
+
+            if (blk(word, strokes)) { break; }
+        }
+
+        sqlite3_reset(stmt);
+    }
+
+    sqlite3_free(end);
+    return total;
+}
+
+size_t sqldict_pron(struct sqldict *sd, const char *pron, size_t k, int (^blk)(const struct sqldict_entry *entry))
+{
+    if (!sd->pron)
+    {
+        fprintf(stderr, "Error: This dictionary has no pronunciation columns!\n");
+        return 0;
+    }
+
+    if (sqlite_bind_str(sd->pron, 1, pron) || sqlite_bind_int(sd->pron, 2, _sqldict_limit(k))) { return 0; }
+    return _sqldict_entries(sd->pron, blk);
+}
+
+void sqldict_close(struct sqldict *sd)
+{
+    // Finalizing NULL is harmless.
+    sqlite3_finalize(sd->exact);
+    sqlite3_finalize(sd->prefix[DINDEX_ORDER_LEX]);
+    sqlite3_finalize(sd->prefix[DINDEX_ORDER_STROKES]);
+    sqlite3_finalize(sd->count);
+    sqlite3_finalize(sd->pron);
+
+    sqlite_close(sd->db);
+    free(sd);
+}
@@ -5,10 +5,13 @@
 /* ********************************************************** */
 
 #include <sqlite.h>
+#include <trace.h>
 #include <stdio.h>
 
 sqlite3 *sqlite_open(const char *path, int readonly)
 {
+    TRACE_SPAN("sqlite_open", path);
+
     int flags = (readonly ? SQLITE_OPEN_READONLY : SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE);
     sqlite3 *db;
 
@@ -33,8 +36,10 @@ static int _sqlite_exec_callback(void *block, int cols, char **cvals, char **cna
 
 int sqlite_exec(sqlite3 *db, const char *query, int (^callback)(int cols, char **cvals, char **cnames))
 {
+    TRACE_SPAN("sqlite_exec", query);
+
     if (DEBUG_SQLITE) {
-        printf("sqlite_exec: '%s'\n", query);
+        fprintf(stderr, "sqlite_exec: '%s'\n", query);
     }
 
     // Possible error message.
@@ -60,10 +65,12 @@ int sqlite_exec(sqlite3 *db, const char *query, int (^callback)(int cols, char *
 
 sqlite3_stmt *sqlite_prepare(sqlite3 *db, const char *query)
 {
+    TRACE_SPAN("sqlite_prepare", query);
+
     sqlite3_stmt *res;
 
     if (DEBUG_SQLITE) {
-        printf("sqlite_prepare: '%s'\n", query);
+        fprintf(stderr, "sqlite_prepare: '%s'\n", query);
     }
 
     int code = sqlite3_prepare_v2(db, query, -1, &res, NULL);
@@ -85,6 +92,22 @@ int sqlite_bind_str(sqlite3_stmt *statement, int loc, const char *str)
     return (code != SQLITE_OK);
 }
 
+int sqlite_bind_strn(sqlite3_stmt *statement, int loc, const char *str, size_t len)
+{
+    int code = sqlite3_bind_text(statement, loc, str, (int)len, SQLITE_STATIC);
+
+    if (code != SQLITE_OK) { _sqlerror("sqlite3_bind", code); }
+    return (code != SQLITE_OK);
+}
+
+int sqlite_bind_blob(sqlite3_stmt *statement, int loc, const void *data, size_t len)
+{
+    int code = sqlite3_bind_blob(statement, loc, data, (int)len, SQLITE_STATIC);
+
+    if (code != SQLITE_OK) { _sqlerror("sqlite3_bind", code); }
+    return (code != SQLITE_OK);
+}
+
 int sqlite_bind_int(sqlite3_stmt *statement, int loc, int val)
 {
     int code = sqlite3_bind_int(statement, loc, val);
@@ -93,6 +116,14 @@ int sqlite_bind_int(sqlite3_stmt *statement, int loc, int val)
     return (code != SQLITE_OK);
 }
 
+int sqlite_bind_int64(sqlite3_stmt *statement, int loc, int64_t val)
+{
+    int code = sqlite3_bind_int64(statement, loc, val);
+
+    if (code != SQLITE_OK) { _sqlerror("sqlite3_bind", code); }
+    return (code != SQLITE_OK);
+}
+
 int sqlite_bind_null(sqlite3_stmt *statement, int loc)
 {
     int code = sqlite3_bind_null(statement, loc);
@@ -114,6 +145,8 @@ int sqlite_step(sqlite3_stmt *statement)
 
 int sqlite_close(sqlite3 *db)
 {
+    TRACE_SPAN("sqlite_close", NULL);
+
     int code = sqlite3_close_v2(db);
 
     if (code != SQLITE_OK) {
@@ -0,0 +1,153 @@
+/* ********************************************************** */
+/* -*- synth.c -*- Synthetic dictionary generator         -*- */
+/* ********************************************************** */
+/* Tyler Besselman (C) October 2026                           */
+/* ********************************************************** */
+
+#include <strings.h>
+#include <string.h>
+#include <stdio.h>
+
+#include <synth.h>
+#include <utf8.h>
+
+// Characters are drawn from this many codepoints starting at U+4E00.
+#define SYNTH_CHARS 6000
+
+// Percentage of rows which are single characters, long idioms, and repeats of an earlier word.
+#define SYNTH_SINGLE_PCT 10
+#define SYNTH_LONG_PCT   2
+#define SYNTH_REPEAT_PCT 3
+
+// Pick a character. Low codepoints are much more common, so lots of words share prefixes.
+static uint32_t _synth_char(uint64_t *state)
+{
+    double u = (double)(synth_rand(state) >> 11) / (double)(1ULL << 53);
+    return 0x4E00 + (uint32_t)(u * u * u * SYNTH_CHARS);
+}
+
+// Make a string of `n` random characters.
+static char *_synth_text(uint64_t *state, size_t n, const char *prefix, const char *suffix)
+{
+    size_t plen = strlen(prefix);
+    size_t slen = strlen(suffix);
+
+    char *str = malloc(plen + n * 4 + slen + 1);
+    if (!str) { return NULL; }
+
+    char *p = str;
+
+    memcpy(p, prefix, plen);
+    p += plen;
+
+    for (size_t i = 0; i < n; i++) {
+        p += utf8_encode(_synth_char(state), p);
+    }
+
+    memcpy(p, suffix, slen + 1);
+    return str;
+}
+
+static char *_synth_def(uint64_t *state)
+{
+    char *def = _synth_text(state, 10 + synth_below(state, 70), "1.　", "。");
+
+    // Some words have a second sense.
+    if (def && synth_below(state, 100) < 30)
+    {
+        char *more = _synth_text(state, 5 + synth_below(state, 40), "\n2.　", "。");
+        char *both = (more ? malloc(strlen(def) + strlen(more) + 1) : NULL);
+
+        if (both)
+        {
+            strcpy(both, def);
+            strcat(both, more);
+        }
+
+        free(def);
+        free(more);
+
+        def = both;
+    }
+
+    return def;
+}
+
+struct xlsx *synth_dict(size_t rows, uint64_t seed)
+{
+    static const char *headers[SYNTH_COLS] = { "字詞名", "釋義", "總筆畫數" };
+
+    struct xlsx *doc = calloc(1, sizeof(struct xlsx));
+    struct xlsx_value *grid = calloc((rows + 1) * SYNTH_COLS, sizeof(struct xlsx_value));
+
+    if (!doc || !grid)
+    {
+        perror("calloc");
+
+        free(doc);
+        free(grid);
+
+        return NULL;
+    }
+
+    doc->rows = rows + 1;
+    doc->cols = SYNTH_COLS;
+    doc->grid = grid;
+
+    for (size_t i = 0; i < doc->rows * SYNTH_COLS; i++) {
+        grid[i].type = XLSX_TYPE_NULL;
+    }
+
+    for (size_t c = 0; c < SYNTH_COLS; c++)
+    {
+        grid[c].type = XLSX_TYPE_LSTR;
+
+        if (!(grid[c].str = strdup(headers[c]))) { goto fail; }
+    }
+
+    uint64_t state = seed;
+
+    for (size_t r = 1; r <= rows; r++)
+    {
+        struct xlsx_value *row = &grid[r * SYNTH_COLS];
+        uint64_t kind = synth_below(&state, 100);
+        char *word;
+
+        if (kind < SYNTH_REPEAT_PCT && r > 1) {
+            // Another pronunciation of an earlier word.
+            word = strdup(grid[(1 + synth_below(&state, r - 1)) * SYNTH_COLS + SYNTH_COL_WORD].str);
+        } else if (kind < SYNTH_REPEAT_PCT + SYNTH_SINGLE_PCT) {
+            uint32_t cp = _synth_char(&state);
+            word = malloc(5);
+
+            if (word) {
+                word[utf8_encode(cp, word)] = 0;
+            }
+
+            // Keep stroke counts consistent for the same character.
+            row[SYNTH_COL_STROKES].type = XLSX_TYPE_INT;
+            row[SYNTH_COL_STROKES].ival = 1 + (cp % 30);
+        } else if (kind < SYNTH_REPEAT_PCT + SYNTH_SINGLE_PCT + SYNTH_LONG_PCT) {
+            word = _synth_text(&state, 8 + synth_below(&state, 5), "", "");
+        } else {
+            word = _synth_text(&state, 2 + synth_below(&state, 3), "", "");
+        }
+
+        row[SYNTH_COL_WORD].type = XLSX_TYPE_LSTR;
+        row[SYNTH_COL_WORD].str = word;
+
+        row[SYNTH_COL_DEF].type = XLSX_TYPE_LSTR;
+        row[SYNTH_COL_DEF].str = _synth_def(&state);
+
+        if (!word || !row[SYNTH_COL_DEF].str) { goto fail; }
+    }
+
+    return doc;
+
+fail:
+    perror("malloc");
+
+    // Anything we didn't get to is still NULL, which is fine to free.
+    xlsx_doc_free(doc);
+    return NULL;
+}
@@ -0,0 +1,191 @@
+/* ********************************************************** */
+/* -*- trace.c -*- Timeline tracing of scoped spans       -*- */
+/* ********************************************************** */
+/* Tyler Besselman (C) October 2026                           */
+/* ********************************************************** */
+
+#include <pthread.h>
+#include <strings.h>
+#include <string.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <stdio.h>
+
+#include <trace.h>
+
+// A finished span.
+struct _trace_event {
+    const char *name;
+
+    uint64_t start;
+    uint64_t end;
+
+    char detail[TRACE_DETAIL];
+};
+
+// Spans recorded by a single thread. Only that thread writes to it, so recording never takes a lock.
+struct _trace_ring {
+    struct _trace_event events[TRACE_RING];
+    uint64_t count;
+
+    uint32_t tid;
+    struct _trace_ring *next;
+};
+
+bool trace_on = false;
+
+// Where the trace goes, and when tracing started (timestamps are relative to this).
+static const char *_trace_path;
+static uint64_t _trace_base;
+
+// Every thread's ring (for writing them all out).
+static pthread_mutex_t _trace_lock = PTHREAD_MUTEX_INITIALIZER;
+static struct _trace_ring *_trace_rings;
+static uint32_t _trace_threads;
+
+static __thread struct _trace_ring *_trace_ring;
+
+// Make a ring for the calling thread (NULL on failure, in which case its spans are dropped).
+static struct _trace_ring *_trace_ring_new(void)
+{
+    struct _trace_ring *ring = calloc(1, sizeof(struct _trace_ring));
+
+    if (!ring)
+    {
+        perror("calloc");
+        return NULL;
+    }
+
+    pthread_mutex_lock(&_trace_lock);
+
+    ring->tid = ++_trace_threads;
+    ring->next = _trace_rings;
+    _trace_rings = ring;
+
+    pthread_mutex_unlock(&_trace_lock);
+
+    return ring;
+}
+
+void _trace_record(const struct trace_span *span, uint64_t end)
+{
+    struct _trace_ring *ring = _trace_ring;
+
+    if (!ring && !(ring = _trace_ring = _trace_ring_new())) {
+        return;
+    }
+
+    struct _trace_event *event = &ring->events[ring->count++ & (TRACE_RING - 1)];
+
+    event->name = span->name;
+    event->start = span->start;
+    event->end = end;
+
+    const char *detail = (span->detail ? span->detail : "");
+    size_t len = strnlen(detail, TRACE_DETAIL - 1);
+
+    // Don't cut a character in half if the detail doesn't fit.
+    while (len && detail[len] && ((uint8_t)detail[len] & 0xC0) == 0x80) {
+        len--;
+    }
+
+    memcpy(event->detail, detail, len);
+    event->detail[len] = 0;
+}
+
+// Write a JSON string.
+static void _trace_puts(FILE *fp, const char *str)
+{
+    fputc('"', fp);
+
+    for (const unsigned char *p = (const unsigned char *)str; *p; p++)
+    {
+        if (*p == '"' || *p == '\\') {
+            fprintf(fp, "\\%c", *p);
+        } else if (*p < 0x20) {
+            fprintf(fp, "\\u%04x", *p);
+        } else {
+            fputc(*p, fp);
+        }
+    }
+
+    fputc('"', fp);
+}
+
+// Write every thread's spans (oldest first) as Chrome trace "complete" events.
+static void _trace_write(void)
+{
+    FILE *fp = fopen(_trace_path, "w");
+
+    if (!fp)
+    {
+        perror("fopen");
+        return;
+    }
+
+    pthread_mutex_lock(&_trace_lock);
+
+    long pid = (long)getpid();
+    uint64_t dropped = 0;
+    bool first = true;
+
+    fputs("{\"traceEvents\":[\n", fp);
+
+    for (struct _trace_ring *ring = _trace_rings; ring; ring = ring->next)
+    {
+        uint64_t start = (ring->count > TRACE_RING ? ring->count - TRACE_RING : 0);
+        dropped += start;
+
+        for (uint64_t i = start; i < ring->count; i++)
+        {
+            const struct _trace_event *event = &ring->events[i & (TRACE_RING - 1)];
+
+            // Timestamps are in microseconds.
+            fprintf(fp, "%s{\"name\":", (first ? "" : ",\n"));
+            _trace_puts(fp, event->name);
+
+            fprintf(fp, ",\"ph\":\"X\",\"pid\":%ld,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f", pid, ring->tid,
+                    (double)(event->start - _trace_base) / 1000.0, (double)(event->end - event->start) / 1000.0);
+
+            if (event->detail[0])
+            {
+                fputs(",\"args\":{\"detail\":", fp);
+                _trace_puts(fp, event->detail);
+                fputc('}', fp);
+            }
+
+            fputc('}', fp);
+            first = false;
+        }
+    }
+
+    fputs("\n],\"displayTimeUnit\":\"ms\"}\n", fp);
+
+    pthread_mutex_unlock(&_trace_lock);
+
+    if (fclose(fp)) {
+        perror("fclose");
+    }
+
+    if (dropped) {
+        fprintf(stderr, "Warning: Trace dropped the oldest %llu spans (over %d per thread).\n", (unsigned long long)dropped, TRACE_RING);
+    }
+}
+
+// Check the environment once, before anything else runs.
+__attribute__((constructor)) static void _trace_init(void)
+{
+    const char *path = getenv(TRACE_ENV);
+    if (!path || !path[0]) { return; }
+
+    _trace_path = path;
+    _trace_base = trace_now();
+
+    if (atexit(_trace_write))
+    {
+        fprintf(stderr, "Error: Failed to register trace writer (tracing is off).\n");
+        return;
+    }
+
+    trace_on = true;
+}
@@ -0,0 +1,304 @@
+/* ********************************************************** */
+/* -*- wildcard.c -*- Positional wildcard word search     -*- */
+/* ********************************************************** */
+/* Tyler Besselman (C) October 2026                           */
+/* ********************************************************** */
+
+#include <strings.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+#include <wildcard.h>
+#include <utf8.h>
+
+// Decode up to `max` codepoints from a string. Returns the total number of codepoints (even if more than `max`).
+static size_t _wildcard_decode(const char *str, uint32_t *out, size_t max)
+{
+    size_t n = 0;
+
+    while (*str)
+    {
+        uint32_t cp = utf8_next(&str);
+
+        if (n < max) {
+            out[n] = cp;
+        }
+
+        n++;
+    }
+
+    return n;
+}
+
+// A word list being walked during a search.
+struct _wildcard_list {
+    const uint32_t *next;
+    const uint32_t *end;
+};
+
+static int _wildcard_pair_cmp(const void *a, const void *b)
+{
+    uint64_t x = *(const uint64_t *)a;
+    uint64_t y = *(const uint64_t *)b;
+
+    return (x > y) - (x < y);
+}
+
+bool wildcard_is_pattern(const char *query)
+{
+    while (*query)
+    {
+        uint32_t cp = utf8_next(&query);
+        if (cp == WILDCARD_ANY || cp == WILDCARD_ANY_WIDE) { return true; }
+    }
+
+    return false;
+}
+
+struct wildcard *wildcard_build(const struct dindex *idx)
+{
+    struct wildcard *wc = calloc(1, sizeof(struct wildcard));
+
+    if (!wc)
+    {
+        perror("calloc");
+        return NULL;
+    }
+
+    wc->idx = idx;
+
+    // Each indexed word has one pair per codepoint, plus one for its length.
+    size_t npairs = 0;
+
+    for (uint32_t w = 0; w < idx->nwords; w++)
+    {
+        size_t len = utf8_count(dindex_str(idx, idx->words[w].str));
+
+        if (len && len <= WILDCARD_MAX_LEN) {
+            npairs += len + 1;
+        }
+    }
+
+    // Collect every (key, word) pair as a single value, so sorting groups words by key in order.
+    uint64_t *pairs = malloc(npairs * sizeof(uint64_t) + 1);
+
+    if (!pairs)
+    {
+        perror("malloc");
+        wildcard_free(wc);
+
+        return NULL;
+    }
+
+    size_t n = 0;
+
+    for (uint32_t w = 0; w < idx->nwords; w++)
+    {
+        uint32_t cps[WILDCARD_MAX_LEN];
+        size_t len = _wildcard_decode(dindex_str(idx, idx->words[w].str), cps, WILDCARD_MAX_LEN);
+
+        if (!len || len > WILDCARD_MAX_LEN) { continue; }
+
+        pairs[n++] = ((uint64_t)WILDCARD_KEY(0, len, 0) << 32) | w;
+
+        for (size_t i = 0; i < len; i++) {
+            pairs[n++] = ((uint64_t)WILDCARD_KEY(cps[i], len, i) << 32) | w;
+        }
+    }
+
+    qsort(pairs, npairs, sizeof(uint64_t), _wildcard_pair_cmp);
+
+    // Count distinct keys so we can size everything exactly.
+    uint32_t nkeys = 0;
+
+    for (size_t i = 0; i < npairs; i++)
+    {
+        if (!i || (pairs[i] >> 32) != (pairs[i - 1] >> 32)) {
+            nkeys++;
+        }
+    }
+
+    wc->keys = malloc(nkeys * sizeof(uint32_t) + 1);
+    wc->offsets = malloc((nkeys + 1) * sizeof(uint32_t));
+    wc->postings = malloc(npairs * sizeof(uint32_t) + 1);
+    wc->nkeys = nkeys;
+
+    if (!wc->keys || !wc->offsets || !wc->postings)
+    {
+        perror("malloc");
+
+        free(pairs);
+        wildcard_free(wc);
+
+        return NULL;
+    }
+
+    uint32_t k = 0;
+
+    for (size_t i = 0; i < npairs; i++)
+    {
+        if (!i || (pairs[i] >> 32) != (pairs[i - 1] >> 32))
+        {
+            wc->keys[k] = pairs[i] >> 32;
+            wc->offsets[k++] = i;
+        }
+
+        wc->postings[i] = (uint32_t)pairs[i];
+    }
+
+    wc->offsets[nkeys] = npairs;
+    free(pairs);
+
+    if (DEBUG_WILDCARD) {
+        fprintf(stderr, "Wildcard index has %u keys, %zu postings.\n", nkeys, npairs);
+    }
+
+    return wc;
+}
+
+// Find the word list for a key. Returns false if no word has it.
+static bool _wildcard_postings(const struct wildcard *wc, uint32_t key, const uint32_t **start, const uint32_t **end)
+{
+    uint32_t lo = 0;
+    uint32_t hi = wc->nkeys;
+
+    while (lo < hi)
+    {
+        uint32_t mid = lo + (hi - lo) / 2;
+
+        if (wc->keys[mid] < key) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+
+    if (lo >= wc->nkeys || wc->keys[lo] != key) { return false; }
+
+    (*start) = &wc->postings[wc->offsets[lo]];
+    (*end) = &wc->postings[wc->offsets[lo + 1]];
+
+    return true;
+}
+
+// Find the first word in a list at or after `w`, probing 1, 2, 4, ... ahead before searching.
+// Skipping through a long list this way only costs time proportional to the log of each gap.
+static const uint32_t *_wildcard_gallop(const uint32_t *next, const uint32_t *end, uint32_t w)
+{
+    if (next == end || *next >= w) { return next; }
+
+    // Here `next[lo] < w`, and the answer is somewhere in `(lo, hi]`.
+    size_t n = end - next;
+    size_t lo = 0;
+    size_t hi = 1;
+
+    while (hi < n && next[hi] < w)
+    {
+        lo = hi;
+        hi *= 2;
+    }
+
+    if (hi > n) { hi = n; }
+    lo++;
+
+    while (lo < hi)
+    {
+        size_t mid = lo + (hi - lo) / 2;
+
+        if (next[mid] < w) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+
+    return &next[lo];
+}
+
+size_t wildcard_match(const struct wildcard *wc, const char *pattern, size_t k, int (^blk)(const struct dindex_word *word))
+{
+    uint32_t cps[WILDCARD_MAX_LEN];
+    size_t len = _wildcard_decode(pattern, cps, WILDCARD_MAX_LEN);
+
+    if (!len || len > WILDCARD_MAX_LEN) { return 0; }
+
+    struct _wildcard_list lists[WILDCARD_MAX_LEN];
+
+    size_t nlists = 0;
+
+    for (size_t i = 0; i < len; i++)
+    {
+        if (cps[i] == WILDCARD_ANY || cps[i] == WILDCARD_ANY_WIDE) { continue; }
+
+        // Nothing can match if some position has no words at all.
+        if (!_wildcard_postings(wc, WILDCARD_KEY(cps[i], len, i), &lists[nlists].next, &lists[nlists].end)) { return 0; }
+
+        // Keep lists sorted by size, so the shortest one drives the intersection.
+        size_t j = nlists++;
+
+        while (j && (lists[j].end - lists[j].next) < (lists[j - 1].end - lists[j - 1].next))
+        {
+            struct _wildcard_list t = lists[j];
+
+            lists[j] = lists[j - 1];
+            lists[j - 1] = t;
+
+            j--;
+        }
+    }
+
+    // A pattern which is all wildcards matches every word of its length.
+    if (!nlists)
+    {
+        if (!_wildcard_postings(wc, WILDCARD_KEY(0, len, 0), &lists[0].next, &lists[0].end)) { return 0; }
+        nlists = 1;
+    }
+
+    // With a single list, every word in it matches.
+    if (nlists == 1)
+    {
+        size_t total = lists[0].end - lists[0].next;
+
+        for (size_t i = 0; i < total && i < k; i++) {
+            if (blk(&wc->idx->words[lists[0].next[i]])) { break; }
+        }
+
+        return total;
+    }
+
+    size_t total = 0;
+    bool stopped = !k;
+
+    for (const uint32_t *w = lists[0].next; w < lists[0].end; w++)
+    {
+        bool match = true;
+
+        for (size_t i = 1; i < nlists && match; i++)
+        {
+            lists[i].next = _wildcard_gallop(lists[i].next, lists[i].end, *w);
+
+            // Once any list runs out, nothing else can match.
+            if (lists[i].next == lists[i].end) { return total; }
+
+            match = (*lists[i].next == *w);
+        }
+
+        if (!match) { continue; }
+
+        // Keep counting after we have `k` words (or `blk` stops us), so we can say how many there are.
+        if (total++ < k && !stopped) {
+            stopped = blk(&wc->idx->words[*w]);
+        }
+    }
+
+    return total;
+}
+
+void wildcard_free(struct wildcard *wc)
+{
+    free(wc->keys);
+    free(wc->offsets);
+    free(wc->postings);
+
+    free(wc);
+}
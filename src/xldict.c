@@ -6,109 +6,937 @@
 
 #include <strings.h>
 #include <stdbool.h>
+#include <limits.h>
+#include <errno.h>
+#include <unistd.h>
+#include <getopt.h>
 
+#include <dindex.h>
+#include <facets.h>
+#include <fst.h>
+#include <fuzzy.h>
+#include <obuf.h>
+#include <pool.h>
+#include <sarray.h>
+#include <sqldict.h>
+#include <utf8.h>
+#include <wildcard.h>
 #include <xlsx.h>
 
-static int do_query(struct xlsx *doc, const char *query, off_t names, off_t defs)
+// Number of queries each thread answers at a time in batch mode.
+#define BATCH_CHUNK 256
+
+// Number of chunks per thread we read in before writing anything out in batch mode.
+#define BATCH_WINDOW 4
+
+// Longest prefix query we look up (in bytes). No word comes close, and anything longer is just no results.
+#define QUERY_MAX 1024
+
+// Most worker threads we start for batch mode and suffix array builds.
+#define THREADS_MAX 1024
+
+// Perform a block on each entry for a word, through the FST if there is one (otherwise the index's own word table).
+static size_t word_lookup(const struct dindex *idx, const struct fst *fst, const char *word, int (^blk)(const struct dindex_entry *entry))
+{ return (fst ? fst_lookup(fst, idx, word, blk) : dindex_lookup(idx, word, blk)); }
+
+// Perform a block on up to `k` words starting with `prefix` (with their stroke counts), like `word_lookup`.
+static size_t word_prefix(const struct dindex *idx, const struct fst *fst, const char *prefix, enum dindex_order order, size_t k, int (^blk)(const char *word, uint32_t strokes))
+{
+    if (fst)
+    {
+        return fst_complete(fst, idx, prefix, order, k, ^(const char *word, size_t len, uint32_t strokes) {
+            return blk(word, strokes);
+        });
+    }
+
+    return dindex_prefix(idx, prefix, order, k, ^(const struct dindex_word *word) {
+        return blk(dindex_str(idx, word->str), word->strokes);
+    });
+}
+
+// Print all definitions for a query. Returns the number of matches found.
+static size_t do_query(struct dindex *idx, struct fst *fst, const char *query)
 {
     __block unsigned int matches = 0;
 
-    xlsx_iter_col(doc, names, ^(struct xlsx_value *val, size_t row) {
-        if (val->type != XLSX_TYPE_STR)
-        {
-            fprintf(stderr, "Error: Entry is not a string!\n");
-            return 1;
+    return word_lookup(idx, fst, query, ^(const struct dindex_entry *entry) {
+        matches++;
+
+        printf("Found '%s' at %u.\n", query, entry->row + 1);
+
+        if (entry->def == DINDEX_NONE) {
+            fprintf(stderr, "Error: Definition is not of string type!\n");
+        } else {
+            printf("Definition %u:\n%s\n", matches, dindex_str(idx, entry->def));
         }
 
-        const char *name = xlsx_str(doc, val);
+        return 0;
+    });
+}
 
-        if (!strcmp(name, query))
-        {
-            matches++;
+// Print up to `k` words starting with `prefix`. Returns the number of words with this prefix.
+static size_t do_complete(struct dindex *idx, struct fst *fst, const char *prefix, enum dindex_order order, size_t k)
+{
+    size_t total = word_prefix(idx, fst, prefix, order, k, ^(const char *word, uint32_t strokes) {
+        printf("  %s (%u)\n", word, strokes);
+        return 0;
+    });
 
-            struct xlsx_value *info = xlsx_row(doc, row);
-            if (!info) { return false; }
+    if (total > k) {
+        printf("  ... (%zu more)\n", total - k);
+    }
 
-            printf("Found '%s' at %zu.\n", query, row + 1);
+    return total;
+}
 
-            struct xlsx_value *def = &info[defs];
-            if (!def) { return true; }
+// Print up to `k` words close to `word`. Returns the number of words found.
+static size_t do_fuzzy(struct fuzzy *fz, const char *word, size_t k)
+{
+    return fuzzy_lookup(fz, word, fuzzy_default_dist(utf8_count(word)), k, ^(const struct dindex_word *match, size_t dist) {
+        printf("  %s (distance %zu)\n", dindex_str(fz->idx, match->str), dist);
+        return 0;
+    });
+}
 
-            if (def->type != XLSX_TYPE_STR) {
-                fprintf(stderr, "Error: Definition is not of string type! (type=%d)\n", def->type);
-            } else {
-                printf("Definition %u:\n%s\n", matches, xlsx_str(doc, def));
-            }
+// Print up to `k` entries whose definitions contain `phrase`. Returns the number of occurrences.
+static size_t do_phrase(struct sarray *sa, const char *phrase, size_t k)
+{
+    __block size_t entries = 0;
+
+    size_t total = sarray_search(sa, phrase, ^(const struct dindex_entry *entry, size_t count) {
+        if (entries++ < k) {
+            printf("  %s (row %u): %zu time%s\n", dindex_str(sa->idx, entry->word), entry->row + 1, count, (count == 1 ? "" : "s"));
         }
 
         return 0;
     });
 
-    return !!matches;
+    if (entries > k) {
+        printf("  ... (%zu more)\n", entries - k);
+    }
+
+    if (total) {
+        printf("Found %zu occurrences in %zu entries.\n", total, entries);
+    }
+
+    return total;
+}
+
+// Print up to `k` characters matching a filter. Returns the number of characters found (or 0 on failure).
+static size_t do_filter(struct facets *fc, const char *filter, size_t k)
+{
+    struct bitmap matches = BITMAP_INIT;
+    if (facets_filter(fc, filter, &matches)) { return 0; }
+
+    size_t total = bitmap_card(&matches);
+
+    if (k)
+    {
+        __block size_t n = 0;
+
+        bitmap_foreach(&matches, ^(uint32_t id) {
+            printf("  %s (row %u)\n", fc->chars[id], fc->rows[id] + 1);
+            return (++n >= k);
+        });
+    }
+
+    if (total > k) {
+        printf("  ... (%zu more)\n", total - k);
+    }
+
+    if (total) {
+        printf("Found %zu characters.\n", total);
+    }
+
+    bitmap_free(&matches);
+    return total;
+}
+
+// Print up to `k` words matching a wildcard pattern. Returns the number of matching words.
+static size_t do_wildcard(struct wildcard *wc, const char *pattern, size_t k)
+{
+    size_t total = wildcard_match(wc, pattern, k, ^(const struct dindex_word *word) {
+        printf("  %s\n", dindex_str(wc->idx, word->str));
+        return 0;
+    });
+
+    if (total > k) {
+        printf("  ... (%zu more)\n", total - k);
+    }
+
+    return total;
 }
 
-int main(int argc, const char *const *argv)
+// Append a string to a buffer, escaping anything which would break a TSV line.
+static int tsv_escape(struct obuf *out, const char *str)
 {
-    if (argc != 2)
+    const char *run = str;
+
+    for (; *str; str++)
     {
-        fprintf(stderr, "Error: Need exactly 1 argument.\n");
+        const char *esc = NULL;
+
+        switch (*str)
+        {
+            case '\n': esc = "\\n";  break;
+            case '\r': esc = "\\r";  break;
+            case '\t': esc = "\\t";  break;
+            case '\\': esc = "\\\\"; break;
+            default: continue;
+        }
+
+        if (obuf_append(out, run, str - run) || obuf_puts(out, esc)) { return 1; }
+        run = str + 1;
+    }
+
+    return obuf_append(out, run, str - run);
+}
+
+// Format the answer to a single query in batch mode.
+// Each result is a line with the query, the word, its row number, and its definition (tab separated).
+// Completions only have the first two fields, and queries with no results only have the first.
+// Approximate matches (for queries starting with '~') have the edit distance (as "~N") in place of the row number.
+// Phrase searches (for queries starting with '@') give up to `k` entries whose definitions contain the phrase, like lookups.
+// Filters (for queries starting with '=') give up to `k` matching characters with their row numbers (and no definition).
+// Wildcard patterns (queries with a '?' in them) give up to `k` matching words, like completions.
+static int batch_answer(struct dindex *idx, struct fst *fst, struct fuzzy *fz, struct wildcard *wc, struct sarray *sa, struct facets *fc, const char *query, enum dindex_order order, size_t k, struct obuf *out)
+{
+    size_t len = strlen(query);
+    __block int failed = 0;
+
+    if (query[0] == '=' && fc) {
+        struct bitmap matches = BITMAP_INIT;
+        __block size_t n = 0;
+
+        // Bad filters are reported (on stderr) and answered like queries with no results.
+        if (!facets_filter(fc, &query[1], &matches) && k)
+        {
+            bitmap_foreach(&matches, ^(uint32_t id) {
+                failed = (tsv_escape(out, query) || obuf_printf(out, "\t%s\t%u\t\n", fc->chars[id], fc->rows[id] + 1));
+                return (failed || ++n >= k);
+            });
+        }
+
+        bitmap_free(&matches);
+        if (n) { return failed; }
+    } else if (query[0] == '@' && sa) {
+        __block size_t n = 0;
+
+        // Asking for no entries gets no results (the block would still be called once).
+        if (k && sarray_search(sa, &query[1], ^(const struct dindex_entry *entry, size_t count) {
+            failed = (tsv_escape(out, query) || obuf_printf(out, "\t%s\t%u\t", dindex_str(idx, entry->word), entry->row + 1));
+
+            if (!failed && entry->def != DINDEX_NONE) {
+                failed = tsv_escape(out, dindex_str(idx, entry->def));
+            }
+
+            failed = (failed || obuf_puts(out, "\n"));
+            return (failed || ++n >= k);
+        })) { return failed; }
+    } else if (query[0] == '~' && fz) {
+        const char *word = &query[1];
+
+        if (fuzzy_lookup(fz, word, fuzzy_default_dist(utf8_count(word)), k, ^(const struct dindex_word *match, size_t dist) {
+            failed = (tsv_escape(out, query) || obuf_printf(out, "\t%s\t~%zu\t\n", dindex_str(idx, match->str), dist));
+            return failed;
+        })) { return failed; }
+    } else if (wildcard_is_pattern(query) && wc) {
+        __block size_t n = 0;
+
+        // Like completions, this returns how many words match (even with none asked for), so count the lines written.
+        wildcard_match(wc, query, k, ^(const struct dindex_word *word) {
+            failed = (tsv_escape(out, query) || obuf_printf(out, "\t%s\t\t\n", dindex_str(idx, word->str)));
+            n++;
+
+            return failed;
+        });
+
+        if (n || failed) { return failed; }
+    } else if (len && query[len - 1] == '*') {
+        char prefix[QUERY_MAX];
+        __block size_t n = 0;
+
+        if (len <= QUERY_MAX)
+        {
+            memcpy(prefix, query, len - 1);
+            prefix[len - 1] = 0;
+
+            word_prefix(idx, fst, prefix, order, k, ^(const char *word, uint32_t strokes) {
+                failed = (tsv_escape(out, query) || obuf_printf(out, "\t%s\t\t\n", word));
+                n++;
+
+                return failed;
+            });
+        }
+
+        if (n || failed) { return failed; }
+    } else {
+        if (word_lookup(idx, fst, query, ^(const struct dindex_entry *entry) {
+            failed = (tsv_escape(out, query) || obuf_printf(out, "\t%s\t%u\t", dindex_str(idx, entry->word), entry->row + 1));
+
+            if (!failed && entry->def != DINDEX_NONE) {
+                failed = tsv_escape(out, dindex_str(idx, entry->def));
+            }
+
+            failed = (failed || obuf_puts(out, "\n"));
+            return failed;
+        })) { return failed; }
+    }
+
+    // No results at all.
+    return (tsv_escape(out, query) || obuf_puts(out, "\t\t\t\n"));
+}
+
+// Answer every query (one per line) from `in`, writing answers to `out` in the same order.
+// Queries are read and answered a window at a time, with each thread formatting a chunk of answers into its own buffer.
+// The fuzzy and wildcard indexes are built (into `*fz` and `*wc`) before the first window with a query needing them.
+static int do_batch(struct dindex *idx, struct fst *fst, struct fuzzy **fz, struct wildcard **wc, struct sarray *sa, struct facets *fc, FILE *in, FILE *out, size_t threads, enum dindex_order order, size_t k)
+{
+    struct pool *pool = pool_create(threads);
+    if (!pool) { return 1; }
+
+    size_t nchunks = BATCH_WINDOW * pool_threads(pool);
+    size_t window = nchunks * BATCH_CHUNK;
+
+    char **queries = calloc(window, sizeof(char *));
+    struct obuf *bufs = calloc(nchunks, sizeof(struct obuf));
+
+    if (!queries || !bufs)
+    {
+        perror("calloc");
+        pool_destroy(pool);
+
+        free(queries);
+        free(bufs);
+
         return 1;
     }
 
-    struct xlsx *doc = xlsx_doc_at(argv[1]);
-    if (!doc) { return 1; }
+    char *line = NULL;
+    size_t cap = 0;
+
+    bool eof = false;
+    int status = 0;
+
+    // Set once building the fuzzy or wildcard index failed, so it isn't tried again.
+    bool fz_failed = false;
+    bool wc_failed = false;
+
+    while (!eof && !status)
+    {
+        size_t n = 0;
+        ssize_t len;
+
+        while (n < window && (len = getline(&line, &cap, in)) >= 0)
+        {
+            // Remove trailing newline (and carriage return for files from Windows).
+            while (len && (line[len - 1] == '\n' || line[len - 1] == '\r')) {
+                line[--len] = 0;
+            }
+
+            if (!len) { continue; }
+
+            if (!(queries[n++] = strdup(line)))
+            {
+                perror("strdup");
+                status = 1;
+
+                break;
+            }
+        }
+
+        eof = (n < window);
+
+        // Build the fuzzy and wildcard indices the first time a query needs them. A failed build isn't tried again:
+        //   queries needing it are answered as having no results, and the batch fails once every query is answered.
+        for (size_t i = 0; i < n && queries[i]; i++)
+        {
+            if (queries[i][0] == '~')
+            {
+                if (!*fz && !fz_failed) {
+                    fz_failed = !(*fz = fuzzy_build(idx));
+                }
+            } else if (!*wc && !wc_failed && wildcard_is_pattern(queries[i])) {
+                wc_failed = !(*wc = wildcard_build(idx));
+            }
+        }
+
+        struct fuzzy *window_fz = *fz;
+        struct wildcard *window_wc = *wc;
+        __block int failed = 0;
+
+        pool_apply(pool, (n + BATCH_CHUNK - 1) / BATCH_CHUNK, ^(size_t c) {
+            size_t end = (c + 1) * BATCH_CHUNK;
+            if (end > n) { end = n; }
+
+            for (size_t i = c * BATCH_CHUNK; i < end && queries[i]; i++)
+            {
+                if (batch_answer(idx, fst, window_fz, window_wc, sa, fc, queries[i], order, k, &bufs[c])) {
+                    failed = 1;
+                }
+            }
+        });
+
+        // Chunks are written in order, so answers come out in the same order as the queries.
+        for (size_t c = 0; c < nchunks; c++)
+        {
+            if (obuf_flush(&bufs[c], out)) {
+                status = 1;
+            }
+        }
+
+        for (size_t i = 0; i < n; i++)
+        {
+            free(queries[i]);
+            queries[i] = NULL;
+        }
+
+        if (failed) {
+            status = 1;
+        }
+    }
+
+    if (ferror(in))
+    {
+        perror("getline");
+        status = 1;
+    }
+
+    if (fz_failed || wc_failed) {
+        status = 1;
+    }
+
+    for (size_t c = 0; c < nchunks; c++) {
+        obuf_free(&bufs[c]);
+    }
+
+    free(line);
+    free(queries);
+    free(bufs);
+
+    pool_destroy(pool);
+    return status;
+}
+
+// Number shown for a database entry. Sheet rows count from 1 (like rows from an index), but ids which aren't sheet rows
+//   (the 字詞號 of entries in databases from conv) are shown as stored.
+static inline long long sql_row(const struct sqldict *sd, const struct sqldict_entry *entry)
+{ return (sd->sheet_rows ? entry->row + 1 : entry->row); }
+
+// Format the answer to a single query against a database in batch mode (in the same format as `batch_answer`).
+// Queries starting with ':' look up entries by pronunciation, and give up to `k` entries like lookups.
+// Approximate, phrase, filter, and wildcard queries need an index, so they're reported (on stderr) and answered like
+//   queries with no results. Every query gets at least one line.
+static int sql_answer(struct sqldict *sd, const char *query, enum dindex_order order, size_t k, struct obuf *out)
+{
+    size_t len = strlen(query);
+
+    __block int failed = 0;
+    __block size_t n = 0;
+
+    int (^entry)(const struct sqldict_entry *) = ^(const struct sqldict_entry *entry) {
+        failed = (tsv_escape(out, query) || obuf_printf(out, "\t%s\t%lld\t", entry->word, sql_row(sd, entry)));
+
+        if (!failed && entry->def) {
+            failed = tsv_escape(out, entry->def);
+        }
+
+        failed = (failed || obuf_puts(out, "\n"));
+        n++;
+
+        return failed;
+    };
+
+    if (query[0] == '~' || query[0] == '@' || query[0] == '=' || wildcard_is_pattern(query)) {
+        fprintf(stderr, "Error: Query '%s' needs an index (not a database)!\n", query);
+    } else if (query[0] == ':') {
+        sqldict_pron(sd, &query[1], k, entry);
+    } else if (len && query[len - 1] == '*') {
+        char prefix[QUERY_MAX];
+
+        // Longer prefixes can't be in the dictionary.
+        if (len <= QUERY_MAX)
+        {
+            memcpy(prefix, query, len - 1);
+            prefix[len - 1] = 0;
+
+            sqldict_prefix(sd, prefix, order, k, ^(const char *word, int64_t strokes) {
+                failed = (tsv_escape(out, query) || obuf_printf(out, "\t%s\t\t\n", word));
+                n++;
+
+                return failed;
+            });
+        }
+    } else {
+        sqldict_lookup(sd, query, entry);
+    }
+
+    if (n || failed) { return failed; }
+
+    // No results at all.
+    return (tsv_escape(out, query) || obuf_puts(out, "\t\t\t\n"));
+}
+
+// Answer queries against a database, either interactively or (if `in` is set) in batch mode.
+// Statements are shared, so batch queries are answered one at a time.
+static int do_sql(struct sqldict *sd, FILE *in, FILE *out, enum dindex_order order, size_t k)
+{
+    char *str = NULL;
+    size_t cap = 0;
+    ssize_t len;
 
-    off_t names = -1;
-    off_t defs = -1;
+    struct obuf buf = OBUF_INIT;
+    size_t pending = 0;
+    int status = 0;
 
-    struct xlsx_value *header = xlsx_row(doc, 0);
+    if (!in) {
+        printf("Enter query: ");
+    }
 
-    for (size_t i = 0; i < xlsx_cols(doc); i++)
+    while (!status && (len = getline(&str, &cap, (in ? in : stdin))) >= 0)
     {
-        struct xlsx_value *val = &header[i];
+        // Remove trailing newline (and carriage return for files from Windows).
+        while (len && (str[len - 1] == '\n' || (in && str[len - 1] == '\r'))) {
+            str[--len] = 0;
+        }
 
-        if (val->type != XLSX_TYPE_STR)
+        if (in)
         {
-            fprintf(stderr, "Error: Column header is not a string! (type=%d)\n", val->type);
+            if (!len) { continue; }
+
+            status = sql_answer(sd, str, order, k, &buf);
+
+            if (!status && ++pending == BATCH_CHUNK)
+            {
+                status = obuf_flush(&buf, out);
+                pending = 0;
+            }
+
             continue;
         }
 
-        printf("%zu: '%s'\n", i, xlsx_str(doc, val));
+        if (str[0] == ':') {
+            printf("Looking for words pronounced '%s'...\n", &str[1]);
+
+            if (!sqldict_pron(sd, &str[1], k, ^(const struct sqldict_entry *entry) {
+                printf("  %s (%s %lld): %s / %s\n", entry->word, (sd->sheet_rows ? "row" : "entry"), sql_row(sd, entry),
+                    (entry->zhuyin ? entry->zhuyin : "?"), (entry->pinyin ? entry->pinyin : "?"));
+
+                return 0;
+            })) { printf("No records found.\n"); }
+        } else if (str[0] == '~' || str[0] == '@' || wildcard_is_pattern(str)) {
+            printf("Approximate, phrase, and wildcard search need an index (not a database).\n");
+        } else if (len && str[len - 1] == '*') {
+            str[len - 1] = 0;
+            printf("Completing '%s'...\n", str);
+
+            size_t total = sqldict_prefix(sd, str, order, k, ^(const char *word, int64_t strokes) {
+                if (strokes < 0) {
+                    printf("  %s\n", word);
+                } else {
+                    printf("  %s (%lld)\n", word, (long long)strokes);
+                }
+
+                return 0;
+            });
+
+            if (total > k) {
+                printf("  ... (%zu more)\n", total - k);
+            } else if (!total) {
+                printf("No records found.\n");
+            }
+        } else {
+            printf("Looking for '%s'...\n", str);
+            __block unsigned int matches = 0;
+
+            if (!sqldict_lookup(sd, str, ^(const struct sqldict_entry *entry) {
+                if (sd->sheet_rows) {
+                    printf("Found '%s' at %lld.\n", str, sql_row(sd, entry));
+                } else {
+                    printf("Found '%s' (entry %lld).\n", str, sql_row(sd, entry));
+                }
+
+                if (!entry->def) {
+                    fprintf(stderr, "Error: Definition is missing!\n");
+                } else {
+                    printf("Definition %u:\n%s\n", ++matches, entry->def);
+                }
+
+                return 0;
+            })) { printf("No records found.\n"); }
+        }
+
+        printf("Enter query: ");
+    }
+
+    if (in && ferror(in))
+    {
+        perror("getline");
+        status = 1;
+    }
+
+    if (in && !status) {
+        status = obuf_flush(&buf, out);
+    }
+
+    obuf_free(&buf);
+    free(str);
+
+    return status;
+}
+
+// Parse a whole decimal count no greater than `max` from a command line option. Returns non-zero if it isn't one.
+static int parse_count(const char *str, size_t max, size_t *out)
+{
+    char *end;
+
+    errno = 0;
+    unsigned long long n = strtoull(str, &end, 10);
+
+    if (*str < '0' || *str > '9' || *end || errno || n > max) { return 1; }
 
-        if (!strcmp("字詞名", xlsx_str(doc, val))) {
-            names = i;
-        } else if (!strcmp("釋義", xlsx_str(doc, val))) {
-            defs = i;
+    (*out) = n;
+    return 0;
+}
+
+static void usage(const char *name)
+{
+    fprintf(stderr, "Usage: %s [-S] [-k count] [-t dict.fst] [-P | -a dict.sa] [-F dict.xlsx] [-b queries.txt|- [-o out.tsv]] [-j threads] dict.xlsx|dict.idx|dict.sqlite\n", name);
+    fprintf(stderr, "       %s --build-index dict.idx dict.xlsx\n", name);
+    fprintf(stderr, "       %s [-j threads] --build-sarray dict.sa dict.xlsx|dict.idx\n", name);
+    fprintf(stderr, "       %s --build-fst dict.fst dict.xlsx|dict.idx\n", name);
+}
+
+int main(int argc, char *const *argv)
+{
+    // Ordering and count for prefix completions.
+    enum dindex_order order = DINDEX_ORDER_LEX;
+    size_t k = 20;
+
+    // Batch mode input, output, and thread count (0 means one per CPU).
+    const char *batch = NULL;
+    const char *output = NULL;
+    size_t threads = 0;
+
+    // Where to write an index, suffix array, or FST file (instead of answering queries).
+    const char *build_index = NULL;
+    const char *build_sarray = NULL;
+    const char *build_fst = NULL;
+
+    // Phrase search is optional. The suffix array is either built at startup or loaded from a file.
+    bool phrases = false;
+    const char *sarray_path = NULL;
+
+    // Character filters are optional, and are built from a workbook (index files don't keep radicals or pinyin).
+    const char *facets_path = NULL;
+
+    // Words can be looked up and completed through an FST file instead of the index's word, hash, and trie tables.
+    const char *fst_path = NULL;
+
+    static const struct option options[] = {
+        { "build-index",  required_argument, NULL, 'B' },
+        { "build-sarray", required_argument, NULL, 'A' },
+        { "build-fst",    required_argument, NULL, 'T' },
+        { NULL,           0,                 NULL,  0  }
+    };
+
+    int opt;
+
+    while ((opt = getopt_long(argc, argv, "Sk:b:o:j:Pa:F:t:", options, NULL)) != -1)
+    {
+        switch (opt)
+        {
+            case 'S': order = DINDEX_ORDER_STROKES; break;
+            case 'k':
+                if (parse_count(optarg, INT_MAX, &k))
+                {
+                    fprintf(stderr, "Error: Completion count '%s' must be a number from 0 to %d.\n", optarg, INT_MAX);
+                    usage(argv[0]);
+
+                    return 1;
+                }
+
+                break;
+            case 'b': batch = optarg; break;
+            case 'o': output = optarg; break;
+            case 'j':
+                if (parse_count(optarg, THREADS_MAX, &threads))
+                {
+                    fprintf(stderr, "Error: Thread count '%s' must be a number from 0 (one per CPU) to %d.\n", optarg, THREADS_MAX);
+                    usage(argv[0]);
+
+                    return 1;
+                }
+
+                break;
+            case 'B': build_index = optarg; break;
+            case 'A': build_sarray = optarg; break;
+            case 'T': build_fst = optarg; break;
+            case 'P': phrases = true; break;
+            case 'a': sarray_path = optarg; break;
+            case 'F': facets_path = optarg; break;
+            case 't': fst_path = optarg; break;
+            default:
+                usage(argv[0]);
+                return 1;
         }
     }
 
-    if ((names < 0) || (defs < 0))
+    if (argc - optind != 1)
     {
-        fprintf(stderr, "Error: Missing names or definitions.\n");
+        usage(argv[0]);
         return 1;
     }
 
-    char buf[16];
-    char *str;
+    if (build_index)
+    {
+        struct dindex *idx = dindex_load_xlsx(argv[optind], false);
+        if (!idx) { return 1; }
+
+        int status = dindex_save(idx, build_index);
+        dindex_free(idx);
+
+        return status;
+    }
+
+    // Databases (from `xlsx2sql` or `conv`) are queried in place, so there's nothing to load.
+    if (sqldict_is_file(argv[optind]))
+    {
+        if (build_fst)
+        {
+            fprintf(stderr, "Error: Building an FST needs an index (not a database).\n");
+            return 1;
+        }
+
+        if (build_sarray || phrases || sarray_path)
+        {
+            fprintf(stderr, "Error: Phrase search needs an index (not a database).\n");
+            return 1;
+        }
+
+        if (facets_path)
+        {
+            fprintf(stderr, "Error: Character filters need an index (not a database).\n");
+            return 1;
+        }
+
+        if (fst_path)
+        {
+            fprintf(stderr, "Error: FST lookups need an index (not a database).\n");
+            return 1;
+        }
+
+        struct sqldict *sd = sqldict_open(argv[optind]);
+        if (!sd) { return 1; }
+
+        FILE *in = (!batch ? NULL : (strcmp(batch, "-") ? fopen(batch, "r") : stdin));
+        FILE *out = (output ? fopen(output, "w") : stdout);
+
+        if ((batch && !in) || !out)
+        {
+            perror("fopen");
+            sqldict_close(sd);
+
+            return 1;
+        }
+
+        int status = do_sql(sd, in, out, order, k);
+
+        if (in && in != stdin) { fclose(in); }
+        if (out != stdout && fclose(out)) {
+            perror("fclose");
+            status = 1;
+        }
+
+        sqldict_close(sd);
+        return status;
+    }
+
+    struct dindex *idx = dindex_load(argv[optind], !batch);
+    if (!idx) { return 1; }
+
+    if (build_sarray)
+    {
+        struct sarray *sa = sarray_build(idx, threads);
+        int status = (!sa || sarray_save(sa, build_sarray));
+
+        if (sa) { sarray_free(sa); }
+        dindex_free(idx);
+
+        return status;
+    }
+
+    if (build_fst)
+    {
+        struct fst *fst = fst_build(idx);
+        int status = (!fst || fst_save(fst, build_fst));
+
+        // Compare against what it replaces: the index's word, hash, and trie tables, and the words themselves in its pool.
+        size_t raw = 0;
+
+        for (uint32_t w = 0; fst && w < idx->nwords; w++) {
+            raw += idx->words[w].len + 1;
+        }
+
+        size_t tables = idx->nwords * sizeof(struct dindex_word) + idx->nslots * sizeof(struct dindex_slot) + idx->nnodes * sizeof(struct dindex_node);
+        size_t side = (idx->nwords + 1) * sizeof(uint32_t) + idx->nwords * sizeof(uint16_t);
+
+        if (fst && !status && raw)
+        {
+            printf("The FST takes %zu bytes (%.1f%% of the %zu bytes of words it holds), plus %zu bytes for its word table.\n",
+                   fst->size, 100.0 * fst->size / raw, raw, side);
+            printf("Together, that's %.1f%% of the %zu bytes of words and word, hash, and trie tables they replace.\n",
+                   100.0 * (fst->size + side) / (raw + tables), raw + tables);
+        }
+
+        if (fst) { fst_free(fst); }
+        dindex_free(idx);
+
+        return status;
+    }
+
+    struct sarray *sa = NULL;
+
+    if (sarray_path) {
+        sa = sarray_open(sarray_path, idx);
+    } else if (phrases) {
+        sa = sarray_build(idx, threads);
+    }
+
+    struct facets *fc = (facets_path ? facets_load(facets_path) : NULL);
+
+    struct fst *fst = (fst_path ? fst_open(fst_path) : NULL);
+
+    if (fst && !fst_fits(fst, idx))
+    {
+        fprintf(stderr, "Error: FST '%s' wasn't built from this dictionary (rebuild it with --build-fst).\n", fst_path);
+
+        fst_free(fst);
+        fst = NULL;
+    }
+
+    if (((sarray_path || phrases) && !sa) || (facets_path && !fc) || (fst_path && !fst))
+    {
+        if (fst) { fst_free(fst); }
+        if (fc) { facets_free(fc); }
+        if (sa) { sarray_free(sa); }
+        dindex_free(idx);
+
+        return 1;
+    }
+
+    // The fuzzy and wildcard indexes are only built once a query needs them.
+    struct fuzzy *fz = NULL;
+    struct wildcard *wc = NULL;
+
+    if (batch)
+    {
+        FILE *in = (strcmp(batch, "-") ? fopen(batch, "r") : stdin);
+        FILE *out = (output ? fopen(output, "w") : stdout);
+
+        if (!in || !out)
+        {
+            perror("fopen");
+
+            if (fst) { fst_free(fst); }
+            if (fc) { facets_free(fc); }
+            if (sa) { sarray_free(sa); }
+            dindex_free(idx);
+
+            return 1;
+        }
+
+        int status = do_batch(idx, fst, &fz, &wc, sa, fc, in, out, threads, order, k);
+
+        if (in != stdin) { fclose(in); }
+        if (out != stdout && fclose(out)) {
+            perror("fclose");
+            status = 1;
+        }
+
+        if (fst) { fst_free(fst); }
+        if (fc) { facets_free(fc); }
+        if (sa) { sarray_free(sa); }
+        if (wc) { wildcard_free(wc); }
+        if (fz) { fuzzy_free(fz); }
+        dindex_free(idx);
+
+        return status;
+    }
+
+    char *str = NULL;
+    size_t cap = 0;
+    ssize_t len;
 
     printf("Enter query: ");
 
-    while ((str = fgets(buf, 16, stdin)))
+    while ((len = getline(&str, &cap, stdin)) >= 0)
     {
         // Remove trailing newline.
-        size_t len = strlen(str);
-        str[len - 1] = 0;
+        if (len && str[len - 1] == '\n') {
+            str[--len] = 0;
+        }
+
+        // A leading '~' asks for approximate matches, a leading '@' searches definitions for a phrase,
+        //   a leading ':' looks up a pronunciation, a leading '=' filters characters (like "=rad:水 strokes:8-10"),
+        //   a '?' anywhere matches any single character (like "一?不?"), and a trailing '*' asks for completions instead of an exact match.
+        if (str[0] == '=') {
+            printf("Looking for characters matching '%s'...\n", &str[1]);
 
-        // Do query.
-        printf("Looking for '%s'...\n", str);
+            if (!fc) {
+                printf("Character filters need a workbook (use -F).\n");
+            } else if (!do_filter(fc, &str[1], k)) {
+                printf("No records found.\n");
+            }
+        } else if (str[0] == '@') {
+            printf("Looking for definitions containing '%s'...\n", &str[1]);
+
+            if (!sa) {
+                printf("Phrase search needs a suffix array (use -P or -a).\n");
+            } else if (!do_phrase(sa, &str[1], k)) {
+                printf("No records found.\n");
+            }
+        } else if (str[0] == ':') {
+            printf("Pronunciation lookups need a database (from xlsx2sql).\n");
+        } else if (str[0] == '~') {
+            printf("Looking for words close to '%s'...\n", &str[1]);
 
-        if (do_query(doc, str, names, defs)) {
-            printf("No records found.\n");
+            // A failed build has already been reported.
+            if ((fz || (fz = fuzzy_build(idx))) && !do_fuzzy(fz, &str[1], k)) {
+                printf("No records found.\n");
+            }
+        } else if (wildcard_is_pattern(str)) {
+            printf("Looking for words matching '%s'...\n", str);
+
+            if ((wc || (wc = wildcard_build(idx))) && !do_wildcard(wc, str, k)) {
+                printf("No records found.\n");
+            }
+        } else if (len && str[len - 1] == '*') {
+            str[len - 1] = 0;
+            printf("Completing '%s'...\n", str);
+
+            if (!do_complete(idx, fst, str, order, k)) {
+                printf("No records found.\n");
+            }
+        } else {
+            printf("Looking for '%s'...\n", str);
+
+            if (!do_query(idx, fst, str)) {
+                printf("No records found.\n");
+            }
         }
 
         printf("Enter query: ");
     }
 
-    xlsx_doc_free(doc);
+    free(str);
+
+    if (fst) { fst_free(fst); }
+    if (fc) { facets_free(fc); }
+    if (sa) { sarray_free(sa); }
+    if (wc) { wildcard_free(wc); }
+    if (fz) { fuzzy_free(fz); }
+    dindex_free(idx);
+
     return 0;
 }
@@ -8,12 +8,19 @@
 #include <stdbool.h>
 #include <stdlib.h>
 
+#include <libxml/xmlreader.h>
+
+#include <trace.h>
 #include <xlsx.h>
+#include <xlsxint.h>
 #include <xml.h>
 
 // "rels" file stores some info on how to access worksheet data.
 #define XLSX_RELS "xl/_rels/workbook.xml.rels"
 
+// Most columns a sheet can have (column "XFD").
+#define XLSX_MAX_COLS 16384
+
 // Given a path, make it relative to the `xl` directory
 // The returned path should be passed to `free`
 static char *_xlsx_xl_path(const char *path)
@@ -37,7 +44,7 @@ static char *_xlsx_xl_path(const char *path)
     }
 
     if (DEBUG_XLSX) {
-        printf("'%s' --> '%s'\n", path, (char *)buf);
+        fprintf(stderr, "'%s' --> '%s'\n", path, (char *)buf);
     }
 
     return buf;
@@ -62,6 +69,8 @@ static xmlNodePtr _xlsx_xl_root(zip_t *archive, const char *path)
 // Build a string table from the XML file at the given (xl-rel) path in an archive.
 static int _xlsx_strtab(zip_t *archive, const char *path, struct xlsx_strtab *strtab)
 {
+    TRACE_SPAN("xlsx_strtab", path);
+
     xmlNodePtr strdata = _xlsx_xl_root(archive, path);
     if (!strdata) { return 1; }
 
@@ -150,7 +159,65 @@ static int _xlsx_strtab(zip_t *archive, const char *path, struct xlsx_strtab *st
     }
 
     if (DEBUG_XLSX) {
-        printf("Info: Read %zu strings from excel document.\n", strtab->count);
+        fprintf(stderr, "Info: Read %zu strings from excel document.\n", strtab->count);
+    }
+
+    return 0;
+}
+
+int _xlsx_value(struct xlsx_value *slot, const char *type, const char *value, size_t row, size_t col)
+{
+    slot->type = XLSX_TYPE_NULL;
+
+    if (type)
+    {
+        // String table indicies are "s". Literal strings are "str"
+        if (!strcmp("s", type)) {
+            slot->type = XLSX_TYPE_STR;
+        } else if (!strcmp("str", type)) {
+            slot->type = XLSX_TYPE_LSTR;
+        } else {
+            fprintf(stderr, "Warning: Excel document specifies unknown type '%s' at (%zu, %zu)\n", type, col, row);
+            slot->type = XLSX_TYPE_LSTR; // We can always just copy the value as a string.
+        }
+    }
+
+    char *end; // Used for string conversions below.
+    const char *thing;
+
+    if (slot->type == XLSX_TYPE_STR) {
+        // This is a string table offset.
+        slot->sref = strtoll(value, &end, 10);
+        thing = "string table index";
+    } else if (slot->type == XLSX_TYPE_LSTR) {
+        // Unlike the string table, I opt to dup the value here.
+        // These are much less dense in the sheet document vs the string table.
+        if (!(slot->str = strdup(value)))
+        {
+            perror("strdup");
+
+            slot->type = XLSX_TYPE_NULL;
+            return 1;
+        }
+
+        return 0;
+    } else if (strchr(value, '.')) {
+        // Determine float vs int by the presence of a dot.
+        slot->type = XLSX_TYPE_FLOAT;
+        slot->fval = strtod(value, &end);
+        thing = "float value";
+    } else {
+        slot->type = XLSX_TYPE_INT;
+        slot->ival = strtoll(value, &end, 10);
+        thing = "integer value";
+    }
+
+    if (end[0])
+    {
+        fprintf(stderr, "Error: Excel document has malformed %s!\n", thing);
+
+        slot->type = XLSX_TYPE_NULL;
+        return 1;
     }
 
     return 0;
@@ -159,6 +226,8 @@ static int _xlsx_strtab(zip_t *archive, const char *path, struct xlsx_strtab *st
 // Process the main `sheet` data for this document. Here, we read in the values.
 static int _xlsx_sheet(zip_t *archive, const char *path, struct xlsx *doc)
 {
+    TRACE_SPAN("xlsx_sheet", path);
+
     xmlNodePtr wsdata = _xlsx_xl_root(archive, path);
     if (!wsdata) { return 1; }
 
@@ -232,7 +301,7 @@ static int _xlsx_sheet(zip_t *archive, const char *path, struct xlsx *doc)
     doc->cols++;
 
     if (DEBUG_XLSX) {
-        printf("Document has %zu rows, %zu cols (mem=%zu).\n", doc->rows, doc->cols, doc->rows * doc->cols * sizeof(struct xlsx_value));
+        fprintf(stderr, "Document has %zu rows, %zu cols (mem=%zu).\n", doc->rows, doc->cols, doc->rows * doc->cols * sizeof(struct xlsx_value));
     }
 
     // Do one big allocation (this is returned to caller)
@@ -345,58 +414,8 @@ static int _xlsx_sheet(zip_t *archive, const char *path, struct xlsx *doc)
             // For strings, we need to determine type by attribute.
             const char *type = xml_node_attribute(col, "t");
 
-            if (type)
-            {
-                // String table indicies are "s". Literal strings are "str"
-                if (!strcmp("s", type)) {
-                    slot->type = XLSX_TYPE_STR;
-                } else if (!strcmp("str", type)) {
-                    slot->type = XLSX_TYPE_LSTR;
-                } else {
-                    fprintf(stderr, "Warning: Excel document specifies unknown type '%s' at (%zu, %zu)\n", type, j, i);
-                    slot->type = XLSX_TYPE_LSTR; // We can always just copy the value as a string.
-                }
-            }
-
-            // This value has meaning now, and we may know its type.
-            const char *value = (char *)val->content;
-            char *end; // Used for string conversions below.
-
-            // Check string conversion and get out on failure.
-            #define _check_conv(thing)                                                      \
-                do {                                                                        \
-                    if (end[0])                                                             \
-                    {                                                                       \
-                        fprintf(stderr, "Error: Excel document has malformed" thing "!\n"); \
-                        _give_up();                                                         \
-                    }                                                                       \
-                } while (0)
-
-            if (slot->type == XLSX_TYPE_STR) {
-                // This is a string table offset.
-                size_t idx = strtoll(value, &end, 10);
-                _check_conv("string table index");
-
-                slot->sref = idx;
-            } else if (slot->type == XLSX_TYPE_LSTR) {
-                // Unlike the string table, I opt to dup the value here.
-                // These are much less dense in the sheet document vs the string table.
-                slot->str = strdup(value);
-            } else {
-                // Determine float vs int by the presence of a dot.
-                char *dot = strchr((char *)val->content, '.');
-
-                if (dot) {
-                    slot->type = XLSX_TYPE_FLOAT;
-                    slot->fval = strtod(value, &end);
-
-                    _check_conv("float value");
-                } else {
-                    slot->type = XLSX_TYPE_INT;
-                    slot->ival = strtoll(value, &end, 10);
-
-                    _check_conv("integer value");
-                }
+            if (_xlsx_value(slot, type, (char *)val->content, i, j)) {
+                _give_up();
             }
 
             return 1;
@@ -419,26 +438,19 @@ static int _xlsx_sheet(zip_t *archive, const char *path, struct xlsx *doc)
     }
 
     if (DEBUG_XLSX) {
-        printf("Finished reading %zu values.\n", doc->rows * doc->cols);
+        fprintf(stderr, "Finished reading %zu values.\n", doc->rows * doc->cols);
     }
 
     return 0;
 }
 
-struct xlsx *xlsx_doc_at(const char *path)
+// Find where the worksheet and string table are in an archive (the paths point into `*rels_out`, which the caller frees).
+static int _xlsx_parts(zip_t *archive, xmlNodePtr *rels_out, char **worksheet_out, char **strings_out)
 {
-    // XLSX files are glorified zip archives.
-    zip_t *archive = zopen(path);
-    if (!archive) { return NULL; }
-
     // We use the `rels` file to figure out where the data we care about is.
     xmlNodePtr rels = zxml_root_at(archive, XLSX_RELS);
 
-    if (!rels)
-    {
-        zclose(archive);
-        return NULL;
-    }
+    if (!rels) { return 1; }
 
     // Find here really just checks and makes sure the root name is correct.
     xmlNodePtr rdata = xml_find(rels, "Relationships");
@@ -448,9 +460,7 @@ struct xlsx *xlsx_doc_at(const char *path)
         fprintf(stderr, "Error: Excel document is missing relationship info!\n");
 
         xmlFreeDoc(rels->doc);
-        zclose(archive);
-
-        return NULL;
+        return 1;
     }
 
     // We want two things: `worksheet` and `sharedStrings` data.
@@ -490,7 +500,7 @@ struct xlsx *xlsx_doc_at(const char *path)
         }
 
         if (DEBUG_XLSX) {
-            printf("Excel document has XML document of type '%s' at '%s'.\n", type, target);
+            fprintf(stderr, "Excel document has XML document of type '%s' at '%s'.\n", type, target);
         }
 
         if (!strcmp(type, "worksheet")) {
@@ -509,8 +519,34 @@ struct xlsx *xlsx_doc_at(const char *path)
         fprintf(stderr, "Error: Excel document is missing worksheet and/or strings.\n");
 
         xmlFreeDoc(rels->doc);
-        zclose(archive);
+        return 1;
+    }
+
+    *rels_out = rels;
+    *worksheet_out = worksheet;
+    *strings_out = strings;
+
+    return 0;
+}
+
+struct xlsx *xlsx_doc_at(const char *path)
+{
+    TRACE_SPAN("xlsx_doc_at", path);
+
+    // XLSX files are glorified zip archives.
+    struct trace_span span = trace_begin("zopen", path);
+    zip_t *archive = zopen(path);
+    trace_end(&span);
+
+    if (!archive) { return NULL; }
+
+    xmlNodePtr rels;
+    char *worksheet;
+    char *strings;
 
+    if (_xlsx_parts(archive, &rels, &worksheet, &strings))
+    {
+        zclose(archive);
         return NULL;
     }
 
@@ -555,6 +591,323 @@ struct xlsx *xlsx_doc_at(const char *path)
     return doc;
 }
 
+// Read more of a zip entry for the streaming sheet reader.
+static int _xlsx_stream_read(void *ctx, char *buf, int len)
+{
+    zip_int64_t n = zip_fread((zip_file_t *)ctx, buf, len);
+    return (n < 0 ? -1 : (int)n);
+}
+
+// Get the column index of a cell reference like "AB12" (-1 if it doesn't start with a valid column).
+static int64_t _xlsx_ref_col(const char *ref)
+{
+    int64_t col = 0;
+
+    for (; *ref >= 'A' && *ref <= 'Z'; ref++)
+    {
+        col = (col * 26) + (*ref - 'A' + 1);
+        if (col > XLSX_MAX_COLS) { return -1; }
+    }
+
+    return (col - 1);
+}
+
+// State while streaming rows out of a sheet.
+struct _xlsx_stream {
+    // The row being read is the grid (`cols` wide). The first row decides how many columns there are.
+    struct xlsx doc;
+    size_t cap;
+
+    // Row number of the row being read.
+    size_t n;
+
+    // Column of the cell being read (or the last cell read), and its type attribute (if any).
+    int64_t col;
+    char type[16];
+    bool typed;
+
+    // Whether we're inside the value of a cell, and the text of the value so far.
+    // The reader can hand us a value in more than one piece (e.g. around entities or buffer boundaries).
+    bool in_value;
+    char *text;
+    size_t text_len;
+    size_t text_cap;
+};
+
+// Add a piece of the text of the value being read. Returns non-zero on failure.
+static int _xlsx_stream_text(struct _xlsx_stream *st, const char *piece)
+{
+    size_t len = strlen(piece);
+
+    if (st->text_len + len + 1 > st->text_cap)
+    {
+        size_t cap = (st->text_cap ? st->text_cap * 2 : 64);
+
+        while (cap < st->text_len + len + 1) {
+            cap *= 2;
+        }
+
+        char *text = realloc(st->text, cap);
+
+        if (!text)
+        {
+            perror("realloc");
+            return 1;
+        }
+
+        st->text = text;
+        st->text_cap = cap;
+    }
+
+    memcpy(&st->text[st->text_len], piece, len + 1);
+    st->text_len += len;
+
+    return 0;
+}
+
+// Finish reading the value of a cell, converting the text collected for it.
+static int _xlsx_stream_value(struct _xlsx_stream *st)
+{
+    struct xlsx_value *slot = &st->doc.grid[st->col];
+
+    if (slot->type == XLSX_TYPE_LSTR) {
+        free(slot->str);
+    }
+
+    slot->type = XLSX_TYPE_NULL;
+    st->in_value = false;
+
+    if (!st->text_len) { return 0; }
+
+    return _xlsx_value(slot, (st->typed ? st->type : NULL), st->text, st->n, st->col);
+}
+
+// Start reading a cell from the attributes of its `c` element.
+static int _xlsx_stream_cell(struct _xlsx_stream *st, xmlTextReaderPtr reader)
+{
+    // Cells without a reference follow the one before.
+    int64_t col = st->col + 1;
+    st->typed = false;
+
+    while (xmlTextReaderMoveToNextAttribute(reader) == 1)
+    {
+        const char *name = (const char *)xmlTextReaderConstLocalName(reader);
+        const char *value = (const char *)xmlTextReaderConstValue(reader);
+
+        if (!name || !value) { continue; }
+
+        if (!strcmp("r", name)) {
+            col = _xlsx_ref_col(value);
+        } else if (!strcmp("t", name)) {
+            snprintf(st->type, sizeof(st->type), "%s", value);
+            st->typed = true;
+        }
+    }
+
+    xmlTextReaderMoveToElement(reader);
+
+    if (col < 0)
+    {
+        fprintf(stderr, "Error: Excel document has invalid column name!\n");
+        return 1;
+    }
+
+    st->col = col;
+
+    if ((size_t)col < st->doc.cols) {
+        return 0;
+    }
+
+    if (st->n)
+    {
+        fprintf(stderr, "Error: Value in row %zu has unknown column %lld\n", st->n, (long long)col);
+        return 1;
+    }
+
+    // Still on the first row, so this is a new column.
+    if ((size_t)col >= st->cap)
+    {
+        size_t cap = (st->cap ? st->cap * 2 : 32);
+        if (cap <= (size_t)col) { cap = col + 1; }
+
+        struct xlsx_value *grid = realloc(st->doc.grid, cap * sizeof(struct xlsx_value));
+
+        if (!grid)
+        {
+            perror("realloc");
+            return 1;
+        }
+
+        for (size_t j = st->cap; j < cap; j++) {
+            grid[j].type = XLSX_TYPE_NULL;
+        }
+
+        st->doc.grid = grid;
+        st->cap = cap;
+    }
+
+    st->doc.cols = col + 1;
+    return 0;
+}
+
+// Hand a finished row to the caller, then empty it for the next one.
+static int _xlsx_stream_row(struct _xlsx_stream *st, int (^blk)(const struct xlsx *doc, struct xlsx_value *row, size_t n))
+{
+    st->doc.rows = st->n + 1;
+
+    int status = blk(&st->doc, st->doc.grid, st->n);
+
+    for (size_t j = 0; j < st->doc.cols; j++)
+    {
+        if (st->doc.grid[j].type == XLSX_TYPE_LSTR) {
+            free(st->doc.grid[j].str);
+        }
+
+        st->doc.grid[j].type = XLSX_TYPE_NULL;
+    }
+
+    st->n++;
+    st->col = -1;
+
+    return status;
+}
+
+// Read the sheet at the given (xl-rel) path one node at a time, handing each row to `blk` as soon as it ends.
+static int _xlsx_stream_sheet(zip_t *archive, const char *path, struct _xlsx_stream *st, int (^blk)(const struct xlsx *doc, struct xlsx_value *row, size_t n))
+{
+    TRACE_SPAN("xlsx_stream_sheet", path);
+
+    char *xl_path = _xlsx_xl_path(path);
+    if (!xl_path) { return 1; }
+
+    zip_int64_t idx = zip_name_locate(archive, xl_path, ZIP_FL_ENC_UTF_8);
+    zip_file_t *file = NULL;
+
+    if (idx < 0) {
+        fprintf(stderr, "Error: Zip archive missing path '%s'.\n", xl_path);
+    } else if (!(file = zip_fopen_index(archive, idx, 0))) {
+        zerror("zip_fopen_index", archive);
+    }
+
+    // The entry is inflated as the reader asks for more, so the sheet is never all in memory.
+    xmlTextReaderPtr reader = (file ? xmlReaderForIO(_xlsx_stream_read, NULL, file, xl_path, NULL, 0) : NULL);
+
+    if (file && !reader) {
+        fprintf(stderr, "Error: Failed to start reading '%s'.\n", xl_path);
+    }
+
+    int status = !reader;
+    int ret = 1;
+
+    while (!status && (ret = xmlTextReaderRead(reader)) == 1)
+    {
+        int kind = xmlTextReaderNodeType(reader);
+        const char *name = (const char *)xmlTextReaderConstLocalName(reader);
+
+        if (kind == XML_READER_TYPE_ELEMENT) {
+            if (!strcmp("row", name)) {
+                // An empty row still counts.
+                if (xmlTextReaderIsEmptyElement(reader)) {
+                    status = _xlsx_stream_row(st, blk);
+                }
+            } else if (!strcmp("c", name)) {
+                status = _xlsx_stream_cell(st, reader);
+            } else if (!strcmp("v", name)) {
+                st->in_value = (st->col >= 0 && !xmlTextReaderIsEmptyElement(reader));
+                st->text_len = 0;
+            }
+        } else if (kind == XML_READER_TYPE_END_ELEMENT) {
+            if (!strcmp("row", name)) {
+                status = _xlsx_stream_row(st, blk);
+            } else if (!strcmp("v", name) && st->in_value) {
+                status = _xlsx_stream_value(st);
+            }
+        } else if (st->in_value && (kind == XML_READER_TYPE_TEXT || kind == XML_READER_TYPE_CDATA)) {
+            const char *value = (const char *)xmlTextReaderConstValue(reader);
+
+            if (value) {
+                status = _xlsx_stream_text(st, value);
+            }
+        }
+    }
+
+    if (ret < 0)
+    {
+        fprintf(stderr, "Error: Excel document has malformed sheet data!\n");
+        status = 1;
+    }
+
+    if (DEBUG_XLSX && !status) {
+        fprintf(stderr, "Streamed %zu rows of %zu cols.\n", st->n, st->doc.cols);
+    }
+
+    if (reader) { xmlFreeTextReader(reader); }
+
+    if (file && zip_fclose(file)) {
+        zerror("zip_fclose", archive);
+    }
+
+    free(xl_path);
+    return status;
+}
+
+int xlsx_stream_at(const char *path, int (^blk)(const struct xlsx *doc, struct xlsx_value *row, size_t n))
+{
+    TRACE_SPAN("xlsx_stream_at", path);
+
+    zip_t *archive = zopen(path);
+    if (!archive) { return 1; }
+
+    xmlNodePtr rels;
+    char *worksheet;
+    char *strings;
+
+    if (_xlsx_parts(archive, &rels, &worksheet, &strings))
+    {
+        zclose(archive);
+        return 1;
+    }
+
+    struct _xlsx_stream st = {
+        .doc = { .rows = 0, .cols = 0, .grid = NULL },
+        .cap = 0,
+        .n = 0,
+        .col = -1,
+        .typed = false,
+        .in_value = false,
+        .text = NULL,
+        .text_len = 0,
+        .text_cap = 0
+    };
+
+    // The string table is still read in whole, since cells can refer to any string in it.
+    int status = _xlsx_strtab(archive, strings, &st.doc.strtab);
+
+    if (!status)
+    {
+        status = _xlsx_stream_sheet(archive, worksheet, &st, blk);
+
+        xmlFreeDoc(st.doc.strtab.ref);
+        free(st.doc.strtab.base);
+    }
+
+    // Anything left over is from a row cut short.
+    for (size_t j = 0; j < st.doc.cols; j++)
+    {
+        if (st.doc.grid[j].type == XLSX_TYPE_LSTR) {
+            free(st.doc.grid[j].str);
+        }
+    }
+
+    free(st.doc.grid);
+    free(st.text);
+
+    xmlFreeDoc(rels->doc);
+    zclose(archive);
+
+    return status;
+}
+
 struct xlsx_value *xlsx_row(struct xlsx *doc, size_t i)
 {
     if (i > xlsx_rows(doc)) {
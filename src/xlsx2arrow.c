@@ -0,0 +1,76 @@
+/* ********************************************************** */
+/* -*- xlsx2arrow.c -*- Convert XLSX to an Arrow IPC file -*- */
+/* ********************************************************** */
+/* Tyler Besselman (C) October 2026                           */
+/* ********************************************************** */
+
+// Write the dictionary sheet as an Arrow IPC file (also known as Feather v2), which pandas, polars, DuckDB and friends
+//   can map and read without copying, instead of going through sqlite.
+
+#include <strings.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+
+#include <arrow.h>
+#include <metrics.h>
+
+int main(int argc, const char *const *argv)
+{
+    size_t batch_rows = ARROW_BATCH_ROWS;
+    int i = 1;
+
+    if (argc == 5 && !strcmp(argv[1], "-b"))
+    {
+        char *end;
+        batch_rows = strtoull(argv[2], &end, 10);
+
+        if (end[0] || !batch_rows)
+        {
+            fprintf(stderr, "Error: Bad batch size '%s'.\n", argv[2]);
+            return 1;
+        }
+
+        i = 3;
+    }
+
+    if (argc - i != 2)
+    {
+        fprintf(stderr, "Usage: %s [-b rows-per-batch] <dict.xlsx> <dict.arrow>\n", argv[0]);
+        return 1;
+    }
+
+    uint64_t start = metrics_now();
+
+    struct xlsx *doc = xlsx_doc_at(argv[i]);
+    if (!doc) { return 1; }
+
+    uint64_t loaded = metrics_now();
+
+    struct arrow_stats stats;
+    int status = arrow_write(argv[i + 1], doc, batch_rows, &stats);
+
+    if (!status)
+    {
+        for (size_t j = 0; j < xlsx_cols(doc); j++)
+        {
+            struct xlsx_value *name = &xlsx_row(doc, 0)[j];
+            printf("%s", (j ? ", " : "Columns: "));
+
+            switch (name->type)
+            {
+                case XLSX_TYPE_STR:  printf("%s", xlsx_str(doc, name)); break;
+                case XLSX_TYPE_LSTR: printf("%s", name->str);           break;
+                default:             printf("C%03zu", j);               break;
+            }
+
+            printf(": %s", arrow_type_name(arrow_infer(doc, j)));
+        }
+
+        printf("\nWrote %zu rows in %zu record batches (%llu bytes) to '%s' in %.2fs (plus %.2fs loading).\n",
+               stats.rows, stats.batches, (unsigned long long)stats.bytes, argv[i + 1], (metrics_now() - loaded) / 1e9, (loaded - start) / 1e9);
+    }
+
+    xlsx_doc_free(doc);
+    return status;
+}
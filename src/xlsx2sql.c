@@ -13,6 +13,7 @@
 #include <unistd.h>
 #include <errno.h>
 
+#include <metrics.h>
 #include <sqlite.h>
 #include <xlsx.h>
 
@@ -27,8 +28,8 @@
 #define SQL_INSERT_HDR_2 " values(?1"
 #define SQL_INSERT_TAIL  ") returning id;"
 
-// Given we know entry->type is STR or LSTR get the string value of entry
-#define XLSX_STRVAL(entry) (((entry)->type == XLSX_TYPE_STR) ? xlsx_str(doc, (entry)) : (entry)->str)
+// Columns which get an index (if the document has them), so the database can be queried directly (e.g. by xldict).
+static const char *const indexed_columns[] = { "字詞號", "字詞名", "注音一式", "漢語拼音" };
 
 // Count # of base 10 digits in the number n
 static inline int digits(size_t n)
@@ -68,8 +69,8 @@ static inline char *filename(char *path)
     return name;
 }
 
-// Create insertion statement for a given doc.
-static char *build_insert_query(const char *name, struct xlsx *doc)
+// Create insertion statement for a given doc. Empty columns (which aren't in the table) are skipped.
+static char *build_insert_query(const char *name, struct xlsx *doc, int *types)
 {
     // insert into `name` values(?1, ?2, ..., ?n) returning id;
     // Here, ?1 is the id and ?2...?n are the xlsx columns
@@ -98,9 +99,13 @@ static char *build_insert_query(const char *name, struct xlsx *doc)
     bsize -= cnt;
     i += cnt;
 
+    size_t param = 2;
+
     for (size_t col = 0; col < xlsx_cols(doc); col++)
     {
-        int cnt = snprintf(&query[i], bsize, ", ?%zu", col + 2);
+        if (types[col] == XLSX_TYPE_NULL) { continue; }
+
+        int cnt = snprintf(&query[i], bsize, ", ?%zu", param++);
 
         if (cnt < 0)
         {
@@ -130,7 +135,7 @@ static char *build_insert_query(const char *name, struct xlsx *doc)
 // Insert all rows into the table we made.
 static int insert_rows(sqlite3 *db, const char *name, struct xlsx *doc, int *types)
 {
-    char *query = build_insert_query(name, doc);
+    char *query = build_insert_query(name, doc, types);
     if (!query) { return 1; }
 
     printf("Built insert query: '%s'\n", query);
@@ -144,40 +149,47 @@ static int insert_rows(sqlite3 *db, const char *name, struct xlsx *doc, int *typ
     }
 
     printf("Inserting %zu rows...\n", xlsx_rows(doc) - 1);
-    size_t mod = xlsx_rows(doc) < 10000 ? 10 : xlsx_rows(doc) / 100;
+
+    // Progress is rate limited by the reporter, so this costs nearly nothing per row.
+    struct metrics metrics;
+    struct metrics *m = &metrics;
+
+    metrics_init(m, "xlsx2sql", xlsx_rows(doc) - 1);
 
     int result = xlsx_foreach_row(doc, ^(struct xlsx_value *entry, size_t i) {
         if (!i) { return 0; }
 
-        if (!(i % mod)) {
-            printf("Insert %zu...", i);
-        }
-
         // Checked bind macro.
         #define CHECK(s)                    \
             do {                            \
                 if (s)                      \
                 {                           \
-                    if (!(i % mod)) {       \
-                        printf(" [err]\n"); \
-                    }                       \
-                                            \
                     sqlerror("bind", db);   \
                     return 1;               \
                 }                           \
             } while (0)
 
+        // Number of bytes of string content in this row.
+        size_t bytes = 0;
+
         CHECK(sqlite_bind_int(stmt, 1, i));
 
+        // Parameter for the next column (empty columns have none).
+        int param = 2;
+
         for (size_t col = 0; col < xlsx_cols(doc); col++)
         {
+            if (types[col] == XLSX_TYPE_NULL) { continue; }
+
             if (entry[col].type == XLSX_TYPE_INT) {
-                CHECK(sqlite_bind_int(stmt, col + 2, entry[col].ival));
+                CHECK(sqlite_bind_int(stmt, param++, entry[col].ival));
             } else if (entry[col].type == XLSX_TYPE_NULL) {
-                CHECK(sqlite_bind_null(stmt, col + 2));
+                CHECK(sqlite_bind_null(stmt, param++));
             } else {
-                //printf("Bind %s = %s", XLSX_STRVAL(&header[col]), XLSX_STRVAL(&entry[col]));
-                CHECK(sqlite_bind_str(stmt, col + 2, XLSX_STRVAL(&entry[col])));
+                const char *str = XLSX_STRVAL(doc, &entry[col]);
+                bytes += strlen(str);
+
+                CHECK(sqlite_bind_str(stmt, param++, str));
             }
         }
 
@@ -186,22 +198,21 @@ static int insert_rows(sqlite3 *db, const char *name, struct xlsx *doc, int *typ
         int status = sqlite3_step(stmt);
 
         if (status == SQLITE_ROW) {
-            if (!(i % mod)) {
-                printf(" [%u]\n", sqlite3_column_int(stmt, 0));
-            }
+            metrics_debug(m, "Inserted row %zu [%u]\n", i, sqlite3_column_int(stmt, 0));
+            metrics_step(m, bytes);
 
             sqlite3_reset(stmt);
             return 0;
         } else {
-            if (!(i % mod)) {
-                printf(" [err]\n");
-            }
-
+            fprintf(stderr, "Error: Failed to insert row %zu\n", i);
             sqlerror("sqlite3_step", db);
+
             return 1;
         }
     });
 
+    metrics_finish(m, result);
+
     sqlite3_finalize(stmt);
     free(query);
 
@@ -220,7 +231,7 @@ static char *build_create_query(const char *name, struct xlsx *doc, int *types)
     for (size_t col = 0; col < xlsx_cols(doc); col++)
     {
         // We know the type is either a string or a literal string here.
-        size_t len = strlen(XLSX_STRVAL(&header[col]));
+        size_t len = strlen(XLSX_STRVAL(doc, &header[col]));
 
         if (len > append_max) {
             append_max = len;
@@ -261,7 +272,7 @@ static char *build_create_query(const char *name, struct xlsx *doc, int *types)
         }
 
         const char *type = (types[col] == XLSX_TYPE_INT ? "integer" : "text");
-        const char *name = XLSX_STRVAL(&header[col]);
+        const char *name = XLSX_STRVAL(doc, &header[col]);
 
         // We truncate `name` at the first space if it exists.
         char *space = strchr(name, ' ');
@@ -309,6 +320,42 @@ static int create_table(sqlite3 *db, const char *name, struct xlsx *doc, int *ty
     return status;
 }
 
+// Create an index for each column in `indexed_columns` the table has. Empty columns (which aren't in the table) are skipped.
+static int create_indices(sqlite3 *db, const char *name, struct xlsx *doc, int *types)
+{
+    struct xlsx_value *header = xlsx_row(doc, 0);
+
+    for (size_t col = 0; col < xlsx_cols(doc); col++)
+    {
+        if (types[col] == XLSX_TYPE_NULL) { continue; }
+
+        const char *column = XLSX_STRVAL(doc, &header[col]);
+
+        for (size_t i = 0; i < sizeof(indexed_columns) / sizeof(*indexed_columns); i++)
+        {
+            if (strcmp(column, indexed_columns[i])) { continue; }
+
+            char *query = sqlite3_mprintf("create index \"%w_%w\" on \"%w\"(\"%w\");", name, column, name, column);
+
+            if (!query)
+            {
+                fprintf(stderr, "Error: Out of memory building index query!\n");
+                return 1;
+            }
+
+            printf("Creating index on '%s'...\n", column);
+
+            // Free the statement before checking how it went, so no path leaks it.
+            int status = sqlite_exec(db, query, NULL);
+            sqlite3_free(query);
+
+            if (status) { return 1; }
+        }
+    }
+
+    return 0;
+}
+
 // Check the provided document is something we can convert.
 // Currently this means all columns have a clear data type.
 // In the process, fill in types[col] for each column with the type of the column.
@@ -331,7 +378,7 @@ static int check_document(struct xlsx *doc, int *types)
             return 1;
         }
 
-        if (strchr(XLSX_STRVAL(&header[col]), ' ')) {
+        if (strchr(XLSX_STRVAL(doc, &header[col]), ' ')) {
             fprintf(stderr, "Warning: Column %zu contains a space in the header\n", col + 1);
         }
 
@@ -441,26 +488,25 @@ int main(int argc, char *const *argv)
     sqlite3 *db = sqlite_open(db_path, false);
     if (!db) { exit(1); }
 
-    if (create_table(db, tblname, doc, types))
+    // Everything below is freed on failure too.
+    int status = create_table(db, tblname, doc, types);
+
+    if (!status)
     {
-        sqlite_close(db);
-        exit(1);
+        printf("Successfully created table '%s'\n", tblname);
+        status = insert_rows(db, tblname, doc, types);
     }
 
-    printf("Successfully created table '%s'\n", tblname);
-
-    if (insert_rows(db, tblname, doc, types))
+    if (!status)
     {
-        sqlite_close(db);
-        exit(1);
+        printf("Finished inserting all rows from document.\n");
+        status = create_indices(db, tblname, doc, types);
     }
 
-    printf("Finished inserting all rows from document.\n");
-
     free(types);
     free(tblname);
     sqlite_close(db);
     xlsx_doc_free(doc);
 
-    return 0;
+    return status;
 }
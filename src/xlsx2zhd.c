@@ -0,0 +1,395 @@
+/* ********************************************************** */
+/* -*- xlsx2zhd.c -*- Convert XLSX document to a zhd file -*- */
+/* ********************************************************** */
+/* Tyler Besselman (C) October 2026                           */
+/* ********************************************************** */
+
+// Write the dictionary as a compact read-only zhd file (see zhd.h), which a phone can map and query without parsing anything.
+// With `-q`, open a zhd file and look up words in it instead (timing the open and the first lookup).
+
+#include <strings.h>
+#include <string.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include <dindex.h>
+#include <obuf.h>
+#include <utf8.h>
+#include <zhd.h>
+
+// Columns we take data from.
+enum {
+    COL_WORD,
+    COL_DEF,
+    COL_ZHUYIN,
+    COL_PINYIN,
+    COL_RADICAL,
+    COL_STROKES,
+    COL_XSTROKES,
+    NCOLS
+};
+
+static const char *const col_names[NCOLS] = {
+    [COL_WORD]     = "字詞名",
+    [COL_DEF]      = "釋義",
+    [COL_ZHUYIN]   = "注音一式",
+    [COL_PINYIN]   = "漢語拼音",
+    [COL_RADICAL]  = "部首字",
+    [COL_STROKES]  = "總筆畫數",
+    [COL_XSTROKES] = "部首外筆畫數"
+};
+
+// String pool being built. Each distinct string is only stored once (pronunciations repeat a lot).
+struct pool {
+    struct obuf data;
+
+    // Open addressing hash table of pool offsets + 1 (0 is empty). `nslots` is a power of 2.
+    uint32_t *slots;
+    uint32_t nslots;
+};
+
+static inline uint32_t pow2(uint32_t n)
+{
+    uint32_t p = 16;
+
+    while (p < n) {
+        p *= 2;
+    }
+
+    return p;
+}
+
+// Add a string to the pool (if it isn't there already), returning its offset (`ZHD_NONE` on failure).
+static uint32_t pool_add(struct pool *pool, const char *str)
+{
+    size_t len = strlen(str);
+    uint32_t mask = pool->nslots - 1;
+    uint32_t s = zhd_hash(str, len) & mask;
+
+    for ( ; pool->slots[s]; s = (s + 1) & mask)
+    {
+        const char *other = &pool->data.data[pool->slots[s] - 1];
+        if (!strcmp(other, str)) { return pool->slots[s] - 1; }
+    }
+
+    uint32_t off = pool->data.len;
+
+    if (pool->data.len + len + 1 >= ZHD_NONE || obuf_append(&pool->data, str, len + 1)) { return ZHD_NONE; }
+
+    pool->slots[s] = off + 1;
+    return off;
+}
+
+// Get a string cell as a pool offset (`ZHD_NONE` if it's missing or not a string).
+static uint32_t pool_cell(struct pool *pool, struct xlsx *doc, struct xlsx_value *row, off_t col, bool *failed)
+{
+    if (col < 0 || !XLSX_ISSTR(&row[col])) { return ZHD_NONE; }
+
+    uint32_t off = pool_add(pool, XLSX_STRVAL(doc, &row[col]));
+    if (off == ZHD_NONE) { (*failed) = true; }
+
+    return off;
+}
+
+// Append a variable length number (7 bits at a time, low bits first). Returns non-zero on failure.
+static int put_varint(struct obuf *buf, uint32_t v)
+{
+    uint8_t bytes[5];
+    size_t n = 0;
+
+    do {
+        bytes[n++] = (v & 0x7F) | ((v > 0x7F) ? 0x80 : 0);
+        v >>= 7;
+    } while (v);
+
+    return obuf_append(buf, bytes, n);
+}
+
+// Get a small integer cell (0 if it's missing or out of range).
+static uint8_t small_cell(struct xlsx_value *row, off_t col)
+{
+    if (col < 0 || row[col].type != XLSX_TYPE_INT || row[col].ival < 0 || row[col].ival > UINT8_MAX) { return 0; }
+    return row[col].ival;
+}
+
+// Build and write a zhd file for a dictionary workbook. Returns non-zero on failure.
+static int write_zhd(struct xlsx *doc, const char *path)
+{
+    off_t cols[NCOLS];
+    struct xlsx_value *header = xlsx_row(doc, 0);
+
+    for (size_t c = 0; c < NCOLS; c++)
+    {
+        cols[c] = -1;
+
+        for (size_t i = 0; i < xlsx_cols(doc); i++)
+        {
+            if (XLSX_ISSTR(&header[i]) && !strcmp(col_names[c], XLSX_STRVAL(doc, &header[i]))) {
+                cols[c] = i;
+                break;
+            }
+        }
+    }
+
+    if (cols[COL_WORD] < 0 || cols[COL_DEF] < 0)
+    {
+        fprintf(stderr, "Error: Missing names or definitions.\n");
+        return 1;
+    }
+
+    // The lookup index already has words sorted and entries grouped by word, which is the order we write them in.
+    struct dindex *idx = dindex_build(doc, cols[COL_WORD], cols[COL_DEF], cols[COL_STROKES]);
+    if (!idx) { return 1; }
+
+    uint32_t nwords = idx->nwords;
+    uint32_t nentries = idx->nentries;
+    uint32_t nblocks = (nwords + ZHD_BLOCK - 1) / ZHD_BLOCK;
+    uint32_t nslots = pow2(nwords * 2 + 1);
+
+    struct pool pool = { .data = OBUF_INIT, .nslots = pow2(nentries * 6 + 1) };
+    struct obuf keys = OBUF_INIT;
+
+    pool.slots = calloc(pool.nslots, sizeof(uint32_t));
+
+    uint32_t *blocks = malloc(nblocks * sizeof(uint32_t) + 1);
+    struct zhd_word *words = malloc(nwords * sizeof(struct zhd_word) + 1);
+    struct zhd_entry *entries = malloc(nentries * sizeof(struct zhd_entry) + 1);
+    struct zhd_slot *slots = calloc(nslots, sizeof(struct zhd_slot));
+    struct zhd_char *chars = malloc(nwords * sizeof(struct zhd_char) + 1);
+
+    bool failed = (!pool.slots || !blocks || !words || !entries || !slots || !chars);
+    uint32_t nchars = 0;
+    size_t words_size = 0;
+
+    if (failed) {
+        perror("malloc");
+    }
+
+    for (uint32_t w = 0; w < nwords && !failed; w++)
+    {
+        const struct dindex_word *word = &idx->words[w];
+        const char *str = dindex_str(idx, word->str);
+
+        if (word->len >= ZHD_MAX_WORD)
+        {
+            fprintf(stderr, "Error: Word in row %u is too long! (max=%d, found=%u)\n", idx->entries[idx->rows[word->first]].row, ZHD_MAX_WORD - 1, word->len);
+            failed = true;
+
+            break;
+        }
+
+        // Front code the word against the one before it (unless it starts a block).
+        uint32_t shared = 0;
+
+        if (w % ZHD_BLOCK) {
+            const struct dindex_word *prev = &idx->words[w - 1];
+            const char *pstr = dindex_str(idx, prev->str);
+
+            while (shared < word->len && shared < prev->len && pstr[shared] == str[shared]) {
+                shared++;
+            }
+
+            failed = put_varint(&keys, shared);
+        } else {
+            blocks[w / ZHD_BLOCK] = keys.len;
+        }
+
+        failed = failed || put_varint(&keys, word->len - shared) || obuf_append(&keys, &str[shared], word->len - shared);
+
+        words_size += word->len;
+        words[w] = (struct zhd_word){ .first = word->first, .count = word->count };
+
+        uint32_t hash = zhd_hash(str, word->len);
+        uint32_t s = hash & (nslots - 1);
+
+        while (slots[s].word) {
+            s = (s + 1) & (nslots - 1);
+        }
+
+        slots[s] = (struct zhd_slot){ .hash = hash, .word = w + 1 };
+
+        for (uint32_t i = 0; i < word->count && !failed; i++)
+        {
+            const struct dindex_entry *entry = &idx->entries[idx->rows[word->first + i]];
+            struct xlsx_value *row = xlsx_row(doc, entry->row);
+
+            entries[word->first + i] = (struct zhd_entry){
+                .def = pool_cell(&pool, doc, row, cols[COL_DEF], &failed),
+                .zhuyin = pool_cell(&pool, doc, row, cols[COL_ZHUYIN], &failed),
+                .pinyin = pool_cell(&pool, doc, row, cols[COL_PINYIN], &failed),
+                .row = entry->row
+            };
+        }
+
+        // Single characters get a fixed size record (taken from their first entry). Words are sorted, so these are too.
+        const char *end = str;
+        uint32_t cp = utf8_next(&end);
+
+        if (!failed && !(*end))
+        {
+            struct xlsx_value *row = xlsx_row(doc, idx->entries[idx->rows[word->first]].row);
+            uint32_t radical = 0;
+
+            if (cols[COL_RADICAL] >= 0 && XLSX_ISSTR(&row[cols[COL_RADICAL]]))
+            {
+                const char *rad = XLSX_STRVAL(doc, &row[cols[COL_RADICAL]]);
+                radical = utf8_next(&rad);
+            }
+
+            chars[nchars++] = (struct zhd_char){
+                .cp = cp,
+                .radical = radical,
+                .strokes = small_cell(row, cols[COL_STROKES]),
+                .xstrokes = small_cell(row, cols[COL_XSTROKES]),
+                .reserved = 0,
+                .word = w
+            };
+        }
+    }
+
+    // The pool can't be empty (readers check it ends with a `\0`).
+    if (!failed && !pool.data.len) {
+        failed = obuf_append(&pool.data, "", 1);
+    }
+
+    if (!failed)
+    {
+        struct zhd_header hdr;
+        mapfile_header_init(&hdr.file, ZHD_MAGIC, ZHD_VERSION, sizeof(struct zhd_header));
+
+        hdr.nwords = nwords;
+        hdr.nentries = nentries;
+        hdr.nslots = nslots;
+        hdr.nchars = nchars;
+        hdr.nblocks = nblocks;
+        hdr.reserved = 0;
+
+        // The hash table and records come first, since a lookup touches them before the strings.
+        mapfile_section_align(&hdr.file, &hdr.slots,   nslots * sizeof(struct zhd_slot), ZHD_ALIGN);
+        mapfile_section_align(&hdr.file, &hdr.blocks,  nblocks * sizeof(uint32_t), ZHD_ALIGN);
+        mapfile_section_align(&hdr.file, &hdr.words,   nwords * sizeof(struct zhd_word), ZHD_ALIGN);
+        mapfile_section_align(&hdr.file, &hdr.entries, nentries * sizeof(struct zhd_entry), ZHD_ALIGN);
+        mapfile_section_align(&hdr.file, &hdr.chars,   nchars * sizeof(struct zhd_char), ZHD_ALIGN);
+        mapfile_section_align(&hdr.file, &hdr.keys,    keys.len, ZHD_ALIGN);
+        mapfile_section_align(&hdr.file, &hdr.pool,    pool.data.len, ZHD_ALIGN);
+
+        failed = mapfile_save(path, ^(FILE *fp) {
+            return (fwrite(&hdr, sizeof(struct zhd_header), 1, fp) != 1)
+                || mapfile_write(fp, &hdr.slots,   slots)
+                || mapfile_write(fp, &hdr.blocks,  blocks)
+                || mapfile_write(fp, &hdr.words,   words)
+                || mapfile_write(fp, &hdr.entries, entries)
+                || mapfile_write(fp, &hdr.chars,   chars)
+                || mapfile_write(fp, &hdr.keys,    keys.data)
+                || mapfile_write(fp, &hdr.pool,    pool.data.data);
+        });
+
+        if (!failed)
+        {
+            printf("Wrote %u words (%u entries, %u characters) to '%s' (%llu bytes).\n", nwords, nentries, nchars, path, (unsigned long long)hdr.file.size);
+            printf("Keys take %zu bytes front coded (%zu bytes whole), and strings %zu bytes.\n", keys.len, words_size, pool.data.len);
+        }
+    }
+
+    dindex_free(idx);
+    obuf_free(&pool.data);
+    obuf_free(&keys);
+
+    free(pool.slots);
+    free(blocks);
+    free(words);
+    free(entries);
+    free(slots);
+    free(chars);
+
+    return failed;
+}
+
+// Seconds elapsed since `start`.
+static double elapsed(struct timespec *start)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (now.tv_sec - start->tv_sec) + (now.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+// Open a zhd file and look up each word, printing every entry found. Returns non-zero on failure.
+static int query_zhd(const char *path, const char *const *queries, size_t n)
+{
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    struct zhd *zd = zhd_open(path);
+    if (!zd) { return 1; }
+
+    double open_time = elapsed(&start);
+
+    for (size_t q = 0; q < n; q++)
+    {
+        size_t found = zhd_lookup(zd, queries[q], ^(const struct zhd_entry *entry) {
+            printf("%s", queries[q]);
+
+            if (entry->zhuyin != ZHD_NONE) { printf(" [%s]", zhd_str(zd, entry->zhuyin)); }
+            if (entry->pinyin != ZHD_NONE) { printf(" (%s)", zhd_str(zd, entry->pinyin)); }
+
+            printf(" (row %u)\n%s\n", entry->row + 1, (entry->def != ZHD_NONE ? zhd_str(zd, entry->def) : ""));
+            return 0;
+        });
+
+        if (!q) {
+            fprintf(stderr, "Opened in %.3f ms, first lookup done after %.3f ms.\n", open_time * 1e3, elapsed(&start) * 1e3);
+        }
+
+        if (!found) {
+            printf("'%s' is not in the dictionary.\n", queries[q]);
+        }
+
+        // Single characters also have their radical and stroke counts.
+        const char *end = queries[q];
+        uint32_t cp = utf8_next(&end);
+        const struct zhd_char *chr = (*end ? NULL : zhd_char(zd, cp));
+
+        if (chr && chr->radical)
+        {
+            char rad[5] = { 0 };
+            utf8_encode(chr->radical, rad);
+
+            printf("Radical %s, %u strokes (%u outside the radical).\n", rad, chr->strokes, chr->xstrokes);
+        }
+    }
+
+    zhd_close(zd);
+    return 0;
+}
+
+int main(int argc, const char *const *argv)
+{
+    if (argc >= 3 && !strcmp(argv[1], "-q")) {
+        return query_zhd(argv[2], &argv[3], argc - 3);
+    }
+
+    if (argc != 3)
+    {
+        fprintf(stderr, "Usage: %s <dict.xlsx> <dict.zhd>\n", argv[0]);
+        fprintf(stderr, "       %s -q <dict.zhd> [word...]\n", argv[0]);
+
+        return 1;
+    }
+
+    struct xlsx *doc = xlsx_doc_at(argv[1]);
+    if (!doc) { return 1; }
+
+    if (!xlsx_rows(doc) || !xlsx_cols(doc))
+    {
+        fprintf(stderr, "Error: Dictionary sheet is empty!\n");
+        xlsx_doc_free(doc);
+
+        return 1;
+    }
+
+    int status = write_zhd(doc, argv[2]);
+    xlsx_doc_free(doc);
+
+    return status;
+}
@@ -7,6 +7,7 @@
 #include <strings.h>
 #include <stdbool.h>
 
+#include <trace.h>
 #include <xml.h>
 
 #define foreach(node, v, f, blk)    \
@@ -37,6 +38,8 @@ static xmlNodePtr _xml_root_for(xmlDocPtr doc)
 
 xmlNodePtr xml_root_at(const char *path)
 {
+    TRACE_SPAN("xml_parse", path);
+
     xmlDocPtr doc = xmlParseFile(path);
 
     if (!doc)
@@ -50,6 +53,8 @@ xmlNodePtr xml_root_at(const char *path)
 
 xmlNodePtr xml_root_in(const void *buf, size_t len)
 {
+    TRACE_SPAN("xml_parse", NULL);
+
     xmlDocPtr doc = xmlParseMemory(buf, len);
 
     if (!doc)
@@ -63,6 +68,8 @@ xmlNodePtr xml_root_in(const void *buf, size_t len)
 
 xmlNodePtr zxml_root_at(zip_t *archive, const char *path)
 {
+    TRACE_SPAN("zxml_root_at", path);
+
     zip_int64_t idx = zip_name_locate(archive, path, ZIP_FL_ENC_UTF_8);
 
     if (idx < 0)
@@ -121,7 +128,7 @@ xmlNodePtr zxml_root_at(zip_t *archive, const char *path)
     }
 
     if (DEBUG_XML) {
-        printf("Read %lld bytes from '%s' in zip archive.\n", read, path);
+        fprintf(stderr, "Read %lld bytes from '%s' in zip archive.\n", read, path);
     }
 
     if (zip_fclose(file))
@@ -0,0 +1,289 @@
+/* ********************************************************** */
+/* -*- zhd.c -*- Compact read-only dictionary files       -*- */
+/* ********************************************************** */
+/* Tyler Besselman (C) October 2026                           */
+/* ********************************************************** */
+
+#include <strings.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+
+#include <zhd.h>
+#include <fnv.h>
+
+uint32_t zhd_hash(const char *str, size_t len)
+{
+    // FNV-1a. Words are short, so this is plenty.
+    return fnv1a(FNV_INIT, str, len);
+}
+
+bool zhd_is_file(const char *path)
+{ return mapfile_is(path, ZHD_MAGIC); }
+
+struct zhd *zhd_open(const char *path)
+{
+    size_t size;
+    void *map = mapfile_open(path, "dictionary", ZHD_MAGIC, ZHD_VERSION, sizeof(struct zhd_header), &size);
+
+    if (!map) { return NULL; }
+
+    const struct zhd_header *header = map;
+    const char *base = map;
+
+    #define SECTION_OK(s, n) (mapfile_section_ok(&header->file, &header->s, (n)) && !(header->s.offset % ZHD_ALIGN))
+
+    bool ok = (header->nslots && !(header->nslots & (header->nslots - 1)))
+        && (header->nblocks == (header->nwords + ZHD_BLOCK - 1) / ZHD_BLOCK)
+        && SECTION_OK(pool,    header->pool.size)
+        && (header->pool.size && base[header->pool.offset + header->pool.size - 1] == 0)
+        && SECTION_OK(keys,    header->keys.size)
+        && SECTION_OK(blocks,  (uint64_t)header->nblocks * sizeof(uint32_t))
+        && SECTION_OK(words,   (uint64_t)header->nwords * sizeof(struct zhd_word))
+        && SECTION_OK(entries, (uint64_t)header->nentries * sizeof(struct zhd_entry))
+        && SECTION_OK(slots,   (uint64_t)header->nslots * sizeof(struct zhd_slot))
+        && SECTION_OK(chars,   (uint64_t)header->nchars * sizeof(struct zhd_char));
+
+    #undef SECTION_OK
+
+    if (!ok) {
+        fprintf(stderr, "Error: Dictionary file '%s' is corrupt!\n", path);
+    }
+
+    struct zhd *zd = (ok ? calloc(1, sizeof(struct zhd)) : NULL);
+
+    if (!zd)
+    {
+        if (ok) { perror("calloc"); }
+        mapfile_close(map, size);
+
+        return NULL;
+    }
+
+    zd->pool = &base[header->pool.offset];
+    zd->pool_size = header->pool.size;
+
+    zd->keys = (const uint8_t *)&base[header->keys.offset];
+    zd->keys_size = header->keys.size;
+
+    zd->blocks = (const uint32_t *)&base[header->blocks.offset];
+    zd->nblocks = header->nblocks;
+
+    zd->words = (const struct zhd_word *)&base[header->words.offset];
+    zd->nwords = header->nwords;
+
+    zd->entries = (const struct zhd_entry *)&base[header->entries.offset];
+    zd->nentries = header->nentries;
+
+    zd->slots = (const struct zhd_slot *)&base[header->slots.offset];
+    zd->nslots = header->nslots;
+
+    zd->chars = (const struct zhd_char *)&base[header->chars.offset];
+    zd->nchars = header->nchars;
+
+    zd->map = map;
+    zd->map_size = size;
+
+    return zd;
+}
+
+// Read a variable length number (7 bits at a time, low bits first) at `*p`. Returns false if it runs past `end`.
+static inline bool _zhd_varint(const uint8_t **p, const uint8_t *end, uint32_t *out)
+{
+    uint32_t v = 0;
+
+    for (uint32_t shift = 0; (*p) < end && shift < 32; shift += 7)
+    {
+        uint8_t b = *(*p)++;
+        v |= (uint32_t)(b & 0x7F) << shift;
+
+        if (!(b & 0x80))
+        {
+            (*out) = v;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+// Decode the words in block `b` into `buf` one at a time, performing a block on each (with its length and index).
+// Returns -1 if the file is corrupt, 1 if `blk` stopped us, and 0 otherwise.
+static int _zhd_block(const struct zhd *zd, uint32_t b, char *buf, int (^blk)(size_t len, uint32_t w))
+{
+    if (b >= zd->nblocks || zd->blocks[b] >= zd->keys_size) { return -1; }
+
+    const uint8_t *p = &zd->keys[zd->blocks[b]];
+    const uint8_t *end = &zd->keys[zd->keys_size];
+
+    uint32_t first = b * ZHD_BLOCK;
+    uint32_t last = (zd->nwords - first < ZHD_BLOCK ? zd->nwords : first + ZHD_BLOCK);
+    uint32_t len = 0;
+
+    for (uint32_t w = first; w < last; w++)
+    {
+        // Each word after the first shares a prefix with the word before it.
+        uint32_t shared = 0;
+        uint32_t suffix;
+
+        if (w != first && !_zhd_varint(&p, end, &shared)) { return -1; }
+        if (!_zhd_varint(&p, end, &suffix)) { return -1; }
+
+        if (shared > len || suffix >= ZHD_MAX_WORD - shared || suffix > (size_t)(end - p)) { return -1; }
+
+        memcpy(&buf[shared], p, suffix);
+        p += suffix;
+
+        len = shared + suffix;
+        buf[len] = 0;
+
+        if (blk(len, w)) { return 1; }
+    }
+
+    return 0;
+}
+
+ssize_t zhd_word(const struct zhd *zd, uint32_t w, char *buf)
+{
+    __block ssize_t found = -1;
+
+    _zhd_block(zd, w / ZHD_BLOCK, buf, ^(size_t len, uint32_t i) {
+        if (i != w) { return 0; }
+
+        found = len;
+        return 1;
+    });
+
+    return found;
+}
+
+int64_t zhd_find(const struct zhd *zd, const char *word, size_t len)
+{
+    uint32_t hash = zhd_hash(word, len);
+    uint32_t mask = zd->nslots - 1;
+
+    char buf[ZHD_MAX_WORD];
+
+    // Only slots with the same hash need their word decoded. A (corrupt) table with no empty slot is only probed once round.
+    uint32_t s = hash & mask;
+
+    for (uint32_t probes = 0; probes < zd->nslots && zd->slots[s].word; probes++, s = (s + 1) & mask)
+    {
+        if (zd->slots[s].hash != hash) { continue; }
+
+        uint32_t w = zd->slots[s].word - 1;
+        ssize_t wlen = zhd_word(zd, w, buf);
+
+        if (wlen == (ssize_t)len && !memcmp(buf, word, len)) {
+            return w;
+        }
+    }
+
+    return -1;
+}
+
+size_t zhd_lookup(const struct zhd *zd, const char *word, int (^blk)(const struct zhd_entry *entry))
+{
+    int64_t w = zhd_find(zd, word, strlen(word));
+    if (w < 0) { return 0; }
+
+    const struct zhd_word *info = &zd->words[w];
+
+    for (uint32_t i = 0; i < info->count; i++)
+    {
+        if (info->first + i >= zd->nentries) { return i; }
+
+        if (blk(&zd->entries[info->first + i])) {
+            return i + 1;
+        }
+    }
+
+    return info->count;
+}
+
+size_t zhd_prefix(const struct zhd *zd, const char *prefix, size_t k, int (^blk)(const char *word, uint32_t w))
+{
+    size_t plen = strlen(prefix);
+
+    if (!k || !zd->nblocks) { return 0; }
+
+    // Find the last block starting before the prefix. Everything with the prefix starts there or later.
+    uint32_t lo = 0;
+    uint32_t hi = zd->nblocks;
+
+    while (hi - lo > 1)
+    {
+        uint32_t mid = lo + (hi - lo) / 2;
+
+        const uint8_t *p = &zd->keys[zd->blocks[mid]];
+        uint32_t len;
+
+        if (zd->blocks[mid] >= zd->keys_size || !_zhd_varint(&p, &zd->keys[zd->keys_size], &len) || len > (size_t)(&zd->keys[zd->keys_size] - p)) { return 0; }
+
+        // The first word in a block is stored whole.
+        int cmp = memcmp(p, prefix, (len < plen ? len : plen));
+
+        if (cmp < 0 || (!cmp && len < plen)) {
+            lo = mid;
+        } else {
+            hi = mid;
+        }
+    }
+
+    // Blocks can't capture arrays, so only the pointer is used inside the block.
+    char words[ZHD_MAX_WORD];
+    char *buf = words;
+
+    __block size_t n = 0;
+    __block bool done = false;
+
+    for (uint32_t b = lo; b < zd->nblocks && !done; b++)
+    {
+        int status = _zhd_block(zd, b, buf, ^(size_t len, uint32_t w) {
+            int cmp = strncmp(buf, prefix, plen);
+
+            // Words before the prefix are skipped, and the first word after everything with it ends the search.
+            if (cmp < 0) { return 0; }
+
+            if (cmp > 0)
+            {
+                done = true;
+                return 1;
+            }
+
+            n++;
+            done = (blk(buf, w) || n >= k);
+
+            return (int)done;
+        });
+
+        if (status < 0) { break; }
+    }
+
+    return n;
+}
+
+const struct zhd_char *zhd_char(const struct zhd *zd, uint32_t cp)
+{
+    uint32_t lo = 0;
+    uint32_t hi = zd->nchars;
+
+    while (lo < hi)
+    {
+        uint32_t mid = lo + (hi - lo) / 2;
+
+        if (zd->chars[mid].cp < cp) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+
+    return ((lo < zd->nchars && zd->chars[lo].cp == cp) ? &zd->chars[lo] : NULL);
+}
+
+void zhd_close(struct zhd *zd)
+{
+    mapfile_close(zd->map, zd->map_size);
+    free(zd);
+}
@@ -0,0 +1,919 @@
+/* ********************************************************** */
+/* -*- zhdictd.c -*- Dictionary lookup daemon             -*- */
+/* ********************************************************** */
+/* Tyler Besselman (C) October 2026                           */
+/* ********************************************************** */
+
+// Requests are JSON objects, either one per line or as a 4 byte (big endian) length followed by that many bytes.
+// A length prefix can never start with '{' or whitespace (that would be a huge request), so both can be mixed freely.
+// Responses use the same framing as the request they answer and always come back in request order.
+//
+// Requests look like `{"id": 1, "op": "lookup", "q": "水"}`. Members are:
+//   id     Anything scalar, echoed back as is
+//   op     "lookup" or "complete" (default is to complete if `q` ends with '*' and to look up otherwise)
+//   q      The word or prefix to look for
+//   k      Max number of completions
+//   order  "lex" or "strokes" for completions
+//
+// Responses look like `{"id": 1, "ok": true, "total": 1, "results": [{"word": "水", "row": 3, "def": "..."}]}`.
+// Completions only have `word` and `strokes` in each result. Failed requests have `"ok": false` and an `error`.
+//
+// SIGHUP reloads the dictionary from the same path in the background. Requests keep being answered from the old one
+//   until the new one is ready, and the old one is freed once the last request using it is done.
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <pthread.h>
+#include <strings.h>
+#include <stdbool.h>
+#include <signal.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <time.h>
+
+#include <dindex.h>
+#include <epoch.h>
+#include <evloop.h>
+#include <json.h>
+#include <obuf.h>
+#include <pool.h>
+
+// Enable debug messages
+#define DEBUG_ZHDICTD 1
+
+// Default socket path.
+#define ZHDICTD_SOCKET "zhdictd.sock"
+
+// Largest request we accept (in bytes).
+#define REQUEST_MAX (1 << 20)
+
+// Largest number of completions a single request can ask for.
+#define COMPLETE_MAX 1000
+
+// Longest query we look up (in bytes). Nothing in a dictionary comes close.
+#define QUERY_MAX 1024
+
+// Bytes read from a connection at a time.
+#define READ_SIZE 16384
+
+// Stop reading from a connection while it has this many bytes of responses waiting to go out.
+#define OUTPUT_HIGH (1 << 20)
+
+// Max events handled per wakeup.
+#define WAIT_EVENTS 64
+
+// Settings shared by every worker.
+struct server {
+    // The index being served. Workers only use it inside an epoch (one per request), so it can be swapped out by a reload.
+    _Atomic(struct dindex *) idx;
+    struct epoch epoch;
+
+    // Where the dictionary is (re)loaded from.
+    const char *dict;
+
+    // Reloads asked for and finished, and whether the reloading thread is running.
+    _Atomic uint64_t reloads_wanted;
+    uint64_t reloads_done;
+
+    atomic_bool reloading;
+    pthread_t reloader;
+    bool reloader_started;
+
+    // Defaults for completions.
+    enum dindex_order order;
+    size_t k;
+};
+
+// A single client connection. Each one is owned by exactly one worker.
+struct conn {
+    int fd;
+
+    // Bytes read but not handled yet start at `in.data[in_off]`.
+    struct obuf in;
+    size_t in_off;
+
+    // Responses not written yet start at `out.data[out_off]`.
+    struct obuf out;
+    size_t out_off;
+
+    // Events we're currently waiting on, and whether the client is done sending.
+    unsigned int events;
+    bool eof;
+
+    struct conn *prev;
+    struct conn *next;
+};
+
+// A worker thread with its own event loop. New connections come in through a pipe from the accepting thread.
+struct worker {
+    pthread_t thread;
+    bool running;
+
+    // This worker is reader `id` of the server's epoch.
+    struct server *srv;
+    size_t id;
+
+    struct evloop *loop;
+    int pipe[2];
+
+    // All connections owned by this worker.
+    struct conn *conns;
+
+    // Decoded request strings.
+    struct obuf scratch;
+};
+
+// A parsed request.
+struct request {
+    const char *id;
+    size_t id_len;
+
+    const char *op;
+    const char *q;
+
+    enum dindex_order order;
+    size_t k;
+};
+
+static volatile sig_atomic_t stopping = 0;
+static volatile sig_atomic_t reload = 0;
+
+// Written to by the signal handler, so a signal arriving just before the accepting thread waits still wakes it up.
+static int signal_pipe[2] = { -1, -1 };
+
+static void on_signal(int sig)
+{
+    int saved = errno;
+
+    if (sig == SIGHUP) {
+        reload = 1;
+    } else {
+        stopping = 1;
+    }
+
+    // Both ends are non-blocking, and if the pipe is full a wakeup is already waiting.
+    (void)!write(signal_pipe[1], "", 1);
+
+    errno = saved;
+}
+
+// Start a thread which leaves signals to the main thread (so it's the one woken up by them).
+static int spawn(pthread_t *thread, void *(*fn)(void *), void *arg)
+{
+    sigset_t set, old;
+
+    sigemptyset(&set);
+    sigaddset(&set, SIGINT);
+    sigaddset(&set, SIGTERM);
+    sigaddset(&set, SIGHUP);
+
+    pthread_sigmask(SIG_BLOCK, &set, &old);
+    errno = pthread_create(thread, NULL, fn, arg);
+    pthread_sigmask(SIG_SETMASK, &old, NULL);
+
+    if (errno)
+    {
+        perror("pthread_create");
+        return 1;
+    }
+
+    return 0;
+}
+
+static int set_nonblocking(int fd)
+{
+    int flags = fcntl(fd, F_GETFL);
+
+    if (flags < 0 || fcntl(fd, F_SETFL, flags | O_NONBLOCK) || fcntl(fd, F_SETFD, FD_CLOEXEC))
+    {
+        perror("fcntl");
+        return 1;
+    }
+
+    return 0;
+}
+
+// Parse the members we care about out of a request.
+static int parse_request(struct worker *w, const char *json, size_t len, struct request *req)
+{
+    (*req) = (struct request){ .order = w->srv->order, .k = w->srv->k };
+
+    return json_object(json, len, &w->scratch, ^(const char *key, const struct json_value *val) {
+        if (!strcmp(key, "id")) {
+            req->id = val->raw;
+            req->id_len = val->raw_len;
+        } else if (!strcmp(key, "op") && val->type == JSON_STRING) {
+            req->op = val->str;
+        } else if (!strcmp(key, "q") && val->type == JSON_STRING) {
+            req->q = val->str;
+        } else if (!strcmp(key, "k") && val->type == JSON_NUMBER) {
+            // Anything below 1 is left as 0 and rejected once we know the id.
+            req->k = (val->num < 1 ? 0 : (val->num > COMPLETE_MAX ? COMPLETE_MAX : (size_t)val->num));
+        } else if (!strcmp(key, "order") && val->type == JSON_STRING) {
+            if (!strcmp(val->str, "strokes")) {
+                req->order = DINDEX_ORDER_STROKES;
+            } else if (!strcmp(val->str, "lex")) {
+                req->order = DINDEX_ORDER_LEX;
+            } else {
+                return 1;
+            }
+        }
+
+        return 0;
+    });
+}
+
+// Start a response object (with the request id, if we have one).
+static int begin_response(struct obuf *out, const struct request *req, bool ok)
+{
+    if (obuf_puts(out, "{\"id\":")) { return 1; }
+
+    if (req && req->id) {
+        if (obuf_append(out, req->id, req->id_len)) { return 1; }
+    } else {
+        if (obuf_puts(out, "null")) { return 1; }
+    }
+
+    return obuf_puts(out, (ok ? ",\"ok\":true" : ",\"ok\":false"));
+}
+
+static int error_response(struct obuf *out, const struct request *req, const char *error)
+{
+    return (begin_response(out, req, false)
+         || obuf_puts(out, ",\"error\":")
+         || json_string(out, error)
+         || obuf_puts(out, "}"));
+}
+
+// Write the answer to a request into `out`, using a given index.
+static int answer_with(struct worker *w, const struct dindex *idx, const char *json, size_t len, struct obuf *out)
+{
+    struct request req;
+
+    if (parse_request(w, json, len, &req)) {
+        return error_response(out, NULL, "malformed request");
+    } else if (!req.q) {
+        return error_response(out, &req, "missing query");
+    }
+
+    size_t qlen = strlen(req.q);
+    bool complete;
+
+    if (qlen > QUERY_MAX) {
+        return error_response(out, &req, "query too long");
+    } else if (!req.k) {
+        return error_response(out, &req, "k must be at least 1");
+    }
+
+    if (!req.op) {
+        complete = (qlen && req.q[qlen - 1] == '*');
+    } else if (!strcmp(req.op, "complete")) {
+        complete = true;
+    } else if (!strcmp(req.op, "lookup")) {
+        complete = false;
+    } else {
+        return error_response(out, &req, "unknown op");
+    }
+
+    if (begin_response(out, &req, true) || obuf_puts(out, ",\"results\":[")) { return 1; }
+
+    __block int failed = 0;
+    __block size_t n = 0;
+    size_t total;
+
+    if (complete) {
+        // The '*' is only a marker when the op wasn't given.
+        char prefix[QUERY_MAX + 1];
+
+        memcpy(prefix, req.q, qlen + 1);
+
+        if (!req.op) {
+            prefix[qlen - 1] = 0;
+        }
+
+        total = dindex_prefix(idx, prefix, req.order, req.k, ^(const struct dindex_word *word) {
+            failed = ((n++ && obuf_puts(out, ","))
+                   || obuf_puts(out, "{\"word\":")
+                   || json_string_n(out, dindex_str(idx, word->str), word->len)
+                   || obuf_printf(out, ",\"strokes\":%u}", word->strokes));
+
+            return failed;
+        });
+    } else {
+        total = dindex_lookup(idx, req.q, ^(const struct dindex_entry *entry) {
+            failed = ((n++ && obuf_puts(out, ","))
+                   || obuf_puts(out, "{\"word\":")
+                   || json_string(out, dindex_str(idx, entry->word))
+                   || obuf_printf(out, ",\"row\":%u,\"def\":", entry->row + 1));
+
+            if (!failed) {
+                failed = (entry->def == DINDEX_NONE ? obuf_puts(out, "null") : json_string(out, dindex_str(idx, entry->def)));
+            }
+
+            failed = (failed || obuf_puts(out, "}"));
+            return failed;
+        });
+    }
+
+    return (failed || obuf_printf(out, "],\"total\":%zu}", total));
+}
+
+// Write the answer to a request into `out`, holding on to the current index until it's done.
+static int answer(struct worker *w, const char *json, size_t len, struct obuf *out)
+{
+    epoch_enter(&w->srv->epoch, w->id);
+
+    const struct dindex *idx = atomic_load_explicit(&w->srv->idx, memory_order_acquire);
+    int status = answer_with(w, idx, json, len, out);
+
+    epoch_exit(&w->srv->epoch, w->id);
+    return status;
+}
+
+// Answer a single framed request, framing the response the same way.
+static int handle_request(struct worker *w, struct conn *c, const char *json, size_t len, bool prefixed)
+{
+    size_t start = c->out.len;
+
+    if (prefixed)
+    {
+        // Fill in the length after we know it.
+        if (obuf_reserve(&c->out, 4)) { return 1; }
+        c->out.len += 4;
+    }
+
+    if (answer(w, json, len, &c->out)) { return 1; }
+
+    if (prefixed) {
+        uint32_t size = c->out.len - start - 4;
+        uint8_t *p = (uint8_t *)&c->out.data[start];
+
+        p[0] = size >> 24;
+        p[1] = size >> 16;
+        p[2] = size >> 8;
+        p[3] = size;
+    } else {
+        if (obuf_puts(&c->out, "\n")) { return 1; }
+    }
+
+    return 0;
+}
+
+// Answer every complete request we have buffered (stopping early if too much output is waiting).
+// Returns non-zero if the connection should be dropped.
+static int conn_process(struct worker *w, struct conn *c)
+{
+    while (c->in_off < c->in.len && c->out.len - c->out_off < OUTPUT_HIGH)
+    {
+        const char *p = &c->in.data[c->in_off];
+        size_t avail = c->in.len - c->in_off;
+
+        if (*p == '\n' || *p == '\r' || *p == ' ' || *p == '\t') {
+            c->in_off++;
+        } else if (*p == '{') {
+            const char *nl = memchr(p, '\n', avail);
+
+            if (!nl)
+            {
+                if (avail > REQUEST_MAX) { return 1; }
+                break;
+            }
+
+            if (handle_request(w, c, p, nl - p, false)) { return 1; }
+            c->in_off += (nl - p) + 1;
+        } else {
+            if (avail < 4) { break; }
+
+            const uint8_t *b = (const uint8_t *)p;
+            uint32_t size = ((uint32_t)b[0] << 24) | ((uint32_t)b[1] << 16) | ((uint32_t)b[2] << 8) | b[3];
+
+            if (size > REQUEST_MAX) { return 1; }
+            if (avail - 4 < size) { break; }
+
+            if (handle_request(w, c, p + 4, size, true)) { return 1; }
+            c->in_off += 4 + size;
+        }
+    }
+
+    // Move whatever is left (a partial request) to the front.
+    if (c->in_off)
+    {
+        memmove(c->in.data, &c->in.data[c->in_off], c->in.len - c->in_off);
+        c->in.len -= c->in_off;
+        c->in_off = 0;
+    }
+
+    // Unterminated garbage at the end of the stream.
+    return (c->eof && c->in.len && c->out.len - c->out_off < OUTPUT_HIGH);
+}
+
+// Write as much pending output as the socket will take. Returns non-zero on error.
+static int conn_flush(struct conn *c)
+{
+    while (c->out_off < c->out.len)
+    {
+        ssize_t n = write(c->fd, &c->out.data[c->out_off], c->out.len - c->out_off);
+
+        if (n < 0)
+        {
+            if (errno == EINTR) { continue; }
+            if (errno == EAGAIN || errno == EWOULDBLOCK) { break; }
+
+            return 1;
+        }
+
+        c->out_off += n;
+    }
+
+    if (c->out_off == c->out.len) {
+        c->out.len = c->out_off = 0;
+    }
+
+    return 0;
+}
+
+static void conn_close(struct worker *w, struct conn *c)
+{
+    evloop_del(w->loop, c->fd);
+    close(c->fd);
+
+    if (c->prev) { c->prev->next = c->next; } else { w->conns = c->next; }
+    if (c->next) { c->next->prev = c->prev; }
+
+    obuf_free(&c->in);
+    obuf_free(&c->out);
+    free(c);
+}
+
+static void conn_open(struct worker *w, int fd)
+{
+    struct conn *c = calloc(1, sizeof(struct conn));
+
+    if (!c)
+    {
+        perror("calloc");
+        close(fd);
+
+        return;
+    }
+
+    c->fd = fd;
+    c->events = EVLOOP_READ;
+
+    if (evloop_add(w->loop, fd, c->events, c))
+    {
+        close(fd);
+        free(c);
+
+        return;
+    }
+
+    c->next = w->conns;
+    if (w->conns) { w->conns->prev = c; }
+    w->conns = c;
+}
+
+// Handle readiness on a connection.
+static void conn_event(struct worker *w, struct conn *c, unsigned int events)
+{
+    if ((events & EVLOOP_READ) && !c->eof && c->out.len - c->out_off < OUTPUT_HIGH)
+    {
+        if (obuf_reserve(&c->in, READ_SIZE)) { conn_close(w, c); return; }
+
+        ssize_t n = read(c->fd, &c->in.data[c->in.len], READ_SIZE);
+
+        if (n > 0) {
+            c->in.len += n;
+        } else if (!n) {
+            c->eof = true;
+        } else if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+            conn_close(w, c);
+            return;
+        }
+    }
+
+    // Requests held back by a full output buffer get another chance after each write,
+    //   including a write right here which drains it (nothing else would wake us up for them).
+    for (;;)
+    {
+        if (conn_process(w, c)) { conn_close(w, c); return; }
+
+        bool held = (c->in.len && c->out.len - c->out_off >= OUTPUT_HIGH);
+        if (conn_flush(c)) { conn_close(w, c); return; }
+
+        if (!held || c->out.len - c->out_off >= OUTPUT_HIGH) { break; }
+    }
+
+    size_t pending = c->out.len - c->out_off;
+
+    // Once the client is done and everything it asked for has been sent, we're done too.
+    if (c->eof && !pending && !c->in.len) { conn_close(w, c); return; }
+
+    unsigned int want = 0;
+
+    if (!c->eof && pending < OUTPUT_HIGH) { want |= EVLOOP_READ; }
+    if (pending) { want |= EVLOOP_WRITE; }
+
+    if (want != c->events)
+    {
+        c->events = want;
+
+        if (evloop_mod(w->loop, c->fd, want, c)) {
+            conn_close(w, c);
+        }
+    }
+}
+
+// Take new connections from the accepting thread. Returns true if we've been told to stop.
+static bool worker_accept(struct worker *w)
+{
+    int fds[WAIT_EVENTS];
+    ssize_t n = read(w->pipe[0], fds, sizeof(fds));
+
+    if (n < 0) {
+        return (errno != EAGAIN && errno != EINTR);
+    }
+
+    for (size_t i = 0; i < (size_t)n / sizeof(int); i++)
+    {
+        if (fds[i] < 0) { return true; }
+        conn_open(w, fds[i]);
+    }
+
+    return !n;
+}
+
+static void *worker_main(void *arg)
+{
+    struct worker *w = arg;
+    struct evloop_event events[WAIT_EVENTS];
+
+    bool stop = false;
+
+    while (!stop)
+    {
+        int n = evloop_wait(w->loop, events, WAIT_EVENTS, -1);
+        if (n < 0) { break; }
+
+        for (int i = 0; i < n; i++)
+        {
+            // The pipe is registered without any data.
+            if (!events[i].data) {
+                stop = worker_accept(w);
+            } else {
+                conn_event(w, events[i].data, events[i].events);
+            }
+        }
+    }
+
+    while (w->conns) {
+        conn_close(w, w->conns);
+    }
+
+    return NULL;
+}
+
+static int worker_start(struct worker *w, struct server *srv, size_t id)
+{
+    w->srv = srv;
+    w->id = id;
+    w->scratch = OBUF_INIT;
+
+    if (pipe(w->pipe))
+    {
+        perror("pipe");
+        w->pipe[0] = w->pipe[1] = -1;
+
+        return 1;
+    }
+
+    if (set_nonblocking(w->pipe[0]) || !(w->loop = evloop_create()) || evloop_add(w->loop, w->pipe[0], EVLOOP_READ, NULL)) {
+        return 1;
+    }
+
+    if (spawn(&w->thread, worker_main, w)) {
+        return 1;
+    }
+
+    w->running = true;
+    return 0;
+}
+
+// Load the dictionary again for every reload asked for, swapping each one in while workers keep answering.
+static void *reload_main(void *arg)
+{
+    struct server *srv = arg;
+
+    do {
+        uint64_t wanted;
+
+        while ((wanted = atomic_load(&srv->reloads_wanted)) != srv->reloads_done)
+        {
+            srv->reloads_done = wanted;
+
+            struct timespec start, end;
+            clock_gettime(CLOCK_MONOTONIC, &start);
+
+            struct dindex *idx = dindex_load(srv->dict, false);
+
+            if (!idx)
+            {
+                fprintf(stderr, "Error: Failed to reload '%s' (still serving the old dictionary).\n", srv->dict);
+                continue;
+            }
+
+            // New requests get the new index right away. Once requests already using the old one are done, nothing can see it.
+            struct dindex *old = atomic_exchange(&srv->idx, idx);
+
+            epoch_synchronize(&srv->epoch);
+            dindex_free(old);
+
+            clock_gettime(CLOCK_MONOTONIC, &end);
+
+            if (DEBUG_ZHDICTD) {
+                printf("Reloaded '%s' (%u words) in %.3fs.\n", srv->dict, idx->nwords,
+                       (double)(end.tv_sec - start.tv_sec) + (double)(end.tv_nsec - start.tv_nsec) / 1e9);
+            }
+        }
+
+        atomic_store(&srv->reloading, false);
+
+        // A reload may have been asked for after we last checked but before we said we were done.
+    } while (atomic_load(&srv->reloads_wanted) != srv->reloads_done && !atomic_exchange(&srv->reloading, true));
+
+    return NULL;
+}
+
+// Ask for a reload, starting the reloading thread if it isn't running already.
+static void reload_start(struct server *srv)
+{
+    atomic_fetch_add(&srv->reloads_wanted, 1);
+
+    // The running thread picks this up if there is one.
+    if (atomic_exchange(&srv->reloading, true)) {
+        return;
+    }
+
+    // Otherwise the last one is done (or just about to return).
+    if (srv->reloader_started) {
+        pthread_join(srv->reloader, NULL);
+    }
+
+    srv->reloader_started = !spawn(&srv->reloader, reload_main, srv);
+
+    if (!srv->reloader_started) {
+        atomic_store(&srv->reloading, false);
+    }
+}
+
+// Bind and listen on a Unix domain socket at `path`, replacing any stale socket there.
+static int listen_at(const char *path)
+{
+    struct sockaddr_un addr = { .sun_family = AF_UNIX };
+
+    if (strlen(path) >= sizeof(addr.sun_path))
+    {
+        fprintf(stderr, "Error: Socket path '%s' is too long!\n", path);
+        return -1;
+    }
+
+    strcpy(addr.sun_path, path);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+
+    if (fd < 0)
+    {
+        perror("socket");
+        return -1;
+    }
+
+    unlink(path);
+
+    if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) || listen(fd, SOMAXCONN))
+    {
+        perror("bind");
+        close(fd);
+
+        return -1;
+    }
+
+    return fd;
+}
+
+static void usage(const char *name)
+{
+    fprintf(stderr, "Usage: %s [-s socket] [-j threads] [-S] [-k count] dict.xlsx|dict.idx\n", name);
+}
+
+int main(int argc, char *const *argv)
+{
+    struct server srv = { .order = DINDEX_ORDER_LEX, .k = 20 };
+
+    const char *path = ZHDICTD_SOCKET;
+    size_t threads = 0;
+
+    int opt;
+
+    while ((opt = getopt(argc, argv, "s:j:Sk:")) != -1)
+    {
+        switch (opt)
+        {
+            case 's': path = optarg; break;
+            case 'j': threads = strtoul(optarg, NULL, 10); break;
+            case 'S': srv.order = DINDEX_ORDER_STROKES; break;
+            case 'k':
+                srv.k = strtoul(optarg, NULL, 10);
+
+                if (!srv.k || srv.k > COMPLETE_MAX)
+                {
+                    fprintf(stderr, "Error: Completion count must be between 1 and %d.\n", COMPLETE_MAX);
+                    return 1;
+                }
+
+                break;
+            default:
+                usage(argv[0]);
+                return 1;
+        }
+    }
+
+    if (argc - optind != 1)
+    {
+        usage(argv[0]);
+        return 1;
+    }
+
+    if (!threads) {
+        threads = pool_ncpus();
+    }
+
+    srv.dict = argv[optind];
+
+    struct dindex *idx = dindex_load(srv.dict, false);
+    if (!idx) { return 1; }
+
+    if (epoch_init(&srv.epoch, threads))
+    {
+        dindex_free(idx);
+        return 1;
+    }
+
+    atomic_init(&srv.idx, idx);
+    atomic_init(&srv.reloads_wanted, 0);
+    atomic_init(&srv.reloading, false);
+
+    if (pipe(signal_pipe) || set_nonblocking(signal_pipe[0]) || set_nonblocking(signal_pipe[1]))
+    {
+        perror("pipe");
+
+        epoch_free(&srv.epoch);
+        dindex_free(idx);
+
+        return 1;
+    }
+
+    // Stop accepting on SIGINT/SIGTERM and reload on SIGHUP (both wake the accepting thread), and report broken clients as write errors.
+    struct sigaction sa = { .sa_handler = on_signal };
+    sigemptyset(&sa.sa_mask);
+
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+    sigaction(SIGHUP, &sa, NULL);
+    signal(SIGPIPE, SIG_IGN);
+
+    // The listening socket and the signal pipe are waited on together, and never block otherwise.
+    int lfd = listen_at(path);
+    struct evloop *loop = NULL;
+
+    if (lfd < 0 || set_nonblocking(lfd) || !(loop = evloop_create())
+        || evloop_add(loop, lfd, EVLOOP_READ, &lfd) || evloop_add(loop, signal_pipe[0], EVLOOP_READ, NULL))
+    {
+        if (loop) { evloop_free(loop); }
+
+        if (lfd >= 0)
+        {
+            close(lfd);
+            unlink(path);
+        }
+
+        close(signal_pipe[0]);
+        close(signal_pipe[1]);
+
+        epoch_free(&srv.epoch);
+        dindex_free(idx);
+
+        return 1;
+    }
+
+    struct worker *workers = calloc(threads, sizeof(struct worker));
+    size_t started = 0;
+    int status = 0;
+
+    if (!workers)
+    {
+        perror("calloc");
+        status = 1;
+    }
+
+    while (!status && started < threads)
+    {
+        status = worker_start(&workers[started], &srv, started);
+        started++;
+    }
+
+    if (DEBUG_ZHDICTD && !status) {
+        printf("Listening on '%s' with %zu workers.\n", path, threads);
+    }
+
+    size_t next = 0;
+
+    while (!status && !stopping)
+    {
+        if (reload)
+        {
+            reload = 0;
+            reload_start(&srv);
+        }
+
+        // Signals set their flag before writing to the pipe, so one arriving after the check above ends this wait at once.
+        struct evloop_event events[2];
+        int n = evloop_wait(loop, events, 2, -1);
+
+        if (n < 0)
+        {
+            status = 1;
+            break;
+        }
+
+        for (int i = 0; i < n; i++)
+        {
+            // The signal pipe is registered without any data. The flags are checked once it's empty.
+            if (!events[i].data)
+            {
+                char buf[64];
+
+                while (read(signal_pipe[0], buf, sizeof(buf)) > 0) {
+                    continue;
+                }
+
+                continue;
+            }
+
+            int fd = accept(lfd, NULL, NULL);
+
+            if (fd < 0)
+            {
+                if (errno == EINTR || errno == ECONNABORTED || errno == EAGAIN || errno == EWOULDBLOCK) { continue; }
+
+                perror("accept");
+                status = 1;
+
+                break;
+            }
+
+            if (set_nonblocking(fd) || write(workers[next].pipe[1], &fd, sizeof(fd)) != sizeof(fd)) {
+                close(fd);
+            }
+
+            next = (next + 1) % threads;
+        }
+    }
+
+    evloop_free(loop);
+    close(lfd);
+    unlink(path);
+
+    // Tell every worker to finish up, then wait for them.
+    for (size_t i = 0; i < started; i++)
+    {
+        int fd = -1;
+
+        if (workers[i].running && write(workers[i].pipe[1], &fd, sizeof(fd)) == sizeof(fd)) {
+            pthread_join(workers[i].thread, NULL);
+        }
+
+        if (workers[i].loop) { evloop_free(workers[i].loop); }
+        obuf_free(&workers[i].scratch);
+
+        if (workers[i].pipe[0] >= 0)
+        {
+            close(workers[i].pipe[0]);
+            close(workers[i].pipe[1]);
+        }
+    }
+
+    // A reload in progress finishes first, since it swaps the index.
+    if (srv.reloader_started) {
+        pthread_join(srv.reloader, NULL);
+    }
+
+    free(workers);
+    dindex_free(atomic_load(&srv.idx));
+    epoch_free(&srv.epoch);
+
+    close(signal_pipe[0]);
+    close(signal_pipe[1]);
+
+    return status;
+}
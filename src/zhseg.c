@@ -0,0 +1,204 @@
+/* ********************************************************** */
+/* -*- zhseg.c -*- Segment text into dictionary words     -*- */
+/* ********************************************************** */
+/* Tyler Besselman (C) October 2026                           */
+/* ********************************************************** */
+
+// Reads text from stdin and writes it to stdout with a delimiter between adjacent words.
+// Whitespace in the input is copied through as is (and never gets a delimiter next to it).
+
+#include <strings.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <dindex.h>
+#include <obuf.h>
+#include <segment.h>
+
+// Input is read in chunks of (at least) this many bytes, and only whole lines are segmented at once.
+#define ZHSEG_CHUNK (1 << 20)
+
+// Segment `len` bytes of text and write it out with `delim` between adjacent tokens.
+static int zhseg_chunk(const struct segmenter *seg, const char *text, size_t len, const char *delim, struct segment_buf *buf, struct obuf *out)
+{
+    size_t ntokens;
+    if (segment_text(seg, text, len, buf, &ntokens)) { return 1; }
+
+    size_t dlen = strlen(delim);
+
+    // Output is the input plus at most one delimiter per token.
+    if (obuf_reserve(out, len + ntokens * dlen)) { return 1; }
+
+    char *p = &out->data[out->len];
+    size_t prev = 0;
+
+    for (size_t i = 0; i < ntokens; i++)
+    {
+        size_t start = buf->tokens[2 * i];
+        size_t end = buf->tokens[2 * i + 1];
+
+        if (start > prev) {
+            memcpy(p, &text[prev], start - prev);
+            p += start - prev;
+        } else if (i) {
+            memcpy(p, delim, dlen);
+            p += dlen;
+        }
+
+        memcpy(p, &text[start], end - start);
+        p += end - start;
+
+        prev = end;
+    }
+
+    memcpy(p, &text[prev], len - prev);
+    p += len - prev;
+
+    out->len = p - out->data;
+    return obuf_flush(out, stdout);
+}
+
+static int zhseg(const struct segmenter *seg, FILE *in, const char *delim)
+{
+    struct segment_buf buf = SEGMENT_BUF_INIT;
+    struct obuf out = OBUF_INIT;
+
+    size_t cap = ZHSEG_CHUNK;
+    size_t len = 0;
+    char *text = malloc(cap);
+
+    if (!text)
+    {
+        perror("malloc");
+        return 1;
+    }
+
+    int status = 0;
+    bool eof = false;
+
+    while (!status && !eof)
+    {
+        // Lines longer than the buffer just make it grow.
+        if (len == cap)
+        {
+            char *more = realloc(text, cap * 2);
+
+            if (!more)
+            {
+                perror("realloc");
+                status = 1;
+
+                break;
+            }
+
+            text = more;
+            cap *= 2;
+        }
+
+        size_t n = fread(&text[len], 1, cap - len, in);
+
+        if (n < cap - len)
+        {
+            if (ferror(in))
+            {
+                perror("fread");
+                status = 1;
+
+                break;
+            }
+
+            eof = true;
+        }
+
+        // Segment everything up to the last newline we have (or everything, at the end).
+        size_t old = len;
+        len += n;
+
+        size_t cut = len;
+
+        if (!eof)
+        {
+            while (cut > old && text[cut - 1] != '\n') {
+                cut--;
+            }
+
+            // What was left over from before has no newlines, so there's nothing to do yet.
+            if (cut == old) {
+                cut = 0;
+            }
+        }
+
+        if (!cut) { continue; }
+
+        status = zhseg_chunk(seg, text, cut, delim, &buf, &out);
+
+        memmove(text, &text[cut], len - cut);
+        len -= cut;
+    }
+
+    free(text);
+    segment_buf_free(&buf);
+    obuf_free(&out);
+
+    return status;
+}
+
+static void usage(const char *name)
+{
+    fprintf(stderr, "Usage: %s [-m forward|backward|dag] [-d delimiter] dict.xlsx|dict.idx < text\n", name);
+}
+
+int main(int argc, char *const *argv)
+{
+    enum segment_mode mode = SEGMENT_FORWARD;
+    const char *delim = " ";
+
+    int opt;
+
+    while ((opt = getopt(argc, argv, "m:d:")) != -1)
+    {
+        switch (opt)
+        {
+            case 'm': {
+                if (!strcmp(optarg, "forward")) {
+                    mode = SEGMENT_FORWARD;
+                } else if (!strcmp(optarg, "backward")) {
+                    mode = SEGMENT_BACKWARD;
+                } else if (!strcmp(optarg, "dag")) {
+                    mode = SEGMENT_DAG;
+                } else {
+                    fprintf(stderr, "Error: Unknown segmentation mode '%s'!\n", optarg);
+                    return 1;
+                }
+            } break;
+            case 'd': delim = optarg; break;
+            default:
+                usage(argv[0]);
+                return 1;
+        }
+    }
+
+    if (argc - optind != 1)
+    {
+        usage(argv[0]);
+        return 1;
+    }
+
+    struct dindex *idx = dindex_load(argv[optind], false);
+    if (!idx) { return 1; }
+
+    struct segmenter *seg = segment_create(idx, mode);
+
+    if (!seg)
+    {
+        dindex_free(idx);
+        return 1;
+    }
+
+    int status = zhseg(seg, stdin, delim);
+
+    segment_free(seg);
+    dindex_free(idx);
+
+    return status;
+}